@@ -158,6 +158,25 @@ extern "C"
  */
 
 
+/* Public Macros -------------------------------------------------------------- */
+/** @defgroup ADC_Public_Macros ADC Public Macros
+ * @{
+ */
+
+/** Stream buffers */
+#define 	ADC_STREAM_BLOCK	256			// Raw words per DMA block, 8 per scan, two blocks
+#define 	ADC_STREAM_FRAMES	32			// Output frames per callback block, two blocks
+
+/** Stream status */
+#define ADC_STREAM_IDLE		0		/**< Not started */
+#define ADC_STREAM_RUNNING	1		/**< Converting */
+#define ADC_STREAM_ERROR	2		/**< Stopped by a DMA error */
+
+/**
+ * @}
+ */
+
+
 /* Public Types --------------------------------------------------------------- */
 /** @defgroup ADC_Public_Types ADC Public Types
  * @{
@@ -230,6 +249,22 @@ typedef enum
 	ADC_DATA_DONE		 /*Done bit*/
 }ADC_DATA_STATUS;
 
+/**
+ * @brief Completed block of a stream, called from DMA_IRQHandler. The
+ * block holds frames of one averaged sample per enabled channel, in
+ * channel order, and stays valid until the next block is complete.
+ */
+typedef void (*ADC_StreamCallback_Type)(const uint16_t *block, uint32_t frames);
+
+/** @brief Streaming acquisition setup */
+typedef struct
+{
+	uint8_t ChannelMask;				/**< Bit n scans AD0.n */
+	uint32_t Rate;						/**< Output frames per second */
+	uint16_t Decimation;				/**< Scans averaged per frame, 1 for none */
+	ADC_StreamCallback_Type Callback;	/**< Block handler */
+} ADC_STREAM_CFG_Type;
+
 /**
  * @}
  */
@@ -262,6 +297,13 @@ FlagStatus ADC_ChannelGetStatus(LPC_ADC_TypeDef *ADCx, uint8_t channel, uint32_t
 uint32_t ADC_GlobalGetData(LPC_ADC_TypeDef *ADCx);
 FlagStatus	ADC_GlobalGetStatus(LPC_ADC_TypeDef *ADCx, uint32_t StatusType);
 
+/* Streaming acquisition functions -----------*/
+Status ADC_StreamStart(ADC_STREAM_CFG_Type *StreamCfg);
+void ADC_StreamStop(void);
+uint32_t ADC_StreamGetRate(void);
+uint32_t ADC_StreamGetStatus(void);
+uint32_t ADC_StreamGetOverruns(void);
+
 /**
  * @}
  */
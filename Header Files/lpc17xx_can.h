@@ -38,6 +38,13 @@ extern "C"
 #define ID_11					1
 #define MAX_HW_FULLCAN_OBJ 		64
 #define MAX_SW_FULLCAN_OBJ 		32
+#define CAN_AF_RAM_WORDS		512		// AF RAM, tables and FullCAN objects
+
+/******************************************************************************/
+/*                       CAN Mailboxes                                        */
+/******************************************************************************/
+#define 	CAN_RX_RING			32		// Received frames buffered per controller, power of two
+#define 	CAN_TX_QUEUE		16		// Frames waiting for a TX buffer per controller
 
 /**
  * @}
@@ -788,6 +795,39 @@ typedef struct {
 	uint8_t EFF_GPR_NumEntry;		/**< Group Extended ID Entry Number */
 } AF_SectionDef;
 
+/**
+ * @brief Received frame with the time it was taken from the controller
+ */
+typedef struct {
+	CAN_MSG_Type msg;		/**< Frame */
+	uint32_t stamp;			/**< Receive time in us, wraps after 71 minutes */
+} CAN_RX_FRAME_Type;
+
+/**
+ * @brief Mailbox counters of a controller, since CAN_MailboxInit()
+ */
+typedef struct {
+	uint32_t rxFrames;		/**< Frames put in the RX ring */
+	uint32_t rxDropped;		/**< Frames lost because the RX ring was full */
+	uint32_t rxOverruns;	/**< Frames lost in the controller (data overrun) */
+	uint32_t txFrames;		/**< Frames sent */
+	uint32_t txDropped;		/**< Frames refused because the TX queue was full */
+	uint32_t busErrors;		/**< Bus error interrupts */
+	uint32_t errorPassive;	/**< Error passive or error warning changes */
+	uint32_t arbLost;		/**< Arbitrations lost */
+} CAN_STATS_Type;
+
+/**
+ * @brief Acceptance Filter entry for CAN_BuildAFLUT(), any type in any order
+ */
+typedef struct {
+	AFLUT_ENTRY_Type type;	/**< Section the entry goes in */
+	uint8_t controller;		/**< CAN1_CTRL or CAN2_CTRL */
+	uint8_t disable;		/**< MSG_ENABLE or MSG_DISABLE, standard ID entries only */
+	uint32_t lowerID;		/**< Identifier, or lower bound of a group */
+	uint32_t upperID;		/**< Upper bound of a group, unused otherwise */
+} CAN_AF_ENTRY_Type;
+
 /**
  * @}
  */
@@ -815,6 +855,19 @@ Status CAN_SendMsg(LPC_CAN_TypeDef *CANx, CAN_MSG_Type *CAN_Msg);
 Status CAN_ReceiveMsg(LPC_CAN_TypeDef *CANx, CAN_MSG_Type *CAN_Msg);
 CAN_ERROR FCAN_ReadObj(LPC_CANAF_TypeDef* CANAFx, CAN_MSG_Type *CAN_Msg);
 
+/* CAN mailbox functions ----------------*/
+void CAN_MailboxInit(LPC_CAN_TypeDef *CANx);
+Status CAN_QueueMsg(LPC_CAN_TypeDef *CANx, CAN_MSG_Type *CAN_Msg, uint8_t prio);
+Status CAN_GetMsg(LPC_CAN_TypeDef *CANx, CAN_RX_FRAME_Type *frame);
+uint32_t CAN_GetRxCount(LPC_CAN_TypeDef *CANx);
+void CAN_GetStats(LPC_CAN_TypeDef *CANx, CAN_STATS_Type *stats);
+
+/* FullCAN signal functions -------------*/
+void CAN_FullCANStart(void);
+uint32_t CAN_FullCANService(void);
+int32_t CAN_FullCANFindObj(uint8_t controller, uint16_t id);
+uint32_t CAN_FullCANRead(uint16_t obj, CAN_RX_FRAME_Type *frame);
+
 /* CAN configure functions ---------------*/
 void CAN_ModeConfig(LPC_CAN_TypeDef* CANx, CAN_MODE_Type mode,
 		FunctionalState NewState);
@@ -829,6 +882,8 @@ CAN_ERROR CAN_LoadExplicitEntry(LPC_CAN_TypeDef* CANx, uint32_t ID,
 CAN_ERROR CAN_LoadGroupEntry(LPC_CAN_TypeDef* CANx, uint32_t lowerID,
 		uint32_t upperID, CAN_ID_FORMAT_Type format);
 CAN_ERROR CAN_RemoveEntry(AFLUT_ENTRY_Type EntryType, uint16_t position);
+CAN_ERROR CAN_BuildAFLUT(LPC_CANAF_TypeDef* CANAFx, CAN_AF_ENTRY_Type* list, uint16_t count);
+Bool CAN_AFLookup(uint8_t controller, uint32_t id, CAN_ID_FORMAT_Type format);
 
 /* CAN interrupt functions -----------------*/
 void CAN_IRQCmd(LPC_CAN_TypeDef* CANx, CAN_INT_EN_Type arg, FunctionalState NewState);
@@ -52,6 +52,19 @@ is VALUE/1024 
 /** DCAR DACCTRL mask bit */
 #define DAC_DACCTRL_MASK	((uint32_t)(0x0F))
 
+/******************************************************************************/
+/*                       DAC Waveform Buffers                                 */
+/******************************************************************************/
+#define 	DAC_SINE_POINTS		256			// Samples per sine period, multiple of 4
+#define 	DAC_WAVE_MAX_LLI	4			// Longest table: DAC_WAVE_MAX_LLI * 4095 samples
+#define 	DAC_STREAM_BLOCK	128			// Samples per DMA block, two blocks
+#define 	DAC_STREAM_RING		1024		// Samples queued by DAC_StreamWrite(), power of two
+
+/** Waveform engine mode */
+#define DAC_WAVE_IDLE		0		/**< Not playing */
+#define DAC_WAVE_TABLE		1		/**< Repeating a table */
+#define DAC_WAVE_STREAM		2		/**< Playing the stream ring */
+
 /** Macro to determine if it is valid DAC peripheral */
 #define PARAM_DACx(n)	(((uint32_t *)n)==((uint32_t *)LPC_DAC))
 
@@ -113,6 +126,15 @@ void    DAC_SetBias (LPC_DAC_TypeDef *DACx,uint32_t bias);
 void    DAC_ConfigDAConverterControl (LPC_DAC_TypeDef *DACx,DAC_CONVERTER_CFG_Type *DAC_ConverterConfigStruct);
 void 	DAC_SetDMATimeOut(LPC_DAC_TypeDef *DACx,uint32_t time_out);
 
+Status  DAC_WavePlay (const uint32_t *table, uint32_t count, uint32_t rate);
+Status  DAC_WaveSine (uint32_t freq, uint16_t amplitude);
+void    DAC_WaveStop (void);
+uint32_t DAC_WaveGetMode (void);
+Status  DAC_StreamStart (uint32_t rate);
+uint32_t DAC_StreamWrite (const uint16_t *samples, uint32_t count);
+uint32_t DAC_StreamFree (void);
+uint32_t DAC_StreamGetUnderruns (void);
+
 /**
  * @}
  */
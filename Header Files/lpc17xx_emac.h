@@ -19,6 +19,7 @@
 /* Includes ------------------------------------------------------------------- */
 #include "LPC17xx.h"
 #include "lpc_system_init.h"
+#include "lpc_crc.h"
 
 
 #ifdef __cplusplus
@@ -53,6 +54,15 @@ extern "C"
 	#error PHY not selected
 #endif
 
+/******************************************************************************/
+/*                       Event Log Select                                     */
+/******************************************************************************/
+#define 	EMAC_LOG_SEL       0	         // Print EMAC events on UART0 from EMAC_Poll()
+
+#if EMAC_LOG_SEL
+	#define EMAC_LOG_MODE
+#endif
+
 /* This is the MAC address of LPC1768
 #define MYMAC_1 	1
 #define MYMAC_2 	2
@@ -98,12 +108,36 @@ uint8_t __attribute__ ((aligned (4))) gRxBuf[TX_PACKET_SIZE + 0x10];
  */
 
 
-/* EMAC Memory Buffer configuration for 16K Ethernet RAM */
-#define EMAC_NUM_RX_FRAG         4           /**< Num.of RX Fragments 4*1536= 6.0kB */
-#define EMAC_NUM_TX_FRAG         3           /**< Num.of TX Fragments 3*1536= 4.6kB */
+/* EMAC Memory Buffer configuration for 32K AHB SRAM (AHBRAM0 + AHBRAM1)
+ * Descriptors, status words and the packet buffer pool all live in AHB SRAM
+ * so the Ethernet DMA can reach them; the RX and TX rings only hold pointers
+ * into the pool, frames are never copied by the driver.
+ */
+#define EMAC_NUM_RX_FRAG         12          /**< RX ring depth (descriptors)       */
+#define EMAC_NUM_TX_FRAG         8           /**< TX ring depth (descriptors)       */
+#define EMAC_PBUF_NUM            20          /**< Packet buffers in the pool, 20*1536= 30kB */
 #define EMAC_ETH_MAX_FLEN        1536        /**< Max. Ethernet Frame Size          */
 #define EMAC_TX_FRAME_TOUT       0x00100000  /**< Frame Transmit timeout count      */
 
+/* EMAC event queue, filled by ENET_IRQHandler and drained by EMAC_Poll() */
+#define EMAC_EVT_QUEUE_SIZE      32          /**< Event queue entries, power of 2   */
+
+#if (EMAC_EVT_QUEUE_SIZE & (EMAC_EVT_QUEUE_SIZE - 1))
+	#error EMAC_EVT_QUEUE_SIZE must be a power of 2
+#endif
+
+#define EMAC_AHBRAM_BASE         LPC_AHBRAM0_BASE  /**< Start of EMAC memory        */
+#define EMAC_AHBRAM_SIZE         0x8000      /**< AHBRAM0 and AHBRAM1 are contiguous */
+
+#if (EMAC_PBUF_NUM < (EMAC_NUM_RX_FRAG + 1))
+	#error EMAC_PBUF_NUM must cover every RX descriptor plus one spare buffer
+#endif
+
+#if ((EMAC_NUM_RX_FRAG * 16) + (EMAC_NUM_TX_FRAG * 12) + \
+	 (EMAC_PBUF_NUM * EMAC_ETH_MAX_FLEN)) > EMAC_AHBRAM_SIZE
+	#error EMAC rings and packet buffer pool do not fit in AHB SRAM
+#endif
+
 /* --------------------- BIT DEFINITIONS -------------------------------------- */
 /*********************************************************************//**
  * Macro defines for MAC Configuration Register 1
@@ -573,6 +607,40 @@ typedef struct {
 	uint32_t *pbDataBuf;		/**< A word-align data pointer to data buffer */
 } EMAC_PACKETBUF_Type;
 
+/**
+ * @brief Packet buffer structure definition
+ *
+ * Packet buffers are handed out from a fixed pool in AHB SRAM. A received
+ * frame is one buffer; a frame to be sent may be a chain of buffers linked
+ * through 'next', each chained buffer becoming one TX fragment.
+ */
+typedef struct EMAC_PBUF {
+	struct EMAC_PBUF *next;		/**< Next fragment of the frame, NULL for the last one */
+	uint8_t  *payload;			/**< Data pointer, may be moved inside the buffer */
+	uint16_t len;				/**< Number of valid bytes at payload */
+	uint16_t index;				/**< Pool slot, owned by the driver */
+	uint32_t stamp;				/**< Receive time from now_us(), set by EMAC_ReceiveFrame() */
+} EMAC_PBUF_Type;
+
+/**
+ * @brief EMAC event counters, one per interrupt source
+ */
+typedef struct {
+	uint32_t RxOverrun;			/**< Receive overrun */
+	uint32_t RxError;			/**< Receive error */
+	uint32_t RxFinished;		/**< RX descriptors exhausted */
+	uint32_t RxDone;			/**< Receive done */
+	uint32_t TxUnderrun;		/**< Transmit under-run */
+	uint32_t TxError;			/**< Transmit error */
+	uint32_t TxFinished;		/**< TX descriptors all sent */
+	uint32_t TxDone;			/**< Transmit done */
+	uint32_t Wakeup;			/**< Wake-up event */
+	uint32_t QueueFull;			/**< Events merged because the event queue was full */
+} EMAC_COUNTERS_Type;
+
+/** Receive callback, the callee owns the buffer and must free it */
+typedef void (*EMAC_RxCallback_Type)(EMAC_PBUF_Type *p);
+
 /**
  * @brief EMAC configuration structure definition
  */
@@ -617,9 +685,22 @@ void EMAC_SetHashFilter(uint8_t dstMAC_addr[], FunctionalState NewState);
 void EMAC_SetFilterMode(uint32_t ulFilterMode, FunctionalState NewState);
 
 /* EMAC Packet Buffer functions */
-void EMAC_WritePacketBuffer(EMAC_PACKETBUF_Type *pDataStruct);
+Status EMAC_WritePacketBuffer(EMAC_PACKETBUF_Type *pDataStruct);
 void EMAC_ReadPacketBuffer(EMAC_PACKETBUF_Type *pDataStruct);
 
+/* EMAC zero-copy functions --------*/
+EMAC_PBUF_Type *EMAC_PbufAlloc(void);
+void EMAC_PbufFree(EMAC_PBUF_Type *p);
+EMAC_PBUF_Type *EMAC_ReceiveFrame(void);
+Status EMAC_SendFrame(EMAC_PBUF_Type *p);
+void EMAC_TxReclaim(void);
+
+/* EMAC deferred event functions ---*/
+void EMAC_Poll(void);
+void EMAC_SetRxCallback(EMAC_RxCallback_Type Callback);
+void EMAC_GetCounters(EMAC_COUNTERS_Type *pCounters);
+void EMAC_ClearCounters(void);
+
 /* EMAC Interrupt functions -------*/
 void EMAC_IntCmd(uint32_t ulIntType, FunctionalState NewState);
 IntStatus EMAC_IntGetStatus(uint32_t ulIntType);
@@ -0,0 +1,348 @@
+/******************************************************************//**
+* @file		lpc17xx_gpdma.h
+* @brief	Contains all macro definitions and function prototypes
+* 			support for GPDMA firmware library on LPC17xx
+* @version	1.0
+* @date		20. June. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* Peripheral group ----------------------------------------------------------- */
+/** @defgroup GPDMA GPDMA
+ * @ingroup LPC1700CMSIS_FwLib_Drivers
+ * @{
+ */
+
+#ifndef LPC17XX_GPDMA_H_
+#define LPC17XX_GPDMA_H_
+
+/* Includes ------------------------------------------------------------------- */
+#include "LPC17xx.h"
+#include "lpc_system_init.h"
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Public Macros -------------------------------------------------------------- */
+/** @defgroup GPDMA_Public_Macros GPDMA Public Macros
+ * @{
+ */
+
+/** Number of GPDMA channels on LPC17xx */
+#define GPDMA_NUM_CHANNELS		8
+
+/** Maximum number of transfers in one DMA descriptor (12 bit field) */
+#define GPDMA_MAX_XFER_SIZE		0xFFF
+
+/** DMA Connection number definitions */
+#define GPDMA_CONN_SSP0_Tx 			((0UL)) 		/**< SSP0 Tx */
+#define GPDMA_CONN_SSP0_Rx 			((1UL)) 		/**< SSP0 Rx */
+#define GPDMA_CONN_SSP1_Tx 			((2UL)) 		/**< SSP1 Tx */
+#define GPDMA_CONN_SSP1_Rx 			((3UL)) 		/**< SSP1 Rx */
+#define GPDMA_CONN_ADC 				((4UL)) 		/**< ADC */
+#define GPDMA_CONN_I2S_Channel_0 	((5UL)) 		/**< I2S channel 0 */
+#define GPDMA_CONN_I2S_Channel_1 	((6UL)) 		/**< I2S channel 1 */
+#define GPDMA_CONN_DAC 				((7UL)) 		/**< DAC */
+#define GPDMA_CONN_UART0_Tx			((8UL)) 		/**< UART0 Tx */
+#define GPDMA_CONN_UART0_Rx			((9UL)) 		/**< UART0 Rx */
+#define GPDMA_CONN_UART1_Tx			((10UL)) 		/**< UART1 Tx */
+#define GPDMA_CONN_UART1_Rx			((11UL)) 		/**< UART1 Rx */
+#define GPDMA_CONN_UART2_Tx			((12UL)) 		/**< UART2 Tx */
+#define GPDMA_CONN_UART2_Rx			((13UL)) 		/**< UART2 Rx */
+#define GPDMA_CONN_UART3_Tx			((14UL)) 		/**< UART3 Tx */
+#define GPDMA_CONN_UART3_Rx			((15UL)) 		/**< UART3 Rx */
+#define GPDMA_CONN_MAT0_0 			((16UL)) 		/**< MAT0.0 */
+#define GPDMA_CONN_MAT0_1 			((17UL)) 		/**< MAT0.1 */
+#define GPDMA_CONN_MAT1_0 			((18UL)) 		/**< MAT1.0 */
+#define GPDMA_CONN_MAT1_1   		((19UL)) 		/**< MAT1.1 */
+#define GPDMA_CONN_MAT2_0   		((20UL)) 		/**< MAT2.0 */
+#define GPDMA_CONN_MAT2_1   		((21UL)) 		/**< MAT2.1 */
+#define GPDMA_CONN_MAT3_0 			((22UL)) 		/**< MAT3.0 */
+#define GPDMA_CONN_MAT3_1   		((23UL)) 		/**< MAT3.1 */
+
+/** GPDMA Transfer type definitions */
+#define GPDMA_TRANSFERTYPE_M2M 		((0UL))			/**< Memory to memory - DMA control */
+#define GPDMA_TRANSFERTYPE_M2P 		((1UL))			/**< Memory to peripheral - DMA control */
+#define GPDMA_TRANSFERTYPE_P2M 		((2UL))			/**< Peripheral to memory - DMA control */
+#define GPDMA_TRANSFERTYPE_P2P 		((3UL))			/**< Source peripheral to destination peripheral - DMA control */
+
+/** Burst size in Source and Destination definitions */
+#define GPDMA_BSIZE_1 	((0UL)) /**< Burst size = 1 */
+#define GPDMA_BSIZE_4 	((1UL)) /**< Burst size = 4 */
+#define GPDMA_BSIZE_8 	((2UL)) /**< Burst size = 8 */
+#define GPDMA_BSIZE_16 	((3UL)) /**< Burst size = 16 */
+#define GPDMA_BSIZE_32 	((4UL)) /**< Burst size = 32 */
+#define GPDMA_BSIZE_64 	((5UL)) /**< Burst size = 64 */
+#define GPDMA_BSIZE_128 ((6UL)) /**< Burst size = 128 */
+#define GPDMA_BSIZE_256 ((7UL)) /**< Burst size = 256 */
+
+/** Width in Source transfer width and Destination transfer width definitions */
+#define GPDMA_WIDTH_BYTE 		((0UL)) /**< Width = 1 byte */
+#define GPDMA_WIDTH_HALFWORD 	((1UL)) /**< Width = 2 bytes */
+#define GPDMA_WIDTH_WORD 		((2UL)) /**< Width = 4 bytes */
+
+/** Channel allocation priority, channel 0 has the highest priority */
+#define GPDMA_PRIO_HIGH			((0UL))	/**< Search from channel 0 upward */
+#define GPDMA_PRIO_LOW			((1UL))	/**< Search from channel 7 downward */
+
+/** Status passed to a channel callback */
+#define GPDMA_CB_DONE			((0UL))	/**< Terminal count reached */
+#define GPDMA_CB_ERROR			((1UL))	/**< AHB error on the channel */
+
+/**
+ * @}
+ */
+
+/* Private Macros ------------------------------------------------------------- */
+/** @defgroup GPDMA_Private_Macros GPDMA Private Macros
+ * @{
+ */
+
+/* --------------------- BIT DEFINITIONS -------------------------------------- */
+/*********************************************************************//**
+ * Macro defines for DMA Interrupt Status register
+ **********************************************************************/
+#define GPDMA_DMACIntStat_Ch(n)			(((1UL<<n)&0xFF))
+#define GPDMA_DMACIntStat_BITMASK		((0xFF))
+
+/*********************************************************************//**
+ * Macro defines for DMA Interrupt Terminal Count Request Status register
+ **********************************************************************/
+#define GPDMA_DMACIntTCStat_Ch(n)		(((1UL<<n)&0xFF))
+#define GPDMA_DMACIntTCStat_BITMASK		((0xFF))
+
+/*********************************************************************//**
+ * Macro defines for DMA Interrupt Terminal Count Request Clear register
+ **********************************************************************/
+#define GPDMA_DMACIntTCClear_Ch(n)		(((1UL<<n)&0xFF))
+#define GPDMA_DMACIntTCClear_BITMASK	((0xFF))
+
+/*********************************************************************//**
+ * Macro defines for DMA Interrupt Error Status register
+ **********************************************************************/
+#define GPDMA_DMACIntErrStat_Ch(n)		(((1UL<<n)&0xFF))
+#define GPDMA_DMACIntErrStat_BITMASK	((0xFF))
+
+/*********************************************************************//**
+ * Macro defines for DMA Interrupt Error Clear register
+ **********************************************************************/
+#define GPDMA_DMACIntErrClr_Ch(n)		(((1UL<<n)&0xFF))
+#define GPDMA_DMACIntErrClr_BITMASK		((0xFF))
+
+/*********************************************************************//**
+ * Macro defines for DMA Enabled Channel register
+ **********************************************************************/
+#define GPDMA_DMACEnbldChns_Ch(n)		(((1UL<<n)&0xFF))
+#define GPDMA_DMACEnbldChns_BITMASK		((0xFF))
+
+/*********************************************************************//**
+ * Macro defines for DMA Configuration register
+ **********************************************************************/
+/** DMA Controller enable*/
+#define GPDMA_DMACConfig_E				((0x01))
+/** AHB Master endianness configuration*/
+#define GPDMA_DMACConfig_M				((0x02))
+#define GPDMA_DMACConfig_BITMASK		((0x03))
+
+/*********************************************************************//**
+ * Macro defines for DMA Channel Linked List Item registers
+ **********************************************************************/
+/** DMA Channel Linked List Item registers bit mask*/
+#define GPDMA_DMACCxLLI_BITMASK 		((0xFFFFFFFC))
+
+/*********************************************************************//**
+ * Macro defines for DMA channel control registers
+ **********************************************************************/
+#define GPDMA_DMACCxControl_TransferSize(n) (((n&0xFFF)<<0)) 	/**< Transfer size*/
+#define GPDMA_DMACCxControl_SBSize(n)		(((n&0x07)<<12)) 	/**< Source burst size*/
+#define GPDMA_DMACCxControl_DBSize(n)		(((n&0x07)<<15)) 	/**< Destination burst size*/
+#define GPDMA_DMACCxControl_SWidth(n)		(((n&0x07)<<18)) 	/**< Source transfer width*/
+#define GPDMA_DMACCxControl_DWidth(n)		(((n&0x07)<<21)) 	/**< Destination transfer width*/
+#define GPDMA_DMACCxControl_SI				((1UL<<26)) 		/**< Source increment*/
+#define GPDMA_DMACCxControl_DI				((1UL<<27)) 		/**< Destination increment*/
+#define GPDMA_DMACCxControl_Prot1			((1UL<<28)) 		/**< Privileged mode */
+#define GPDMA_DMACCxControl_Prot2			((1UL<<29)) 		/**< Bufferable */
+#define GPDMA_DMACCxControl_Prot3			((1UL<<30)) 		/**< Cacheable */
+#define GPDMA_DMACCxControl_I				((1UL<<31)) 		/**< Terminal count interrupt enable bit */
+#define GPDMA_DMACCxControl_BITMASK			((0xFCFFFFFF))
+/** Extract source transfer width field from a control word */
+#define GPDMA_DMACCxControl_GetSWidth(n)	((n>>18)&0x07)
+/** Extract destination transfer width field from a control word */
+#define GPDMA_DMACCxControl_GetDWidth(n)	((n>>21)&0x07)
+
+/*********************************************************************//**
+ * Macro defines for DMA Channel Configuration registers
+ **********************************************************************/
+#define GPDMA_DMACCxConfig_E 					((1UL<<0))			/**< DMA control enable*/
+#define GPDMA_DMACCxConfig_SrcPeripheral(n) 	(((n&0x1F)<<1)) 	/**< Source peripheral*/
+#define GPDMA_DMACCxConfig_DestPeripheral(n) 	(((n&0x1F)<<6)) 	/**< Destination peripheral*/
+#define GPDMA_DMACCxConfig_TransferType(n) 		(((n&0x7)<<11)) 	/**< This value indicates the type of transfer*/
+#define GPDMA_DMACCxConfig_IE 					((1UL<<14))			/**< Interrupt error mask*/
+#define GPDMA_DMACCxConfig_ITC 					((1UL<<15)) 		/**< Terminal count interrupt mask*/
+#define GPDMA_DMACCxConfig_L 					((1UL<<16)) 		/**< Lock*/
+#define GPDMA_DMACCxConfig_A 					((1UL<<17)) 		/**< Active*/
+#define GPDMA_DMACCxConfig_H 					((1UL<<18)) 		/**< Halt*/
+#define GPDMA_DMACCxConfig_BITMASK				((0x7FFFF))
+
+/* ---------------- CHECK PARAMETER DEFINITIONS ---------------------------- */
+/* Macros check GPDMA channel */
+#define PARAM_GPDMA_CHANNEL(n)	(n<=7)
+
+/* Macros check GPDMA connection type */
+#define PARAM_GPDMA_CONN(n)		((n<=GPDMA_CONN_MAT3_1))
+
+/* Macros check GPDMA burst size type */
+#define PARAM_GPDMA_BSIZE(n)	((n==GPDMA_BSIZE_1) || (n==GPDMA_BSIZE_4) \
+|| (n==GPDMA_BSIZE_8) || (n==GPDMA_BSIZE_16) \
+|| (n==GPDMA_BSIZE_32) || (n==GPDMA_BSIZE_64) \
+|| (n==GPDMA_BSIZE_128) || (n==GPDMA_BSIZE_256))
+
+/* Macros check GPDMA width type */
+#define PARAM_GPDMA_WIDTH(n) ((n==GPDMA_WIDTH_BYTE) || (n==GPDMA_WIDTH_HALFWORD) \
+|| (n==GPDMA_WIDTH_WORD))
+
+/* Macros check GPDMA status type */
+#define PARAM_GPDMA_STAT(n)	((n==GPDMA_STAT_INT) || (n==GPDMA_STAT_INTTC) \
+|| (n==GPDMA_STAT_INTERR) || (n==GPDMA_STAT_RAWINTTC) \
+|| (n==GPDMA_STAT_RAWINTERR) || (n==GPDMA_STAT_ENABLED_CH))
+
+/* Macros check GPDMA transfer type */
+#define PARAM_GPDMA_TRANSFERTYPE(n) ((n==GPDMA_TRANSFERTYPE_M2M)||(n==GPDMA_TRANSFERTYPE_M2P) \
+||(n==GPDMA_TRANSFERTYPE_P2M)||(n==GPDMA_TRANSFERTYPE_P2P))
+
+/* Macros check GPDMA state clear type */
+#define PARAM_GPDMA_STATCLR(n) ((n==GPDMA_STATCLR_INTTC) || (n==GPDMA_STATCLR_INTERR))
+
+/* Macros check GPDMA allocation priority */
+#define PARAM_GPDMA_PRIO(n)		((n==GPDMA_PRIO_HIGH) || (n==GPDMA_PRIO_LOW))
+
+/**
+ * @}
+ */
+
+
+/* Public Types --------------------------------------------------------------- */
+/** @defgroup GPDMA_Public_Types GPDMA Public Types
+ * @{
+ */
+
+/**
+ * @brief GPDMA Status enumeration
+ */
+typedef enum {
+	GPDMA_STAT_INT,			/**< GPDMA Interrupt Status */
+	GPDMA_STAT_INTTC,		/**< GPDMA Interrupt Terminal Count Request Status */
+	GPDMA_STAT_INTERR,		/**< GPDMA Interrupt Error Status */
+	GPDMA_STAT_RAWINTTC,	/**< GPDMA Raw Interrupt Terminal Count Status */
+	GPDMA_STAT_RAWINTERR,	/**< GPDMA Raw Error Interrupt Status */
+	GPDMA_STAT_ENABLED_CH	/**< GPDMA Enabled Channel Status */
+} GPDMA_Status_Type;
+
+/**
+ * @brief GPDMA Interrupt clear status enumeration
+ */
+typedef enum{
+	GPDMA_STATCLR_INTTC,	/**< GPDMA Interrupt Terminal Count Request Clear */
+	GPDMA_STATCLR_INTERR	/**< GPDMA Interrupt Error Clear */
+}GPDMA_StateClear_Type;
+
+/**
+ * @brief GPDMA Channel configuration structure type definition
+ */
+typedef struct {
+	uint32_t ChannelNum;	/**< DMA channel number, should be in
+								range from 0 to 7.
+								Note: DMA channel 0 has the highest priority
+								and DMA channel 7 the lowest priority.
+								*/
+	uint32_t TransferSize;	/**< Length/Size of transfer */
+	uint32_t TransferWidth;	/**< Transfer width - used for TransferType is GPDMA_TRANSFERTYPE_M2M only */
+	uint32_t SrcMemAddr;	/**< Physical Source Address, used in case TransferType is chosen as
+								 GPDMA_TRANSFERTYPE_M2M or GPDMA_TRANSFERTYPE_M2P */
+	uint32_t DstMemAddr;	/**< Physical Destination Address, used in case TransferType is chosen as
+								 GPDMA_TRANSFERTYPE_M2M or GPDMA_TRANSFERTYPE_P2M */
+	uint32_t TransferType;	/**< Transfer Type, should be one of the following:
+							- GPDMA_TRANSFERTYPE_M2M: Memory to memory - DMA control
+							- GPDMA_TRANSFERTYPE_M2P: Memory to peripheral - DMA control
+							- GPDMA_TRANSFERTYPE_P2M: Peripheral to memory - DMA control
+							- GPDMA_TRANSFERTYPE_P2P: Source peripheral to destination peripheral - DMA control
+							*/
+	uint32_t SrcConn;		/**< Peripheral Source Connection type, used in case TransferType is chosen as
+							GPDMA_TRANSFERTYPE_P2M or GPDMA_TRANSFERTYPE_P2P, should be one of
+							the GPDMA_CONN_x values */
+	uint32_t DstConn;		/**< Peripheral Destination Connection type, used in case TransferType is chosen as
+							GPDMA_TRANSFERTYPE_M2P or GPDMA_TRANSFERTYPE_P2P, should be one of
+							the GPDMA_CONN_x values */
+	uint32_t DMALLI;		/**< Linker List Item structure data address
+							if there's no Linker List, set as '0'
+							*/
+} GPDMA_Channel_CFG_Type;
+
+/**
+ * @brief GPDMA Linker List Item structure type definition
+ * Note: must be word aligned, the hardware fetches it as 4 words
+ */
+typedef struct {
+	uint32_t SrcAddr;	/**< Source Address */
+	uint32_t DstAddr;	/**< Destination address */
+	uint32_t NextLLI;	/**< Next LLI address, otherwise set to '0' */
+	uint32_t Control;	/**< GPDMA Control of this LLI */
+} GPDMA_LLI_Type;
+
+/**
+ * @brief GPDMA channel callback, called from DMA_IRQHandler with
+ * the channel number and GPDMA_CB_DONE or GPDMA_CB_ERROR
+ */
+typedef void (*GPDMA_Callback_Type)(uint32_t ChannelNum, uint32_t Status);
+
+/**
+ * @}
+ */
+
+
+/* Public Functions ----------------------------------------------------------- */
+/** @defgroup GPDMA_Public_Functions GPDMA Public Functions
+ * @{
+ */
+
+/* GPDMA Init/Setup functions -------------------------------------------------*/
+void GPDMA_Init(void);
+Status GPDMA_Setup(GPDMA_Channel_CFG_Type *GPDMAChannelConfig);
+Status GPDMA_SetupLLI(GPDMA_Channel_CFG_Type *GPDMAChannelConfig, GPDMA_LLI_Type *pLLI);
+void GPDMA_ChannelCmd(uint8_t channelNum, FunctionalState NewState);
+uint32_t GPDMA_GetPeriphAddr(uint32_t Conn);
+
+/* GPDMA Channel allocator ----------------------------------------------------*/
+int32_t GPDMA_ChannelAlloc(uint32_t Priority);
+void GPDMA_ChannelFree(uint8_t channelNum);
+void GPDMA_SetCallback(uint8_t channelNum, GPDMA_Callback_Type Callback);
+
+/* GPDMA Linked List functions ------------------------------------------------*/
+uint32_t GPDMA_MakeControl(uint32_t TransferType, uint32_t SrcConn, uint32_t DstConn,
+						uint32_t TransferWidth);
+uint32_t GPDMA_BuildLLI(GPDMA_LLI_Type *pLLI, uint32_t NumLLI, uint32_t SrcAddr,
+						uint32_t DstAddr, uint32_t Count, uint32_t Control);
+
+/* GPDMA Interrupt status functions -------------------------------------------*/
+IntStatus GPDMA_IntGetStatus(GPDMA_Status_Type type, uint8_t channel);
+void GPDMA_ClearIntPending(GPDMA_StateClear_Type type, uint8_t channel);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* LPC17XX_GPDMA_H_ */
+
+/**
+ * @}
+ */
+
+/* --------------------------------- End Of File ------------------------------ */
@@ -45,6 +45,22 @@ uint16_t I2C_Tx_Buf[BUFFER_SIZE];
 uint16_t I2C_Rx_Buf[BUFFER_SIZE];
 #endif
 
+/******************************************************************************/
+/*                       I2C Job Queue                                        */
+/******************************************************************************/
+#define 	I2C_JOB_TIMEOUT		25			// ms a job may hold the bus, retries included
+#define 	I2C_JOB_RETRIES		3			// Restarts after NACK or arbitration loss
+#define 	I2C_RECOVERY_CLOCKS	9			// SCL pulses to make a slave release SDA
+
+/** I2C job status */
+#define I2C_JOB_IDLE		0		/**< Not submitted */
+#define I2C_JOB_QUEUED		1		/**< Waiting for the bus */
+#define I2C_JOB_ACTIVE		2		/**< Being transferred */
+#define I2C_JOB_DONE		3		/**< All bytes transferred */
+#define I2C_JOB_NACK		4		/**< Slave did not acknowledge */
+#define I2C_JOB_TIMEOUT_ERR	5		/**< Timed out, bus was recovered */
+#define I2C_JOB_ERROR		6		/**< Arbitration lost or bus error */
+
 
 /**
  * @}
@@ -331,6 +347,38 @@ typedef enum {
 	I2C_TRANSFER_INTERRUPT			/**< Transfer in interrupt mode */
 } I2C_TRANSFER_OPT_Type;
 
+struct I2C_JOB;
+
+/**
+ * @brief I2C job completion callback, called from I2Cx_IRQHandler or,
+ * after a timeout or a bus error, from the SWTIMER dispatch context;
+ * may submit further jobs
+ */
+typedef void (*I2C_JobCallback_Type)(struct I2C_JOB *job);
+
+/**
+ * @brief Asynchronous I2C master transaction: tx_length bytes are written,
+ * then rx_length bytes are read after a repeated start. The structure
+ * and its buffers belong to the driver from I2C_JobSubmit() until the
+ * callback runs.
+ */
+typedef struct I2C_JOB {
+	struct I2C_JOB *next;			/**< Queue link, used by the driver */
+	uint8_t sl_addr7bit;			/**< Slave address in 7bit mode */
+	const uint8_t *tx_data;			/**< Bytes to write, e.g. register address */
+	uint32_t tx_length;				/**< Number of bytes to write, may be 0 */
+	uint8_t *rx_data;				/**< Bytes read back */
+	uint32_t rx_length;				/**< Number of bytes to read, may be 0 */
+	uint32_t tx_count;				/**< Bytes written, set by the driver */
+	uint32_t rx_count;				/**< Bytes read, set by the driver */
+	uint8_t Retries;				/**< Restarts allowed, 0 for I2C_JOB_RETRIES */
+	uint16_t Timeout;				/**< Limit in ms, 0 for I2C_JOB_TIMEOUT */
+	I2C_JobCallback_Type Callback;	/**< Completion callback, may be NULL */
+	void *Arg;						/**< User data for the callback */
+	uint8_t Code;					/**< Last I2STAT code, set by the driver */
+	__IO uint32_t status;			/**< I2C_JOB_x */
+} I2C_JOB_Type;
+
 
 /**
  * @}
@@ -373,6 +421,10 @@ void I2C_IntCmd (LPC_I2C_TypeDef *I2Cx, Bool NewState);
 void I2C_MasterHandler (LPC_I2C_TypeDef *I2Cx);
 void I2C_SlaveHandler (LPC_I2C_TypeDef *I2Cx);
 
+/* I2C job queue functions -------------*/
+Status I2C_JobSubmit(LPC_I2C_TypeDef *I2Cx, I2C_JOB_Type *job);
+Bool I2C_JobBusy(LPC_I2C_TypeDef *I2Cx);
+
 
 /**
  * @}
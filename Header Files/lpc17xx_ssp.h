@@ -46,6 +46,24 @@ uint16_t Rx_Buf1[BUFFER_SIZE1];
 #endif
 
 
+/******************************************************************************/
+/*                       SSP Job Mode                                         */
+/******************************************************************************/
+#define 	SSP_JOB_DMA_SEL		DISABLE		// Move job frames with GPDMA instead of the SSP interrupt
+#define 	SSP_JOB_DMA_MIN		16			// Shorter jobs use the interrupt even in DMA mode
+
+#if SSP_JOB_DMA_SEL
+	#define SSP_JOB_DMA_MODE
+#endif
+
+/** SSP job status */
+#define SSP_JOB_IDLE		0		/**< Not submitted */
+#define SSP_JOB_QUEUED		1		/**< Waiting for the bus */
+#define SSP_JOB_ACTIVE		2		/**< Being transferred */
+#define SSP_JOB_DONE		3		/**< All frames transferred */
+#define SSP_JOB_ERROR		4		/**< Receive overrun or DMA error */
+
+
 /*********************************************************************//**
  * SSP configuration parameter defines
  **********************************************************************/
@@ -405,6 +423,33 @@ typedef struct {
 	uint32_t status;			/**< Current status of SSP activity */
 } SSP_DATA_SETUP_Type;
 
+struct SSP_JOB;
+
+/**
+ * @brief SSP job completion callback, called from SSPx_IRQHandler or
+ * DMA_IRQHandler; may submit further jobs
+ */
+typedef void (*SSP_JobCallback_Type)(struct SSP_JOB *job);
+
+/**
+ * @brief Asynchronous SSP transaction. The structure and its buffers
+ * belong to the driver from SSP_JobSubmit() until the callback runs.
+ * Buffers hold uint8_t frames up to 8 bits, uint16_t frames above.
+ */
+typedef struct SSP_JOB {
+	struct SSP_JOB *next;			/**< Queue link, used by the driver */
+	uint8_t CsPort;					/**< GPIO port of the active low chip select */
+	uint32_t CsPin;					/**< Chip select pin mask, 0 if none */
+	uint32_t Databit;				/**< Frame size, should be SSP_DATABIT_x */
+	const void *tx_data;			/**< Frames to send, NULL sends all ones */
+	void *rx_data;					/**< Received frames, NULL discards them */
+	uint32_t length;				/**< Number of frames */
+	Bool KeepCs;					/**< TRUE: leave chip select asserted for the next job */
+	SSP_JobCallback_Type Callback;	/**< Completion callback, may be NULL */
+	void *Arg;						/**< User data for the callback */
+	__IO uint32_t status;			/**< SSP_JOB_x */
+} SSP_JOB_Type;
+
 
 /**
  * @}
@@ -445,6 +490,10 @@ uint16_t SSP_ReceiveData(LPC_SSP_TypeDef* SSPx);
 int32_t SSP_ReadWrite (LPC_SSP_TypeDef *SSPx, SSP_DATA_SETUP_Type *dataCfg, \
 						SSP_TRANSFER_Type xfType);
 
+/* SSP asynchronous job functions ---------------------------------------------*/
+Status SSP_JobSubmit(LPC_SSP_TypeDef *SSPx, SSP_JOB_Type *job);
+Bool SSP_JobBusy(LPC_SSP_TypeDef *SSPx);
+
 /* SSP IRQ function ------------------------------------------------------------*/
 void SSP_IntConfig(LPC_SSP_TypeDef *SSPx, uint32_t IntType, FunctionalState NewState);
 void SSP_ClearIntPending(LPC_SSP_TypeDef *SSPx, uint32_t IntType);
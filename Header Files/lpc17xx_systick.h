@@ -69,6 +69,7 @@ extern "C"
  */
 
 void delay_ms (uint32_t dly_ticks);  
+void SYSTICK_Idle(void);
 void SYSTICK_Config(void);
 void SYSTICK_InternalInit(uint32_t time);
 void SYSTICK_ExternalInit(uint32_t freq, uint32_t time);
@@ -76,6 +77,7 @@ void SYSTICK_ExternalInit(uint32_t freq, uint32_t time);
 void SYSTICK_Cmd(FunctionalState NewState);
 void SYSTICK_IntCmd(FunctionalState NewState);
 uint32_t SYSTICK_GetCurrentValue(void);
+uint32_t SYSTICK_GetTick(void);
 void SYSTICK_ClearCounterFlag(void);
 
 /**
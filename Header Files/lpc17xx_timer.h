@@ -19,6 +19,7 @@
 /* Includes ------------------------------------------------------------------- */
 #include "LPC17xx.h"
 #include "lpc_types.h"
+#include "lpc_timebase.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -123,6 +124,9 @@ extern "C"
 #define PARAM_TIMx(n)	((((uint32_t *)n)==((uint32_t *)LPC_TIM0)) || (((uint32_t *)n)==((uint32_t *)LPC_TIM1)) \
 || (((uint32_t *)n)==((uint32_t *)LPC_TIM2)) || (((uint32_t *)n)==((uint32_t *)LPC_TIM3)))
 
+/* Macro check TIMER is not the one kept running by the timebase */
+#define PARAM_TIM_FREE(n)	(((uint32_t *)n)!=((uint32_t *)TIMEBASE_TIM))
+
 /* Macro check interrupt type */
 #define PARAM_TIM_INT_TYPE(TYPE)	((TYPE ==TIM_MR0_INT)||(TYPE ==TIM_MR1_INT)\
 ||(TYPE ==TIM_MR2_INT)||(TYPE ==TIM_MR3_INT)\
@@ -301,11 +305,11 @@ typedef struct {
  * @{
  */
 /* Init TIM Configuration functions -----------*/
-void TIM_Config(LPC_TIM_TypeDef *TIMx, TIM_PCFG_TYPE PCfg);
+Status TIM_Config(LPC_TIM_TypeDef *TIMx, TIM_PCFG_TYPE PCfg);
 
 /* Init/DeInit TIM functions -----------*/
-void TIM_Init(LPC_TIM_TypeDef *TIMx, TIM_MODE_OPT TimerCounterMode, void *TIM_ConfigStruct);
-void TIM_DeInit(LPC_TIM_TypeDef *TIMx);
+Status TIM_Init(LPC_TIM_TypeDef *TIMx, TIM_MODE_OPT TimerCounterMode, void *TIM_ConfigStruct);
+Status TIM_DeInit(LPC_TIM_TypeDef *TIMx);
 
 /* TIM interrupt functions -------------*/
 void TIM_ClearIntPending(LPC_TIM_TypeDef *TIMx, TIM_INT_TYPE IntFlag);
@@ -326,9 +330,7 @@ void TIM_ResetCounter(LPC_TIM_TypeDef *TIMx);
 
 /* Micro sec funtion --------------*/
 void US_TimerInit(void);
-inline void US_TimerStop(void);
-uint32_t US_TimerRead();
-void delay_us(uint32_t us);
+uint32_t US_TimerRead(void);
 
 /**
  * @}
@@ -65,6 +65,8 @@ extern "C"
 #define 	INTERRUPT_SEL     ENABLE
 #define     AB_SEL            DISABLE
 #define     RTC_SUPPORT       DISABLE
+#define     TX_DMA_SEL        DISABLE      // Drain Tx ring with GPDMA instead of THRE interrupt
+#define     TX_FULL_POLICY    UART_TX_FULL_BLOCK  // Tx ring full: BLOCK, DROP or OVERWRITE oldest
 
 /******************************************************************************/
 /*                       UART Mode validation                                 */
@@ -90,53 +92,99 @@ extern "C"
 	#include "lpc17xx_rtc.h"
 #endif
 
+#if TX_DMA_SEL
+	#define UART_TX_DMA_MODE
+#endif
+
 
 /******************************************************************************/
 /*                       UART Buffer Definition                               */
 /******************************************************************************/
-/* buffer size definition */
-#define UART_RING_BUFSIZE 256
+/* Ring sizes per port, power of two (each port has one Tx and one Rx ring) */
+#define UART0_RING_BUFSIZE	256
+#define UART1_RING_BUFSIZE	64
+#define UART2_RING_BUFSIZE	256
+#define UART3_RING_BUFSIZE	256
+
+/* Number of UART ports served by the driver */
+#define UART_NUM_PORTS		4
 
-/* Buf mask */
-#define __BUF_MASK (UART_RING_BUFSIZE-1)
 /* Check buf is full or not */
-#define __BUF_IS_FULL(head, tail) ((tail&__BUF_MASK)==((head+1)&__BUF_MASK))
+#define __BUF_IS_FULL(head, tail, mask) ((tail&mask)==((head+1)&mask))
 /* Check buf will be full in next receiving or not */
-#define __BUF_WILL_FULL(head, tail) ((tail&__BUF_MASK)==((head+2)&__BUF_MASK))
+#define __BUF_WILL_FULL(head, tail, mask) ((tail&mask)==((head+2)&mask))
 /* Check buf is empty */
-#define __BUF_IS_EMPTY(head, tail) ((head&__BUF_MASK)==(tail&__BUF_MASK))
+#define __BUF_IS_EMPTY(head, tail, mask) ((head&mask)==(tail&mask))
 /* Reset buf */
 #define __BUF_RESET(bufidx)	(bufidx=0)
-#define __BUF_INCR(bufidx)	(bufidx=(bufidx+1)&__BUF_MASK)
+#define __BUF_INCR(bufidx, mask)	(bufidx=(bufidx+1)&mask)
+
+/* Tx ring full policy, used by UART_Send() in BLOCKING mode */
+#define UART_TX_FULL_BLOCK		0	/* Wait for room (drops when called from an interrupt) */
+#define UART_TX_FULL_DROP		1	/* Drop the bytes that do not fit */
+#define UART_TX_FULL_OVERWRITE	2	/* Drop the oldest queued bytes (drops in DMA mode) */
+
+/* printf() queues its output in spans of this size */
+#define UART_PRINTF_SPAN		32
+
+/* UART_Receive() TIME_BLOCKING deadline in SysTick ticks (ms) */
+#define UART_RX_TIMEOUT_MS		1000
+/* UART_ReceiveTimeout() without deadline */
+#define UART_WAIT_FOREVER		(0xFFFFFFFFUL)
 
 /************************** BUFFER TYPES *************************/
 
 /** @brief UART Ring buffer structure */
 typedef struct
 {
+    __IO uint8_t  *tx;                    /*!< UART Tx data ring buffer */
+    __IO uint8_t  *rx;                    /*!< UART Rx data ring buffer */
+    uint32_t tx_mask;                     /*!< UART Tx ring buffer size - 1 */
+    uint32_t rx_mask;                     /*!< UART Rx ring buffer size - 1 */
     __IO uint32_t tx_head;                /*!< UART Tx ring buffer head index */
     __IO uint32_t tx_tail;                /*!< UART Tx ring buffer tail index */
     __IO uint32_t rx_head;                /*!< UART Rx ring buffer head index */
     __IO uint32_t rx_tail;                /*!< UART Rx ring buffer tail index */
-    __IO uint8_t  tx[UART_RING_BUFSIZE];  /*!< UART Tx data ring buffer */
-    __IO uint8_t  rx[UART_RING_BUFSIZE];  /*!< UART Rx data ring buffer */
+    __IO FlagStatus tx_busy;              /*!< Tx ring is being drained (THRE interrupt or DMA) */
+    __IO uint32_t tx_drop;                /*!< Bytes dropped because the Tx ring was full */
+    __IO uint32_t rx_drop;                /*!< Bytes dropped because the Rx ring was full */
+#ifdef UART_TX_DMA_MODE
+    int32_t  tx_dma_ch;                   /*!< GPDMA channel draining the Tx ring, -1 if none */
+    uint32_t tx_dma_len;                  /*!< Bytes of the current Tx DMA transfer */
+#endif
 } UART_RING_BUFFER_T;
 
+/** @brief UART port descriptor, one per UART peripheral */
+typedef struct
+{
+    LPC_UART_TypeDef   *UARTx;            /*!< UART peripheral (LPC_UART1 cast) */
+    IRQn_Type           IRQn;             /*!< UART interrupt */
+    uint32_t            IntPrio;          /*!< NVIC priority set by UART_Config() */
+    uint32_t            TxConn;           /*!< GPDMA connection of the Tx FIFO */
+    UART_RING_BUFFER_T  rb;               /*!< Tx and Rx rings */
+    __IO uint8_t        TrgLvl;           /*!< Rx FIFO trigger level in characters */
+    __IO uint32_t       RxCount;          /*!< Bytes received */
+    __IO uint32_t       RxTick;           /*!< SysTick tick of the last received byte */
+    __IO uint32_t       RxStamp;          /*!< now_us() of the last received byte */
+    __IO uint32_t       OverrunErr;       /*!< Rx FIFO overruns */
+    __IO uint32_t       ParityErr;        /*!< Characters with parity error (discarded) */
+    __IO uint32_t       FramingErr;       /*!< Characters with framing error (discarded) */
+    __IO uint32_t       BreakCnt;         /*!< Break conditions */
+    __IO uint32_t       TxCount;          /*!< Bytes queued for transmission */
+    __IO uint8_t        ModemStat;        /*!< Last modem status (UART1 only) */
+    __IO uint32_t       ModemEvents;      /*!< Modem status interrupts (UART1 only) */
+} UART_PORT_Type;
+
 
 /*
  * Variables
  */
 
 extern uint16 EscFlag;
-Bool UART0_RxReady,UART2_RxReady;
-extern uchar TTrgLvlU0,TrgLvlU2;
-// UART Ring buffer
 
-UART_RING_BUFFER_T rb0;
-UART_RING_BUFFER_T rb2;
+// UART port descriptors, indexed by UART number
+extern UART_PORT_Type UART_Port[UART_NUM_PORTS];
 
-// Current Tx Interrupt enable state
-__IO FlagStatus TxIntStat;
 
 #ifdef AB_MODE
 /* Synchronous Flag */
@@ -683,9 +731,13 @@ uint8_t UART_ReceiveByte(LPC_UART_TypeDef* UARTx);
 #ifdef POLLING_MODE
 uint32_t UART_Send(LPC_UART_TypeDef *UARTx, uint8_t *txbuf,
 		uint32_t buflen, TRANSFER_BLOCK_Type flag);
+#endif
 uint32_t UART_Receive(LPC_UART_TypeDef *UARTx, uint8_t *rxbuf, \
 		uint32_t buflen, TRANSFER_BLOCK_Type flag);
-#endif
+uint32_t UART_ReceiveTimeout(LPC_UART_TypeDef *UARTx, uint8_t *rxbuf, \
+		uint32_t buflen, uint32_t timeout, uint32_t gap);
+void UART_TxFlush(LPC_UART_TypeDef *UARTx);
+UART_PORT_Type *UART_GetPort(LPC_UART_TypeDef *UARTx);
 
 int16 getche(LPC_UART_TypeDef *UARTx, TRANSFER_BLOCK_Type mode);
 uchar get_line(LPC_UART_TypeDef *UARTx, schar s[], uchar lim);
@@ -734,7 +786,6 @@ void UART_IrDAPulseDivConfig(LPC_UART_TypeDef *UARTx, UART_IrDA_PULSE_Type Pulse
 #ifdef INTERRUPT_MODE
 uint32_t UART_Send(LPC_UART_TypeDef *UARTx, uint8_t *txbuf,
 		uint32_t buflen, TRANSFER_BLOCK_Type flag);
-uint32_t UART_Receive(LPC_UART_TypeDef *UARTx, uint8_t *rxbuf,uint32_t buflen, TRANSFER_BLOCK_Type flag);
 #endif
 
 /* UART VT100 Terminal functions--------------------------------------------------------*/
@@ -0,0 +1,88 @@
+/******************************************************************//**
+* @file		lpc_crc.h
+* @brief	Contains all macro definitions and function prototypes
+* 			support for the shared CRC-32, CRC-16-CCITT and CRC-7 engine
+* @version	1.0
+* @date		16. June. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* Peripheral group ----------------------------------------------------------- */
+/** @defgroup CRC CRC
+ * @ingroup LPC1700CMSIS_FwLib_Drivers
+ * @{
+ */
+
+#ifndef LPC_CRC_H_
+#define LPC_CRC_H_
+
+/* Includes ------------------------------------------------------------------- */
+#include "lpc_types.h"
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/* Public Macros -------------------------------------------------------------- */
+/** @defgroup CRC_Public_Macros CRC Public Macros
+ * @{
+ */
+
+/******************************************************************************/
+/*                       Table Size Select                                    */
+/******************************************************************************/
+#ifndef CRC_FAST_SEL				// the build may set it, e.g. -DCRC_FAST_SEL=0
+#define 	CRC_FAST_SEL       1	// 1: byte tables, slicing-by-4 CRC-32 (~4.8kB flash)
+									// 0: nibble tables (~100 bytes flash), about 3x slower
+#endif
+
+#if CRC_FAST_SEL
+	#define CRC_FAST_MODE
+#endif
+
+/* CRC-32 (IEEE 802.3, reflected, polynomial 0x04C11DB7) */
+#define CRC32_INIT			0xFFFFFFFFUL	/**< Start value for CRC32_Update() */
+#define CRC32_FINAL(crc)	((crc) ^ 0xFFFFFFFFUL)	/**< Turn a running CRC into the FCS value */
+
+/* CRC-16-CCITT (XModem / SD data block, polynomial 0x1021) */
+#define CRC16_INIT			0x0000			/**< Start value for CRC16_Update() */
+
+/* CRC-7 (SD command token, polynomial x^7 + x^3 + 1) */
+#define CRC7_INIT			0x00			/**< Start value for CRC7_Update() */
+
+/**
+ * @}
+ */
+
+
+/* Public Functions ----------------------------------------------------------- */
+/** @defgroup CRC_Public_Functions CRC Public Functions
+ * @{
+ */
+
+uint32_t CRC32_Update (uint32_t crc, const uint8_t *data, uint32_t len);
+uint32_t CRC32_Calc (const uint8_t *data, uint32_t len);
+uint16_t CRC16_Update (uint16_t crc, const uint8_t *data, uint32_t len);
+uint16_t CRC16_Calc (const uint8_t *data, uint32_t len);
+uint8_t CRC7_Update (uint8_t crc, const uint8_t *data, uint32_t len);
+uint8_t CRC7_Calc (const uint8_t *data, uint32_t len);
+
+/**
+ * @}
+ */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LPC_CRC_H_ */
+
+/**
+ * @}
+ */
+
+/* --------------------------------- End Of File ------------------------------ */
@@ -0,0 +1,95 @@
+/******************************************************************//**
+* @file		lpc_eeprom.h
+* @brief	Contains all macro definitions and function prototypes
+* 			support for the common I2C/SPI serial E2PROM engine
+* @version	1.0
+* @date		25. June. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* Peripheral group ----------------------------------------------------------- */
+/** @defgroup E2P E2P
+ * @ingroup LPC1700CMSIS_FwLib_Drivers
+ * @{
+ */
+
+#ifndef LPC_EEPROM_H_
+#define LPC_EEPROM_H_
+
+/* Includes ------------------------------------------------------------------- */
+#include "LPC17xx.h"
+#include "lpc_types.h"
+#include "lpc17xx_i2c.h"
+#include "lpc17xx_systick.h"
+#include "lpc_spi_bus.h"
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/* Public Macros -------------------------------------------------------------- */
+/** @defgroup E2P_Public_Macros E2P Public Macros
+ * @{
+ */
+
+/** Largest write page handled, M24256 */
+#define E2P_MAX_PAGE			64
+
+/**
+ * @}
+ */
+
+
+/* Public Types --------------------------------------------------------------- */
+/** @defgroup E2P_Public_Types E2P Public Types
+ * @{
+ */
+
+/**
+ * @brief Serial E2PROM part. I2C parts with one address byte take the
+ * higher address bits in the slave address (AT24C16 block select), SPI
+ * parts with one address byte take A8 in bit 3 of the opcode.
+ */
+typedef struct {
+	LPC_I2C_TypeDef *I2Cx;		/**< I2C bus, NULL for an SPI part */
+	SPIBUS_DEVICE_Type *Spi;	/**< SPI/SSP device, used when I2Cx is NULL */
+	uint8_t Id;					/**< 7bit slave address of an I2C part */
+	uint8_t AddrBytes;			/**< Address bytes sent, 1 or 2 */
+	uint16_t PageSize;			/**< Write page in bytes, power of two up to E2P_MAX_PAGE */
+	uint32_t Size;				/**< Capacity in bytes */
+	uint16_t WriteTime;			/**< Longest write cycle (tWC) in ms */
+} E2P_DEVICE_Type;
+
+/**
+ * @}
+ */
+
+
+/* Public Functions ----------------------------------------------------------- */
+/** @defgroup E2P_Public_Functions E2P Public Functions
+ * @{
+ */
+
+Status E2P_Write (E2P_DEVICE_Type *dev, uint32_t addr, const uint8_t *data, uint32_t length);
+Status E2P_Read (E2P_DEVICE_Type *dev, uint32_t addr, uint8_t *data, uint32_t length);
+Status E2P_WaitReady (E2P_DEVICE_Type *dev);
+
+/**
+ * @}
+ */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LPC_EEPROM_H_ */
+
+/**
+ * @}
+ */
+
+/* --------------------------------- End Of File ------------------------------ */
@@ -0,0 +1,143 @@
+/******************************************************************//**
+* @file		lpc_fat.h
+* @brief	Contains all macro definitions and function prototypes
+* 			support for the FAT16/FAT32 file system on the SD card
+* @version	1.0
+* @date		18. June. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* Peripheral group ----------------------------------------------------------- */
+/** @defgroup FAT FAT
+ * @ingroup LPC1700CMSIS_FwLib_Drivers
+ * @{
+ */
+
+#ifndef LPC_FAT_H_
+#define LPC_FAT_H_
+
+/* Includes ------------------------------------------------------------------- */
+#include "lpc_types.h"
+#include "lpc_spi_sd.h"
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/* Public Macros -------------------------------------------------------------- */
+/** @defgroup FAT_Public_Macros FAT Public Macros
+ * @{
+ */
+
+/* Sector cache: FAT_CACHE_SECTORS lines of 512 bytes, FAT_CACHE_WAYS lines per set */
+#define FAT_SECTOR_SIZE			512
+#define FAT_CACHE_SECTORS		8			// 4kB of RAM
+#define FAT_CACHE_WAYS			4			// must divide FAT_CACHE_SECTORS
+#define FAT_CACHE_SETS			(FAT_CACHE_SECTORS / FAT_CACHE_WAYS)
+
+#if ((FAT_CACHE_SECTORS % FAT_CACHE_WAYS) != 0)
+	#error FAT_CACHE_WAYS must divide FAT_CACHE_SECTORS
+#endif
+
+/* FAT_Open() mode flags */
+#define FAT_READ				0x01		// read access
+#define FAT_WRITE				0x02		// write access
+#define FAT_APPEND				0x04		// write access, start at end of file
+#define FAT_CREATE				0x08		// create the file if it does not exist
+
+/* Directory entry attributes */
+#define FAT_ATTR_READ_ONLY		0x01
+#define FAT_ATTR_HIDDEN			0x02
+#define FAT_ATTR_SYSTEM			0x04
+#define FAT_ATTR_VOLUME_ID		0x08
+#define FAT_ATTR_DIRECTORY		0x10
+#define FAT_ATTR_ARCHIVE		0x20
+#define FAT_ATTR_LFN			0x0F
+
+/**
+ * @}
+ */
+
+
+/* Public Types --------------------------------------------------------------- */
+/** @defgroup FAT_Public_Types FAT Public Types
+ * @{
+ */
+
+typedef enum _fat_error
+{
+	FAT_OK,
+	FAT_ERR_DISK,				// sector read/write failed
+	FAT_ERR_NO_FS,				// no FAT16/FAT32 volume or corrupt chain
+	FAT_ERR_NOT_FOUND,			// file or directory does not exist
+	FAT_ERR_FULL,				// no free cluster or directory entry
+	FAT_ERR_PARAM,				// bad name, mode or handle
+	FAT_ERR_DENIED				// access not allowed by open mode or attributes
+}fat_error;
+
+/**
+ * @brief Block device the file system runs on, sectors of FAT_SECTOR_SIZE bytes
+ */
+typedef struct {
+	Status (*Read)(uint32_t sector, uint8_t *buf, uint32_t count);			/**< Read count sectors */
+	Status (*Write)(uint32_t sector, const uint8_t *buf, uint32_t count);	/**< Write count sectors */
+} FAT_DISK_Type;
+
+/**
+ * @brief Open file handle, allocated by the caller
+ */
+typedef struct {
+	uint32_t FirstCluster;		/**< First cluster, 0 for an empty file */
+	uint32_t Size;				/**< File size in bytes */
+	uint32_t Pos;				/**< Read/write position */
+	uint32_t Cluster;			/**< Cached cluster of the chain, 0 if none */
+	uint32_t ClusIdx;			/**< Index of Cluster within the chain */
+	uint32_t DirSector;			/**< Sector holding the directory entry */
+	uint16_t DirOffset;			/**< Offset of the entry in that sector */
+	uint8_t  Mode;				/**< FAT_READ/FAT_WRITE/FAT_APPEND, 0 when closed */
+	uint8_t  Dirty;				/**< Directory entry needs updating */
+} FAT_FILE_Type;
+
+/**
+ * @}
+ */
+
+
+/* Public Variables ----------------------------------------------------------- */
+/** SD card as FAT block device */
+extern const FAT_DISK_Type FAT_SdDisk;
+
+
+/* Public Functions ----------------------------------------------------------- */
+/** @defgroup FAT_Public_Functions FAT Public Functions
+ * @{
+ */
+
+fat_error FAT_Mount (const FAT_DISK_Type *disk);
+fat_error FAT_Sync (void);
+fat_error FAT_Open (FAT_FILE_Type *fp, const char *path, uint8_t mode);
+fat_error FAT_Read (FAT_FILE_Type *fp, void *buf, uint32_t len, uint32_t *done);
+fat_error FAT_Write (FAT_FILE_Type *fp, const void *buf, uint32_t len, uint32_t *done);
+fat_error FAT_Seek (FAT_FILE_Type *fp, uint32_t pos);
+fat_error FAT_Flush (FAT_FILE_Type *fp);
+fat_error FAT_Close (FAT_FILE_Type *fp);
+
+/**
+ * @}
+ */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LPC_FAT_H_ */
+
+/**
+ * @}
+ */
+
+/* --------------------------------- End Of File ------------------------------ */
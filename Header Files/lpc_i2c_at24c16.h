@@ -18,6 +18,7 @@
 /* Includes ------------------------------------------------------------------- */
 #include "LPC17xx.h"
 #include "lpc_system_init.h"
+#include "lpc_eeprom.h"
 
 
 #ifdef __cplusplus
@@ -49,6 +50,7 @@ char I2C_Eeprom_Write (uint16_t eep_address, uint8_t* byte_data, uint16_t length
 char I2C_Eeprom_Read (uint16_t eep_address, uint8_t* buf_data, uint16_t length);
 void Display_Eeprom_Array (uint8_t *string, uint16_t length);
 void Display_Eeprom_Loc (uint16 mem_start_address, uint16 mem_end_address);
+E2P_DEVICE_Type *I2C_Eeprom_Device (void);
 
 
 /**
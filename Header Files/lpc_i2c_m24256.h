@@ -18,6 +18,7 @@
 /* Includes ------------------------------------------------------------------- */
 #include "LPC17xx.h"
 #include "lpc_system_init.h"
+#include "lpc_eeprom.h"
 
 
 #ifdef __cplusplus
@@ -49,6 +50,7 @@ char I2C_IEeprom_Write (uint16_t eep_address, uint8_t* byte_data, uint16_t lengt
 char I2C_IEeprom_Read (uint16_t eep_address, uint8_t* buf_data, uint16_t length);
 void Display_IEeprom_Array (uint8_t *string, uint16_t length);
 void Display_IEeprom_Loc (uint16_t mem_start_address, uint16_t mem_end_address);
+E2P_DEVICE_Type *I2C_IEeprom_Device (void);
 
 
 /**
@@ -100,6 +100,8 @@ uchar TMP102_Set_Config(uint16_t val);
 uchar TMP102_Set_Threshold_Value(THRES_Type limit, int16_t deg, BIT_Type res);
 uchar TMP102_Read_Threshold_Value(THRES_Type limit, BIT_Type res);
 uchar TMP102_Read_Temp(BIT_Type res);
+Status TMP102_Sample(void);
+Bool TMP102_Get_Sample(int16_t *val);
 
 /**
  * @}
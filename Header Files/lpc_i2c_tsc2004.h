@@ -18,6 +18,7 @@
 /* Includes ------------------------------------------------------------------- */
 #include "LPC17xx.h"
 #include "lpc_system_init.h"
+#include "lpc17xx_exti.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -79,6 +80,22 @@ extern "C"
 #define MAX_12BIT ((1 << 12) - 1)
 #define MEAS_MASK 0xFFF
 
+/******************************************************************************/
+/*                       Touch Pipeline Config                                */
+/******************************************************************************/
+#define TSC_PENIRQ_LINE			EXTI_EINT2			// PINTDAV on P2.12
+#define TSC_PENIRQ_IRQHandler	EINT2_IRQHandler	// Handler of that line
+#define TSC_EVENT_RING			16					// Events buffered, power of two
+#define TSC_PENUP_TIME			40					// ms without data before pen up
+#define TSC_IIR_SHIFT			1					// IIR weight of a new sample, 1/2^n
+#define TSC_X_PLATE_OHMS		400					// X plate resistance of the panel
+#define TSC_MAX_RT				2000				// Touch resistance above which a sample is dropped
+
+/* Touch event types */
+#define TSC_EV_PRESS			1					// Pen down, first filtered sample
+#define TSC_EV_MOVE				2					// Pen still down, new position
+#define TSC_EV_RELEASE			3					// Pen up, last position
+
 
 /**
  * @}
@@ -145,6 +162,33 @@ typedef struct
 }ts_event;
 
 
+/* Filtered touch event in screen coordinates */
+typedef struct
+{
+	uint16_t x;				/**< Screen column */
+	uint16_t y;				/**< Screen row */
+	uint16_t pressure;		/**< Touch resistance in ohms, lower is harder */
+	uint8_t type;			/**< TSC_EV_x */
+}TSC_EVENT_Type;
+
+
+/* Panel to screen mapping, x = (An*X + Bn*Y + Cn)/Div, y = (Dn*X + En*Y + Fn)/Div */
+typedef struct
+{
+	int32_t An, Bn, Dn, En;
+	int64_t Cn, Fn;
+	int32_t Div;
+}TSC_CAL_Type;
+
+
+/* Calibration point, panel or screen coordinates */
+typedef struct
+{
+	int32_t x;
+	int32_t y;
+}TSC_POINT_Type;
+
+
 /**
  * @}
  */
@@ -163,6 +207,12 @@ uint16_t I2C_TSC2004_Read_Word (uint8_t Command);
 uint16_t TSC2004_Read_Reg (register_address reg);
 void TSC2004_Read_Values (ts_event *tc);
 
+void TSC2004_Start (void);
+Bool TSC2004_GetEvent (TSC_EVENT_Type *ev);
+uint32_t TSC2004_GetDropped (void);
+void TSC2004_SetCalibration (const TSC_CAL_Type *cal);
+Status TSC2004_Calibrate (const TSC_POINT_Type *panel, const TSC_POINT_Type *screen, TSC_CAL_Type *cal);
+
 void TSC2004_Read_Value_Test (void);
 void TSC2004_Draw_Test (void);
 void TSC2004_Slide_Test (void);
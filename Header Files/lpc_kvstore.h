@@ -0,0 +1,111 @@
+/******************************************************************//**
+* @file		lpc_kvstore.h
+* @brief	Contains all macro definitions and function prototypes
+* 			support for the log-structured key/value store on the
+* 			serial E2PROMs
+* @version	1.0
+* @date		27. June. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* Peripheral group ----------------------------------------------------------- */
+/** @defgroup KV KV
+ * @ingroup LPC1700CMSIS_FwLib_Drivers
+ * @{
+ */
+
+#ifndef LPC_KVSTORE_H_
+#define LPC_KVSTORE_H_
+
+/* Includes ------------------------------------------------------------------- */
+#include "LPC17xx.h"
+#include "lpc_types.h"
+#include "lpc_eeprom.h"
+#include "lpc_crc.h"
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/* Public Macros -------------------------------------------------------------- */
+/** @defgroup KV_Public_Macros KV Public Macros
+ * @{
+ */
+
+/** Keys are 0 .. KV_MAX_KEYS-1, the RAM index has one entry per key */
+#define KV_MAX_KEYS				32
+
+/** Largest value in bytes */
+#define KV_MAX_VALUE			32
+
+/** Bank header: magic (2), sequence (4), CRC-16 (2) */
+#define KV_BANK_HDR				8
+
+/** Record header: key (1), length (1), CRC-16 (2), followed by the value */
+#define KV_REC_HDR				4
+
+/**
+ * @}
+ */
+
+
+/* Public Types --------------------------------------------------------------- */
+/** @defgroup KV_Public_Types KV Public Types
+ * @{
+ */
+
+/**
+ * @brief Key/value store in a region of an E2PROM. The region holds two
+ * banks of BankSize bytes, the one with the valid header and the higher
+ * sequence number is in use. Everything but the first three members is
+ * filled in by KV_Init().
+ */
+typedef struct {
+	E2P_DEVICE_Type *Dev;		/**< E2PROM part */
+	uint32_t Base;				/**< First byte of the region */
+	uint32_t BankSize;			/**< Bytes per bank, the region is twice this */
+	uint8_t  Bank;				/**< Bank in use, 0 or 1 */
+	uint32_t Seq;				/**< Sequence number of the bank in use */
+	uint32_t Tail;				/**< Offset in the bank where the next record goes */
+	uint32_t Live;				/**< Bytes of records still referenced by the index */
+	uint32_t Compactions;		/**< Number of bank switches since KV_Init() */
+	uint16_t Index[KV_MAX_KEYS];/**< Offset in the bank of the latest record of a key, 0 if none */
+	uint8_t  Length[KV_MAX_KEYS];/**< Value length of that record */
+} KV_STORE_Type;
+
+/**
+ * @}
+ */
+
+
+/* Public Functions ----------------------------------------------------------- */
+/** @defgroup KV_Public_Functions KV Public Functions
+ * @{
+ */
+
+Status KV_Init (KV_STORE_Type *kv, E2P_DEVICE_Type *dev, uint32_t base, uint32_t bank_size);
+Status KV_Format (KV_STORE_Type *kv);
+Status KV_Set (KV_STORE_Type *kv, uint8_t key, const void *data, uint8_t length);
+uint8_t KV_Get (KV_STORE_Type *kv, uint8_t key, void *data, uint8_t size);
+Status KV_Delete (KV_STORE_Type *kv, uint8_t key);
+uint32_t KV_Free (KV_STORE_Type *kv);
+
+/**
+ * @}
+ */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LPC_KVSTORE_H_ */
+
+/**
+ * @}
+ */
+
+/* --------------------------------- End Of File ------------------------------ */
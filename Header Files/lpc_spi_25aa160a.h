@@ -18,6 +18,8 @@
 /* Includes ------------------------------------------------------------------- */
 #include "LPC17xx.h"
 #include "lpc_system_init.h"
+#include "lpc_spi_bus.h"
+#include "lpc_eeprom.h"
 
 
 #ifdef __cplusplus
@@ -26,6 +28,21 @@ extern "C"
 #endif
 
 
+/******************************************************************************/
+/*                       Chip Select                                          */
+/******************************************************************************/
+#define 	EEP_CS_SEL		0		// 0: P0.16, shared with the SD card as wired on the board
+									// 1: P4.28, needs a board rework, MAT2.0 is then unusable
+
+#if EEP_CS_SEL
+	#define EEP_CS_PORT		4
+	#define EEP_CS_PIN		_BIT(28)
+#else
+	#define EEP_CS_PORT		0
+	#define EEP_CS_PIN		_BIT(16)
+#endif
+
+
 /* Public Macros -------------------------------------------------------------- */
 /** @defgroup EEPROM_Public_Macros
  * @{
@@ -38,6 +55,8 @@ extern "C"
 #define EEP_RDSR   0x05;  /* Read Status Reg     */
 #define EEP_WRSR   0x01;  /* Write Status Reg    */
 
+#define EEP_MAX_CLOCK	5000000		/* SCK limit at 2.5V..4.5V */
+
 /**
  * @}
  */
@@ -58,6 +77,7 @@ uint8_t Spi_Eeprom_Read_Byte (uint16 eep_address);
 uchar Spi_Eeprom_Read (uint16_t eep_address, uint8_t *dest_addr, uint8_t length);
 void Display_Eeprom_Array (uint8_t *string, uint8_t length);
 void Display_Eeprom_Loc (uint16 mem_start_address, uint16 mem_end_address);
+E2P_DEVICE_Type *Spi_Eeprom_Device (void);
 
 /**
  * @}
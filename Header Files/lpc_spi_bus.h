@@ -0,0 +1,111 @@
+/******************************************************************//**
+* @file		lpc_spi_bus.h
+* @brief	Contains all macro definitions and function prototypes
+* 			support for the shared SPI/SSP bus manager
+* @version	1.0
+* @date		23. June. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* Peripheral group ----------------------------------------------------------- */
+/** @defgroup SPIBUS SPIBUS
+ * @ingroup LPC1700CMSIS_FwLib_Drivers
+ * @{
+ */
+
+#ifndef LPC_SPI_BUS_H_
+#define LPC_SPI_BUS_H_
+
+/* Includes ------------------------------------------------------------------- */
+#include "LPC17xx.h"
+#include "lpc_types.h"
+#include "lpc17xx_spi.h"
+#include "lpc17xx_ssp.h"
+#include "lpc17xx_gpio.h"
+#include "lpc17xx_clkpwr.h"
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/* Public Macros -------------------------------------------------------------- */
+/** @defgroup SPIBUS_Public_Macros SPIBUS Public Macros
+ * @{
+ */
+
+/** Buses handled by the manager */
+#define SPIBUS_SPI				0			// LPC_SPI
+#define SPIBUS_SSP0				1			// LPC_SSP0
+#define SPIBUS_SSP1				2			// LPC_SSP1
+#define SPIBUS_NUM				3
+
+/** Clock modes, (CPOL << 1) | CPHA */
+#define SPIBUS_MODE0			0			// SCK idle low, sample on rising edge
+#define SPIBUS_MODE1			1			// SCK idle low, sample on falling edge
+#define SPIBUS_MODE2			2			// SCK idle high, sample on falling edge
+#define SPIBUS_MODE3			3			// SCK idle high, sample on rising edge
+
+/**
+ * @}
+ */
+
+
+/* Public Types --------------------------------------------------------------- */
+/** @defgroup SPIBUS_Public_Types SPIBUS Public Types
+ * @{
+ */
+
+/**
+ * @brief Device on a shared bus. The first six members are set by the
+ * device driver, the rest is a cache of the register values kept by
+ * the bus manager (zero it when declaring the descriptor). Devices may
+ * share a chip select pin, e.g. the SD card and the SPI E2PROM on P0.16:
+ * each keeps its own mode and clock and only one is selected at a time.
+ */
+typedef struct {
+	uint8_t  Bus;				/**< SPIBUS_SPI, SPIBUS_SSP0 or SPIBUS_SSP1 */
+	uint8_t  CsPort;			/**< GPIO port of the active low chip select */
+	uint32_t CsPin;				/**< Chip select pin mask */
+	uint8_t  Mode;				/**< SPIBUS_MODEx */
+	uint8_t  Databit;			/**< Frame size in bits, 8..16 (4..16 on SSP) */
+	uint32_t MaxClock;			/**< Fastest SCK the device accepts, Hz */
+	uint32_t Pclk;				/**< PCLK the cache was computed for, 0 if stale */
+	uint32_t Ctrl;				/**< SPCR or CR0 value */
+	uint32_t Div;				/**< SPCCR or CPSR value */
+} SPIBUS_DEVICE_Type;
+
+/**
+ * @}
+ */
+
+
+/* Public Functions ----------------------------------------------------------- */
+/** @defgroup SPIBUS_Public_Functions SPIBUS Public Functions
+ * @{
+ */
+
+void SPIBUS_Acquire (SPIBUS_DEVICE_Type *dev);
+void SPIBUS_Select (SPIBUS_DEVICE_Type *dev);
+void SPIBUS_Release (SPIBUS_DEVICE_Type *dev);
+void SPIBUS_SetClock (SPIBUS_DEVICE_Type *dev, uint32_t clock);
+uint32_t SPIBUS_GetSwitches (uint8_t bus);
+
+/**
+ * @}
+ */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LPC_SPI_BUS_H_ */
+
+/**
+ * @}
+ */
+
+/* --------------------------------- End Of File ------------------------------ */
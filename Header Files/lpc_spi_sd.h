@@ -18,6 +18,9 @@
 /* Includes ------------------------------------------------------------------- */
 #include "LPC17xx.h"
 #include "lpc_system_init.h"
+#include "lpc17xx_spi.h"
+#include "lpc_spi_bus.h"
+#include "lpc_crc.h"
 
 
 #ifdef __cplusplus
@@ -48,16 +51,30 @@ typedef enum _sd_error
 	SD_ERROR_CMD0,
 	SD_ERROR_CMD55,
 	SD_ERROR_ACMD41,
-	SD_ERROR_CMD59
+	SD_ERROR_CMD59,
+	SD_ERROR_CMD8,
+	SD_ERROR_CMD16,
+	SD_ERROR_CMD58,
+	SD_ERROR_CRC,
+	SD_ERROR_WRITE
 }sd_error;
 
+typedef enum _sd_card_type
+{
+	SD_CARD_UNKNOWN,			// not initialised
+	SD_CARD_V1,					// SD v1.x, byte addressed
+	SD_CARD_V2,					// SD v2 standard capacity, byte addressed
+	SD_CARD_V2_HC				// SDHC/SDXC, block addressed
+}sd_card_type;
+
 //SD command code
 #define 	CMD0_GO_IDLE_STATE            0x00
 #define		CMD1_SEND_OPCOND              0x01
+#define 	CMD8_SEND_IF_COND             0x08
 #define 	CMD9_SEND_CSD                 0x09
 #define 	CMD10_SEND_CID                0x0a
-#define  	CMD12_STOP_TRANSMISSION       0x0b
-#define 	CMD13_SEND_STATUS             0x0c
+#define  	CMD12_STOP_TRANSMISSION       0x0c
+#define 	CMD13_SEND_STATUS             0x0d
 #define 	CMD16_SET_BLOCKLEN            0x10
 #define 	CMD17_READ_SINGLE_BLOCK       0x11
 #define 	CMD18_READ_MULTIPLE_BLOCK     0x12
@@ -100,11 +117,30 @@ typedef enum _sd_error
 #define 	R2_ERASE_PARAM 				  0x40
 #define 	R2_RANGE_ERR   				  0x80
 
+/* Data tokens */
+#define 	SD_TOKEN_START_BLOCK		  0xFE	// CMD17/18/24 data block
+#define 	SD_TOKEN_START_MULTI		  0xFC	// CMD25 data block
+#define 	SD_TOKEN_STOP_TRAN			  0xFD	// end of CMD25 transfer
+/* Data response token - bits 4..0 */
+#define 	SD_DATA_RESP_MASK			  0x1F
+#define 	SD_DATA_RESP_ACCEPTED		  0x05
+#define 	SD_DATA_RESP_CRC_ERR		  0x0B
+#define 	SD_DATA_RESP_WRITE_ERR		  0x0D
+
 #define GETBIT(in, bit) ((in & (1<<bit)) >> bit)
 #define SD_CMD_BLOCK_LENGTH		6
 #define SD_DATA_BLOCK_LENGTH	515
 #define SD_WAIT_R1_TIMEOUT		100000
 
+#define SD_BLOCK_SIZE			512
+#define SD_CS_PORT				0			// chip select P0.16, shared with the SPI E2PROM
+#define SD_CS_PIN				_BIT(16)
+#define SD_SPI_INIT_CLOCK		400000		// identification mode, 400kHz max
+#define SD_SPI_FAST_CLOCK		12500000	// data transfer, PCLK/8 with PCLK = CCLK
+#define SD_INIT_TIMEOUT_MS		1000		// ACMD41 initialisation
+#define SD_READ_TIMEOUT_MS		100			// data token after CMD17/18
+#define SD_WRITE_TIMEOUT_MS		500			// programming busy after a block
+
 
 uint8_t sd_cmd_buf[SD_CMD_BLOCK_LENGTH];
 uint8_t sd_data_buf[SD_DATA_BLOCK_LENGTH];
@@ -120,14 +156,19 @@ uint8_t sd_data_buf[SD_DATA_BLOCK_LENGTH];
  */
 
 sd_connect_status SD_GetCardConnectStatus (void);
-uint8_t CRC_7 (uint8_t old_crc, uint8_t data);
-uint8_t CRC_7Final (uint8_t old_crc);
 uint32_t SD_SendReceiveData_Polling (void* tx_buf, void* rx_buf, uint32_t length);
 void SD_SendCommand(uint8_t cmd, uint8_t *arg);
 sd_error SD_WaitR1 (uint8_t *buffer, uint32_t length, uint32_t timeout);
 sd_error SD_WaitDeviceIdle (uint32_t num_char);
 sd_error SD_Init (uint8_t retries);
 sd_error SD_GetCID (void);
+sd_card_type SD_GetCardType (void);
+sd_error SD_ReadBlock (uint32_t block, uint8_t *buffer);
+sd_error SD_ReadBlocks (uint32_t block, uint8_t *buffer, uint32_t count);
+sd_error SD_WriteBlock (uint32_t block, const uint8_t *buffer);
+sd_error SD_WriteBlocks (uint32_t block, const uint8_t *buffer, uint32_t count);
+Bool SD_IsBusy (void);
+sd_error SD_Sync (void);
 void SD_ErrorMsg (sd_error sd_status);
 
 
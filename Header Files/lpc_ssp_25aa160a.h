@@ -18,6 +18,8 @@
 /* Includes ------------------------------------------------------------------- */
 #include "LPC17xx.h"
 #include "lpc_system_init.h"
+#include "lpc_spi_bus.h"
+#include "lpc_eeprom.h"
 
 
 #ifdef __cplusplus
@@ -38,6 +40,8 @@ extern "C"
 #define EEP_RDSR   0x05;  /* Read Status Reg     */
 #define EEP_WRSR   0x01;  /* Write Status Reg    */
 
+#define EEP_MAX_CLOCK	5000000		/* SCK limit at 2.5V..4.5V */
+
 /**
  * @}
  */
@@ -58,6 +62,7 @@ uint8_t Ssp_Eeprom_Read_Byte (LPC_SSP_TypeDef *SSPx, uint16 eep_address);
 uchar Ssp_Eeprom_Read (LPC_SSP_TypeDef *SSPx, uint16_t eep_address, uint8_t *dest_addr, uint8_t length);
 void Display_Eeprom_Array (uint8_t *string, uint8_t length);
 void Display_Eeprom_Loc (LPC_SSP_TypeDef *SSPx, uint16 mem_start_address, uint16 mem_end_address);
+E2P_DEVICE_Type *Ssp_Eeprom_Device (LPC_SSP_TypeDef *SSPx);
 
 /**
  * @}
@@ -18,6 +18,7 @@
 /* Includes ------------------------------------------------------------------- */
 #include "LPC17xx.h"
 #include "lpc_system_init.h"
+#include "lpc_spi_bus.h"
 #include "stdarg.h"
 
 #ifdef __cplusplus
@@ -35,6 +36,36 @@ extern "C"
 #define LCD_RS 		(1<<0)  //port2
 #define	LCD_RST		(1<<5)	//port0
 #define LCD_BK		(1<<8)	//port2
+#define GLCD_MAX_CLOCK	3000000	// SSP1 SCK for the SSD2119
+
+/******************************************************************************/
+/*                       Pixel Stream Mode                                    */
+/******************************************************************************/
+#define 	GLCD_DMA_SEL       0	     // 1: Push pixel runs through GPDMA, 0: CPU
+
+#if GLCD_DMA_SEL
+	#define GLCD_DMA_MODE
+#endif
+
+/******************************************************************************/
+/*                       Dirty Rectangle Compositor                           */
+/******************************************************************************/
+#define 	GLCD_COMP_SEL         0	     // 1: Compose into a tile cache, flush in bursts (21 KB), 0: Draw direct
+
+#if GLCD_COMP_SEL
+	#define GLCD_COMP_MODE
+#endif
+
+/******************************************************************************/
+/*                       Glyph Cache                                          */
+/******************************************************************************/
+#define 	GLCD_GLYPH_CACHE_SEL  0	     // 1: Keep expanded Font_24x16 glyphs, 0: Expand per row
+#define 	GLCD_GLYPH_SLOTS      8	     // Cached (char, text, back color) glyphs, 780 bytes each
+									 // of SRAM with the tag: 8 slots take 6.1 KB
+
+#if GLCD_GLYPH_CACHE_SEL
+	#define GLCD_GLYPH_CACHE_MODE
+#endif
 
 /*------------------------------------------------------------------------------
   Color coding
@@ -71,6 +102,20 @@ extern "C"
 #define BPP         16                  /* Bits per pixel                     */
 #define BYPP        ((BPP+7)/8)         /* Bytes per pixel                    */
 
+/*---------------------- Dirty rectangle compositor --------------------------*/
+/* Tiles are 32x32 RGB565 (2 KB each), one coverage bit per pixel, so the
+ * tile size is fixed by the 32 bit row mask. The pool holds one row of
+ * tiles, so a full width primitive is not flushed part way: 10 tiles of
+ * 2176 bytes, 21.3 KB of the 32 KB main SRAM with GLCD_COMP_SEL = 1 (the
+ * AHB SRAM is taken by the EMAC). Leave the glyph cache off with it.        */
+#define GLCD_TILE_SIZE      32
+#define GLCD_TILES_X        ((WIDTH + GLCD_TILE_SIZE - 1)/GLCD_TILE_SIZE)
+#define GLCD_TILES_Y        ((HEIGHT + GLCD_TILE_SIZE - 1)/GLCD_TILE_SIZE)
+#define GLCD_TILE_POOL      GLCD_TILES_X
+
+/* Linked list items needed to stream one full screen through GPDMA          */
+#define GLCD_DMA_NUM_LLI	((WIDTH*HEIGHT + GPDMA_MAX_XFER_SIZE - 1)/GPDMA_MAX_XFER_SIZE)
+
 /**
  * @brief GLCD Driver Output Type definitions
  */
@@ -132,9 +177,24 @@ void GLCD_Clear (uint16_t color);
 void GLCD_Draw_Char (uint16_t x, uint16_t y, uint16_t *c);
 void GLCD_Display_Char (uint16_t ln, uint16_t col, uchar  c);
 void GLCD_Display_String (uint16_t ln, uint16_t col, uchar *s);
+void GLCD_Draw_String (uint16_t x, uint16_t y, uchar *s, uint16_t n);
 void GLCD_ClearLn (uint16_t ln);
 void GLCD_Bitmap (uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t *bitmap);
 void GLCD_Window_Fill (uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
+void GLCD_Stream_Start (uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+void GLCD_Stream_Fill (uint16_t color, uint32_t count);
+void GLCD_Stream_Pixels (const uint16_t *pixels, uint32_t count);
+void GLCD_Stream_Stop (void);
+#ifdef GLCD_COMP_MODE
+void GLCD_Comp_Cmd (FunctionalState NewState);
+void GLCD_Comp_Pixel (uint16_t x, uint16_t y, uint16_t color);
+void GLCD_Comp_Fill (uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
+void GLCD_Comp_Flush (void);
+#else
+/* Without the compositor drawing goes straight to the panel */
+#define GLCD_Comp_Cmd(NewState)		((void)(NewState))
+#define GLCD_Comp_Flush()
+#endif
 void GLCD_Line(int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color);
 void GLCD_Rect(COORDINATE_Type *p1, COORDINATE_Type *p2, Bool fill, uint16_t color, uint16_t fill_color);
 void GLCD_Frame(COORDINATE_Type *p1, COORDINATE_Type *p2, int16_t frame_width, uint16_t color, uint16_t fill_color);
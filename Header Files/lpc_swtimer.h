@@ -0,0 +1,122 @@
+/******************************************************************//**
+* @file		lpc_swtimer.h
+* @brief	Contains all macro definitions and function prototypes
+* 			support for the software timer wheel driven by SysTick
+* @version	1.0
+* @date		04. July. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* Peripheral group ----------------------------------------------------------- */
+/** @defgroup SWTIMER SWTIMER
+ * @ingroup LPC1700CMSIS_FwLib_Drivers
+ * @{
+ */
+
+#ifndef LPC_SWTIMER_H_
+#define LPC_SWTIMER_H_
+
+/* Includes ------------------------------------------------------------------- */
+#include "LPC17xx.h"
+#include "lpc_types.h"
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/******************************************************************************/
+/*                       Software Timer Configuration                         */
+/******************************************************************************/
+#define SWTIMER_LEVELS			5			// Wheels of 32 slots, delays up to 32^LEVELS - 1 ticks
+
+/** Callback context */
+#define SWTIMER_DISPATCH_PENDSV	0			// PendSV_Handler runs the callbacks
+#define SWTIMER_DISPATCH_POLL	1			// main loop calls SWTIMER_Dispatch()
+
+#define SWTIMER_DISPATCH_SEL	0			// Select: 0 = PendSV, 1 = polled
+
+#if (SWTIMER_DISPATCH_SEL == 0)
+	#define SWTIMER_DISPATCH	SWTIMER_DISPATCH_PENDSV
+#else
+	#define SWTIMER_DISPATCH	SWTIMER_DISPATCH_POLL
+#endif
+
+/** Let SYSTICK_Idle() stretch SysTick up to the next expiry, 1 = on */
+#define SWTIMER_TICKLESS		1
+
+
+/* Public Macros -------------------------------------------------------------- */
+/** @defgroup SWTIMER_Public_Macros SWTIMER Public Macros
+ * @{
+ */
+
+/** Slots per wheel, one bit each in the occupancy map */
+#define SWTIMER_SLOTS			32
+
+/** Longest delay or period in ticks, longer ones are clamped */
+#define SWTIMER_MAX_DELAY		((1UL << (5 * SWTIMER_LEVELS)) - 1)
+
+/**
+ * @}
+ */
+
+
+/* Public Types --------------------------------------------------------------- */
+/** @defgroup SWTIMER_Public_Types SWTIMER Public Types
+ * @{
+ */
+
+/** Timer callback, runs in the dispatch context with interrupts enabled */
+typedef void (*SWTIMER_Callback_Type)(void *arg);
+
+/**
+ * @brief Software timer. Owned by the caller, set up once with
+ * SWTIMER_Init(), the members are private to the wheel.
+ */
+typedef struct SWTIMER_Tag {
+	struct SWTIMER_Tag *next;		/**< Next timer in the same list */
+	struct SWTIMER_Tag **pprev;		/**< Link pointing at this timer, NULL when stopped */
+	uint32_t expires;				/**< Tick it fires at */
+	uint32_t period;				/**< Reload in ticks, 0 for a one-shot */
+	SWTIMER_Callback_Type callback;	/**< Called on expiry */
+	void *arg;						/**< Passed to callback */
+	uint8_t slot;					/**< Wheel slot it is in, level * 32 + index */
+} SWTIMER_Type;
+
+/**
+ * @}
+ */
+
+
+/* Public Functions ----------------------------------------------------------- */
+/** @defgroup SWTIMER_Public_Functions SWTIMER Public Functions
+ * @{
+ */
+
+void SWTIMER_Init (SWTIMER_Type *timer, SWTIMER_Callback_Type callback, void *arg);
+void SWTIMER_Start (SWTIMER_Type *timer, uint32_t delay, uint32_t period);
+void SWTIMER_Stop (SWTIMER_Type *timer);
+Bool SWTIMER_IsRunning (SWTIMER_Type *timer);
+void SWTIMER_Tick (void);
+void SWTIMER_Dispatch (void);
+uint32_t SWTIMER_NextExpiry (void);
+
+/**
+ * @}
+ */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LPC_SWTIMER_H_ */
+
+/**
+ * @}
+ */
+
+/* --------------------------------- End Of File ------------------------------ */
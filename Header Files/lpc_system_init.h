@@ -24,10 +24,13 @@
 
 /* Peripherals Include----------------------------------------------------------*/
 #include "lpc17xx_systick.h"
+#include "lpc_swtimer.h"
+#include "lpc_timebase.h"
 #include "lpc17xx_gpio.h"
 #include "lpc17xx_wdt.h"
 #include "lpc17xx_uart.h"
 #include "lpc17xx_ssp.h"
+#include "lpc17xx_gpdma.h"
 #include "lpc17xx_i2c.h"
 #include "lpc_i2c_tsc2004.h"
 #include "lpc_ssp_glcd.h"
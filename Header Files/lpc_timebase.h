@@ -0,0 +1,96 @@
+/******************************************************************//**
+* @file		lpc_timebase.h
+* @brief	Contains all macro definitions and function prototypes
+* 			support for the monotonic timebase: a free running 1 us
+* 			timer and the 64-bit core cycle counter
+* @version	1.0
+* @date		07. July. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* Peripheral group ----------------------------------------------------------- */
+/** @defgroup TIMEBASE TIMEBASE
+ * @ingroup LPC1700CMSIS_FwLib_Drivers
+ * @{
+ */
+
+#ifndef LPC_TIMEBASE_H_
+#define LPC_TIMEBASE_H_
+
+/* Includes ------------------------------------------------------------------- */
+#include "LPC17xx.h"
+#include "lpc_types.h"
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/******************************************************************************/
+/*                         Timebase Configuration                             */
+/******************************************************************************/
+#define TIMEBASE_TIM_SEL		2			// Timer kept free running at 1 us: 0..3, the TIM driver refuses it
+
+#if (TIMEBASE_TIM_SEL == 0)
+	#define TIMEBASE_TIM		LPC_TIM0
+	#define TIMEBASE_PCONP		CLKPWR_PCONP_PCTIM0
+	#define TIMEBASE_PCLKSEL	CLKPWR_PCLKSEL_TIMER0
+#elif (TIMEBASE_TIM_SEL == 1)
+	#define TIMEBASE_TIM		LPC_TIM1
+	#define TIMEBASE_PCONP		CLKPWR_PCONP_PCTIM1
+	#define TIMEBASE_PCLKSEL	CLKPWR_PCLKSEL_TIMER1
+#elif (TIMEBASE_TIM_SEL == 2)
+	#define TIMEBASE_TIM		LPC_TIM2
+	#define TIMEBASE_PCONP		CLKPWR_PCONP_PCTIM2
+	#define TIMEBASE_PCLKSEL	CLKPWR_PCLKSEL_TIMER2
+#else
+	#define TIMEBASE_TIM		LPC_TIM3
+	#define TIMEBASE_PCONP		CLKPWR_PCONP_PCTIM3
+	#define TIMEBASE_PCLKSEL	CLKPWR_PCLKSEL_TIMER3
+#endif
+
+
+/* Public Macros -------------------------------------------------------------- */
+/** @defgroup TIMEBASE_Public_Macros TIMEBASE Public Macros
+ * @{
+ */
+
+/** Longest deadline_us() horizon, deadline_expired() is signed */
+#define TIMEBASE_MAX_DEADLINE	0x7FFFFFFFUL
+
+/**
+ * @}
+ */
+
+
+/* Public Functions ----------------------------------------------------------- */
+/** @defgroup TIMEBASE_Public_Functions TIMEBASE Public Functions
+ * @{
+ */
+
+void TIMEBASE_Init (void);
+uint32_t now_us (void);
+uint64_t now_cycles (void);
+uint32_t deadline_us (uint32_t us);
+Bool deadline_expired (uint32_t deadline);
+uint32_t deadline_left (uint32_t deadline);
+void delay_us (uint32_t us);
+
+/**
+ * @}
+ */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LPC_TIMEBASE_H_ */
+
+/**
+ * @}
+ */
+
+/* --------------------------------- End Of File ------------------------------ */
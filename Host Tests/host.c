@@ -0,0 +1,492 @@
+/******************************************************************//**
+* @file		host.c
+* @brief	Contains the shared support of the host tests: register
+* 			blocks, PRIMASK/NVIC/SysTick model on a simulated clock,
+* 			timebase, checks and reports
+* @version	1.0
+* @date		21. July. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* Includes ------------------------------------------------------------------- */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <time.h>
+#include "host.h"
+#include "lpc_timebase.h"
+
+
+/* Private Macros ------------------------------------------------------------- */
+/** Exceptions in a row without returning to the code, a livelock */
+#define HOST_IRQ_STORM			100000
+
+/** Seconds of real time a test may run, a runaway loop fails it */
+#define HOST_TIME_LIMIT			120
+
+
+/* Public Variables ----------------------------------------------------------- */
+LPC_SC_TypeDef			host_SC;
+LPC_GPIO_TypeDef		host_GPIO[5];
+LPC_WDT_TypeDef			host_WDT;
+LPC_TIM_TypeDef			host_TIM[4];
+LPC_RIT_TypeDef			host_RIT;
+LPC_UART_TypeDef		host_UART0, host_UART2, host_UART3;
+LPC_UART1_TypeDef		host_UART1;
+LPC_PWM_TypeDef			host_PWM1;
+LPC_I2C_TypeDef			host_I2C[3];
+LPC_I2S_TypeDef			host_I2S;
+LPC_SPI_TypeDef			host_SPI;
+LPC_RTC_TypeDef			host_RTC;
+LPC_GPIOINT_TypeDef		host_GPIOINT;
+LPC_PINCON_TypeDef		host_PINCON;
+LPC_SSP_TypeDef			host_SSP[2];
+LPC_ADC_TypeDef			host_ADC;
+LPC_DAC_TypeDef			host_DAC;
+LPC_CANAF_RAM_TypeDef	host_CANAF_RAM;
+LPC_CANAF_TypeDef		host_CANAF;
+LPC_CANCR_TypeDef		host_CANCR;
+LPC_CAN_TypeDef			host_CAN[2];
+LPC_MCPWM_TypeDef		host_MCPWM;
+LPC_QEI_TypeDef			host_QEI;
+LPC_EMAC_TypeDef		host_EMAC;
+LPC_GPDMA_TypeDef		host_GPDMA;
+LPC_GPDMACH_TypeDef		host_GPDMACH[8];
+LPC_USB_TypeDef			host_USB;
+NVIC_Type				host_NVIC;
+CoreDebug_Type			host_CoreDebug;
+
+uint32_t SystemCoreClock = 100000000;
+uint32_t host_ipsr;
+uint64_t host_cycles;
+
+
+/* Private Variables ---------------------------------------------------------- */
+/* Handlers the model can run, the tests link the drivers they need */
+void SysTick_Handler(void) __attribute__((weak));
+void PendSV_Handler(void) __attribute__((weak));
+void DMA_IRQHandler(void) __attribute__((weak));
+
+static uint32_t host_primask;
+static uint64_t host_wake;				// cycle an outside interrupt wakes WFI, 0: none
+
+/* SysTick as the hardware holds it, and the view last handed out */
+static struct
+{
+	uint32_t ctrl, load, val;
+	uint8_t flag;						// COUNTFLAG
+	uint8_t seen;						// an access saw COUNTFLAG, next one clears it
+} st;
+static SysTick_Type st_view;
+
+/* ICSR pend bits, and the view last handed out */
+static uint32_t scb_pend;
+static SCB_Type scb_view;
+
+static uint32_t checks, failures;
+static uint32_t advances;
+static double started;
+
+
+/* Private Functions ---------------------------------------------------------- */
+/*********************************************************************//**
+ * @brief 		Apply what the code wrote through the last SysTick and
+ * 				SCB views
+ * @param		None
+ * @return 		None
+ *
+ * Note: a VAL write is seen when the value differs from the one read,
+ * writing the value just read back is lost, the drivers only write 0.
+ **********************************************************************/
+static void host_sync (void)
+{
+	uint32_t icsr;
+
+	if (st_view.VAL != st.val)
+	{
+		st.val = 0;						// any write clears VAL and COUNTFLAG
+		st.flag = 0;
+	}
+	st.load = st_view.LOAD & SysTick_LOAD_RELOAD_Msk;
+	st.ctrl = st_view.CTRL & (SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk);
+	if (st.seen)
+	{
+		st.flag = 0;					// reading CTRL clears COUNTFLAG
+		st.seen = 0;
+	}
+
+	icsr = scb_view.ICSR;
+	if (icsr & SCB_ICSR_PENDSTSET_Msk) scb_pend |= SCB_ICSR_PENDSTSET_Msk;
+	if (icsr & SCB_ICSR_PENDSTCLR_Msk) scb_pend &= ~SCB_ICSR_PENDSTSET_Msk;
+	if (icsr & SCB_ICSR_PENDSVSET_Msk) scb_pend |= SCB_ICSR_PENDSVSET_Msk;
+	if (icsr & SCB_ICSR_PENDSVCLR_Msk) scb_pend &= ~SCB_ICSR_PENDSVSET_Msk;
+	scb_view.ICSR = scb_pend;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Publish the hardware state in the views
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void host_publish (void)
+{
+	st_view.CTRL = st.ctrl | (st.flag ? SysTick_CTRL_COUNTFLAG_Msk : 0);
+	st_view.LOAD = st.load;
+	st_view.VAL = st.val;
+	scb_view.ICSR = scb_pend;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Clocks until SysTick pends its interrupt
+ * @param		None
+ * @return 		Clocks, 0 if it never does
+ **********************************************************************/
+static uint64_t host_systick_due (void)
+{
+	if (!(st.ctrl & SysTick_CTRL_ENABLE_Msk) || !(st.ctrl & SysTick_CTRL_TICKINT_Msk))
+	{
+		return 0;
+	}
+	if (st.val != 0)
+	{
+		return st.val;
+	}
+	return (st.load != 0) ? (uint64_t)st.load + 1 : 0;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Any enabled interrupt pending
+ * @param		None
+ * @return 		1 if one is
+ **********************************************************************/
+static int host_irq_pending (void)
+{
+	return (scb_pend != 0) || ((host_NVIC.ISPR[0] & host_NVIC.ISER[0]) != 0)
+			|| ((host_NVIC.ISPR[1] & host_NVIC.ISER[1]) != 0);
+}
+
+
+/* Public Functions ----------------------------------------------------------- */
+/*********************************************************************//**
+ * @brief 		Let clocks pass: SysTick counts and pends its interrupt,
+ * 				which runs at once if PRIMASK allows
+ * @param[in]	cycles	Clocks
+ * @return 		None
+ *
+ * Note: every 64K calls the real time is checked against
+ * HOST_TIME_LIMIT, a code stuck polling the model ends the test.
+ **********************************************************************/
+void host_advance (uint32_t cycles)
+{
+	uint32_t n = cycles, step;
+
+	if ((++advances & 0xFFFF) == 1)
+	{
+		if (started == 0)
+		{
+			started = host_seconds();
+		}
+		else if ((host_seconds() - started) > HOST_TIME_LIMIT)
+		{
+			host_check(0, "time limit", __FILE__, __LINE__);
+			exit(host_done("host"));
+		}
+	}
+	host_sync();
+	while (n && (st.ctrl & SysTick_CTRL_ENABLE_Msk))
+	{
+		if (st.val == 0)
+		{
+			if (st.load == 0)
+			{
+				break;					// LOAD 0 stops the counter
+			}
+			st.val = st.load;			// reload takes one clock
+			n--;
+			continue;
+		}
+		step = (n < st.val) ? n : st.val;
+		st.val -= step;
+		n -= step;
+		if (st.val == 0)
+		{
+			st.flag = 1;
+			if (st.ctrl & SysTick_CTRL_TICKINT_Msk)
+			{
+				scb_pend |= SCB_ICSR_PENDSTSET_Msk;
+			}
+		}
+	}
+	host_cycles += cycles;
+	host_publish();
+	host_irq_run();
+}
+
+
+/*********************************************************************//**
+ * @brief 		Schedule an interrupt from outside, it only wakes WFI
+ * @param[in]	cycle	Value of host_cycles to wake at, 0 to cancel
+ * @return 		None
+ **********************************************************************/
+void host_wake_at (uint64_t cycle)
+{
+	host_wake = cycle;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Run the pending exceptions if PRIMASK allows, SysTick
+ * 				first then PendSV then the NVIC lines, without nesting
+ * @param		None
+ * @return 		None
+ *
+ * Note: a handler that keeps pending itself (SysTick reloading faster
+ * than its handler runs) never lets the code go on, the test fails.
+ **********************************************************************/
+void host_irq_run (void)
+{
+	uint32_t i, lines, runs = 0;
+
+	while (!host_primask && (host_ipsr == 0))
+	{
+		if (++runs > HOST_IRQ_STORM)
+		{
+			host_check(0, "interrupt storm", __FILE__, __LINE__);
+			exit(host_done("host"));
+		}
+		host_sync();
+		if ((scb_pend & SCB_ICSR_PENDSTSET_Msk) && SysTick_Handler)
+		{
+			scb_pend &= ~SCB_ICSR_PENDSTSET_Msk;
+			host_publish();
+			host_ipsr = 15;
+			SysTick_Handler();
+		}
+		else if ((scb_pend & SCB_ICSR_PENDSVSET_Msk) && PendSV_Handler)
+		{
+			scb_pend &= ~SCB_ICSR_PENDSVSET_Msk;
+			host_publish();
+			host_ipsr = 14;
+			PendSV_Handler();
+		}
+		else if ((lines = host_NVIC.ISPR[0] & host_NVIC.ISER[0]) != 0)
+		{
+			i = __builtin_ctz(lines);
+			host_NVIC.ISPR[0] &= ~(1UL << i);
+			host_ipsr = 16 + i;
+			if ((i == DMA_IRQn) && DMA_IRQHandler)
+			{
+				DMA_IRQHandler();
+			}
+		}
+		else
+		{
+			scb_pend = 0;				// no handler linked, drop it
+			host_publish();
+			break;
+		}
+		host_ipsr = 0;
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief 		SysTick access: a few clocks pass, then the code reads
+ * 				or writes the returned view
+ * @param		None
+ * @return 		SysTick view
+ **********************************************************************/
+SysTick_Type *host_systick (void)
+{
+	host_advance(HOST_ACCESS_CYCLES);
+	st.seen = st.flag;
+	return &st_view;
+}
+
+
+/*********************************************************************//**
+ * @brief 		SCB access, ICSR writes are applied by the next access
+ * @param		None
+ * @return 		SCB view
+ **********************************************************************/
+SCB_Type *host_scb (void)
+{
+	host_advance(HOST_ACCESS_CYCLES);
+	return &scb_view;
+}
+
+
+uint32_t host_get_primask (void)
+{
+	return host_primask;
+}
+
+
+void host_set_primask (uint32_t primask)
+{
+	host_primask = primask & 1;
+	host_irq_run();
+}
+
+
+/*********************************************************************//**
+ * @brief 		WFI: time passes until an interrupt is pending, it runs
+ * 				here only if PRIMASK allows, as on the core
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+void host_wfi (void)
+{
+	uint64_t due, wake;
+
+	host_sync();
+	if (!host_irq_pending())
+	{
+		due = host_systick_due();
+		wake = (host_wake > host_cycles) ? host_wake - host_cycles : 0;
+		if ((wake != 0) && ((due == 0) || (wake < due)))
+		{
+			due = wake;
+			host_wake = 0;
+		}
+		if (due == 0)
+		{
+			host_check(0, "WFI with no wake-up source", __FILE__, __LINE__);
+			exit(host_done("host"));
+		}
+		while (due > 0xFFFFFFFFULL)
+		{
+			host_advance(0xFFFFFFFFUL);
+			due -= 0xFFFFFFFFULL;
+		}
+		host_advance((uint32_t)due);
+	}
+	host_irq_run();
+}
+
+
+void host_nvic_enable (IRQn_Type IRQn)
+{
+	if (IRQn >= 0)
+	{
+		host_NVIC.ISER[IRQn >> 5] |= 1UL << (IRQn & 0x1F);
+	}
+}
+
+
+void host_nvic_disable (IRQn_Type IRQn)
+{
+	if (IRQn >= 0)
+	{
+		host_NVIC.ISER[IRQn >> 5] &= ~(1UL << (IRQn & 0x1F));
+	}
+}
+
+
+void host_nvic_set_priority (IRQn_Type IRQn, uint32_t priority)
+{
+	if (IRQn >= 0)
+	{
+		host_NVIC.IP[IRQn] = (uint8_t)(priority << 3);
+	}
+}
+
+
+/*
+ * Timebase on the simulated clock, lpc_timebase.c is not linked: every
+ * read lets a few clocks pass so polling loops end
+ */
+void TIMEBASE_Init (void)
+{
+}
+
+
+uint64_t now_cycles (void)
+{
+	host_advance(HOST_ACCESS_CYCLES);
+	return host_cycles;
+}
+
+
+uint32_t now_us (void)
+{
+	return (uint32_t)(now_cycles() / (SystemCoreClock / 1000000));
+}
+
+
+uint32_t deadline_us (uint32_t us)
+{
+	return now_us() + us;
+}
+
+
+Bool deadline_expired (uint32_t deadline)
+{
+	return ((int32_t)(now_us() - deadline) >= 0) ? TRUE : FALSE;
+}
+
+
+uint32_t deadline_left (uint32_t deadline)
+{
+	int32_t left = (int32_t)(deadline - now_us());
+
+	return (left > 0) ? (uint32_t)left : 0;
+}
+
+
+void delay_us (uint32_t us)
+{
+	uint32_t start = now_us();
+
+	while ((uint32_t)(now_us() - start) < us);
+}
+
+
+/* Checks and reports */
+void host_check (int ok, const char *expr, const char *file, int line)
+{
+	checks++;
+	if (!ok)
+	{
+		failures++;
+		host_printf("%s:%d: check failed: %s\n", file, line, expr);
+	}
+}
+
+
+/* CHECK_PARAM() of the drivers, the tests build with DEBUG */
+void check_failed (uint8_t *file, uint32_t line)
+{
+	host_check(0, "CHECK_PARAM", (const char *)file, (int)line);
+}
+
+
+void host_printf (const char *format, ...)
+{
+	va_list ap;
+
+	va_start(ap, format);
+	vprintf(format, ap);
+	va_end(ap);
+}
+
+
+double host_seconds (void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+int host_done (const char *name)
+{
+	host_printf("%s: %u checks, %u failed\n", name, checks, failures);
+	return failures ? 1 : 0;
+}
+
+/* --------------------------------- End Of File ------------------------------ */
@@ -0,0 +1,56 @@
+/******************************************************************//**
+* @file		host.h
+* @brief	Contains the shared support of the host tests: simulated
+* 			clock and interrupts, checks and reports
+* @version	1.0
+* @date		21. July. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* The tests include driver headers, and lpc17xx_uart.h declares its own
+ * printf(), so this header stays free of <stdio.h>: report through
+ * host_printf(). host.c does the same, a test that links a driver
+ * printing to a UART stubs that printf() */
+
+#ifndef HOST_H_
+#define HOST_H_
+
+/* Includes ------------------------------------------------------------------- */
+#include "LPC17xx.h"
+#include "lpc_types.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* Public Macros -------------------------------------------------------------- */
+/** Clocks that pass on every SysTick or SCB access */
+#define HOST_ACCESS_CYCLES		4
+
+/** Fail the test and go on, the exit status reports it */
+#define HOST_CHECK(expr)		host_check((expr) != 0, #expr, __FILE__, __LINE__)
+
+/* Public Variables ----------------------------------------------------------- */
+/** Simulated core clocks since start, at SystemCoreClock */
+extern uint64_t host_cycles;
+
+/* Public Functions ----------------------------------------------------------- */
+/* Simulated clock and interrupts */
+void host_advance (uint32_t cycles);
+void host_wake_at (uint64_t cycle);
+void host_irq_run (void);
+
+/* Checks and reports */
+void host_check (int ok, const char *expr, const char *file, int line);
+void host_printf (const char *format, ...);
+double host_seconds (void);
+int host_done (const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_H_ */
+
+/* --------------------------------- End Of File ------------------------------ */
@@ -0,0 +1,226 @@
+/******************************************************************//**
+* @file		LPC17xx.h
+* @brief	Host build of the device header: the CMSIS LPC17xx.h is
+* 			included unchanged, then every peripheral and core register
+* 			block is moved to host memory and the Cortex-M3 intrinsics
+* 			are replaced by the interrupt model in host.c
+* @version	1.0
+* @date		21. July. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* Found before "CM3 Core" because only this directory and "Header Files"
+ * are on the include path of the host build, see Makefile */
+
+#ifndef HOST_LPC17xx_H_
+#define HOST_LPC17xx_H_
+
+#include "../../CM3 Core/LPC17xx.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*
+ * Peripheral register blocks, the drivers index them by pointer so any
+ * block works, tests write the read-only (__I) fields through a cast
+ */
+extern LPC_SC_TypeDef			host_SC;
+extern LPC_GPIO_TypeDef			host_GPIO[5];
+extern LPC_WDT_TypeDef			host_WDT;
+extern LPC_TIM_TypeDef			host_TIM[4];
+extern LPC_RIT_TypeDef			host_RIT;
+extern LPC_UART_TypeDef			host_UART0, host_UART2, host_UART3;
+extern LPC_UART1_TypeDef		host_UART1;
+extern LPC_PWM_TypeDef			host_PWM1;
+extern LPC_I2C_TypeDef			host_I2C[3];
+extern LPC_I2S_TypeDef			host_I2S;
+extern LPC_SPI_TypeDef			host_SPI;
+extern LPC_RTC_TypeDef			host_RTC;
+extern LPC_GPIOINT_TypeDef		host_GPIOINT;
+extern LPC_PINCON_TypeDef		host_PINCON;
+extern LPC_SSP_TypeDef			host_SSP[2];
+extern LPC_ADC_TypeDef			host_ADC;
+extern LPC_DAC_TypeDef			host_DAC;
+extern LPC_CANAF_RAM_TypeDef	host_CANAF_RAM;
+extern LPC_CANAF_TypeDef		host_CANAF;
+extern LPC_CANCR_TypeDef		host_CANCR;
+extern LPC_CAN_TypeDef			host_CAN[2];
+extern LPC_MCPWM_TypeDef		host_MCPWM;
+extern LPC_QEI_TypeDef			host_QEI;
+extern LPC_EMAC_TypeDef			host_EMAC;
+extern LPC_GPDMA_TypeDef		host_GPDMA;
+extern LPC_GPDMACH_TypeDef		host_GPDMACH[8];
+extern LPC_USB_TypeDef			host_USB;
+extern NVIC_Type				host_NVIC;
+extern CoreDebug_Type			host_CoreDebug;
+
+#undef LPC_SC
+#undef LPC_GPIO0
+#undef LPC_GPIO1
+#undef LPC_GPIO2
+#undef LPC_GPIO3
+#undef LPC_GPIO4
+#undef LPC_WDT
+#undef LPC_TIM0
+#undef LPC_TIM1
+#undef LPC_TIM2
+#undef LPC_TIM3
+#undef LPC_RIT
+#undef LPC_UART0
+#undef LPC_UART1
+#undef LPC_UART2
+#undef LPC_UART3
+#undef LPC_PWM1
+#undef LPC_I2C0
+#undef LPC_I2C1
+#undef LPC_I2C2
+#undef LPC_I2S
+#undef LPC_SPI
+#undef LPC_RTC
+#undef LPC_GPIOINT
+#undef LPC_PINCON
+#undef LPC_SSP0
+#undef LPC_SSP1
+#undef LPC_ADC
+#undef LPC_DAC
+#undef LPC_CANAF_RAM
+#undef LPC_CANAF
+#undef LPC_CANCR
+#undef LPC_CAN1
+#undef LPC_CAN2
+#undef LPC_MCPWM
+#undef LPC_QEI
+#undef LPC_EMAC
+#undef LPC_GPDMA
+#undef LPC_GPDMACH0
+#undef LPC_GPDMACH1
+#undef LPC_GPDMACH2
+#undef LPC_GPDMACH3
+#undef LPC_GPDMACH4
+#undef LPC_GPDMACH5
+#undef LPC_GPDMACH6
+#undef LPC_GPDMACH7
+#undef LPC_USB
+#undef SCB
+#undef SysTick
+#undef NVIC
+#undef CoreDebug
+
+#define LPC_SC			(&host_SC)
+#define LPC_GPIO0		(&host_GPIO[0])
+#define LPC_GPIO1		(&host_GPIO[1])
+#define LPC_GPIO2		(&host_GPIO[2])
+#define LPC_GPIO3		(&host_GPIO[3])
+#define LPC_GPIO4		(&host_GPIO[4])
+#define LPC_WDT			(&host_WDT)
+#define LPC_TIM0		(&host_TIM[0])
+#define LPC_TIM1		(&host_TIM[1])
+#define LPC_TIM2		(&host_TIM[2])
+#define LPC_TIM3		(&host_TIM[3])
+#define LPC_RIT			(&host_RIT)
+#define LPC_UART0		(&host_UART0)
+#define LPC_UART1		(&host_UART1)
+#define LPC_UART2		(&host_UART2)
+#define LPC_UART3		(&host_UART3)
+#define LPC_PWM1		(&host_PWM1)
+#define LPC_I2C0		(&host_I2C[0])
+#define LPC_I2C1		(&host_I2C[1])
+#define LPC_I2C2		(&host_I2C[2])
+#define LPC_I2S			(&host_I2S)
+#ifdef HOST_SPI_MODEL
+LPC_SPI_TypeDef *host_spi(void);		// the test models SPI accesses
+#define LPC_SPI			(host_spi())
+#else
+#define LPC_SPI			(&host_SPI)
+#endif
+#define LPC_RTC			(&host_RTC)
+#define LPC_GPIOINT		(&host_GPIOINT)
+#define LPC_PINCON		(&host_PINCON)
+#define LPC_SSP0		(&host_SSP[0])
+#ifdef HOST_SSP1_MODEL
+LPC_SSP_TypeDef *host_ssp1(void);		// the test models SSP1 accesses
+#define LPC_SSP1		(host_ssp1())
+#else
+#define LPC_SSP1		(&host_SSP[1])
+#endif
+#define LPC_ADC			(&host_ADC)
+#define LPC_DAC			(&host_DAC)
+#define LPC_CANAF_RAM	(&host_CANAF_RAM)
+#define LPC_CANAF		(&host_CANAF)
+#define LPC_CANCR		(&host_CANCR)
+#define LPC_CAN1		(&host_CAN[0])
+#define LPC_CAN2		(&host_CAN[1])
+#define LPC_MCPWM		(&host_MCPWM)
+#define LPC_QEI			(&host_QEI)
+#define LPC_EMAC		(&host_EMAC)
+#define LPC_GPDMA		(&host_GPDMA)
+#define LPC_GPDMACH0	(&host_GPDMACH[0])
+#define LPC_GPDMACH1	(&host_GPDMACH[1])
+#define LPC_GPDMACH2	(&host_GPDMACH[2])
+#define LPC_GPDMACH3	(&host_GPDMACH[3])
+#define LPC_GPDMACH4	(&host_GPDMACH[4])
+#define LPC_GPDMACH5	(&host_GPDMACH[5])
+#define LPC_GPDMACH6	(&host_GPDMACH[6])
+#define LPC_GPDMACH7	(&host_GPDMACH[7])
+#define LPC_USB			(&host_USB)
+#define NVIC			(&host_NVIC)
+#define CoreDebug		(&host_CoreDebug)
+
+/*
+ * SysTick counts on the simulated clock: every access lets a few clocks
+ * pass and applies the writes of the previous one, see host_systick().
+ * SCB->ICSR keeps the set/clear semantics of the pend bits.
+ */
+SysTick_Type *host_systick(void);
+SCB_Type *host_scb(void);
+#define SysTick			(host_systick())
+#define SCB				(host_scb())
+
+/*
+ * Intrinsics and the core_cm3.h inlines that touch registers. The ARM
+ * versions above are unused static inlines, so they emit no code.
+ */
+uint32_t host_get_primask(void);
+void host_set_primask(uint32_t primask);
+void host_wfi(void);
+void host_nvic_enable(IRQn_Type IRQn);
+void host_nvic_disable(IRQn_Type IRQn);
+void host_nvic_set_priority(IRQn_Type IRQn, uint32_t priority);
+extern uint32_t host_ipsr;
+
+#define __get_PRIMASK()					host_get_primask()
+#define __set_PRIMASK(m)				host_set_primask(m)
+#define __disable_irq()					host_set_primask(1)
+#define __enable_irq()					host_set_primask(0)
+#define __get_IPSR()					(host_ipsr)
+#define __WFI()							host_wfi()
+#define __NOP()							((void)0)
+#define __DMB()							__sync_synchronize()
+#define __DSB()							__sync_synchronize()
+#define __ISB()							__sync_synchronize()
+#define __CLZ(x)						((uint8_t)((x) ? __builtin_clz(x) : 32))
+#define __RBIT(x)						host_rbit(x)
+#define NVIC_EnableIRQ(IRQn)			host_nvic_enable(IRQn)
+#define NVIC_DisableIRQ(IRQn)			host_nvic_disable(IRQn)
+#define NVIC_SetPriority(IRQn, prio)	host_nvic_set_priority((IRQn), (prio))
+
+static inline uint32_t host_rbit(uint32_t x)
+{
+	uint32_t r = 0, i;
+
+	for (i = 0; i < 32; i++, x >>= 1)
+	{
+		r = (r << 1) | (x & 1);
+	}
+	return r;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_LPC17xx_H_ */
+
+/* --------------------------------- End Of File ------------------------------ */
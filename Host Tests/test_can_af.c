@@ -0,0 +1,459 @@
+/******************************************************************//**
+* @file		test_can_af.c
+* @brief	Host test of the CAN acceptance filter table: random entry
+* 			lists packed by CAN_BuildAFLUT(), searched by CAN_AFLookup()
+* 			and compared with a brute force search of the list, and the
+* 			cost of the batch build against CAN_LoadExplicitEntry()
+* @version	1.0
+* @date		21. July. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* LPC_CANAF and LPC_CANAF_RAM are host memory (include/LPC17xx.h), so the
+ * builder and CAN_AFLookup() run unchanged. The lookup searches the
+ * sections the way the filter does: a table that is not sorted or not
+ * packed right loses IDs in the binary searches. */
+
+/* Includes ------------------------------------------------------------------- */
+#include <string.h>
+#include "host.h"
+#include "lpc17xx_can.h"
+
+
+/* Private Macros ------------------------------------------------------------- */
+/** AF RAM contents the builder must not touch */
+#define AF_RAM_FILL			0xA5A5A5A5UL
+
+/** Largest random list, fits the AF RAM whatever the mix */
+#define LIST_MAX			200
+
+/** IDs of the benchmark, as on the HMI */
+#define BENCH_IDS			300
+
+
+/* Private Variables ---------------------------------------------------------- */
+static CAN_AF_ENTRY_Type list[CAN_AF_RAM_WORDS + 1], orig[BENCH_IDS];
+
+/* Section sizes kept by lpc17xx_can.c, its header does not export them */
+extern uint16_t CANAF_FullCAN_cnt, CANAF_std_cnt, CANAF_gstd_cnt, CANAF_ext_cnt, CANAF_gext_cnt;
+static uint32_t rnd = 1;
+
+
+/* Private Functions ---------------------------------------------------------- */
+static uint32_t rnd_next (void)
+{
+	rnd = rnd * 1103515245 + 12345;
+	return (rnd >> 16) | ((rnd & 0xFFFF) << 16);
+}
+
+
+/*********************************************************************//**
+ * @brief 		Brute force search of the unsorted entry list
+ * @param[in]	entries		List as given to CAN_BuildAFLUT()
+ * @param[in]	count		Number of entries
+ * @param[in]	controller	CAN1_CTRL or CAN2_CTRL
+ * @param[in]	id			Received identifier
+ * @param[in]	format		STD_ID_FORMAT or EXT_ID_FORMAT
+ * @return 		TRUE if any enabled entry takes the frame
+ **********************************************************************/
+static Bool ref_accept (const CAN_AF_ENTRY_Type *entries, uint32_t count, uint8_t controller,
+						uint32_t id, CAN_ID_FORMAT_Type format)
+{
+	const CAN_AF_ENTRY_Type *e;
+	uint32_t i;
+
+	for (i = 0; i < count; i++)
+	{
+		e = &entries[i];
+		if (e->controller != controller)
+		{
+			continue;
+		}
+		switch (e->type)
+		{
+		case FULLCAN_ENTRY:
+		case EXPLICIT_STANDARD_ENTRY:
+			if ((format == STD_ID_FORMAT) && (e->lowerID == id) && !e->disable)
+			{
+				return TRUE;
+			}
+			break;
+		case GROUP_STANDARD_ENTRY:
+			if ((format == STD_ID_FORMAT) && (e->lowerID <= id) && (id <= e->upperID) && !e->disable)
+			{
+				return TRUE;
+			}
+			break;
+		case EXPLICIT_EXTEND_ENTRY:
+			if ((format == EXT_ID_FORMAT) && (e->lowerID == id))
+			{
+				return TRUE;
+			}
+			break;
+		default:
+			if ((format == EXT_ID_FORMAT) && (e->lowerID <= id) && (id <= e->upperID))
+			{
+				return TRUE;
+			}
+			break;
+		}
+	}
+	return FALSE;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Random entry list. Narrow ID spans give duplicates,
+ * 				overlapping groups and equal IDs on both controllers.
+ * @param[in]	count		Number of entries
+ * @param[in]	std_span	Standard IDs are below this
+ * @param[in]	ext_span	Extended IDs are below this
+ * @return 		None
+ **********************************************************************/
+static void list_make (uint32_t count, uint32_t std_span, uint32_t ext_span)
+{
+	CAN_AF_ENTRY_Type *e;
+	uint32_t i, fullcan = 0;
+
+	for (i = 0; i < count; i++)
+	{
+		e = &orig[i];
+		e->type = (AFLUT_ENTRY_Type)(rnd_next() % 5);
+		if ((e->type == FULLCAN_ENTRY) && (++fullcan > MAX_HW_FULLCAN_OBJ / 2))
+		{
+			e->type = EXPLICIT_STANDARD_ENTRY;
+		}
+		e->controller = (uint8_t)(rnd_next() & 1);
+		e->disable = MSG_ENABLE;
+		e->upperID = 0;
+		if (e->type <= GROUP_STANDARD_ENTRY)
+		{
+			e->lowerID = rnd_next() % std_span;
+			e->disable = ((rnd_next() & 7) == 0) ? MSG_DISABLE : MSG_ENABLE;
+			if (e->type == GROUP_STANDARD_ENTRY)
+			{
+				e->upperID = e->lowerID + rnd_next() % 16;
+				e->upperID = (e->upperID > 0x7FF) ? 0x7FF : e->upperID;
+			}
+		}
+		else
+		{
+			e->lowerID = rnd_next() % ext_span;
+			if (e->type == GROUP_EXTEND_ENTRY)
+			{
+				e->upperID = e->lowerID + rnd_next() % 64;
+				e->upperID = (e->upperID > 0x1FFFFFFF) ? 0x1FFFFFFF : e->upperID;
+			}
+		}
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief 		Compare CAN_AFLookup() on the loaded table with the
+ * 				brute force search: every standard ID, and extended
+ * 				IDs at and around every entry and at random
+ * @param[in]	count		Entries in orig
+ * @param[in]	ext_span	Extended IDs are below this
+ * @return 		Number of IDs the two disagree on
+ **********************************************************************/
+static uint32_t lookup_compare (uint32_t count, uint32_t ext_span)
+{
+	uint32_t bad = 0, i, id, d;
+	uint8_t ctrl;
+
+	for (ctrl = CAN1_CTRL; ctrl <= CAN2_CTRL; ctrl++)
+	{
+		for (id = 0; id <= 0x7FF; id++)
+		{
+			bad += CAN_AFLookup(ctrl, id, STD_ID_FORMAT) != ref_accept(orig, count, ctrl, id, STD_ID_FORMAT);
+		}
+		for (i = 0; i < count; i++)
+		{
+			if (orig[i].type < EXPLICIT_EXTEND_ENTRY)
+			{
+				continue;
+			}
+			for (d = 0; d < 3; d++)
+			{
+				id = orig[i].lowerID + d - 1;
+				bad += CAN_AFLookup(ctrl, id & 0x1FFFFFFF, EXT_ID_FORMAT) != \
+					   ref_accept(orig, count, ctrl, id & 0x1FFFFFFF, EXT_ID_FORMAT);
+				id = orig[i].upperID + d - 1;
+				bad += CAN_AFLookup(ctrl, id & 0x1FFFFFFF, EXT_ID_FORMAT) != \
+					   ref_accept(orig, count, ctrl, id & 0x1FFFFFFF, EXT_ID_FORMAT);
+			}
+		}
+		for (i = 0; i < 256; i++)
+		{
+			id = rnd_next() % ext_span;
+			bad += CAN_AFLookup(ctrl, id, EXT_ID_FORMAT) != ref_accept(orig, count, ctrl, id, EXT_ID_FORMAT);
+		}
+	}
+	return bad;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Section registers, FullCAN objects and the RAM past them
+ * 				after a build of orig
+ * @param[in]	count	Entries in orig
+ * @return 		Number of faults
+ **********************************************************************/
+static uint32_t table_check (uint32_t count)
+{
+	uint32_t num[5] = {0, 0, 0, 0, 0};
+	uint32_t bad = 0, i, j, end, below, dup;
+	int32_t obj;
+
+	// Distinct entries per section, by the sort key of the builder
+	for (i = 0; i < count; i++)
+	{
+		for (j = 0, dup = 0; (j < i) && !dup; j++)
+		{
+			dup = (orig[j].type == orig[i].type) && (orig[j].controller == orig[i].controller) && \
+				  (orig[j].lowerID == orig[i].lowerID) && \
+				  ((orig[i].type != GROUP_STANDARD_ENTRY && orig[i].type != GROUP_EXTEND_ENTRY) || \
+				   (orig[j].upperID == orig[i].upperID));
+		}
+		num[orig[i].type] += !dup;
+	}
+	bad += (CANAF_FullCAN_cnt != num[FULLCAN_ENTRY]) || (CANAF_std_cnt != num[EXPLICIT_STANDARD_ENTRY]);
+	bad += (CANAF_gstd_cnt != num[GROUP_STANDARD_ENTRY]) || (CANAF_ext_cnt != num[EXPLICIT_EXTEND_ENTRY]);
+	bad += CANAF_gext_cnt != num[GROUP_EXTEND_ENTRY];
+
+	bad += LPC_CANAF->SFF_sa != ((num[0] + 1) >> 1) * 4;
+	bad += LPC_CANAF->SFF_GRP_sa != LPC_CANAF->SFF_sa + ((num[1] + 1) >> 1) * 4;
+	bad += LPC_CANAF->EFF_sa != LPC_CANAF->SFF_GRP_sa + num[2] * 4;
+	bad += LPC_CANAF->EFF_GRP_sa != LPC_CANAF->EFF_sa + num[3] * 4;
+	bad += LPC_CANAF->ENDofTable != LPC_CANAF->EFF_GRP_sa + num[4] * 8;
+	bad += LPC_CANAF->AFMR != (num[0] ? 0x04 : 0x00);
+
+	// Objects follow the table cleared, in the order of the sorted IDs
+	end = LPC_CANAF->ENDofTable >> 2;
+	for (i = 0; i < num[0] * 3; i++)
+	{
+		bad += LPC_CANAF_RAM->mask[end + i] != 0;
+	}
+	for (i = end + num[0] * 3; i < CAN_AF_RAM_WORDS; i++)
+	{
+		bad += LPC_CANAF_RAM->mask[i] != AF_RAM_FILL;
+	}
+	for (i = 0; i < count; i++)
+	{
+		if (orig[i].type != FULLCAN_ENTRY)
+		{
+			continue;
+		}
+		for (j = 0, below = 0; j < count; j++)
+		{
+			dup = 0;
+			if ((orig[j].type == FULLCAN_ENTRY) && \
+				((orig[j].controller << 13 | orig[j].lowerID) < (orig[i].controller << 13 | orig[i].lowerID)))
+			{
+				// Count each smaller ID once
+				for (end = 0; (end < j) && !dup; end++)
+				{
+					dup = (orig[end].type == FULLCAN_ENTRY) && (orig[end].controller == orig[j].controller) && \
+						  (orig[end].lowerID == orig[j].lowerID);
+				}
+				below += !dup;
+			}
+		}
+		obj = CAN_FullCANFindObj(orig[i].controller, (uint16_t)orig[i].lowerID);
+		bad += obj != (int32_t)below;
+	}
+	return bad;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Build orig into the AF RAM, filled beforehand so that
+ * 				stray writes show
+ * @param[in]	count	Entries in orig
+ * @return 		CAN_BuildAFLUT() result
+ **********************************************************************/
+static CAN_ERROR table_build (uint32_t count)
+{
+	uint32_t i;
+
+	for (i = 0; i < CAN_AF_RAM_WORDS; i++)
+	{
+		LPC_CANAF_RAM->mask[i] = AF_RAM_FILL;
+	}
+	memcpy(list, orig, count * sizeof(list[0]));
+	return CAN_BuildAFLUT(LPC_CANAF, list, (uint16_t)count);
+}
+
+
+/* Tests ---------------------------------------------------------------------- */
+/*********************************************************************//**
+ * @brief 		Random lists of every size up to LIST_MAX, with narrow
+ * 				and full ID spans
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void test_random (void)
+{
+	static const uint32_t std_span[3] = {24, 256, 0x800};
+	static const uint32_t ext_span[3] = {96, 4096, 0x20000000};
+	uint32_t count, s, built = 0, fail = 0, bad = 0, faults = 0;
+
+	for (s = 0; s < 3; s++)
+	{
+		for (count = 0; count <= LIST_MAX; count += 1 + count / 8)
+		{
+			list_make(count, std_span[s], ext_span[s]);
+			if (table_build(count) != CAN_OK)
+			{
+				fail++;
+				continue;
+			}
+			built++;
+			faults += table_check(count);
+			bad += lookup_compare(count, ext_span[s]);
+		}
+	}
+	host_printf("random    %u tables: %u IDs disagree with the brute force search, "
+				"%u table faults\n", built, bad, faults);
+	HOST_CHECK(fail == 0);
+	HOST_CHECK(bad == 0);
+	HOST_CHECK(faults == 0);
+}
+
+
+/*********************************************************************//**
+ * @brief 		Lists that do not load keep the table in use
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void test_errors (void)
+{
+	uint32_t i, count = 40;
+
+	list_make(count, 256, 4096);
+	HOST_CHECK(table_build(count) == CAN_OK);
+
+	// Bad ID, bad group, bad controller
+	memcpy(list, orig, count * sizeof(list[0]));
+	list[7].type = EXPLICIT_STANDARD_ENTRY;
+	list[7].lowerID = 0x800;
+	HOST_CHECK(CAN_BuildAFLUT(LPC_CANAF, list, (uint16_t)count) == CAN_AF_ENTRY_ERROR);
+
+	memcpy(list, orig, count * sizeof(list[0]));
+	list[3].type = GROUP_EXTEND_ENTRY;
+	list[3].lowerID = 100;
+	list[3].upperID = 99;
+	HOST_CHECK(CAN_BuildAFLUT(LPC_CANAF, list, (uint16_t)count) == CAN_AF_ENTRY_ERROR);
+
+	memcpy(list, orig, count * sizeof(list[0]));
+	list[0].controller = 2;
+	HOST_CHECK(CAN_BuildAFLUT(LPC_CANAF, list, (uint16_t)count) == CAN_AF_ENTRY_ERROR);
+
+	// Too many FullCAN IDs, or more words than the AF RAM has
+	for (i = 0; i <= CAN_AF_RAM_WORDS; i++)
+	{
+		list[i].type = FULLCAN_ENTRY;
+		list[i].controller = CAN1_CTRL;
+		list[i].disable = MSG_ENABLE;
+		list[i].lowerID = i;
+	}
+	HOST_CHECK(CAN_BuildAFLUT(LPC_CANAF, list, MAX_HW_FULLCAN_OBJ + 1) == CAN_OBJECTS_FULL_ERROR);
+	for (i = 0; i <= CAN_AF_RAM_WORDS; i++)
+	{
+		list[i].type = EXPLICIT_EXTEND_ENTRY;
+	}
+	HOST_CHECK(CAN_BuildAFLUT(LPC_CANAF, list, CAN_AF_RAM_WORDS + 1) == CAN_OBJECTS_FULL_ERROR);
+
+	// None of them touched the table in use
+	HOST_CHECK(table_check(count) == 0);
+	HOST_CHECK(lookup_compare(count, 4096) == 0);
+
+	// The AF RAM to the last word
+	HOST_CHECK(CAN_BuildAFLUT(LPC_CANAF, list, CAN_AF_RAM_WORDS) == CAN_OK);
+	HOST_CHECK(LPC_CANAF->ENDofTable == CAN_AF_RAM_WORDS * 4);
+
+	// Bypass takes everything, off takes nothing
+	CAN_SetAFMode(LPC_CANAF, CAN_AccBP);
+	HOST_CHECK(CAN_AFLookup(CAN2_CTRL, 0x123, STD_ID_FORMAT) == TRUE);
+	CAN_SetAFMode(LPC_CANAF, CAN_AccOff);
+	HOST_CHECK(CAN_AFLookup(CAN1_CTRL, CAN_AF_RAM_WORDS - 1, EXT_ID_FORMAT) == FALSE);
+	CAN_SetAFMode(LPC_CANAF, CAN_Normal);
+	HOST_CHECK(CAN_AFLookup(CAN1_CTRL, CAN_AF_RAM_WORDS - 1, EXT_ID_FORMAT) == TRUE);
+}
+
+
+/*********************************************************************//**
+ * @brief 		BENCH_IDS IDs loaded one by one through the shifting
+ * 				CAN_LoadExplicitEntry() and CAN_LoadFullCANEntry(), and
+ * 				in one batch; both tables must filter alike
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void bench (void)
+{
+	uint32_t i, j, runs = 200, bad;
+	double t_one, t_batch;
+
+	// Distinct IDs, two thirds standard and a few of those FullCAN
+	for (i = 0; i < BENCH_IDS; i++)
+	{
+		do
+		{
+			orig[i].type = (i % 3) ? ((i % 10) ? EXPLICIT_STANDARD_ENTRY : FULLCAN_ENTRY) : EXPLICIT_EXTEND_ENTRY;
+			orig[i].controller = (uint8_t)(rnd_next() & 1);
+			orig[i].disable = MSG_ENABLE;
+			orig[i].lowerID = rnd_next() & ((i % 3) ? 0x7FF : 0x1FFFFFFF);
+			orig[i].upperID = 0;
+			for (j = 0; (j < i) && ((orig[j].type != orig[i].type) || (orig[j].controller != orig[i].controller) || \
+				 (orig[j].lowerID != orig[i].lowerID)); j++);
+		} while (j < i);
+	}
+
+	t_one = host_seconds();
+	for (j = 0; j < runs; j++)
+	{
+		CANAF_FullCAN_cnt = CANAF_std_cnt = CANAF_gstd_cnt = CANAF_ext_cnt = CANAF_gext_cnt = 0;
+		memset((void *)LPC_CANAF_RAM, 0, sizeof(*LPC_CANAF_RAM));
+		LPC_CANAF->SFF_sa = LPC_CANAF->SFF_GRP_sa = LPC_CANAF->EFF_sa = 0;
+		LPC_CANAF->EFF_GRP_sa = LPC_CANAF->ENDofTable = 0;
+		for (i = 0; i < BENCH_IDS; i++)
+		{
+			if (orig[i].type == FULLCAN_ENTRY)
+			{
+				CAN_LoadFullCANEntry(orig[i].controller ? LPC_CAN2 : LPC_CAN1, (uint16_t)orig[i].lowerID);
+				continue;
+			}
+			CAN_LoadExplicitEntry(orig[i].controller ? LPC_CAN2 : LPC_CAN1, orig[i].lowerID,
+								  (orig[i].type == EXPLICIT_STANDARD_ENTRY) ? STD_ID_FORMAT : EXT_ID_FORMAT);
+		}
+	}
+	t_one = (host_seconds() - t_one) / runs;
+	bad = lookup_compare(BENCH_IDS, 0x20000000);
+
+	t_batch = host_seconds();
+	for (j = 0; j < runs; j++)
+	{
+		memcpy(list, orig, sizeof(orig));
+		CAN_BuildAFLUT(LPC_CANAF, list, BENCH_IDS);
+	}
+	t_batch = (host_seconds() - t_batch) / runs;
+	bad += lookup_compare(BENCH_IDS, 0x20000000);
+
+	host_printf("bench     %u IDs: one by one %.1f us, batch %.1f us (%.0fx)\n",
+				BENCH_IDS, t_one * 1e6, t_batch * 1e6, t_one / t_batch);
+	HOST_CHECK(bad == 0);
+	HOST_CHECK(t_batch < t_one);
+}
+
+
+int main (void)
+{
+	test_random();
+	test_errors();
+	bench();
+
+	return host_done("test_can_af");
+}
+
+/* --------------------------------- End Of File ------------------------------ */
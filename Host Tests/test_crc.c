@@ -0,0 +1,251 @@
+/******************************************************************//**
+* @file		test_crc.c
+* @brief	Host test and benchmark of the shared CRC engine: reference
+* 			vectors, a bitwise reference on random data at every
+* 			alignment and split, and throughput of each CRC
+* @version	1.0
+* @date		21. July. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* Runs twice, see Makefile: test_crc with the byte tables (CRC_FAST_SEL
+ * 1) and test_crc_small with the nibble tables (CRC_FAST_SEL 0) */
+
+/* Includes ------------------------------------------------------------------- */
+#include <string.h>
+#include "host.h"
+#include "lpc_crc.h"
+
+
+/* Private Macros ------------------------------------------------------------- */
+/** Bytes hashed per benchmark run */
+#define BENCH_BYTES			(32UL << 20)
+
+#ifdef CRC_FAST_MODE
+#define TEST_NAME			"test_crc (byte tables)"
+#else
+#define TEST_NAME			"test_crc (nibble tables)"
+#endif
+
+
+/* Private Variables ---------------------------------------------------------- */
+static uint8_t buf[4096 + 8];
+static uint32_t rnd = 12345;
+
+
+/* Private Functions ---------------------------------------------------------- */
+/*********************************************************************//**
+ * @brief 		Repeatable test data
+ * @param		None
+ * @return 		Pseudo random byte
+ **********************************************************************/
+static uint8_t rnd_byte (void)
+{
+	rnd = rnd * 1103515245 + 12345;
+	return (uint8_t)(rnd >> 16);
+}
+
+
+/*********************************************************************//**
+ * @brief 		Bitwise references, straight from the polynomials
+ * @param[in]	data	Data
+ * @param[in]	len		Number of bytes
+ * @return 		CRC, final form as the *_Calc() functions return it
+ **********************************************************************/
+static uint32_t ref_crc32 (const uint8_t *data, uint32_t len)
+{
+	uint32_t crc = 0xFFFFFFFF, i;
+
+	while (len--)
+	{
+		crc ^= *data++;
+		for (i = 0; i < 8; i++)
+		{
+			crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320 : 0);
+		}
+	}
+	return ~crc;
+}
+
+
+static uint16_t ref_crc16 (const uint8_t *data, uint32_t len)
+{
+	uint16_t crc = 0;
+	uint32_t i;
+
+	while (len--)
+	{
+		crc ^= (uint16_t)(*data++ << 8);
+		for (i = 0; i < 8; i++)
+		{
+			crc = (uint16_t)((crc << 1) ^ ((crc & 0x8000) ? 0x1021 : 0));
+		}
+	}
+	return crc;
+}
+
+
+static uint8_t ref_crc7 (const uint8_t *data, uint32_t len)
+{
+	uint8_t crc = 0;
+	uint32_t i;
+
+	while (len--)
+	{
+		for (i = 0; i < 8; i++)
+		{
+			uint8_t in = ((*data >> (7 - i)) & 1) ^ (crc >> 6);
+
+			crc = (uint8_t)((crc << 1) & 0x7F);
+			if (in)
+			{
+				crc ^= 0x09;
+			}
+		}
+		data++;
+	}
+	return crc;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Published check values and SD command tokens
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void test_vectors (void)
+{
+	static const uint8_t check[] = "123456789";
+	static const uint8_t cmd0[5] = {0x40, 0, 0, 0, 0};
+	static const uint8_t cmd8[5] = {0x48, 0, 0, 0x01, 0xAA};
+	static const uint8_t cmd17[5] = {0x51, 0, 0, 0, 0};
+	uint8_t ff[512];
+
+	HOST_CHECK(CRC32_Calc(check, 9) == 0xCBF43926);
+	HOST_CHECK(CRC16_Calc(check, 9) == 0x31C3);
+	HOST_CHECK(CRC7_Calc(check, 9) == 0x75);
+	HOST_CHECK(CRC32_Calc(check, 0) == 0);
+
+	// Command tokens end in (CRC7 << 1) | 1
+	HOST_CHECK(((CRC7_Calc(cmd0, 5) << 1) | 1) == 0x95);
+	HOST_CHECK(((CRC7_Calc(cmd8, 5) << 1) | 1) == 0x87);
+	HOST_CHECK(((CRC7_Calc(cmd17, 5) << 1) | 1) == 0x55);
+
+	// Erased SD data block, from the SD physical layer specification
+	memset(ff, 0xFF, sizeof(ff));
+	HOST_CHECK(CRC16_Calc(ff, 512) == 0x7FA1);
+}
+
+
+/*********************************************************************//**
+ * @brief 		Random data at every start alignment and short length,
+ * 				and every split of the incremental API
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void test_random (void)
+{
+	uint32_t i, off, len, cut, bad = 0;
+	uint32_t c32;
+	uint16_t c16;
+	uint8_t c7;
+
+	for (i = 0; i < sizeof(buf); i++)
+	{
+		buf[i] = rnd_byte();
+	}
+
+	for (off = 0; off < 8; off++)
+	{
+		for (len = 0; len <= 80; len++)
+		{
+			const uint8_t *p = &buf[off];
+
+			bad += CRC32_Calc(p, len) != ref_crc32(p, len);
+			bad += CRC16_Calc(p, len) != ref_crc16(p, len);
+			bad += CRC7_Calc(p, len) != ref_crc7(p, len);
+
+			for (cut = 0; cut <= len; cut++)
+			{
+				c32 = CRC32_Update(CRC32_Update(CRC32_INIT, p, cut), p + cut, len - cut);
+				c16 = CRC16_Update(CRC16_Update(CRC16_INIT, p, cut), p + cut, len - cut);
+				c7 = CRC7_Update(CRC7_Update(CRC7_INIT, p, cut), p + cut, len - cut);
+				bad += CRC32_FINAL(c32) != ref_crc32(p, len);
+				bad += c16 != ref_crc16(p, len);
+				bad += c7 != ref_crc7(p, len);
+			}
+		}
+	}
+	HOST_CHECK(bad == 0);
+
+	// Long unaligned run through the four byte loop
+	HOST_CHECK(CRC32_Calc(&buf[3], 4096) == ref_crc32(&buf[3], 4096));
+	HOST_CHECK(CRC16_Calc(&buf[1], 4096) == ref_crc16(&buf[1], 4096));
+}
+
+
+/*********************************************************************//**
+ * @brief 		Throughput of each CRC on 512 byte blocks (SD sector)
+ * 				and 1518 byte blocks (Ethernet frame)
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void bench (void)
+{
+	static const uint32_t sizes[2] = {512, 1518};
+	volatile uint32_t sink = 0;
+	uint32_t s, n, runs;
+	double t;
+
+	for (s = 0; s < 2; s++)
+	{
+		runs = BENCH_BYTES / sizes[s];
+
+		t = host_seconds();
+		for (n = 0; n < runs; n++)
+		{
+			sink += CRC32_Calc(buf, sizes[s]);
+		}
+		t = host_seconds() - t;
+		host_printf("CRC32 %4u B blocks: %7.1f MB/s\n", sizes[s], runs * sizes[s] / t / 1e6);
+
+		t = host_seconds();
+		for (n = 0; n < runs; n++)
+		{
+			sink += CRC16_Calc(buf, sizes[s]);
+		}
+		t = host_seconds() - t;
+		host_printf("CRC16 %4u B blocks: %7.1f MB/s\n", sizes[s], runs * sizes[s] / t / 1e6);
+	}
+
+	// CRC-7 only ever sees 5 byte command tokens
+	runs = BENCH_BYTES / 5;
+	t = host_seconds();
+	for (n = 0; n < runs; n++)
+	{
+		sink += CRC7_Calc(&buf[n & 1023], 5);
+	}
+	t = host_seconds() - t;
+	host_printf("CRC7  command token: %7.1f ns\n", t / runs * 1e9);
+
+	t = host_seconds();
+	for (n = 0; n < runs / 64; n++)
+	{
+		sink += ref_crc32(buf, 512);
+	}
+	t = host_seconds() - t;
+	host_printf("CRC32 bitwise ref  : %7.1f MB/s\n", runs / 64 * 512.0 / t / 1e6);
+	(void)sink;
+}
+
+
+int main (void)
+{
+	test_vectors();
+	test_random();
+	bench();
+
+	return host_done(TEST_NAME);
+}
+
+/* --------------------------------- End Of File ------------------------------ */
@@ -0,0 +1,615 @@
+/******************************************************************//**
+* @file		test_fat.c
+* @brief	Host test and benchmark of the FAT16/FAT32 layer on a disk
+* 			image in memory: formatting, file round trips checked by an
+* 			independent image walker, directory growth, errors, and
+* 			disk traffic of logging and bulk workloads
+* @version	1.0
+* @date		21. July. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* The image is a FAT_DISK_Type like FAT_SdDisk. After each volume test it
+ * is saved to build/test_fat/fat16.img and fat32.img, e.g. for
+ * fsck.fat -n on a machine that has it. */
+
+/* Includes ------------------------------------------------------------------- */
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "host.h"
+#include "lpc_fat.h"
+
+
+/* Private Macros ------------------------------------------------------------- */
+#define SEC					FAT_SECTOR_SIZE
+
+#define LD16(p)				((uint16_t)((p)[0] | ((p)[1] << 8)))
+#define LD32(p)				((uint32_t)((p)[0] | ((p)[1] << 8) | ((p)[2] << 16) | ((uint32_t)(p)[3] << 24)))
+#define ST16(p,v)			do { (p)[0] = (uint8_t)(v); (p)[1] = (uint8_t)((v) >> 8); } while (0)
+#define ST32(p,v)			do { ST16(p, v); ST16((p) + 2, (v) >> 16); } while (0)
+
+
+/* Private Types -------------------------------------------------------------- */
+/** Layout of the formatted volume, as the test's own walker sees it */
+typedef struct {
+	uint32_t type;				/**< 16 or 32 */
+	uint32_t base;				/**< Partition start, 0 without MBR */
+	uint32_t spc;				/**< Sectors per cluster */
+	uint32_t fat;				/**< First FAT sector */
+	uint32_t fatsz;				/**< Sectors per FAT */
+	uint32_t root;				/**< FAT16 root directory sector */
+	uint32_t rootsecs;			/**< FAT16 root directory length */
+	uint32_t rootclus;			/**< FAT32 root cluster */
+	uint32_t data;				/**< Sector of cluster 2 */
+	uint32_t clusters;			/**< Data clusters */
+	uint32_t logclus;			/**< Cluster of the LOG directory */
+} IMG_LAYOUT_Type;
+
+/** Disk traffic */
+typedef struct {
+	uint32_t reads, writes;		/**< Read()/Write() calls */
+	uint32_t rsec, wsec;		/**< Sectors moved */
+	uint32_t fatr, fatw;		/**< Of which in the FAT copies */
+} IMG_STAT_Type;
+
+
+/* Private Variables ---------------------------------------------------------- */
+static uint8_t *img;
+static uint32_t img_sectors;
+static IMG_LAYOUT_Type lay;
+static IMG_STAT_Type io;
+static int img_fail;				// fail disk access once this reaches 1
+static uint32_t rnd = 1;
+
+static uint8_t data[4 << 20], back[4 << 20];
+static FAT_FILE_Type f;
+
+
+/* Private Functions ---------------------------------------------------------- */
+/*********************************************************************//**
+ * @brief 		Count the FAT sectors of a transfer
+ * @param[in]	sector	First sector
+ * @param[in]	count	Number of sectors
+ * @return 		Sectors inside the FAT copies
+ **********************************************************************/
+static uint32_t img_in_fat (uint32_t sector, uint32_t count)
+{
+	uint32_t n = 0;
+
+	while (count--)
+	{
+		if ((sector >= lay.fat) && (sector < lay.fat + 2 * lay.fatsz)) n++;
+		sector++;
+	}
+	return n;
+}
+
+
+static Status img_read (uint32_t sector, uint8_t *buf, uint32_t count)
+{
+	if ((img_fail && (--img_fail == 0)) || (sector + count > img_sectors)) return ERROR;
+	memcpy(buf, &img[(size_t)sector * SEC], (size_t)count * SEC);
+	io.reads++;
+	io.rsec += count;
+	io.fatr += img_in_fat(sector, count);
+	return SUCCESS;
+}
+
+
+static Status img_write (uint32_t sector, const uint8_t *buf, uint32_t count)
+{
+	if ((img_fail && (--img_fail == 0)) || (sector + count > img_sectors)) return ERROR;
+	memcpy(&img[(size_t)sector * SEC], buf, (size_t)count * SEC);
+	io.writes++;
+	io.wsec += count;
+	io.fatw += img_in_fat(sector, count);
+	return SUCCESS;
+}
+
+/** The image as block device */
+static const FAT_DISK_Type img_disk = { img_read, img_write };
+
+
+/*********************************************************************//**
+ * @brief 		Save the image next to the test binary
+ * @param[in]	name	File name
+ * @return 		None
+ **********************************************************************/
+static void img_save (const char *name)
+{
+	char path[64] = "build/test_fat/";
+	int fd;
+
+	strcat(path, name);
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	HOST_CHECK(fd >= 0);
+	if (fd >= 0)
+	{
+		HOST_CHECK(write(fd, img, (size_t)img_sectors * SEC) == (ssize_t)img_sectors * SEC);
+		close(fd);
+	}
+}
+
+
+/* Stubs ---------------------------------------------------------------------- */
+/* FAT_SdDisk is linked in but never mounted here */
+sd_error SD_ReadBlocks (uint32_t block, uint8_t *buffer, uint32_t count)
+{
+	return SD_NG;
+}
+
+
+sd_error SD_WriteBlocks (uint32_t block, const uint8_t *buffer, uint32_t count)
+{
+	return SD_NG;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Format a fresh image, as mkfs.fat would, with a LOG
+ * 				directory in the root
+ * @param[in]	sectors		Image size
+ * @param[in]	type		16 or 32
+ * @param[in]	spc			Sectors per cluster
+ * @param[in]	base		Partition start, 0 for a bare volume
+ * @return 		None
+ **********************************************************************/
+static void img_format (uint32_t sectors, uint32_t type, uint32_t spc, uint32_t base)
+{
+	uint32_t rsvd = (type == 16) ? 1 : 32, total = sectors - base, i;
+	uint8_t *b, *e;
+
+	free(img);
+	img = calloc(sectors, SEC);
+	img_sectors = sectors;
+	memset(&lay, 0, sizeof(lay));
+	lay.type = type;
+	lay.base = base;
+	lay.spc = spc;
+	lay.rootsecs = (type == 16) ? 32 : 0;	// 512 entries
+
+	// FAT size: grow until it covers every cluster left over
+	for (lay.fatsz = 1; ; lay.fatsz++)
+	{
+		lay.clusters = (total - rsvd - 2 * lay.fatsz - lay.rootsecs) / spc;
+		if (lay.fatsz * SEC / (type / 8) >= lay.clusters + 2) break;
+	}
+	lay.fat = base + rsvd;
+	lay.root = lay.fat + 2 * lay.fatsz;
+	lay.data = lay.root + lay.rootsecs;
+	HOST_CHECK((type == 16) ? (lay.clusters >= 4085 && lay.clusters < 65525) : (lay.clusters >= 65525));
+
+	if (base)
+	{
+		b = img;
+		b[446 + 4] = (type == 16) ? 0x06 : 0x0C;
+		ST32(b + 446 + 8, base);
+		ST32(b + 446 + 12, total);
+		ST16(b + 510, 0xAA55);
+	}
+
+	b = &img[(size_t)base * SEC];
+	b[0] = 0xEB; b[1] = 0x3C; b[2] = 0x90;
+	memcpy(b + 3, "MSWIN4.1", 8);
+	ST16(b + 11, SEC);
+	b[13] = (uint8_t)spc;
+	ST16(b + 14, rsvd);
+	b[16] = 2;
+	ST16(b + 17, lay.rootsecs * SEC / 32);
+	if (total < 65536) ST16(b + 19, total);
+	else ST32(b + 32, total);
+	b[21] = 0xF8;
+	if (type == 16)
+	{
+		ST16(b + 22, lay.fatsz);
+	}
+	else
+	{
+		ST32(b + 36, lay.fatsz);
+		lay.rootclus = 2;
+		ST32(b + 44, lay.rootclus);
+		ST16(b + 48, 1);
+		e = b + SEC;						// FSInfo
+		ST32(e, 0x41615252);
+		ST32(e + 484, 0x61417272);
+		ST32(e + 488, lay.clusters - 2);
+		ST32(e + 492, 4);
+		ST16(e + 510, 0xAA55);
+	}
+	ST16(b + 510, 0xAA55);
+
+	// Reserved entries, FAT32 root, LOG directory; both copies
+	lay.logclus = (type == 16) ? 2 : 3;
+	for (i = 0; i < 2; i++)
+	{
+		b = &img[(size_t)(lay.fat + i * lay.fatsz) * SEC];
+		if (type == 16)
+		{
+			ST16(b, 0xFFF8); ST16(b + 2, 0xFFFF);
+			ST16(b + 2 * lay.logclus, 0xFFFF);
+		}
+		else
+		{
+			ST32(b, 0x0FFFFFF8); ST32(b + 4, 0x0FFFFFFF);
+			ST32(b + 4 * lay.rootclus, 0x0FFFFFFF);
+			ST32(b + 4 * lay.logclus, 0x0FFFFFFF);
+		}
+	}
+
+	e = &img[(size_t)((type == 16) ? lay.root : lay.data) * SEC];
+	memcpy(e, "LOG        ", 11);
+	e[11] = FAT_ATTR_DIRECTORY;
+	ST16(e + 26, lay.logclus);
+
+	e = &img[(size_t)(lay.data + (lay.logclus - 2) * spc) * SEC];
+	memcpy(e, ".          ", 11);
+	e[11] = FAT_ATTR_DIRECTORY;
+	ST16(e + 26, lay.logclus);
+	memcpy(e + 32, "..         ", 11);
+	e[32 + 11] = FAT_ATTR_DIRECTORY;
+}
+
+
+/*********************************************************************//**
+ * @brief 		FAT entry as stored in one copy
+ * @param[in]	copy	FAT copy, 0 or 1
+ * @param[in]	clus	Cluster
+ * @return 		Next cluster, 0xFFFFFFFF at end of chain
+ **********************************************************************/
+static uint32_t img_fat (uint32_t copy, uint32_t clus)
+{
+	uint8_t *b = &img[(size_t)(lay.fat + copy * lay.fatsz) * SEC];
+	uint32_t v;
+
+	if (lay.type == 16)
+	{
+		v = LD16(b + 2 * clus);
+		return (v >= 0xFFF8) ? 0xFFFFFFFF : v;
+	}
+	v = LD32(b + 4 * clus) & 0x0FFFFFFF;
+	return (v >= 0x0FFFFFF8) ? 0xFFFFFFFF : v;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Read a file straight from the image: find the entry,
+ * 				follow the chain and check it fits the size
+ * @param[in]	dir		Directory cluster, 0 for the root
+ * @param[in]	name	8.3 name, space padded
+ * @param[out]	buf		File contents
+ * @return 		File size, 0xFFFFFFFF if missing or inconsistent
+ **********************************************************************/
+static uint32_t img_file (uint32_t dir, const char *name, uint8_t *buf)
+{
+	uint32_t clus = dir ? dir : lay.rootclus, sec = 0, nsec, size, n, got = 0;
+	uint8_t *e = NULL;
+
+	// Entry: FAT16 root is fixed, anything else is a chain
+	while (e == NULL)
+	{
+		if (clus == 0)
+		{
+			sec = lay.root;
+			nsec = lay.rootsecs;
+		}
+		else
+		{
+			sec = lay.data + (clus - 2) * lay.spc;
+			nsec = lay.spc;
+		}
+		for (n = 0; (n < nsec * SEC / 32) && (e == NULL); n++)
+		{
+			if (memcmp(&img[(size_t)sec * SEC + n * 32], name, 11) == 0)
+			{
+				e = &img[(size_t)sec * SEC + n * 32];
+			}
+		}
+		if (e != NULL) break;
+		if ((clus == 0) || ((clus = img_fat(0, clus)) == 0xFFFFFFFF)) return 0xFFFFFFFF;
+	}
+
+	size = LD32(e + 28);
+	clus = ((uint32_t)LD16(e + 20) << 16) | LD16(e + 26);
+	while (got < size)
+	{
+		if ((clus < 2) || (clus >= lay.clusters + 2)) return 0xFFFFFFFF;
+		n = lay.spc * SEC;
+		if (n > size - got) n = size - got;
+		memcpy(buf + got, &img[(size_t)(lay.data + (clus - 2) * lay.spc) * SEC], n);
+		got += n;
+		clus = img_fat(0, clus);
+	}
+	return (clus == 0xFFFFFFFF) || (size == 0) ? size : 0xFFFFFFFF;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Both FAT copies equal and no cluster in two chains
+ * @param		None
+ * @return 		TRUE if consistent
+ **********************************************************************/
+static Bool img_consistent (void)
+{
+	static uint8_t used[1 << 17];
+	uint32_t c, next;
+
+	if (memcmp(&img[(size_t)lay.fat * SEC], &img[(size_t)(lay.fat + lay.fatsz) * SEC],
+			   (size_t)lay.fatsz * SEC) != 0) return FALSE;
+
+	memset(used, 0, sizeof(used));
+	for (c = 2; c < lay.clusters + 2; c++)
+	{
+		next = img_fat(0, c);
+		if ((next == 0) || (next == 0xFFFFFFFF)) continue;
+		if ((next < 2) || (next >= lay.clusters + 2) || used[next]) return FALSE;
+		used[next] = 1;
+	}
+	return TRUE;
+}
+
+
+static void fill (uint8_t *buf, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++)
+	{
+		rnd = rnd * 1103515245 + 12345;
+		buf[i] = (uint8_t)(rnd >> 16);
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief 		Write a file in mixed chunk sizes, read it back through
+ * 				the layer and from the image, seek and append
+ * @param[in]	path	File path
+ * @param[in]	dir		Cluster of its directory for img_file(), 0 root
+ * @param[in]	name	Its 8.3 name
+ * @return 		None
+ **********************************************************************/
+static void test_roundtrip (const char *path, uint32_t dir, const char *name)
+{
+	static const uint32_t chunk[] = {1, 100, 511, 512, 2048, 5000, 37, 65536, 3};
+	uint32_t len = 0, n, done, i, pos;
+
+	fill(data, sizeof(data));
+	HOST_CHECK(FAT_Open(&f, path, FAT_WRITE | FAT_CREATE) == FAT_OK);
+	for (i = 0; len + chunk[i % 9] < 300000; i++)
+	{
+		n = chunk[i % 9];
+		HOST_CHECK((FAT_Write(&f, &data[len], n, &done) == FAT_OK) && (done == n));
+		len += n;
+	}
+	HOST_CHECK(FAT_Close(&f) == FAT_OK);
+	HOST_CHECK(img_file(dir, name, back) == len);
+	HOST_CHECK(memcmp(back, data, len) == 0);
+	HOST_CHECK(img_consistent());
+
+	// Read back in other chunk sizes
+	memset(back, 0, len);
+	HOST_CHECK(FAT_Open(&f, path, FAT_READ) == FAT_OK);
+	for (pos = 0, i = 3; pos < len; pos += done, i++)
+	{
+		HOST_CHECK(FAT_Read(&f, &back[pos], chunk[i % 9], &done) == FAT_OK);
+		if (done == 0) break;
+	}
+	HOST_CHECK(pos == len);
+	HOST_CHECK(memcmp(back, data, len) == 0);
+	HOST_CHECK((FAT_Read(&f, back, 10, &done) == FAT_OK) && (done == 0));
+
+	// Seeks backwards and forwards
+	for (i = 0; i < 50; i++)
+	{
+		rnd = rnd * 1103515245 + 12345;
+		pos = (rnd >> 8) % len;
+		HOST_CHECK(FAT_Seek(&f, pos) == FAT_OK);
+		HOST_CHECK(FAT_Read(&f, back, 700, &done) == FAT_OK);
+		HOST_CHECK((done == ((len - pos < 700) ? len - pos : 700)) && (memcmp(back, &data[pos], done) == 0));
+	}
+	HOST_CHECK(FAT_Write(&f, data, 1, &done) == FAT_ERR_DENIED);
+	HOST_CHECK(FAT_Close(&f) == FAT_OK);
+
+	// Overwrite inside, then append
+	fill(&data[1000], 3000);
+	HOST_CHECK(FAT_Open(&f, path, FAT_READ | FAT_WRITE) == FAT_OK);
+	HOST_CHECK(FAT_Seek(&f, 1000) == FAT_OK);
+	HOST_CHECK(FAT_Write(&f, &data[1000], 3000, &done) == FAT_OK);
+	HOST_CHECK(FAT_Close(&f) == FAT_OK);
+	fill(&data[len], 10000);
+	HOST_CHECK(FAT_Open(&f, path, FAT_APPEND) == FAT_OK);
+	HOST_CHECK(FAT_Write(&f, &data[len], 10000, &done) == FAT_OK);
+	HOST_CHECK(FAT_Close(&f) == FAT_OK);
+	len += 10000;
+	HOST_CHECK(img_file(dir, name, back) == len);
+	HOST_CHECK(memcmp(back, data, len) == 0);
+	HOST_CHECK(img_consistent());
+}
+
+
+/*********************************************************************//**
+ * @brief 		Enough files to grow the LOG directory past its first
+ * 				cluster, each findable afterwards
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void test_dir_growth (void)
+{
+	char path[20] = "LOG/F000.DAT", name[12] = "F000    DAT";
+	uint32_t i, n = lay.spc * SEC / 32 + 5, done;
+	uint8_t b[4];
+
+	for (i = 0; i < n; i++)
+	{
+		path[5] = name[1] = '0' + i / 100;
+		path[6] = name[2] = '0' + i / 10 % 10;
+		path[7] = name[3] = '0' + i % 10;
+		HOST_CHECK(FAT_Open(&f, path, FAT_WRITE | FAT_CREATE) == FAT_OK);
+		ST32(b, i);
+		HOST_CHECK(FAT_Write(&f, b, 4, &done) == FAT_OK);
+		HOST_CHECK(FAT_Close(&f) == FAT_OK);
+	}
+	HOST_CHECK(img_fat(0, lay.logclus) != 0xFFFFFFFF);		// grew
+	for (i = 0; i < n; i += 7)
+	{
+		path[5] = name[1] = '0' + i / 100;
+		path[6] = name[2] = '0' + i / 10 % 10;
+		path[7] = name[3] = '0' + i % 10;
+		HOST_CHECK((img_file(lay.logclus, name, b) == 4) && (LD32(b) == i));
+		HOST_CHECK(FAT_Open(&f, path, FAT_READ) == FAT_OK);
+		HOST_CHECK((FAT_Read(&f, b, 4, &done) == FAT_OK) && (LD32(b) == i));
+		HOST_CHECK(FAT_Close(&f) == FAT_OK);
+	}
+	HOST_CHECK(img_consistent());
+}
+
+
+/*********************************************************************//**
+ * @brief 		Names, modes and disk errors
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void test_errors (void)
+{
+	uint32_t done;
+
+	HOST_CHECK(FAT_Open(&f, "NONE.TXT", FAT_READ) == FAT_ERR_NOT_FOUND);
+	HOST_CHECK(FAT_Open(&f, "NODIR/A.TXT", FAT_READ | FAT_CREATE) == FAT_ERR_NOT_FOUND);
+	HOST_CHECK(FAT_Open(&f, "TOOLONGNAME.TXT", FAT_WRITE | FAT_CREATE) == FAT_ERR_PARAM);
+	HOST_CHECK(FAT_Open(&f, "A.TOOL", FAT_WRITE | FAT_CREATE) == FAT_ERR_PARAM);
+	HOST_CHECK(FAT_Open(&f, "A*.TXT", FAT_WRITE | FAT_CREATE) == FAT_ERR_PARAM);
+	HOST_CHECK(FAT_Open(&f, "LOG", FAT_READ) == FAT_ERR_DENIED);
+	HOST_CHECK(FAT_Open(&f, "E.TXT", FAT_CREATE) == FAT_ERR_PARAM);
+	HOST_CHECK(FAT_Read(&f, back, 1, &done) == FAT_ERR_DENIED);
+
+	// Disk fails on the way: the error comes back, a retry works
+	HOST_CHECK(FAT_Open(&f, "ERR.BIN", FAT_WRITE | FAT_CREATE) == FAT_OK);
+	img_fail = 1 + 3;
+	HOST_CHECK(FAT_Write(&f, data, 100000, &done) == FAT_ERR_DISK);
+	img_fail = 0;
+	HOST_CHECK(FAT_Close(&f) == FAT_OK);
+	HOST_CHECK(img_consistent());
+}
+
+
+/*********************************************************************//**
+ * @brief 		Fill the volume: FAT_ERR_FULL, nothing cross-linked
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void test_full (void)
+{
+	uint32_t done, total = 0;
+	fat_error ret;
+
+	img_format(12000, 16, 1, 0);
+	HOST_CHECK(FAT_Mount(&img_disk) == FAT_OK);
+	HOST_CHECK(FAT_Open(&f, "BIG.BIN", FAT_WRITE | FAT_CREATE) == FAT_OK);
+	do
+	{
+		ret = FAT_Write(&f, data, sizeof(data), &done);
+		total += done;
+	} while (ret == FAT_OK);
+	HOST_CHECK(ret == FAT_ERR_FULL);
+	HOST_CHECK(total == (lay.clusters - 1) * SEC);			// LOG holds one
+	HOST_CHECK(FAT_Close(&f) == FAT_OK);
+	HOST_CHECK(img_file(0, "BIG     BIN", back) == total);
+	HOST_CHECK(img_consistent());
+}
+
+
+/*********************************************************************//**
+ * @brief 		Disk traffic of a logger (64 byte records, flushed every
+ * 				4kB), of 16kB bulk writes and of 4kB reads
+ * @param[in]	name	Volume, for the report
+ * @return 		None
+ **********************************************************************/
+static void bench (const char *name)
+{
+	uint32_t i, done, bytes;
+	double t;
+
+	memset(&io, 0, sizeof(io));
+	bytes = 1 << 20;
+	t = host_seconds();
+	HOST_CHECK(FAT_Open(&f, "LOG/BENCH.CSV", FAT_APPEND | FAT_CREATE) == FAT_OK);
+	for (i = 0; i < bytes / 64; i++)
+	{
+		FAT_Write(&f, &data[i * 64], 64, &done);
+		if ((i % 64) == 63) FAT_Flush(&f);
+	}
+	HOST_CHECK(FAT_Close(&f) == FAT_OK);
+	t = host_seconds() - t;
+	host_printf("%s log  1MB/64B: %5u reads %5u writes %6u sectors, FAT %3u read %4u written, %6.1f MB/s\n",
+				name, io.reads, io.writes, io.rsec + io.wsec, io.fatr, io.fatw, bytes / t / 1e6);
+	// Appending reads each FAT sector it crosses once, it stays cached
+	HOST_CHECK(io.fatr <= bytes / (lay.spc * SEC) * (lay.type / 8) / SEC + 2);
+
+	memset(&io, 0, sizeof(io));
+	bytes = sizeof(data);
+	t = host_seconds();
+	HOST_CHECK(FAT_Open(&f, "BULK.BIN", FAT_WRITE | FAT_CREATE) == FAT_OK);
+	for (i = 0; i < bytes; i += 16384)
+	{
+		FAT_Write(&f, &data[i], 16384, &done);
+	}
+	HOST_CHECK(FAT_Close(&f) == FAT_OK);
+	t = host_seconds() - t;
+	host_printf("%s bulk 4MB/16kB: %5u reads %5u writes %6u sectors, FAT %3u read %4u written, %6.1f MB/s\n",
+				name, io.reads, io.writes, io.rsec + io.wsec, io.fatr, io.fatw, bytes / t / 1e6);
+
+	memset(&io, 0, sizeof(io));
+	t = host_seconds();
+	HOST_CHECK(FAT_Open(&f, "BULK.BIN", FAT_READ) == FAT_OK);
+	for (i = 0; i < bytes; i += 4096)
+	{
+		FAT_Read(&f, &back[i], 4096, &done);
+	}
+	HOST_CHECK(FAT_Close(&f) == FAT_OK);
+	t = host_seconds() - t;
+	HOST_CHECK(memcmp(back, data, bytes) == 0);
+	host_printf("%s read 4MB/4kB:  %5u reads %5u writes %6u sectors, FAT %3u read %4u written, %6.1f MB/s\n",
+				name, io.reads, io.writes, io.rsec + io.wsec, io.fatr, io.fatw, bytes / t / 1e6);
+	HOST_CHECK(img_consistent());
+}
+
+
+int main (void)
+{
+	uint8_t *fsinfo;
+
+	// Nothing to mount
+	img_format(20000, 16, 1, 0);
+	memset(img, 0, SEC);
+	HOST_CHECK(FAT_Mount(&img_disk) == FAT_ERR_NO_FS);
+
+	// FAT16, bare volume, 2kB clusters
+	img_format(32768, 16, 4, 0);
+	HOST_CHECK(FAT_Mount(&img_disk) == FAT_OK);
+	test_roundtrip("DATA.BIN", 0, "DATA    BIN");
+	test_roundtrip("LOG/DATA.CSV", lay.logclus, "DATA    CSV");
+	test_dir_growth();
+	test_errors();
+	bench("FAT16");
+	img_save("fat16.img");
+
+	// FAT32 behind an MBR, 512 byte clusters
+	img_format(2048 + 70000 + 2 * 560 + 32, 32, 1, 2048);
+	HOST_CHECK(FAT_Mount(&img_disk) == FAT_OK);
+	test_roundtrip("/data.bin", 0, "DATA    BIN");
+	test_roundtrip("log/data.csv", lay.logclus, "DATA    CSV");
+	test_dir_growth();
+	test_errors();
+	bench("FAT32");
+	fsinfo = &img[(size_t)(lay.base + 1) * SEC];
+	HOST_CHECK(LD32(fsinfo + 488) == 0xFFFFFFFF);			// free count now unknown
+	img_save("fat32.img");
+
+	test_full();
+
+	return host_done("test_fat");
+}
+
+/* --------------------------------- End Of File ------------------------------ */
@@ -0,0 +1,325 @@
+/******************************************************************//**
+* @file		test_glcd.c
+* @brief	Host timing model of the GLCD pixel streams: bytes on the
+* 			wire per GLCD_Clear, GLCD_Window_Fill and GLCD_Bitmap call,
+* 			TX FIFO occupancy and SCK utilisation on an SSP1 model
+* @version	1.0
+* @date		21. July. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* Built with -DHOST_SSP1_MODEL (see Makefile): every LPC_SSP1 access of
+ * the driver goes through host_ssp1(), which lets the simulated clock
+ * run and shifts the TX FIFO out at the SCK rate. Register writes of the
+ * command path go through SSP_ReadWrite(), stubbed below with its wire
+ * time. The bus manager is stubbed too, it only records the frame size
+ * and the SCK of the selected device. */
+
+/* Includes ------------------------------------------------------------------- */
+#include <string.h>
+#include "host.h"
+#include "lpc_ssp_glcd.h"
+
+
+/* Private Macros ------------------------------------------------------------- */
+/** SSP1 TX FIFO depth, frames */
+#define SSP_FIFO_DEPTH		8
+
+/** DR value while no write is pending, a frame is at most 16 bits */
+#define SSP_DR_IDLE			0xFFFF0000UL
+
+/** PCLK of SSP1, CCLK/4 after reset */
+#define SSP_PCLK			(SystemCoreClock / 4)
+
+
+/* Private Types -------------------------------------------------------------- */
+/** Counters of one drawing call */
+typedef struct {
+	uint32_t cmd;				/**< Command bytes, RS low */
+	uint32_t reg;				/**< Register data bytes, RS high */
+	uint32_t pix;				/**< Pixel frames through DR */
+	uint32_t selects;			/**< SPIBUS_Select() calls */
+	uint64_t wire;				/**< Clocks SCK was running */
+	uint64_t start;				/**< host_cycles at the start of the call */
+	uint32_t sum;				/**< Checksum of the pixel frames */
+	uint32_t bad;				/**< Frames written unselected or into a full FIFO */
+	uint16_t first, last;		/**< First and last pixel frame */
+} GLCD_STAT_Type;
+
+
+/* Private Variables ---------------------------------------------------------- */
+static LPC_SSP_TypeDef ssp;
+static uint64_t ssp_done[SSP_FIFO_DEPTH + 1];	// end of each queued frame
+static uint32_t ssp_head, ssp_count;
+static uint32_t ssp_frame;						// clocks per frame
+static uint32_t ssp_bits = 8, ssp_sck;
+static int ssp_selected;
+
+static GLCD_STAT_Type st;
+
+/* Below 4 GB, the bitmap header is 16 halfwords as in the driver */
+static uint16_t bmp[16 + 64 * 48];
+
+
+/* Private Functions ---------------------------------------------------------- */
+/*********************************************************************//**
+ * @brief 		SCK the bus manager programs for a device, as
+ * 				spibus_compute() does: smallest even CPSR, then SCR
+ * @param[in]	max		Fastest SCK the device accepts, Hz
+ * @return 		SCK, Hz
+ **********************************************************************/
+static uint32_t ssp_clock (uint32_t max)
+{
+	uint32_t div = (SSP_PCLK + max - 1) / max, cpsr = 2, scr;
+
+	while ((div + cpsr - 1) / cpsr > 256)
+	{
+		cpsr += 2;
+	}
+	scr = (div + cpsr - 1) / cpsr - 1;
+	return SSP_PCLK / (cpsr * (scr + 1));
+}
+
+
+/*********************************************************************//**
+ * @brief 		Retire the frames shifted out by now
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void ssp_retire (void)
+{
+	while (ssp_count && (ssp_done[ssp_head] <= host_cycles))
+	{
+		ssp_head = (ssp_head + 1) % (SSP_FIFO_DEPTH + 1);
+		ssp_count--;
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief 		Queue one frame behind the last one, the shifter holds
+ * 				one frame and the FIFO the others
+ * @param[in]	data	Frame
+ * @return 		None
+ **********************************************************************/
+static void ssp_push (uint16_t data)
+{
+	uint32_t tail = (ssp_head + ssp_count) % (SSP_FIFO_DEPTH + 1);
+	uint64_t begin = host_cycles;
+
+	if (!ssp_selected || (ssp_count > SSP_FIFO_DEPTH))	// TNF was checked
+	{
+		st.bad++;
+	}
+	if (ssp_count && (ssp_done[(tail + SSP_FIFO_DEPTH) % (SSP_FIFO_DEPTH + 1)] > begin))
+	{
+		begin = ssp_done[(tail + SSP_FIFO_DEPTH) % (SSP_FIFO_DEPTH + 1)];
+	}
+	ssp_done[tail] = begin + ssp_frame;
+	ssp_count++;
+	st.wire += ssp_frame;
+
+	if (st.pix == 0)
+	{
+		st.first = data;
+	}
+	st.last = data;
+	st.sum = st.sum * 31 + data;
+	st.pix++;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Register block of SSP1 as the driver sees it: applies
+ * 				the DR write of the previous access, lets a few clocks
+ * 				pass and publishes SR. Nothing is received.
+ * @param		None
+ * @return 		SSP1 register block
+ **********************************************************************/
+LPC_SSP_TypeDef *host_ssp1 (void)
+{
+	uint32_t fifo;
+
+	if (ssp.DR != SSP_DR_IDLE)
+	{
+		ssp_retire();
+		ssp_push((uint16_t)ssp.DR);
+	}
+	host_advance(HOST_ACCESS_CYCLES);
+	ssp_retire();
+
+	// The shifter holds the oldest frame once it has started
+	fifo = ssp_count;
+	if (ssp_count && (ssp_done[ssp_head] - ssp_frame <= host_cycles))
+	{
+		fifo--;
+	}
+	*(uint32_t *)&ssp.SR = ((fifo < SSP_FIFO_DEPTH) ? SSP_SR_TNF : 0)
+						 | ((fifo == 0) ? SSP_SR_TFE : 0)
+						 | (ssp_count ? SSP_SR_BSY : 0);
+	ssp.DR = SSP_DR_IDLE;
+	return &ssp;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Start counting one drawing call
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void stat_start (void)
+{
+	memset(&st, 0, sizeof(st));
+	st.start = host_cycles;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Report one drawing call and check its fixed costs
+ * @param[in]	name	Call under test
+ * @param[in]	w, h	Window drawn
+ * @return 		None
+ **********************************************************************/
+static void stat_report (const char *name, uint32_t w, uint32_t h)
+{
+	uint64_t total = host_cycles - st.start;
+	uint32_t bytes = st.cmd + st.reg + 2 * st.pix;
+
+	host_printf("%-16s %3ux%-3u %6u B/call: %2u cmd + %2u reg + %6u pixel, "
+				"%3u selects, %7.3f ms, SCK busy %5.1f%%\n",
+				name, w, h, bytes, st.cmd, st.reg, 2 * st.pix, st.selects,
+				total * 1e3 / SystemCoreClock, 100.0 * st.wire / total);
+
+	// GLCD_Set_Loc(): window, start address, write GRAM
+	HOST_CHECK(st.cmd == 7);
+	HOST_CHECK(st.reg == 12);
+	HOST_CHECK(st.selects == st.cmd + st.reg / 2 + 1);
+	HOST_CHECK(st.pix == w * h);
+	HOST_CHECK(st.bad == 0);
+
+	// Stream_Stop() returned with the link idle and CS released
+	HOST_CHECK((ssp_count == 0) && !ssp_selected);
+	HOST_CHECK(ssp_bits == 8);
+}
+
+
+/* Stubs ---------------------------------------------------------------------- */
+/*********************************************************************//**
+ * @brief 		Bus manager: the device's frame size and SCK take effect
+ * @param[in]	dev		Device
+ * @return 		None
+ **********************************************************************/
+void SPIBUS_Select (SPIBUS_DEVICE_Type *dev)
+{
+	HOST_CHECK(!ssp_selected && (ssp_count == 0));
+	ssp_selected = 1;
+	ssp_bits = dev->Databit;
+	ssp_sck = ssp_clock(dev->MaxClock);
+	ssp_frame = (uint32_t)((uint64_t)ssp_bits * SystemCoreClock / ssp_sck);
+	st.selects++;
+}
+
+
+void SPIBUS_Release (SPIBUS_DEVICE_Type *dev)
+{
+	HOST_CHECK(ssp_selected && (ssp_count == 0));
+	ssp_selected = 0;
+	ssp_bits = 8;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Polled transfer of the command path: the caller waits
+ * 				for every frame
+ * @param[in]	SSPx		SSP peripheral
+ * @param[in]	dataCfg		Transfer
+ * @param[in]	xfType		SSP_TRANSFER_POLLING
+ * @return 		Frames sent
+ **********************************************************************/
+int32_t SSP_ReadWrite (LPC_SSP_TypeDef *SSPx, SSP_DATA_SETUP_Type *dataCfg,
+						SSP_TRANSFER_Type xfType)
+{
+	HOST_CHECK(ssp_selected && (ssp_bits == 8));
+	HOST_CHECK(xfType == SSP_TRANSFER_POLLING);
+
+	// RS low selects a command, see Write_Command_Glcd()
+	if (host_GPIO[2].FIOCLR & LCD_RS)
+	{
+		st.cmd += dataCfg->length;
+	}
+	else
+	{
+		st.reg += dataCfg->length;
+	}
+	host_GPIO[2].FIOCLR = 0;
+	st.wire += (uint64_t)dataCfg->length * ssp_frame;
+	host_advance(dataCfg->length * ssp_frame);
+	return dataCfg->length;
+}
+
+
+void TSC2004_Start (void)
+{
+}
+
+
+Bool TSC2004_GetEvent (TSC_EVENT_Type *ev)
+{
+	return FALSE;
+}
+
+
+void delay_ms (uint32_t ms)
+{
+	host_advance(ms * (SystemCoreClock / 1000));
+}
+
+
+/* Tests ---------------------------------------------------------------------- */
+int main (void)
+{
+	uint32_t i, sum = 0;
+
+	ssp.DR = SSP_DR_IDLE;
+
+	// Clear: one fill run of the whole screen
+	stat_start();
+	GLCD_Clear(0x1234);
+	stat_report("GLCD_Clear", WIDTH, HEIGHT);
+	HOST_CHECK((st.first == 0x1234) && (st.last == 0x1234));
+	HOST_CHECK(st.wire * 100 > (host_cycles - st.start) * 90);
+
+	// Small window: the fixed cost of the window setup shows
+	stat_start();
+	GLCD_Window_Fill(10, 20, 30, 40, 0xF800);
+	stat_report("GLCD_Window_Fill", 30, 40);
+	HOST_CHECK((st.first == 0xF800) && (st.last == 0xF800));
+
+	stat_start();
+	GLCD_Window_Fill(0, 0, 1, 1, 0x07E0);
+	stat_report("GLCD_Window_Fill", 1, 1);
+
+	// Bitmap: pixels leave in order, header skipped
+	for (i = 0; i < 16; i++)
+	{
+		bmp[i] = 0xDEAD;
+	}
+	for (i = 0; i < 64 * 48; i++)
+	{
+		bmp[16 + i] = (uint16_t)(i * 2654435761U >> 16);
+		sum = sum * 31 + bmp[16 + i];
+	}
+	stat_start();
+	GLCD_Bitmap(100, 50, 64, 48, bmp);
+	stat_report("GLCD_Bitmap", 64, 48);
+	HOST_CHECK(st.sum == sum);
+	HOST_CHECK((st.first == bmp[16]) && (st.last == bmp[16 + 64 * 48 - 1]));
+	HOST_CHECK(st.wire * 100 > (host_cycles - st.start) * 90);
+
+	host_printf("SCK %u Hz, %u clocks per 16 bit frame\n", ssp_sck,
+				16 * SystemCoreClock / ssp_sck);
+
+	return host_done("test_glcd");
+}
+
+/* --------------------------------- End Of File ------------------------------ */
@@ -0,0 +1,302 @@
+/******************************************************************//**
+* @file		test_gpdma.c
+* @brief	Host test of the GPDMA driver: LLI chains built by
+* 			GPDMA_BuildLLI() run on a register model, channel
+* 			allocation order and interrupt dispatch
+* @version	1.0
+* @date		21. July. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* Includes ------------------------------------------------------------------- */
+#include <string.h>
+#include "host.h"
+#include "lpc17xx_gpdma.h"
+
+
+/* Private Variables ---------------------------------------------------------- */
+/* Below 4 GB (the Makefile links without PIE), the driver keeps addresses
+ * in 32 bit registers */
+static uint8_t src[40000], dst[40000];
+static GPDMA_LLI_Type lli[16];
+
+static uint32_t cb_order[8], cb_status[8], cb_count;
+
+void DMA_IRQHandler(void);
+
+
+/* Private Functions ---------------------------------------------------------- */
+/*********************************************************************//**
+ * @brief 		Apply the write-only clear registers and the channel
+ * 				enables, as the controller does
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void gpdma_sync (void)
+{
+	uint32_t ch, en = 0;
+
+	*(uint32_t *)&host_GPDMA.DMACIntTCStat &= ~host_GPDMA.DMACIntTCClear;
+	*(uint32_t *)&host_GPDMA.DMACIntErrStat &= ~host_GPDMA.DMACIntErrClr;
+	host_GPDMA.DMACIntTCClear = 0;
+	host_GPDMA.DMACIntErrClr = 0;
+	for (ch = 0; ch < 8; ch++)
+	{
+		if (host_GPDMACH[ch].DMACCConfig & GPDMA_DMACCxConfig_E)
+		{
+			en |= 1UL << ch;
+		}
+	}
+	*(uint32_t *)&host_GPDMA.DMACEnbldChns = en;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Run one memory to memory item of a channel: copy, raise
+ * 				the terminal count if asked, load the next item or stop
+ * @param[in]	ch		Channel
+ * @return 		None
+ **********************************************************************/
+static void gpdma_item (uint32_t ch)
+{
+	LPC_GPDMACH_TypeDef *c = &host_GPDMACH[ch];
+	GPDMA_LLI_Type *next;
+	uint32_t ctrl = c->DMACCControl, n, w, i;
+	uint8_t *s = (uint8_t *)(uintptr_t)c->DMACCSrcAddr;
+	uint8_t *d = (uint8_t *)(uintptr_t)c->DMACCDestAddr;
+
+	n = ctrl & 0xFFF;
+	w = 1U << GPDMA_DMACCxControl_GetSWidth(ctrl);
+	HOST_CHECK(GPDMA_DMACCxControl_GetSWidth(ctrl) == GPDMA_DMACCxControl_GetDWidth(ctrl));
+	for (i = 0; i < n; i++)
+	{
+		memcpy(d, s, w);
+		if (ctrl & GPDMA_DMACCxControl_SI) s += w;
+		if (ctrl & GPDMA_DMACCxControl_DI) d += w;
+	}
+	if ((ctrl & GPDMA_DMACCxControl_I) && (c->DMACCConfig & GPDMA_DMACCxConfig_ITC))
+	{
+		*(uint32_t *)&host_GPDMA.DMACIntTCStat |= 1UL << ch;
+		host_NVIC.ISPR[0] |= 1UL << DMA_IRQn;
+	}
+
+	next = (GPDMA_LLI_Type *)(uintptr_t)c->DMACCLLI;
+	if (next == NULL)
+	{
+		c->DMACCConfig &= ~GPDMA_DMACCxConfig_E;
+		return;
+	}
+	c->DMACCSrcAddr = next->SrcAddr;
+	c->DMACCDestAddr = next->DstAddr;
+	c->DMACCLLI = next->NextLLI;
+	c->DMACCControl = next->Control;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Run the controller for a number of items, the enabled
+ * 				channel with the lowest number wins each arbitration
+ * @param[in]	items	Items to run
+ * @return 		Items run before every channel stopped
+ **********************************************************************/
+static uint32_t gpdma_run (uint32_t items)
+{
+	uint32_t ch, done = 0;
+
+	while (done < items)
+	{
+		gpdma_sync();
+		if (host_GPDMA.DMACEnbldChns == 0)
+		{
+			break;
+		}
+		ch = __builtin_ctz(host_GPDMA.DMACEnbldChns);
+		gpdma_item(ch);
+		done++;
+		host_irq_run();
+	}
+	gpdma_sync();
+	return done;
+}
+
+
+static void cb (uint32_t ChannelNum, uint32_t Status)
+{
+	cb_order[cb_count] = ChannelNum;
+	cb_status[cb_count] = Status;
+	cb_count++;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Chain of any length: item sizes, addresses, terminal
+ * 				count on the last item only, then run it
+ * @param[in]	width	GPDMA_WIDTH_x
+ * @param[in]	count	Transfers
+ * @return 		None
+ **********************************************************************/
+static void test_build (uint32_t width, uint32_t count)
+{
+	GPDMA_Channel_CFG_Type cfg;
+	uint32_t ctrl, num, i, total = 0, bytes = count << width;
+	int32_t ch;
+
+	for (i = 0; i < bytes; i++)
+	{
+		src[i] = (uint8_t)(i * 7 + width);
+	}
+	memset(dst, 0, sizeof(dst));
+
+	ctrl = GPDMA_MakeControl(GPDMA_TRANSFERTYPE_M2M, 0, 0, width);
+	num = GPDMA_BuildLLI(lli, 16, (uint32_t)(uintptr_t)src, (uint32_t)(uintptr_t)dst, count, ctrl);
+	HOST_CHECK(num == (count + GPDMA_MAX_XFER_SIZE - 1) / GPDMA_MAX_XFER_SIZE);
+	for (i = 0; i < num; i++)
+	{
+		HOST_CHECK((lli[i].Control & 0xFFF) != 0);
+		HOST_CHECK(lli[i].SrcAddr == (uint32_t)(uintptr_t)src + (total << width));
+		HOST_CHECK(lli[i].DstAddr == (uint32_t)(uintptr_t)dst + (total << width));
+		HOST_CHECK(!(lli[i].Control & GPDMA_DMACCxControl_I) == (i != num - 1));
+		HOST_CHECK(lli[i].NextLLI == ((i == num - 1) ? 0 : (uint32_t)(uintptr_t)&lli[i + 1]));
+		total += lli[i].Control & 0xFFF;
+	}
+	HOST_CHECK(total == count);
+
+	ch = GPDMA_ChannelAlloc(GPDMA_PRIO_HIGH);
+	HOST_CHECK(ch == 0);
+	GPDMA_SetCallback(ch, cb);
+	cfg.ChannelNum = ch;
+	cfg.TransferType = GPDMA_TRANSFERTYPE_M2M;
+	cfg.SrcConn = 0;
+	cfg.DstConn = 0;
+	HOST_CHECK(GPDMA_SetupLLI(&cfg, lli) == SUCCESS);
+	GPDMA_ChannelCmd(ch, ENABLE);
+	cb_count = 0;
+	HOST_CHECK(gpdma_run(100) == num);
+	HOST_CHECK(memcmp(src, dst, bytes) == 0);
+	HOST_CHECK(dst[bytes] == 0);
+	HOST_CHECK((cb_count == 1) && (cb_status[0] == GPDMA_CB_DONE));
+	GPDMA_ChannelFree(ch);
+}
+
+
+/*********************************************************************//**
+ * @brief 		Allocation order, exhaustion, free and callback reset
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void test_alloc (void)
+{
+	int32_t ch[8];
+	uint32_t i;
+
+	for (i = 0; i < 4; i++)
+	{
+		ch[i] = GPDMA_ChannelAlloc(GPDMA_PRIO_HIGH);
+		HOST_CHECK(ch[i] == (int32_t)i);
+	}
+	for (i = 4; i < 8; i++)
+	{
+		ch[i] = GPDMA_ChannelAlloc(GPDMA_PRIO_LOW);
+		HOST_CHECK(ch[i] == (int32_t)(11 - i));
+	}
+	HOST_CHECK(GPDMA_ChannelAlloc(GPDMA_PRIO_HIGH) == -1);
+	HOST_CHECK(GPDMA_ChannelAlloc(GPDMA_PRIO_LOW) == -1);
+
+	GPDMA_SetCallback(5, cb);
+	GPDMA_ChannelFree(5);
+	GPDMA_ChannelFree(2);
+	HOST_CHECK(GPDMA_ChannelAlloc(GPDMA_PRIO_LOW) == 5);
+	HOST_CHECK(GPDMA_ChannelAlloc(GPDMA_PRIO_HIGH) == 2);
+
+	// A reused channel does not keep the callback of its last owner
+	cb_count = 0;
+	*(uint32_t *)&host_GPDMA.DMACIntTCStat = 1UL << 5;
+	DMA_IRQHandler();
+	gpdma_sync();
+	HOST_CHECK(cb_count == 0);
+
+	for (i = 0; i < 8; i++)
+	{
+		GPDMA_ChannelFree(i);
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief 		Two chains at once: the lower channel finishes first,
+ * 				callbacks run in channel order with the right status
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void test_arbitration (void)
+{
+	GPDMA_Channel_CFG_Type cfg;
+	uint32_t ctrl;
+	int32_t lo, hi;
+
+	memset(dst, 0, sizeof(dst));
+	hi = GPDMA_ChannelAlloc(GPDMA_PRIO_LOW);
+	lo = GPDMA_ChannelAlloc(GPDMA_PRIO_HIGH);
+	HOST_CHECK((lo == 0) && (hi == 7));
+	GPDMA_SetCallback(lo, cb);
+	GPDMA_SetCallback(hi, cb);
+
+	ctrl = GPDMA_MakeControl(GPDMA_TRANSFERTYPE_M2M, 0, 0, GPDMA_WIDTH_WORD);
+	GPDMA_BuildLLI(&lli[0], 4, (uint32_t)(uintptr_t)src, (uint32_t)(uintptr_t)dst, 5000, ctrl);
+	GPDMA_BuildLLI(&lli[8], 4, (uint32_t)(uintptr_t)src, (uint32_t)(uintptr_t)&dst[20000], 2000, ctrl);
+
+	cfg.TransferType = GPDMA_TRANSFERTYPE_M2M;
+	cfg.SrcConn = 0;
+	cfg.DstConn = 0;
+	cfg.ChannelNum = hi;
+	GPDMA_SetupLLI(&cfg, &lli[8]);
+	cfg.ChannelNum = lo;
+	GPDMA_SetupLLI(&cfg, &lli[0]);
+	GPDMA_ChannelCmd(hi, ENABLE);
+	GPDMA_ChannelCmd(lo, ENABLE);
+	gpdma_sync();
+	HOST_CHECK(GPDMA_SetupLLI(&cfg, &lli[0]) == ERROR);	// busy channel refused
+
+	cb_count = 0;
+	HOST_CHECK(gpdma_run(100) == 3);
+	HOST_CHECK((cb_count == 2) && (cb_order[0] == (uint32_t)lo) && (cb_order[1] == (uint32_t)hi));
+	HOST_CHECK(memcmp(src, dst, 20000) == 0);
+	HOST_CHECK(memcmp(src, &dst[20000], 8000) == 0);
+
+	// Terminal count and error together: one pass, channel order
+	cb_count = 0;
+	*(uint32_t *)&host_GPDMA.DMACIntTCStat = 1UL << hi;
+	*(uint32_t *)&host_GPDMA.DMACIntErrStat = 1UL << lo;
+	host_NVIC.ISPR[0] |= 1UL << DMA_IRQn;
+	host_irq_run();
+	gpdma_sync();
+	HOST_CHECK((cb_count == 2) && (cb_order[0] == (uint32_t)lo) && (cb_status[0] == GPDMA_CB_ERROR));
+	HOST_CHECK((cb_order[1] == (uint32_t)hi) && (cb_status[1] == GPDMA_CB_DONE));
+	HOST_CHECK((host_GPDMA.DMACIntTCStat | host_GPDMA.DMACIntErrStat) == 0);
+
+	GPDMA_ChannelFree(lo);
+	GPDMA_ChannelFree(hi);
+}
+
+
+int main (void)
+{
+	GPDMA_Init();
+	HOST_CHECK(host_NVIC.ISER[0] & (1UL << DMA_IRQn));
+
+	// Degenerate sizes
+	HOST_CHECK(GPDMA_BuildLLI(lli, 16, 0, 0, 0, 0) == 0);
+	HOST_CHECK(GPDMA_BuildLLI(lli, 2, 0, 0, 3 * GPDMA_MAX_XFER_SIZE, 0) == 0);
+
+	test_build(GPDMA_WIDTH_BYTE, 1);
+	test_build(GPDMA_WIDTH_BYTE, GPDMA_MAX_XFER_SIZE);
+	test_build(GPDMA_WIDTH_BYTE, GPDMA_MAX_XFER_SIZE + 1);
+	test_build(GPDMA_WIDTH_HALFWORD, 10000);
+	test_build(GPDMA_WIDTH_WORD, 9999);
+	test_alloc();
+	test_arbitration();
+
+	return host_done("test_gpdma");
+}
+
+/* --------------------------------- End Of File ------------------------------ */
@@ -0,0 +1,636 @@
+/******************************************************************//**
+* @file		test_kvstore.c
+* @brief	Host test of the key/value store on a file-backed E2PROM
+* 			simulator: power cuts at every page write of random update
+* 			scripts, wear spread, lookup cost and when compaction runs
+* @version	1.0
+* @date		21. July. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* E2P_Write()/E2P_Read() are stubbed by the simulator: the part lives in
+ * build/test_kvstore/e2p.bin and a reboot closes and reopens it. Writes
+ * are split into page write cycles as the parts do. A power cut hits one
+ * cycle: that page write does not start, completes, or leaves each byte
+ * old, new or garbage; nothing is written after it until the next
+ * reboot. */
+
+/* Includes ------------------------------------------------------------------- */
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "host.h"
+#include "lpc_kvstore.h"
+
+
+/* Private Macros ------------------------------------------------------------- */
+#define E2P_FILE			"build/test_kvstore/e2p.bin"
+
+/** Largest part simulated, M24256 */
+#define E2P_MAX_SIZE		32768
+
+/** Operations per torture script and keys they use */
+#define SCRIPT_OPS			48
+#define SCRIPT_KEYS			6
+
+
+/* Private Types -------------------------------------------------------------- */
+/** One step of a torture script */
+typedef enum {
+	OP_SET = 0,
+	OP_DELETE,
+	OP_FORMAT
+} KV_OP_Kind;
+
+typedef struct {
+	KV_OP_Kind kind;
+	uint8_t key;
+	uint8_t len;
+	uint8_t val[KV_MAX_VALUE];
+} KV_OP_Type;
+
+/** Committed contents of the store, what a reboot must find */
+typedef struct {
+	uint8_t len[KV_MAX_KEYS];
+	uint8_t val[KV_MAX_KEYS][KV_MAX_VALUE];
+} KV_MODEL_Type;
+
+
+/* Private Variables ---------------------------------------------------------- */
+static int e2p_fd = -1;
+static uint32_t e2p_cut;			// page write that the power cut tears, 0 = none
+static int e2p_dead;				// powered off until the next reboot
+static uint32_t e2p_cycles;			// page write cycles
+static uint32_t e2p_bytes;			// bytes written
+static uint32_t e2p_reads;			// E2P_Read() calls
+static uint32_t e2p_errors;			// file access failures
+static uint32_t e2p_wear[E2P_MAX_SIZE / 16];
+static uint32_t rnd = 1;
+
+/* The three parts of the board, see lpc_i2c_at24c16.c, lpc_i2c_m24256.c
+ * and lpc_spi_25aa160a.c; the bus fields are not used here */
+static E2P_DEVICE_Type at24c16 = {NULL, NULL, 0x50, 1, 16, 2048, 5};
+static E2P_DEVICE_Type m24256 = {NULL, NULL, 0x50, 2, 64, 32768, 5};
+static E2P_DEVICE_Type e25aa160a = {NULL, NULL, 0, 2, 16, 2048, 5};
+
+static KV_STORE_Type kv;
+static KV_MODEL_Type model;
+static KV_OP_Type script[SCRIPT_OPS];
+
+
+/* Private Functions ---------------------------------------------------------- */
+static uint32_t rnd_next (void)
+{
+	rnd = rnd * 1103515245 + 12345;
+	return rnd >> 16;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Fit a new, erased part in the simulator
+ * @param[in]	dev		Part
+ * @return 		None
+ **********************************************************************/
+static void e2p_new (E2P_DEVICE_Type *dev)
+{
+	static uint8_t ff[E2P_MAX_SIZE];
+
+	if (e2p_fd >= 0)
+	{
+		close(e2p_fd);
+	}
+	e2p_fd = open(E2P_FILE, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	memset(ff, 0xFF, sizeof(ff));
+	e2p_errors += pwrite(e2p_fd, ff, dev->Size, 0) != (ssize_t)dev->Size;
+	memset(e2p_wear, 0, sizeof(e2p_wear));
+	e2p_cut = 0;
+	e2p_dead = 0;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Power up again: the file is all that is left
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void e2p_reboot (void)
+{
+	close(e2p_fd);
+	e2p_fd = open(E2P_FILE, O_RDWR);
+	e2p_errors += e2p_fd < 0;
+	e2p_cut = 0;
+	e2p_dead = 0;
+	memset(&kv, 0xA5, sizeof(kv));		// RAM does not survive
+}
+
+
+/* Stubs ---------------------------------------------------------------------- */
+/*********************************************************************//**
+ * @brief 		Simulated part: page write cycles into the file, the
+ * 				e2p_cut-th one torn by a power cut
+ * @param[in]	dev		Part
+ * @param[in]	addr	First byte
+ * @param[in]	data	Data
+ * @param[in]	length	Number of bytes
+ * @return 		SUCCESS, or ERROR once the power is off
+ **********************************************************************/
+Status E2P_Write (E2P_DEVICE_Type *dev, uint32_t addr, const uint8_t *data, uint32_t length)
+{
+	uint8_t page[E2P_MAX_PAGE];
+	uint32_t chunk, i, mode;
+
+	if (e2p_dead || (addr + length > dev->Size))
+	{
+		return ERROR;
+	}
+	while (length)
+	{
+		chunk = dev->PageSize - (addr & (dev->PageSize - 1));
+		if (chunk > length)
+		{
+			chunk = length;
+		}
+		memcpy(page, data, chunk);
+
+		// The cut comes before, during or right after the write cycle
+		if (e2p_cut && (--e2p_cut == 0))
+		{
+			mode = rnd_next() % 4;
+			if (mode != 1)
+			{
+				e2p_errors += pread(e2p_fd, page, chunk, addr) != (ssize_t)chunk;
+			}
+			for (i = 0; (mode > 1) && (i < chunk); i++)
+			{
+				switch (rnd_next() % 3)
+				{
+				case 0: break;							// not programmed yet
+				case 1: page[i] = data[i]; break;		// programmed
+				default: page[i] = (uint8_t)rnd_next(); break;
+				}
+			}
+			e2p_dead = 1;
+		}
+
+		e2p_errors += pwrite(e2p_fd, page, chunk, addr) != (ssize_t)chunk;
+		e2p_wear[addr / dev->PageSize]++;
+		e2p_cycles++;
+		e2p_bytes += chunk;
+		if (e2p_dead)
+		{
+			return ERROR;
+		}
+		addr += chunk;
+		data += chunk;
+		length -= chunk;
+	}
+	return SUCCESS;
+}
+
+
+Status E2P_Read (E2P_DEVICE_Type *dev, uint32_t addr, uint8_t *data, uint32_t length)
+{
+	if (addr + length > dev->Size)
+	{
+		return ERROR;
+	}
+	e2p_reads++;
+	return (pread(e2p_fd, data, length, addr) == (ssize_t)length) ? SUCCESS : ERROR;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Run one script step on the store and the model
+ * @param[in]	op		Step
+ * @return 		Status of the store call
+ **********************************************************************/
+static Status op_run (const KV_OP_Type *op)
+{
+	Status ret;
+	uint8_t k;
+
+	switch (op->kind)
+	{
+	case OP_SET:
+		ret = KV_Set(&kv, op->key, op->val, op->len);
+		break;
+	case OP_DELETE:
+		ret = KV_Delete(&kv, op->key);
+		break;
+	default:
+		ret = KV_Format(&kv);
+		break;
+	}
+	if (ret != SUCCESS)
+	{
+		return ret;
+	}
+
+	for (k = 0; k < KV_MAX_KEYS; k++)
+	{
+		if ((op->kind == OP_FORMAT) || (k == op->key))
+		{
+			model.len[k] = (op->kind == OP_SET) ? op->len : 0;
+			memcpy(model.val[k], op->val, model.len[k]);
+		}
+	}
+	return SUCCESS;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Compare the store with the model after a reboot
+ * @param[in]	op		Step the power cut hit, NULL if none: its keys
+ * 						may hold the old or the new value, a format
+ * 						hits all keys or none. The model takes what
+ * 						is found.
+ * @return 		Number of keys wrong
+ **********************************************************************/
+static uint32_t model_check (const KV_OP_Type *op)
+{
+	uint8_t val[KV_MAX_VALUE];
+	uint32_t bad = 0, live = 0;
+	Bool all_old = TRUE, all_new = TRUE, old, new;
+	uint8_t k, len;
+
+	for (k = 0; k < KV_MAX_KEYS; k++)
+	{
+		len = KV_Get(&kv, k, val, sizeof(val));
+		old = (len == model.len[k]) && (memcmp(val, model.val[k], len) == 0);
+		new = FALSE;
+		if (op && ((op->kind == OP_FORMAT) || (k == op->key)))
+		{
+			new = (op->kind == OP_SET) ? ((len == op->len) && (memcmp(val, op->val, len) == 0))
+									   : (len == 0);
+		}
+		if (!old && !new)
+		{
+			bad++;
+		}
+		all_old &= old;
+		all_new &= new;
+
+		model.len[k] = len;
+		memcpy(model.val[k], val, len);
+		live += len ? KV_REC_HDR + len : 0;
+	}
+	if (op && (op->kind == OP_FORMAT) && !all_old && !all_new)
+	{
+		bad++;
+	}
+
+	// The RAM index accounts for exactly the live records
+	if (KV_Free(&kv) != kv.BankSize - KV_BANK_HDR - live)
+	{
+		bad++;
+	}
+	return bad;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Random script: mostly updates of a few keys with short
+ * 				values, some deletes, rarely a format
+ * @param[in]	fixed	Value length of every update, 0 for random ones.
+ * 						Equal records line up from one compaction to the
+ * 						next, so leftovers of a cut one sit where the
+ * 						log of the next one could run on.
+ * @return 		None
+ **********************************************************************/
+static void script_make (uint8_t fixed)
+{
+	uint32_t i, j, r;
+
+	for (i = 0; i < SCRIPT_OPS; i++)
+	{
+		r = rnd_next() % 32;
+		script[i].kind = (r == 0) ? OP_FORMAT : ((r < 5) ? OP_DELETE : OP_SET);
+		script[i].key = (uint8_t)(rnd_next() % SCRIPT_KEYS);
+		script[i].len = (uint8_t)(1 + rnd_next() % 12);
+		for (j = 0; j < KV_MAX_VALUE; j++)
+		{
+			script[i].val[j] = (uint8_t)rnd_next();
+		}
+		if (r == 31)
+		{
+			script[i].len = KV_MAX_VALUE;
+		}
+		if (fixed)
+		{
+			script[i].len = fixed;
+		}
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief 		Play the script from a fresh part, the power failing at
+ * 				page write number cut (0 = never) and at cut2 counted
+ * 				from the first reboot. Every reboot is checked.
+ * @param[in]	dev			Part
+ * @param[in]	bank_size	Bytes per bank
+ * @param[in]	ops			Script length
+ * @param[in]	cut, cut2	Page writes before the power cuts
+ * @return 		Number of failures
+ **********************************************************************/
+static uint32_t script_play (E2P_DEVICE_Type *dev, uint32_t bank_size, uint32_t ops,
+							 uint32_t cut, uint32_t cut2)
+{
+	uint32_t bad = 0, i = 0, base = dev->Size - 2 * bank_size;
+
+	e2p_new(dev);
+	memset(&model, 0, sizeof(model));
+	bad += KV_Init(&kv, dev, base, bank_size) != SUCCESS;
+	e2p_cut = cut;
+
+	while (i < ops)
+	{
+		if (op_run(&script[i]) == SUCCESS)
+		{
+			i++;
+			continue;
+		}
+		if (!e2p_dead)
+		{
+			// Only a value that does not fit even after compaction fails
+			bad += (script[i].kind != OP_SET) || (KV_Free(&kv) >= KV_REC_HDR + script[i].len);
+			i++;
+			continue;
+		}
+
+		// Power back: the step cut is done or not, the store carries on
+		e2p_reboot();
+		bad += KV_Init(&kv, dev, base, bank_size) != SUCCESS;
+		bad += model_check(&script[i]);
+		i++;
+		e2p_cut = cut2;
+		cut2 = 0;
+	}
+
+	e2p_reboot();
+	bad += KV_Init(&kv, dev, base, bank_size) != SUCCESS;
+	bad += model_check(NULL);
+	return bad;
+}
+
+
+/* Tests ---------------------------------------------------------------------- */
+/*********************************************************************//**
+ * @brief 		Power cut at every page write of random scripts, and a
+ * 				second cut after the first recovery
+ * @param[in]	dev			Part
+ * @param[in]	bank_size	Bytes per bank, small so compactions are
+ * 							frequent
+ * @param[in]	name		Part name for the report
+ * @return 		None
+ **********************************************************************/
+static void test_power_cut (E2P_DEVICE_Type *dev, uint32_t bank_size, const char *name)
+{
+	uint32_t seed, cut, total, bad = 0, runs = 0, cuts = 0;
+
+	for (seed = 1; seed <= 24; seed++)
+	{
+		rnd = seed * 7919;
+		script_make((seed & 1) ? 0 : 4);
+
+		// Odd seeds mix value lengths, even ones update 4 byte counters
+		// Clean run: page writes of the whole script
+		e2p_cycles = 0;
+		bad += script_play(dev, bank_size, SCRIPT_OPS, 0, 0);
+		total = e2p_cycles;
+
+		for (cut = 1; cut <= total; cut++)
+		{
+			bad += script_play(dev, bank_size, SCRIPT_OPS, cut, 1 + (cut * 13) % total);
+			runs++;
+		}
+		cuts += total;
+	}
+	host_printf("%-9s bank %4u B: %6u power cuts over 24 scripts, %u keys wrong\n",
+				name, bank_size, cuts, bad);
+	HOST_CHECK(runs > 24 * SCRIPT_OPS);
+	HOST_CHECK(bad == 0);
+}
+
+
+/*********************************************************************//**
+ * @brief 		A cut compaction leaves records behind in the other bank,
+ * 				sealed with the sequence number the next compaction into
+ * 				it uses again. That one copies fewer keys, a newer value
+ * 				among them, and the append after it is cut: a reboot
+ * 				must not run on into the leftovers. Every pair of cuts.
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void test_leftovers (void)
+{
+	uint32_t n = 0, cut, cut2, total, bad = 0;
+	uint8_t k;
+
+	memset(script, 0, sizeof(script));
+	for (k = 0; k < 6; k++)						// 4 byte counters
+	{
+		script[n].key = k;
+		script[n].val[0] = k;
+		script[n++].len = 4;
+	}
+	script[n].val[0] = 0x10;					// key 0 again, 8 B free
+	script[n++].len = 4;
+	script[n].key = 6;							// does not fit: compaction
+	script[n++].len = KV_MAX_VALUE;
+	script[n].key = 5;							// newer value of key 5
+	script[n].val[0] = 0x55;
+	script[n++].len = 4;
+	script[n].kind = OP_DELETE;					// one key less
+	script[n++].key = 0;
+	script[n].key = 6;							// compaction again
+	script[n++].len = KV_MAX_VALUE;
+
+	e2p_cycles = 0;
+	bad += script_play(&at24c16, 96, n, 0, 0);
+	total = e2p_cycles;
+	for (cut = 1; cut <= total; cut++)
+	{
+		for (cut2 = 1; cut2 <= total; cut2++)
+		{
+			bad += script_play(&at24c16, 96, n, cut, cut2);
+		}
+	}
+	HOST_CHECK(bad == 0);
+}
+
+
+/*********************************************************************//**
+ * @brief 		Counters updated in place would wear one page; the log
+ * 				spreads them over both banks. Compaction runs only when
+ * 				a record does not fit the bank any more.
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void test_wear (void)
+{
+	uint32_t n, updates = 20000, pages, max = 0, sum = 0, early = 0, late = 0, failed = 0;
+	uint32_t counter[4] = {0, 0, 0, 0}, tail, comp, i;
+	uint32_t bank_size = 2048, base = 0;
+
+	e2p_new(&m24256);
+	HOST_CHECK(KV_Init(&kv, &m24256, base, bank_size) == SUCCESS);
+	e2p_cycles = e2p_bytes = 0;
+
+	for (n = 0; n < updates; n++)
+	{
+		i = n & 3;
+		counter[i]++;
+		tail = kv.Tail;
+		comp = kv.Compactions;
+		failed += KV_Set(&kv, (uint8_t)i, &counter[i], 4) != SUCCESS;
+
+		if (kv.Compactions != comp)
+		{
+			early += tail + KV_REC_HDR + 4 <= kv.BankSize;
+		}
+		else
+		{
+			late += tail + KV_REC_HDR + 4 > kv.BankSize;
+		}
+	}
+	HOST_CHECK(failed == 0);
+	HOST_CHECK(early == 0);
+	HOST_CHECK(late == 0);
+
+	pages = 2 * bank_size / m24256.PageSize;
+	for (i = 0; i < pages; i++)
+	{
+		sum += e2p_wear[i];
+		max = (e2p_wear[i] > max) ? e2p_wear[i] : max;
+	}
+	host_printf("wear      %u counter updates: %u compactions, %.1f B and %.2f page "
+				"writes per update, max %u / mean %.1f cycles per page (in place: %u)\n",
+				updates, kv.Compactions, (double)e2p_bytes / updates,
+				(double)e2p_cycles / updates, max, (double)sum / pages, updates / 4);
+
+	// Every page of both banks takes its share, none near the in-place count
+	for (i = 0, n = 0; i < pages; i++)
+	{
+		n += e2p_wear[i] == 0;
+	}
+	HOST_CHECK(n == 0);
+	HOST_CHECK(max * 10 < updates / 4);
+	HOST_CHECK(max < 3 * sum / pages);
+
+	// A value that did not change costs no write
+	n = e2p_cycles;
+	HOST_CHECK(KV_Set(&kv, 0, &counter[0], 4) == SUCCESS);
+	HOST_CHECK(e2p_cycles == n);
+
+	// And the counters survive a reboot
+	e2p_reboot();
+	HOST_CHECK(KV_Init(&kv, &m24256, base, bank_size) == SUCCESS);
+	for (i = 0; i < 4; i++)
+	{
+		HOST_CHECK((KV_Get(&kv, (uint8_t)i, &n, 4) == 4) && (n == counter[i]));
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief 		A lookup is one record read whatever the log holds;
+ * 				only KV_Init() scans
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void test_lookup (void)
+{
+	uint8_t val[KV_MAX_VALUE];
+	uint32_t k, n, reads, scan;
+
+	e2p_new(&at24c16);
+	HOST_CHECK(KV_Init(&kv, &at24c16, 0, 1024) == SUCCESS);
+	for (n = 0; n < 3; n++)
+	{
+		for (k = 0; k < KV_MAX_KEYS; k++)
+		{
+			memset(val, (int)(k + n), sizeof(val));
+			HOST_CHECK(KV_Set(&kv, (uint8_t)k, val, (uint8_t)(1 + k % 8)) == SUCCESS);
+		}
+	}
+
+	e2p_reboot();
+	e2p_reads = 0;
+	HOST_CHECK(KV_Init(&kv, &at24c16, 0, 1024) == SUCCESS);
+	scan = e2p_reads;
+
+	reads = e2p_reads;
+	for (k = 0; k < KV_MAX_KEYS; k++)
+	{
+		HOST_CHECK((KV_Get(&kv, (uint8_t)k, val, sizeof(val)) == 1 + k % 8) && (val[0] == k + 2));
+	}
+	reads = e2p_reads - reads;
+	host_printf("lookup    KV_Init() %u reads for %u records, KV_Get() %.1f reads\n",
+				scan, 3 * KV_MAX_KEYS, (double)reads / KV_MAX_KEYS);
+
+	// Header and value of the latest record
+	HOST_CHECK(reads <= 2 * KV_MAX_KEYS);
+
+	// Unset and deleted keys cost nothing
+	reads = e2p_reads;
+	HOST_CHECK(KV_Delete(&kv, 5) == SUCCESS);
+	HOST_CHECK(KV_Get(&kv, 5, val, sizeof(val)) == 0);
+	HOST_CHECK(e2p_reads == reads);
+}
+
+
+/*********************************************************************//**
+ * @brief 		Region checks and a full store
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void test_errors (void)
+{
+	uint8_t val[KV_MAX_VALUE];
+	uint32_t k;
+
+	e2p_new(&e25aa160a);
+	HOST_CHECK(KV_Init(&kv, &e25aa160a, 0, 43) == ERROR);
+	HOST_CHECK(KV_Init(&kv, &e25aa160a, 1024, 1025) == ERROR);
+	HOST_CHECK(KV_Init(&kv, &e25aa160a, 1024, 512) == SUCCESS);
+	HOST_CHECK(KV_Set(&kv, KV_MAX_KEYS, val, 1) == ERROR);
+	HOST_CHECK(KV_Set(&kv, 0, val, 0) == ERROR);
+	HOST_CHECK(KV_Set(&kv, 0, val, KV_MAX_VALUE + 1) == ERROR);
+
+	// 512 B banks take 14 full size values, filling the bank to the byte
+	memset(val, 0x5A, sizeof(val));
+	for (k = 0; k < 14; k++)
+	{
+		HOST_CHECK(KV_Set(&kv, (uint8_t)k, val, KV_MAX_VALUE) == SUCCESS);
+	}
+	HOST_CHECK(KV_Set(&kv, 14, val, KV_MAX_VALUE) == ERROR);
+	HOST_CHECK(KV_Free(&kv) < KV_REC_HDR + KV_MAX_VALUE);
+
+	// A full bank still takes a delete, its compaction makes the room
+	HOST_CHECK(kv.Tail == kv.BankSize);
+	HOST_CHECK(KV_Delete(&kv, 0) == SUCCESS);
+	HOST_CHECK(KV_Set(&kv, 14, val, KV_MAX_VALUE) == SUCCESS);
+	e2p_reboot();
+	HOST_CHECK(KV_Init(&kv, &e25aa160a, 1024, 512) == SUCCESS);
+	HOST_CHECK(KV_Get(&kv, 0, val, sizeof(val)) == 0);
+	HOST_CHECK(KV_Get(&kv, 14, val, sizeof(val)) == KV_MAX_VALUE);
+}
+
+
+int main (void)
+{
+	test_power_cut(&at24c16, 96, "AT24C16");
+	test_power_cut(&e25aa160a, 160, "25AA160A");
+	test_power_cut(&m24256, 256, "M24256");
+	test_leftovers();
+	test_wear();
+	test_lookup();
+	test_errors();
+
+	close(e2p_fd);
+	HOST_CHECK(e2p_errors == 0);
+	return host_done("test_kvstore");
+}
+
+/* --------------------------------- End Of File ------------------------------ */
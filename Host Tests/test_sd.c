@@ -0,0 +1,712 @@
+/******************************************************************//**
+* @file		test_sd.c
+* @brief	Host test of the SD block layer against an SD card SPI
+* 			state machine: identification of v1, v2 and SDHC cards,
+* 			CMD17/18/24/25 with ACMD23 and R1b, CRC-16, background
+* 			programming busy and the modelled throughput
+* @version	1.0
+* @date		21. July. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* Built with -DHOST_SPI_MODEL (see Makefile): every LPC_SPI access of the
+ * driver goes through host_spi(). A byte written to SPDR is exchanged
+ * with the card on the next access, which also lets 8 SCK periods pass
+ * on the simulated clock. The real bus manager (lpc_spi_bus.c) programs
+ * SPCCR and drives the chip select on P0.16, the card follows both. */
+
+/* Includes ------------------------------------------------------------------- */
+#include <string.h>
+#include "host.h"
+#include "lpc_spi_sd.h"
+
+
+/* Private Macros ------------------------------------------------------------- */
+/** SPDR while no write is pending: marker in the upper half, last byte
+ * received in the low one */
+#define SPI_DR_IDLE			0xFFFF0000UL
+
+/** Blocks on the emulated card */
+#define CARD_BLOCKS			4096
+
+/** Card timing, microseconds */
+#define CARD_NAC_US			100		// command to read data token
+#define CARD_PROG_US		300		// programming busy per written block
+#define CARD_R1B_US			20		// CMD12 busy
+
+/** Data phases of the card */
+#define PH_CMD				0		// waiting for a command
+#define PH_READ				1		// sending CMD17/18 blocks
+#define PH_TOKEN			2		// CMD24/25 waiting for a start token
+#define PH_DATA				3		// CMD24/25 receiving a block
+
+
+/* Private Types -------------------------------------------------------------- */
+/** SD card in SPI mode */
+typedef struct {
+	sd_card_type type;			/**< Card to emulate */
+	uint8_t  idle;				/**< In idle state until ACMD41 completes */
+	uint8_t  app;				/**< Last command was CMD55 */
+	uint8_t  crc_on;			/**< CMD59 enabled CRC checking */
+	uint8_t  cs;				/**< Chip select asserted */
+	uint32_t init_polls;		/**< ACMD41 calls left until ready */
+
+	uint8_t  cmd[6];			/**< Command being received */
+	uint32_t cmd_len;
+	uint8_t  out[8];			/**< Response bytes queued */
+	uint32_t out_head, out_len;
+
+	uint32_t phase;				/**< PH_x */
+	uint8_t  multi;				/**< CMD18 / CMD25 */
+	uint32_t block;				/**< Block being transferred */
+	uint8_t  blk[SD_BLOCK_SIZE + 3];	/**< Token, data and CRC */
+	uint32_t pos;				/**< Position in blk */
+	uint64_t ready_at;			/**< Read data token not before */
+	uint64_t busy_until;		/**< Holds DO low until */
+
+	uint8_t  fault_read_crc;	/**< Corrupt the CRC of the next read block */
+	uint8_t  fault_resp;		/**< Data response of the next written block */
+
+	uint32_t cmds[64];			/**< Commands seen by index */
+	uint32_t acmd23;			/**< Last ACMD23 block count */
+	uint32_t last_arg;			/**< Argument of the last data command */
+	uint32_t selects;			/**< CS falling edges */
+	uint32_t bytes;				/**< Bytes exchanged while selected */
+	uint32_t violations;		/**< Protocol errors: command or token while
+									 busy, no stop bit, SPCCR under 8 */
+	uint32_t sck;				/**< SCK of the last exchange */
+} SD_CARD_Type;
+
+
+/* Private Variables ---------------------------------------------------------- */
+static LPC_SPI_TypeDef spi;
+static SD_CARD_Type card;
+static uint8_t image[CARD_BLOCKS][SD_BLOCK_SIZE];
+static uint8_t wbuf[16 * SD_BLOCK_SIZE], rbuf[16 * SD_BLOCK_SIZE];
+
+
+/* Private Functions ---------------------------------------------------------- */
+/*********************************************************************//**
+ * @brief 		Clocks for a number of microseconds
+ * @param[in]	us		Microseconds
+ * @return 		Core clocks
+ **********************************************************************/
+static uint64_t us_cycles (uint32_t us)
+{
+	return (uint64_t)us * (SystemCoreClock / 1000000);
+}
+
+
+/*********************************************************************//**
+ * @brief 		Queue a response, one NCR byte before it
+ * @param[in]	r1		R1
+ * @param[in]	extra	Bytes after R1 (R3/R7), NULL if none
+ * @param[in]	n		Number of extra bytes
+ * @return 		None
+ **********************************************************************/
+static void card_respond (uint8_t r1, const uint8_t *extra, uint32_t n)
+{
+	uint32_t i;
+
+	card.out_head = 0;
+	card.out_len = 0;
+	card.out[card.out_len++] = 0xFF;
+	card.out[card.out_len++] = r1;
+	for (i = 0; i < n; i++)
+	{
+		card.out[card.out_len++] = extra[i];
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief 		Turn a data command argument into a block number
+ * @param[in]	arg		Command argument
+ * @param[out]	block	Block number
+ * @return 		0 or the R1 address error bit
+ **********************************************************************/
+static uint8_t card_address (uint32_t arg, uint32_t *block)
+{
+	if (card.type != SD_CARD_V2_HC)
+	{
+		if (arg % SD_BLOCK_SIZE) return R1_ADDR_ERR;
+		arg /= SD_BLOCK_SIZE;
+	}
+	if (arg >= CARD_BLOCKS) return R1_ADDR_ERR;
+	*block = arg;
+	return 0;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Execute a complete command frame
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void card_command (void)
+{
+	uint8_t idx = card.cmd[0] & 0x3F, r1, ext[4];
+	uint32_t arg = ((uint32_t)card.cmd[1] << 24) | ((uint32_t)card.cmd[2] << 16) |
+				   ((uint32_t)card.cmd[3] << 8) | card.cmd[4];
+	uint8_t app = card.app;
+
+	card.app = 0;
+	card.cmds[idx]++;
+	if ((card.cmd[5] & 1) == 0)
+	{
+		card.violations++;
+	}
+
+	// CMD0 and CMD8 are always checked, the rest after CMD59
+	if ((card.crc_on || (idx == 0) || (idx == 8)) &&
+		((CRC7_Calc(card.cmd, 5) << 1 | 1) != card.cmd[5]))
+	{
+		card_respond(card.idle | R1_CRC_ERR, NULL, 0);
+		return;
+	}
+
+	r1 = card.idle;
+	switch (idx)
+	{
+	case CMD0_GO_IDLE_STATE:
+		card.idle = R1_IDLE;
+		card.crc_on = 0;
+		card.phase = PH_CMD;
+		card_respond(R1_IDLE, NULL, 0);
+		break;
+
+	case CMD8_SEND_IF_COND:
+		if (card.type == SD_CARD_V1)
+		{
+			card_respond(r1 | R1_ILLEGAL, NULL, 0);
+			break;
+		}
+		ext[0] = 0;
+		ext[1] = 0;
+		ext[2] = (uint8_t)((arg >> 8) & 0x0F);
+		ext[3] = (uint8_t)arg;
+		card_respond(r1, ext, 4);
+		break;
+
+	case CMD55_APP_CMD:
+		card.app = 1;
+		card_respond(r1, NULL, 0);
+		break;
+
+	case CMD58_READ_OCR:
+		ext[0] = 0x80 | ((card.type == SD_CARD_V2_HC) ? 0x40 : 0);
+		ext[1] = 0xFF;
+		ext[2] = 0x80;
+		ext[3] = 0x00;
+		card_respond(r1, ext, 4);
+		break;
+
+	case CMD16_SET_BLOCKLEN:
+		card_respond(r1 | ((arg == SD_BLOCK_SIZE) ? 0 : R1_PARAM_ERR), NULL, 0);
+		break;
+
+	case CMD59_CRC_ON_OFF:
+		card.crc_on = arg & 1;
+		card_respond(r1, NULL, 0);
+		break;
+
+	case CMD12_STOP_TRANSMISSION:
+		// Stuff byte, then R1b
+		card.phase = PH_CMD;
+		card_respond(0xFF, NULL, 0);
+		card.out[card.out_len++] = r1;
+		card.busy_until = host_cycles + us_cycles(CARD_R1B_US);
+		break;
+
+	case CMD17_READ_SINGLE_BLOCK:
+	case CMD18_READ_MULTIPLE_BLOCK:
+	case CMD24_WRITE_BLOCK:
+	case CMD25_WRITE_MULTIPLE_BLOCK:
+		card.last_arg = arg;
+		r1 |= card.idle ? R1_ILLEGAL : card_address(arg, &card.block);
+		card_respond(r1, NULL, 0);
+		if (r1 != R1_NOERROR)
+		{
+			break;
+		}
+		card.multi = (idx == CMD18_READ_MULTIPLE_BLOCK) || (idx == CMD25_WRITE_MULTIPLE_BLOCK);
+		card.pos = 0;
+		if ((idx == CMD17_READ_SINGLE_BLOCK) || (idx == CMD18_READ_MULTIPLE_BLOCK))
+		{
+			card.phase = PH_READ;
+			card.ready_at = host_cycles + us_cycles(CARD_NAC_US);
+		}
+		else
+		{
+			card.phase = PH_TOKEN;
+		}
+		break;
+
+	default:
+		if (app && (idx == ACMD41_SEND_OP_COND))
+		{
+			if (card.init_polls && --card.init_polls == 0)
+			{
+				card.idle = 0;
+			}
+			card_respond(card.idle, NULL, 0);
+		}
+		else if (app && (idx == ACMD23_SET_WR_BLK_ERASE_COUNT))
+		{
+			card.acmd23 = arg;
+			card_respond(r1, NULL, 0);
+		}
+		else
+		{
+			card_respond(r1 | R1_ILLEGAL, NULL, 0);
+		}
+		break;
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief 		Next byte of a read stream: NAC gap, token, data, CRC
+ * @param		None
+ * @return 		Byte on DO
+ **********************************************************************/
+static uint8_t card_read_byte (void)
+{
+	uint16_t crc;
+	uint8_t b;
+
+	if (card.pos == 0)
+	{
+		if (host_cycles < card.ready_at)
+		{
+			return 0xFF;
+		}
+		card.blk[0] = SD_TOKEN_START_BLOCK;
+		memcpy(&card.blk[1], image[card.block], SD_BLOCK_SIZE);
+		crc = CRC16_Calc(image[card.block], SD_BLOCK_SIZE);
+		if (card.fault_read_crc)
+		{
+			crc ^= 0x0100;
+			card.fault_read_crc = 0;
+		}
+		card.blk[SD_BLOCK_SIZE + 1] = (uint8_t)(crc >> 8);
+		card.blk[SD_BLOCK_SIZE + 2] = (uint8_t)crc;
+	}
+	b = card.blk[card.pos++];
+	if (card.pos == SD_BLOCK_SIZE + 3)
+	{
+		card.pos = 0;
+		if (card.multi && (card.block + 1 < CARD_BLOCKS))
+		{
+			card.block++;
+			card.ready_at = host_cycles + us_cycles(CARD_NAC_US / 4);
+		}
+		else
+		{
+			card.phase = PH_CMD;
+		}
+	}
+	return b;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Take one byte of a written block
+ * @param[in]	b		Byte on DI
+ * @return 		None
+ **********************************************************************/
+static void card_write_byte (uint8_t b)
+{
+	uint16_t crc;
+	uint8_t resp;
+
+	card.blk[card.pos++] = b;
+	if (card.pos < SD_BLOCK_SIZE + 3)
+	{
+		return;
+	}
+
+	crc = ((uint16_t)card.blk[SD_BLOCK_SIZE + 1] << 8) | card.blk[SD_BLOCK_SIZE + 2];
+	resp = 0xE0 | SD_DATA_RESP_ACCEPTED;
+	if (card.crc_on && (crc != CRC16_Calc(&card.blk[1], SD_BLOCK_SIZE)))
+	{
+		resp = 0xE0 | SD_DATA_RESP_CRC_ERR;
+	}
+	if (card.fault_resp)
+	{
+		resp = 0xE0 | card.fault_resp;
+		card.fault_resp = 0;
+	}
+
+	card.out_head = 0;
+	card.out_len = 1;
+	card.out[0] = resp;
+	card.pos = 0;
+	if ((resp & SD_DATA_RESP_MASK) == SD_DATA_RESP_ACCEPTED)
+	{
+		memcpy(image[card.block], &card.blk[1], SD_BLOCK_SIZE);
+		card.block++;
+		card.busy_until = host_cycles + us_cycles(CARD_PROG_US);
+		card.phase = (card.multi && (card.block < CARD_BLOCKS)) ? PH_TOKEN : PH_CMD;
+	}
+	else
+	{
+		// Rejected: CMD25 waits for the stop token, CMD24 is over
+		card.phase = card.multi ? PH_TOKEN : PH_CMD;
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief 		One byte exchange with the card, output first as both
+ * 				directions shift at once
+ * @param[in]	tx		Byte on DI
+ * @return 		Byte on DO
+ **********************************************************************/
+static uint8_t card_xchg (uint8_t tx)
+{
+	uint8_t rx;
+	int busy = host_cycles < card.busy_until;
+
+	if (!card.cs)
+	{
+		return 0xFF;
+	}
+	card.bytes++;
+
+	if (card.out_head < card.out_len)
+	{
+		rx = card.out[card.out_head++];
+	}
+	else if (card.phase == PH_READ)
+	{
+		rx = card_read_byte();
+	}
+	else
+	{
+		rx = busy ? 0x00 : 0xFF;
+	}
+
+	if (card.phase == PH_DATA)
+	{
+		card_write_byte(tx);
+	}
+	else if (card.phase == PH_TOKEN)
+	{
+		if (busy && (tx != 0xFF))
+		{
+			card.violations++;
+		}
+		else if ((tx == SD_TOKEN_START_BLOCK) && !card.multi)
+		{
+			card.blk[0] = tx;
+			card.pos = 1;
+			card.phase = PH_DATA;
+		}
+		else if ((tx == SD_TOKEN_START_MULTI) && card.multi)
+		{
+			card.blk[0] = tx;
+			card.pos = 1;
+			card.phase = PH_DATA;
+		}
+		else if ((tx == SD_TOKEN_STOP_TRAN) && card.multi)
+		{
+			card.phase = PH_CMD;
+			card.busy_until = host_cycles + us_cycles(CARD_PROG_US);
+		}
+	}
+	else if (card.cmd_len || ((tx & 0xC0) == 0x40))
+	{
+		if ((card.cmd_len == 0) && busy)
+		{
+			card.violations++;
+		}
+		card.cmd[card.cmd_len++] = tx;
+		if (card.cmd_len == 6)
+		{
+			card.cmd_len = 0;
+			card_command();
+		}
+	}
+	return rx;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Reset the card model to power-up
+ * @param[in]	type	Card to emulate
+ * @return 		None
+ **********************************************************************/
+static void card_reset (sd_card_type type)
+{
+	memset(&card, 0, sizeof(card));
+	card.type = type;
+	card.idle = R1_IDLE;
+	card.init_polls = 3;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Register block of the SPI as the driver sees it: follows
+ * 				the chip select, exchanges the byte written to SPDR by
+ * 				the previous access and publishes SPIF
+ * @param		None
+ * @return 		SPI register block
+ **********************************************************************/
+LPC_SPI_TypeDef *host_spi (void)
+{
+	uint32_t pclk, div;
+	uint8_t rx;
+
+	// Select sets then clears the pin, Release only sets it
+	if (host_GPIO[SD_CS_PORT].FIOCLR & SD_CS_PIN)
+	{
+		card.cmd_len = 0;
+		card.selects++;
+		card.cs = 1;
+	}
+	else if (host_GPIO[SD_CS_PORT].FIOSET & SD_CS_PIN)
+	{
+		card.cs = 0;
+	}
+	host_GPIO[SD_CS_PORT].FIOCLR = 0;
+	host_GPIO[SD_CS_PORT].FIOSET = 0;
+
+	if ((spi.SPDR & SPI_DR_IDLE) != SPI_DR_IDLE)
+	{
+		pclk = CLKPWR_GetPCLK(CLKPWR_PCLKSEL_SPI);
+		div = spi.SPCCR & SPI_SPCCR_BITMASK;
+		if (div < 8)
+		{
+			card.violations++;
+		}
+		card.sck = pclk / div;
+		rx = card_xchg((uint8_t)spi.SPDR);
+		host_advance(8 * div * (SystemCoreClock / pclk));
+		*(uint32_t *)&spi.SPSR = SPI_SPSR_SPIF;
+		spi.SPDR = SPI_DR_IDLE | rx;
+	}
+	host_advance(HOST_ACCESS_CYCLES);
+	return &spi;
+}
+
+
+/* Stubs ---------------------------------------------------------------------- */
+uint32_t SYSTICK_GetTick (void)
+{
+	return (uint32_t)(host_cycles / (SystemCoreClock / 1000));
+}
+
+
+Bool SSP_JobBusy (LPC_SSP_TypeDef *SSPx)
+{
+	return FALSE;
+}
+
+
+int32_t SPI_ReadWrite (LPC_SPI_TypeDef *SPIx, SPI_DATA_SETUP_Type *dataCfg, SPI_TRANSFER_Type xfType)
+{
+	return 0;
+}
+
+
+int16 printf (LPC_UART_TypeDef *UARTx, const char *format, ...)
+{
+	return 0;
+}
+
+
+/* Tests ---------------------------------------------------------------------- */
+/*********************************************************************//**
+ * @brief 		Fill a buffer with a pattern of its own
+ * @param[in]	buf		Buffer
+ * @param[in]	len		Bytes
+ * @param[in]	seed	Pattern
+ * @return 		None
+ **********************************************************************/
+static void fill (uint8_t *buf, uint32_t len, uint32_t seed)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		buf[i] = (uint8_t)(seed >> 16);
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief 		Identification, then single and multi-block transfers
+ * 				with their command sequences
+ * @param[in]	type	Card to emulate
+ * @return 		None
+ **********************************************************************/
+static void test_card (sd_card_type type)
+{
+	uint32_t sel, n25, n18, n12;
+
+	card_reset(type);
+	HOST_CHECK(SD_Init(5) == SD_OK);
+	HOST_CHECK(SD_GetCardType() == type);
+	HOST_CHECK(card.crc_on && !card.idle);
+	HOST_CHECK(card.cmds[CMD16_SET_BLOCKLEN] == ((type == SD_CARD_V2_HC) ? 0 : 1));
+	HOST_CHECK(card.cmds[CMD58_READ_OCR] == ((type == SD_CARD_V1) ? 0 : 1));
+
+	// CMD24 then CMD17, addressed by byte or by block
+	fill(wbuf, SD_BLOCK_SIZE, type);
+	sel = card.selects;
+	HOST_CHECK(SD_WriteBlock(7, wbuf) == SD_OK);
+	HOST_CHECK(card.selects == sel + 1);
+	HOST_CHECK(card.last_arg == ((type == SD_CARD_V2_HC) ? 7 : 7 * SD_BLOCK_SIZE));
+	HOST_CHECK(card.cmds[CMD24_WRITE_BLOCK] == 1);
+	HOST_CHECK(SD_Sync() == SD_OK);
+	HOST_CHECK(memcmp(image[7], wbuf, SD_BLOCK_SIZE) == 0);
+
+	memset(rbuf, 0, sizeof(rbuf));
+	HOST_CHECK(SD_ReadBlock(7, rbuf) == SD_OK);
+	HOST_CHECK(card.cmds[CMD17_READ_SINGLE_BLOCK] == 1);
+	HOST_CHECK(memcmp(rbuf, wbuf, SD_BLOCK_SIZE) == 0);
+
+	// ACMD23 + CMD25, then CMD18 + CMD12 (R1b), CS held throughout
+	fill(wbuf, sizeof(wbuf), type + 100);
+	sel = card.selects;
+	n25 = card.cmds[CMD25_WRITE_MULTIPLE_BLOCK];
+	HOST_CHECK(SD_WriteBlocks(100, wbuf, 16) == SD_OK);
+	HOST_CHECK(card.selects == sel + 1);
+	HOST_CHECK(card.cmds[CMD25_WRITE_MULTIPLE_BLOCK] == n25 + 1);
+	HOST_CHECK(card.acmd23 == 16);
+
+	n18 = card.cmds[CMD18_READ_MULTIPLE_BLOCK];
+	n12 = card.cmds[CMD12_STOP_TRANSMISSION];
+	memset(rbuf, 0, sizeof(rbuf));
+	sel = card.selects;
+	HOST_CHECK(SD_ReadBlocks(100, rbuf, 16) == SD_OK);
+	HOST_CHECK(card.selects == sel + 1);
+	HOST_CHECK(card.cmds[CMD18_READ_MULTIPLE_BLOCK] == n18 + 1);
+	HOST_CHECK(card.cmds[CMD12_STOP_TRANSMISSION] == n12 + 1);
+	HOST_CHECK(memcmp(rbuf, wbuf, sizeof(wbuf)) == 0);
+	HOST_CHECK(memcmp(image[100], wbuf, sizeof(wbuf)) == 0);
+
+	// R1b drained: the card is idle once the read returns
+	HOST_CHECK(host_cycles >= card.busy_until);
+	HOST_CHECK(card.violations == 0);
+}
+
+
+/*********************************************************************//**
+ * @brief 		A write returns while the card programs, the next
+ * 				command waits for it
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void test_busy (void)
+{
+	uint64_t t;
+
+	fill(wbuf, 4 * SD_BLOCK_SIZE, 7);
+	HOST_CHECK(SD_WriteBlocks(200, wbuf, 4) == SD_OK);
+	HOST_CHECK(host_cycles < card.busy_until);
+	HOST_CHECK(SD_IsBusy() == TRUE);
+
+	t = card.busy_until;
+	host_advance((uint32_t)(t - host_cycles));
+	HOST_CHECK(SD_IsBusy() == FALSE);
+	HOST_CHECK(SD_Sync() == SD_OK);
+
+	// Read straight after a write: no command while DO is held low
+	HOST_CHECK(SD_WriteBlock(210, wbuf) == SD_OK);
+	HOST_CHECK(SD_ReadBlock(200, rbuf) == SD_OK);
+	HOST_CHECK(memcmp(rbuf, wbuf, SD_BLOCK_SIZE) == 0);
+	HOST_CHECK(card.violations == 0);
+}
+
+
+/*********************************************************************//**
+ * @brief 		Bad CRC, rejected blocks and bad arguments
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void test_errors (void)
+{
+	fill(wbuf, 2 * SD_BLOCK_SIZE, 9);
+	HOST_CHECK(SD_WriteBlocks(300, wbuf, 2) == SD_OK);
+
+	card.fault_read_crc = 1;
+	HOST_CHECK(SD_ReadBlock(300, rbuf) == SD_ERROR_CRC);
+	card.fault_read_crc = 1;
+	HOST_CHECK(SD_ReadBlocks(300, rbuf, 2) == SD_ERROR_CRC);
+	HOST_CHECK(SD_ReadBlocks(300, rbuf, 2) == SD_OK);
+	HOST_CHECK(memcmp(rbuf, wbuf, 2 * SD_BLOCK_SIZE) == 0);
+
+	// A rejected block leaves no programming busy behind
+	HOST_CHECK(SD_Sync() == SD_OK);
+	card.fault_resp = SD_DATA_RESP_CRC_ERR;
+	HOST_CHECK(SD_WriteBlock(301, wbuf) == SD_ERROR_CRC);
+	HOST_CHECK(SD_IsBusy() == FALSE);
+	card.fault_resp = SD_DATA_RESP_WRITE_ERR;
+	HOST_CHECK(SD_WriteBlocks(301, wbuf, 2) == SD_ERROR_WRITE);
+	HOST_CHECK(SD_WriteBlock(301, wbuf) == SD_OK);
+
+	HOST_CHECK(SD_ReadBlock(CARD_BLOCKS, rbuf) == SD_NG);
+	HOST_CHECK(SD_WriteBlocks(CARD_BLOCKS, wbuf, 2) == SD_NG);
+	HOST_CHECK(SD_ReadBlocks(0, NULL, 1) == SD_CMD_BAD_PARAMETER);
+	HOST_CHECK(SD_WriteBlocks(0, wbuf, 0) == SD_CMD_BAD_PARAMETER);
+	HOST_CHECK(SD_Sync() == SD_OK);
+	HOST_CHECK(card.violations == 0);
+}
+
+
+/*********************************************************************//**
+ * @brief 		Modelled throughput of 16 block transfers against the
+ * 				bare wire rate
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void bench (void)
+{
+	uint64_t t;
+	uint32_t n, bytes = 0;
+	double wire;
+
+	fill(wbuf, sizeof(wbuf), 11);
+	t = host_cycles;
+	for (n = 0; n < 32; n++)
+	{
+		HOST_CHECK(SD_WriteBlocks(1000 + 16 * n, wbuf, 16) == SD_OK);
+		bytes += sizeof(wbuf);
+	}
+	HOST_CHECK(SD_Sync() == SD_OK);
+	t = host_cycles - t;
+	wire = card.sck / 8.0 / 1024;
+	host_printf("write %u KB: %6.1f KB/s (SCK %u Hz, wire %6.1f KB/s)\n",
+				bytes / 1024, bytes / 1024.0 * SystemCoreClock / t, card.sck, wire);
+
+	t = host_cycles;
+	for (n = 0; n < 32; n++)
+	{
+		HOST_CHECK(SD_ReadBlocks(1000 + 16 * n, rbuf, 16) == SD_OK);
+	}
+	t = host_cycles - t;
+	HOST_CHECK(memcmp(rbuf, wbuf, sizeof(wbuf)) == 0);
+	host_printf("read  %u KB: %6.1f KB/s\n", bytes / 1024,
+				bytes / 1024.0 * SystemCoreClock / t);
+}
+
+
+int main (void)
+{
+	spi.SPDR = SPI_DR_IDLE | 0xFF;
+
+	test_card(SD_CARD_V1);
+	HOST_CHECK(card.sck == 12500000);		// raised after identification
+	test_card(SD_CARD_V2);
+	test_card(SD_CARD_V2_HC);
+	test_busy();
+	test_errors();
+	bench();
+
+	return host_done("test_sd");
+}
+
+/* --------------------------------- End Of File ------------------------------ */
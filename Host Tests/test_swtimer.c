@@ -0,0 +1,581 @@
+/******************************************************************//**
+* @file		test_swtimer.c
+* @brief	Host test of the software timer wheel and the tickless idle
+* 			on the simulated clock: random timers against a reference,
+* 			expiries at every wheel boundary, late dispatch, and
+* 			SYSTICK_Idle() stretches with early wakes
+* @version	1.0
+* @date		21. July. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* The wheel runs unchanged: SWTIMER_Tick() pends PendSV through the SCB
+ * model and host.c runs lpc_swtimer.c's PendSV_Handler, so callbacks come
+ * from the deferred context as on the target. The first tests tick the
+ * wheel by hand with SysTick off. test_idle() then starts SysTick with
+ * SYSTICK_Config() and sleeps in SYSTICK_Idle(): tick k must start at
+ * clock t0 + k * SYSTICK_PER however the stretches end. */
+
+/* Includes ------------------------------------------------------------------- */
+#include "host.h"
+#include "lpc_swtimer.h"
+#include "lpc17xx_systick.h"
+
+
+/* Private Macros ------------------------------------------------------------- */
+/** Clocks of one tick, SYSTICK_Config() sets 1 ms */
+#define SYSTICK_PER			(SystemCoreClock / 1000)
+
+/** A tick may be counted this many clocks early, SYSTICK_IDLE_MARGIN */
+#define IDLE_EARLY			64
+
+/** Latest a callback may run after its tick started, 20 us */
+#define IDLE_LATE			2000
+
+/** Reference timers */
+#define REF_TIMERS			64
+
+/** Ticks of the random run, and of each idle run */
+#define WHEEL_TICKS			300000
+#define IDLE_TICKS			20000
+
+/** Longest single step of the simulated clock while the core works,
+ * host_advance() runs the interrupts it pended at its end */
+#define WORK_STEP			1000
+
+/** Heartbeat rate the test sets, in ticks between toggles */
+#define HEARTBEAT			1000
+
+
+/* Private Types -------------------------------------------------------------- */
+/** Timer and what the reference expects of it */
+typedef struct {
+	SWTIMER_Type timer;
+	uint32_t expires;			/**< Tick of the next callback */
+	uint32_t period;			/**< 0 for a one-shot */
+	uint8_t running;
+} REF_TIMER_Type;
+
+
+/* Private Variables ---------------------------------------------------------- */
+static REF_TIMER_Type ref[REF_TIMERS];
+static uint32_t wheel_now;				// ticks given by hand, SysTick adds its own
+static uint32_t delay_levels = SWTIMER_LEVELS;
+static uint8_t chaos = 1;				// callbacks restart and stop timers
+static uint64_t idle_t0;				// clock of tick 0, 0 while SysTick is off
+static uint32_t fired, wrong, late;
+static uint32_t late_fires, late_at;
+static uint32_t rnd = 7;
+
+
+/* Private Functions ---------------------------------------------------------- */
+static uint32_t rnd_next (void)
+{
+	rnd = rnd * 1103515245 + 12345;
+	return (rnd >> 16) | ((rnd & 0xFFFF) << 16);
+}
+
+
+/*********************************************************************//**
+ * @brief 		Tick the wheel has reached
+ * @param		None
+ * @return 		Tick
+ **********************************************************************/
+static uint32_t now (void)
+{
+	return wheel_now + SYSTICK_GetTick();
+}
+
+
+/*********************************************************************//**
+ * @brief 		Random delay, spread over the first delay_levels wheels
+ * @param		None
+ * @return 		Ticks, 0 now and then (the wheel takes it as 1)
+ **********************************************************************/
+static uint32_t rnd_delay (void)
+{
+	uint32_t level = rnd_next() % delay_levels;
+
+	return rnd_next() & ((1UL << (5 * (level + 1))) - 1);
+}
+
+
+static void ref_cb (void *arg);
+
+
+/*********************************************************************//**
+ * @brief 		Start a reference timer and the wheel's
+ * @param[in]	r		Timer
+ * @param[in]	delay	Ticks to the first callback
+ * @param[in]	period	Ticks between later ones, 0 for a one-shot
+ * @return 		None
+ **********************************************************************/
+static void ref_start (REF_TIMER_Type *r, uint32_t delay, uint32_t period)
+{
+	if (delay == 0)
+	{
+		delay = 1;
+	}
+	r->expires = now() + delay;
+	r->period = period;
+	r->running = 1;
+	SWTIMER_Start(&r->timer, delay, period);
+}
+
+
+static void ref_stop (REF_TIMER_Type *r)
+{
+	r->running = 0;
+	SWTIMER_Stop(&r->timer);
+}
+
+
+/*********************************************************************//**
+ * @brief 		Callback of the reference timers: it must come on the
+ * 				expected tick, and with SysTick on, right after that tick
+ * 				started. Restarts or stops a random timer now and then,
+ * 				the wheel is used from its own dispatch.
+ * @param[in]	arg		Timer
+ * @return 		None
+ **********************************************************************/
+static void ref_cb (void *arg)
+{
+	REF_TIMER_Type *r = (REF_TIMER_Type *)arg;
+	int64_t since;
+
+	fired++;
+	if (!r->running || (r->expires != now()))
+	{
+		wrong++;
+	}
+	if (idle_t0 != 0)
+	{
+		since = (int64_t)(host_cycles - idle_t0) - (int64_t)SYSTICK_GetTick() * SYSTICK_PER;
+		if ((since < -IDLE_EARLY) || (since > IDLE_LATE))
+		{
+			late++;
+		}
+	}
+
+	if (r->period != 0)
+	{
+		r->expires += r->period;
+	}
+	else
+	{
+		r->running = 0;
+	}
+
+	switch (chaos ? (rnd_next() % 8) : 7)
+	{
+	case 0:
+		ref_start(&ref[rnd_next() % REF_TIMERS], rnd_delay(), (rnd_next() & 1) ? rnd_delay() : 0);
+		break;
+	case 1:
+		ref_stop(&ref[rnd_next() % REF_TIMERS]);
+		break;
+	default:
+		break;
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief 		Give the wheel one tick by hand, PendSV runs the
+ * 				callbacks before this returns
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void tick (void)
+{
+	wheel_now++;
+	SWTIMER_Tick();
+	host_advance(0);
+}
+
+
+/*********************************************************************//**
+ * @brief 		Ticks to the first expiry the reference expects
+ * @param		None
+ * @return 		Ticks, SWTIMER_MAX_DELAY if no timer runs
+ **********************************************************************/
+static uint32_t ref_next (void)
+{
+	uint32_t i, best = SWTIMER_MAX_DELAY;
+
+	for (i = 0; i < REF_TIMERS; i++)
+	{
+		if (ref[i].running && ((ref[i].expires - now()) < best))
+		{
+			best = ref[i].expires - now();
+		}
+	}
+	return best;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Callback of test_late(): counts and notes the tick
+ * @param[in]	arg		unused
+ * @return 		None
+ **********************************************************************/
+static void late_cb (void *arg)
+{
+	late_fires++;
+	late_at = now();
+}
+
+
+/*********************************************************************//**
+ * @brief 		Heartbeat toggles expected in a range of ticks: the
+ * 				first at tick 1, then every led_delay + 1
+ * @param[in]	from	Ticks already done
+ * @param[in]	to		Last tick
+ * @return 		Toggles in (from, to]
+ **********************************************************************/
+static uint32_t heartbeat_toggles (uint32_t from, uint32_t to)
+{
+	return ((to + HEARTBEAT) / (HEARTBEAT + 1)) - ((from + HEARTBEAT) / (HEARTBEAT + 1));
+}
+
+
+/*********************************************************************//**
+ * @brief 		Core busy with interrupts enabled, SysTick interrupts
+ * 				run within WORK_STEP of their tick
+ * @param[in]	cycles	Clocks
+ * @return 		None
+ **********************************************************************/
+static void work (uint32_t cycles)
+{
+	while (cycles > WORK_STEP)
+	{
+		host_advance(WORK_STEP);
+		cycles -= WORK_STEP;
+	}
+	host_advance(cycles);
+}
+
+
+/*********************************************************************//**
+ * @brief 		SysTick phase: the tick count is the number of whole
+ * 				periods since t0, give or take the tick in progress
+ * @param[in]	exact	Move to the middle of a tick first, the count
+ * 						must then be exact
+ * @return 		1 if the count is off
+ **********************************************************************/
+static uint32_t phase_off (Bool exact)
+{
+	uint32_t in, expect, tick;
+
+	if (exact)
+	{
+		in = (uint32_t)((host_cycles - idle_t0) % SYSTICK_PER);
+		work((in < SYSTICK_PER / 2) ? (SYSTICK_PER / 2 - in) : (SYSTICK_PER + SYSTICK_PER / 2 - in));
+	}
+	tick = SYSTICK_GetTick();
+	expect = (uint32_t)((host_cycles - idle_t0) / SYSTICK_PER);
+	if (exact)
+	{
+		return (tick != expect) ? 1 : 0;
+	}
+	return ((tick + 1 < expect) || (tick > expect + 1)) ? 1 : 0;
+}
+
+
+/* Stubs ---------------------------------------------------------------------- */
+uint32_t led_delay = HEARTBEAT;
+
+
+/* Tests ---------------------------------------------------------------------- */
+/*********************************************************************//**
+ * @brief 		Random one-shot and periodic timers started, restarted
+ * 				and stopped from the main loop and from callbacks,
+ * 				against the reference, with SWTIMER_NextExpiry() never
+ * 				past the first expiry
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void test_wheel (void)
+{
+	uint32_t i, n, ahead = 0, state = 0;
+
+	for (i = 0; i < REF_TIMERS; i++)
+	{
+		SWTIMER_Init(&ref[i].timer, ref_cb, &ref[i]);
+	}
+	HOST_CHECK(SWTIMER_NextExpiry() == SWTIMER_MAX_DELAY);
+
+	fired = wrong = 0;
+	for (n = 0; n < WHEEL_TICKS; n++)
+	{
+		i = rnd_next() % REF_TIMERS;
+		switch (rnd_next() % 16)
+		{
+		case 0:
+		case 1:
+			ref_start(&ref[i], rnd_delay(), 0);
+			break;
+		case 2:
+			ref_start(&ref[i], rnd_delay(), 1 + (rnd_next() % 2000));
+			break;
+		case 3:
+			ref_stop(&ref[i]);
+			break;
+		default:
+			break;
+		}
+
+		if (SWTIMER_NextExpiry() > ref_next())
+		{
+			ahead++;
+		}
+		for (i = 0; i < REF_TIMERS; i++)
+		{
+			if ((SWTIMER_IsRunning(&ref[i].timer) == TRUE) != (ref[i].running != 0))
+			{
+				state++;
+			}
+		}
+		tick();
+	}
+	host_printf("test_swtimer: %u callbacks in %u ticks\n", fired, WHEEL_TICKS);
+
+	HOST_CHECK(fired > WHEEL_TICKS / 20);
+	HOST_CHECK(wrong == 0);
+	HOST_CHECK(ahead == 0);
+	HOST_CHECK(state == 0);
+
+	for (i = 0; i < REF_TIMERS; i++)
+	{
+		ref_stop(&ref[i]);
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief 		Delays on each side of every wheel boundary, up to
+ * 				SWTIMER_MAX_DELAY, from a random phase of the wheels
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void test_long (void)
+{
+	static const uint32_t delays[] = {
+		1, 2, 31, 32, 33, 1023, 1024, 1025, 32767, 32768, 32769,
+		1048575, 1048576, 1048577, 20000000, SWTIMER_MAX_DELAY - 1, SWTIMER_MAX_DELAY
+	};
+	uint32_t i, count = sizeof(delays) / sizeof(delays[0]), ahead = 0;
+
+	for (i = rnd_next() % 50000; i != 0; i--)
+	{
+		tick();
+	}
+
+	chaos = 0;
+	fired = wrong = 0;
+	for (i = 0; i < count; i++)
+	{
+		ref_start(&ref[i], delays[i], 0);
+	}
+	ref_start(&ref[count], SWTIMER_MAX_DELAY, 0);
+	SWTIMER_Start(&ref[count].timer, SWTIMER_MAX_DELAY + 1000, 0);	// clamped
+
+	for (i = 0; i <= SWTIMER_MAX_DELAY; i++)
+	{
+		if ((i & 0xFFF) == 0)
+		{
+			ahead += (SWTIMER_NextExpiry() > ref_next()) ? 1 : 0;
+		}
+		tick();
+	}
+	chaos = 1;
+
+	HOST_CHECK(fired == count + 1);
+	HOST_CHECK(wrong == 0);
+	HOST_CHECK(ahead == 0);
+	HOST_CHECK(SWTIMER_NextExpiry() == SWTIMER_MAX_DELAY);
+}
+
+
+/*********************************************************************//**
+ * @brief 		Dispatch held off by masked interrupts: periodic timers
+ * 				fire once and keep their phase, also when the period
+ * 				after the missed one ends on the dispatch tick, and a
+ * 				one-shot stopped while waiting for dispatch is not called
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void test_late (void)
+{
+	SWTIMER_Type periodic, eight, oneshot;
+	uint32_t start, i;
+
+	SWTIMER_Init(&periodic, late_cb, NULL);
+	SWTIMER_Init(&eight, late_cb, NULL);
+	SWTIMER_Init(&oneshot, late_cb, NULL);
+	HOST_CHECK(SWTIMER_IsRunning(&periodic) == FALSE);
+
+	start = now();
+	SWTIMER_Start(&periodic, 2, 3);
+	SWTIMER_Start(&eight, 2, 8);
+	SWTIMER_Start(&oneshot, 1, 0);
+
+	__disable_irq();
+	for (i = 0; i < 10; i++)
+	{
+		tick();
+	}
+	HOST_CHECK(late_fires == 0);
+	HOST_CHECK(SWTIMER_NextExpiry() == 0);
+	SWTIMER_Stop(&oneshot);
+	__enable_irq();
+
+	/* Due at start + 2, dispatched at start + 10: next at start + 11,
+	 * and start + 18 for the 8 tick one */
+	HOST_CHECK(late_fires == 2);
+	HOST_CHECK(late_at == start + 10);
+	HOST_CHECK(SWTIMER_IsRunning(&oneshot) == FALSE);
+	HOST_CHECK(SWTIMER_NextExpiry() == 1);
+
+	tick();
+	HOST_CHECK(late_fires == 3);
+	HOST_CHECK(late_at == start + 11);
+	for (i = 0; i < 3; i++)
+	{
+		tick();
+	}
+	HOST_CHECK(late_fires == 4);
+	HOST_CHECK(late_at == start + 14);
+	for (i = 0; i < 4; i++)
+	{
+		tick();
+	}
+	HOST_CHECK(late_fires == 6);
+	HOST_CHECK(late_at == start + 18);
+
+	SWTIMER_Stop(&periodic);
+	SWTIMER_Stop(&eight);
+	HOST_CHECK(SWTIMER_IsRunning(&periodic) == FALSE);
+	HOST_CHECK(SWTIMER_NextExpiry() == SWTIMER_MAX_DELAY);
+}
+
+
+/*********************************************************************//**
+ * @brief 		SysTick and the tickless idle: random timers and work,
+ * 				early wakes at random clocks, then a quiet run with the
+ * 				heartbeat alone and delay_ms(). The tick count must
+ * 				follow the clock, callbacks come right after their tick
+ * 				started and the idle core is not woken every tick.
+ * @param		None
+ * @return 		None
+ **********************************************************************/
+static void test_idle (void)
+{
+	uint32_t i, loops, drift = 0, from, toggles, led, ms;
+	uint64_t start;
+
+	SYSTICK_Config();
+	host_advance(0);						// the enable takes effect
+	idle_t0 = host_cycles;
+
+	/* Busy: timers up to 1024 ticks, wakes and work at random clocks */
+	delay_levels = 2;
+	fired = wrong = late = 0;
+	for (i = 0; i < 8; i++)
+	{
+		ref_start(&ref[i], rnd_delay(), (rnd_next() & 1) ? rnd_delay() : 0);
+	}
+	for (loops = 0; SYSTICK_GetTick() < IDLE_TICKS; loops++)
+	{
+		if (rnd_next() & 1)
+		{
+			host_wake_at(host_cycles + 1 + (rnd_next() % (3 * SYSTICK_PER)));
+		}
+		SYSTICK_Idle();
+		drift += phase_off(FALSE);
+
+		switch (rnd_next() % 16)
+		{
+		case 0:
+			work(rnd_next() % (2 * SYSTICK_PER));
+			break;
+		case 1:
+			drift += phase_off(TRUE);
+			break;
+		case 2:
+			i = rnd_next() % 8;
+			if (!ref[i].running)
+			{
+				ref_start(&ref[i], rnd_delay(), (rnd_next() & 1) ? rnd_delay() : 0);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+	drift += phase_off(TRUE);
+	host_printf("test_swtimer: busy idle, %u callbacks, %u wakes in %u ticks\n",
+				fired, loops, SYSTICK_GetTick());
+
+	HOST_CHECK(fired > IDLE_TICKS / 100);
+	HOST_CHECK(wrong == 0);
+	HOST_CHECK(late == 0);
+	HOST_CHECK(drift == 0);
+
+	/* Quiet: the heartbeat alone, every toggle seen and on time */
+	for (i = 0; i < REF_TIMERS; i++)
+	{
+		ref_stop(&ref[i]);
+	}
+	host_wake_at(0);
+	from = SYSTICK_GetTick();
+	led = LPC_GPIO3->FIOPIN & _BIT(25);
+	toggles = 0;
+	for (loops = 0; SYSTICK_GetTick() < from + IDLE_TICKS; loops++)
+	{
+		SYSTICK_Idle();
+		drift += phase_off(FALSE);
+		if ((LPC_GPIO3->FIOPIN & _BIT(25)) != led)
+		{
+			led ^= _BIT(25);
+			toggles++;
+		}
+	}
+	drift += phase_off(TRUE);
+	host_printf("test_swtimer: quiet idle, %u wakes in %u ticks\n", loops, IDLE_TICKS);
+
+	HOST_CHECK(toggles == heartbeat_toggles(from, SYSTICK_GetTick()));
+	HOST_CHECK(loops < IDLE_TICKS / 100);
+	HOST_CHECK(drift == 0);
+
+	/* delay_ms() ends on time whatever the phase it starts at, to the
+	 * microsecond now_us() counts */
+	for (i = 0; i < 20; i++)
+	{
+		work(rnd_next() % SYSTICK_PER);
+		ms = 1 + (rnd_next() % 300);
+		start = host_cycles;
+		delay_ms(ms);
+		if ((host_cycles - start + SystemCoreClock / 1000000 < (uint64_t)ms * SYSTICK_PER)
+			|| (host_cycles - start > (uint64_t)ms * SYSTICK_PER + IDLE_LATE))
+		{
+			drift++;
+		}
+		drift += phase_off(FALSE);
+	}
+	drift += phase_off(TRUE);
+	HOST_CHECK(drift == 0);
+}
+
+
+int main (void)
+{
+	test_wheel();
+	test_long();
+	test_late();
+	test_idle();
+
+	return host_done("test_swtimer");
+}
+
+/* --------------------------------- End Of File ------------------------------ */
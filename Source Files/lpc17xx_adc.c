@@ -19,6 +19,118 @@
  * otherwise the default FW library configuration file must be included instead
  */
 
+/* Private Variables ---------------------------------------------------------- */
+/** @defgroup ADC_Private_Variables ADC Private Variables
+ * @{
+ */
+
+/** Scans per raw block, each scan takes one 8 word slot indexed by channel */
+#define ADC_STREAM_SCANS	(ADC_STREAM_BLOCK / 8)
+
+/** ADDRn words moved by GPDMA, ping-pong, one LLI per scan (1KB) */
+static uint32_t adc_raw[2][ADC_STREAM_BLOCK];
+static GPDMA_LLI_Type adc_lli[2 * ADC_STREAM_SCANS];
+
+/** Averaged frames handed to the callback, ping-pong */
+static uint16_t adc_out[2][ADC_STREAM_FRAMES * 8];
+static uint8_t adc_out_blk;
+static uint32_t adc_out_frames;
+
+/** Per channel accumulators of the frame being built */
+static uint32_t adc_acc[8];
+static uint16_t adc_cnt[8];
+
+static ADC_STREAM_CFG_Type adc_stream;
+static uint8_t adc_nch;							// channels in the mask
+static uint8_t adc_first_ch;					// lowest channel, starts a scan
+static uint8_t adc_last_ch;						// highest channel, ends a scan
+static uint8_t adc_raw_blk;						// block the DMA fills next
+static int32_t adc_dma_ch = -1;
+static uint32_t adc_rate;						// actual frame rate
+static __IO uint32_t adc_status = ADC_STREAM_IDLE;
+static uint32_t adc_overruns;
+
+/**
+ * @}
+ */
+
+
+/* Private Functions ---------------------------------------------------------- */
+/*********************************************************************//**
+ * @brief		Demultiplex a block of ADDRn words into averaged frames
+ * @param[in]	raw		ADC_STREAM_SCANS slots of 8 words copied by GPDMA
+ * @return 		None
+ *
+ * Note: a word sits at the index of its channel within the slot and
+ * each read cleared its DONE flag, so a lost conversion reads as not
+ * done and only shortens one average instead of shifting the channels.
+ **********************************************************************/
+static void adc_stream_process (const uint32_t *raw)
+{
+	uint32_t i, w, ch, k;
+	uint16_t *out;
+
+	for (i = 0; i < ADC_STREAM_BLOCK; i++)
+	{
+		w = raw[i];
+		ch = i & 7;
+		if (!(adc_stream.ChannelMask & _BIT(ch)) || !(w & ADC_DR_DONE_FLAG))
+		{
+			continue;
+		}
+		if (w & ADC_DR_OVERRUN_FLAG)
+		{
+			adc_overruns++;
+		}
+		adc_acc[ch] += ADC_DR_RESULT(w);
+		adc_cnt[ch]++;
+
+		if ((ch != adc_last_ch) || (adc_cnt[ch] < adc_stream.Decimation))
+		{
+			continue;
+		}
+
+		// Scan complete Decimation times, emit one frame
+		out = &adc_out[adc_out_blk][adc_out_frames * adc_nch];
+		for (ch = 0, k = 0; ch < 8; ch++)
+		{
+			if (adc_stream.ChannelMask & _BIT(ch))
+			{
+				out[k++] = adc_cnt[ch] ? (uint16_t)(adc_acc[ch] / adc_cnt[ch]) : 0;
+				adc_acc[ch] = 0;
+				adc_cnt[ch] = 0;
+			}
+		}
+		if (++adc_out_frames == ADC_STREAM_FRAMES)
+		{
+			adc_stream.Callback(adc_out[adc_out_blk], ADC_STREAM_FRAMES);
+			adc_out_blk ^= 1;
+			adc_out_frames = 0;
+		}
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief		Raw block completion (called from DMA_IRQHandler), the
+ * 				DMA already moved on to the other block
+ * @param[in]	ChannelNum	GPDMA channel
+ * @param[in]	Status		GPDMA_CB_DONE or GPDMA_CB_ERROR
+ * @return 		None
+ **********************************************************************/
+static void adc_stream_dma_done (uint32_t ChannelNum, uint32_t Status)
+{
+	if (Status != GPDMA_CB_DONE)
+	{
+		ADC_StreamStop();
+		adc_status = ADC_STREAM_ERROR;
+		return;
+	}
+	adc_stream_process(adc_raw[adc_raw_blk]);
+	adc_raw_blk ^= 1;
+}
+
+
 /*----------------- INTERRUPT SERVICE ROUTINES --------------------------*/
 /*********************************************************************//**
  * @brief		ADC interrupt handler sub-routine
@@ -118,7 +230,7 @@ void ADC_Channel_Config(LPC_ADC_TypeDef *ADCx, ADC_CHANNEL_SELECTION PCfg, Funct
 			 PinCfg.Funcnum = 1;
 			 PinCfg.OpenDrain = 0;
 			 PinCfg.Pinmode = 0;
-			 PinCfg.Pinnum = 23;
+			 PinCfg.Pinnum = 26;
 			 PinCfg.Portnum = 0;
 			 PINSEL_ConfigPin(&PinCfg);
 
@@ -150,6 +262,32 @@ void ADC_Channel_Config(LPC_ADC_TypeDef *ADCx, ADC_CHANNEL_SELECTION PCfg, Funct
 
 			 ADC_IntConfig(LPC_ADC, ADC_ADINTEN5, IntState);
 
+			 break;
+
+		 case ADC_CHANNEL_6:
+			 // Configure P0.3 as CH6
+			 PinCfg.Funcnum = 2;
+			 PinCfg.OpenDrain = 0;
+			 PinCfg.Pinmode = 0;
+			 PinCfg.Pinnum = 3;
+			 PinCfg.Portnum = 0;
+			 PINSEL_ConfigPin(&PinCfg);
+
+			 ADC_IntConfig(LPC_ADC, ADC_ADINTEN6, IntState);
+
+			 break;
+
+		 case ADC_CHANNEL_7:
+			 // Configure P0.2 as CH7
+			 PinCfg.Funcnum = 2;
+			 PinCfg.OpenDrain = 0;
+			 PinCfg.Pinmode = 0;
+			 PinCfg.Pinnum = 2;
+			 PinCfg.Portnum = 0;
+			 PINSEL_ConfigPin(&PinCfg);
+
+			 ADC_IntConfig(LPC_ADC, ADC_ADINTEN7, IntState);
+
 			 break;
 		}
 	}
@@ -449,6 +587,180 @@ FlagStatus	ADC_GlobalGetStatus(LPC_ADC_TypeDef *ADCx, uint32_t StatusType)
 	}
 }
 
+/*********************************************************************//**
+* @brief 		Start continuous acquisition: the channels are scanned in
+* 				burst mode and GPDMA copies every scan into two raw
+* 				blocks in turn, which are averaged into frames
+* @param[in]	StreamCfg	Channels, output rate, decimation and callback
+* @return 		SUCCESS, or ERROR if the rate is out of range or no DMA
+* 				channel is free
+*
+* Note: a burst scan runs from its own clock, so the rate is set by the
+* ADC clock divider: one frame every Decimation scans of all channels.
+* The divider is integer, ADC_StreamGetRate() returns the rate reached.
+* The ADC interrupt stays off in the NVIC, ADINTEN only raises the DMA
+* request. The request follows the DONE flag of the enabled channel and
+* only a read of its ADDRn drops it, ADGDR does not: ADINTEN selects the
+* last channel of the scan and each request runs one LLI that reads
+* ADDRn of the first to the last channel. GPDMA_Init() must have been
+* called.
+**********************************************************************/
+Status ADC_StreamStart(ADC_STREAM_CFG_Type *StreamCfg)
+{
+	GPDMA_Channel_CFG_Type cfg;
+	uint32_t pclk, conv, div, min_div, ctrl, ch, i, s;
+
+	if ((StreamCfg->ChannelMask == 0) || (StreamCfg->Rate == 0) || (StreamCfg->Callback == NULL))
+	{
+		return ERROR;
+	}
+
+	ADC_StreamStop();
+
+	adc_stream = *StreamCfg;
+	if (adc_stream.Decimation == 0)
+	{
+		adc_stream.Decimation = 1;
+	}
+
+	CLKPWR_ConfigPPWR (CLKPWR_PCONP_PCAD, ENABLE);
+
+	adc_nch = 0;
+	for (ch = 0; ch < 8; ch++)
+	{
+		if (adc_stream.ChannelMask & _BIT(ch))
+		{
+			if (adc_nch++ == 0)
+			{
+				adc_first_ch = ch;
+			}
+			adc_last_ch = ch;
+			ADC_Channel_Config(LPC_ADC, (ADC_CHANNEL_SELECTION)ch, DISABLE);
+		}
+		adc_acc[ch] = 0;
+		adc_cnt[ch] = 0;
+	}
+
+	// Conversions per second, 65 ADC clocks each, ADC clock <= 13MHz
+	conv = adc_stream.Rate * adc_stream.Decimation * adc_nch;
+	if (!PARAM_ADC_RATE(conv))
+	{
+		return ERROR;
+	}
+	pclk = CLKPWR_GetPCLK(CLKPWR_PCLKSEL_ADC);
+	min_div = (pclk + 13000000 - 1) / 13000000;
+	div = pclk / (conv * 65);
+	if (div < min_div) div = min_div;
+	if (div > 256)
+	{
+		return ERROR;								// raise Decimation instead
+	}
+	adc_rate = pclk / (div * 65 * adc_nch * adc_stream.Decimation);
+
+	if (adc_dma_ch < 0)
+	{
+		adc_dma_ch = GPDMA_ChannelAlloc(GPDMA_PRIO_HIGH);
+		if (adc_dma_ch < 0)
+		{
+			return ERROR;
+		}
+		GPDMA_SetCallback(adc_dma_ch, adc_stream_dma_done);
+	}
+
+	// One LLI per scan reads ADDRfirst..ADDRlast into the channel slots,
+	// the last scan of each block raises the terminal count, ring of two
+	s = adc_last_ch - adc_first_ch + 1;
+	ctrl = GPDMA_MakeControl(GPDMA_TRANSFERTYPE_P2M, GPDMA_CONN_ADC, 0, 0) \
+			| GPDMA_DMACCxControl_SI \
+			| GPDMA_DMACCxControl_TransferSize(s);
+	for (i = 0; i < 2 * ADC_STREAM_BLOCK; i++)
+	{
+		adc_raw[i / ADC_STREAM_BLOCK][i % ADC_STREAM_BLOCK] = 0;	// unread slots stay not done
+	}
+	for (i = 0; i < 2 * ADC_STREAM_SCANS; i++)
+	{
+		s = i % ADC_STREAM_SCANS;
+		adc_lli[i].SrcAddr = (uint32_t)(&LPC_ADC->ADDR0 + adc_first_ch);
+		adc_lli[i].DstAddr = (uint32_t)&adc_raw[i / ADC_STREAM_SCANS][s * 8 + adc_first_ch];
+		adc_lli[i].Control = ctrl | ((s == ADC_STREAM_SCANS - 1) ? GPDMA_DMACCxControl_I : 0);
+		adc_lli[i].NextLLI = (uint32_t)&adc_lli[(i + 1) % (2 * ADC_STREAM_SCANS)];
+	}
+
+	adc_raw_blk = 0;
+	adc_out_blk = 0;
+	adc_out_frames = 0;
+	adc_overruns = 0;
+
+	NVIC_DisableIRQ(ADC_IRQn);
+	LPC_ADC->ADCR = adc_stream.ChannelMask | ADC_CR_CLKDIV((div - 1)) | ADC_CR_PDN;
+	LPC_ADC->ADINTEN = ADC_INTEN_CH(adc_last_ch);
+
+	cfg.ChannelNum = adc_dma_ch;
+	cfg.TransferType = GPDMA_TRANSFERTYPE_P2M;
+	cfg.SrcConn = GPDMA_CONN_ADC;
+	cfg.DstConn = 0;
+	GPDMA_SetupLLI(&cfg, &adc_lli[0]);
+	GPDMA_ChannelCmd(adc_dma_ch, ENABLE);
+
+	adc_status = ADC_STREAM_RUNNING;
+	LPC_ADC->ADCR |= ADC_CR_BURST;
+
+	return SUCCESS;
+}
+
+
+/*********************************************************************//**
+* @brief 		Stop the acquisition, frames of an incomplete block are
+* 				discarded
+* @param[in]	None
+* @return 		None
+**********************************************************************/
+void ADC_StreamStop(void)
+{
+	if (adc_status != ADC_STREAM_RUNNING)
+	{
+		return;
+	}
+	LPC_ADC->ADCR &= ~ADC_CR_BURST;
+	LPC_ADC->ADINTEN = 0;
+	GPDMA_ChannelCmd(adc_dma_ch, DISABLE);
+	adc_status = ADC_STREAM_IDLE;
+}
+
+
+/*********************************************************************//**
+* @brief 		Frame rate reached by the last ADC_StreamStart()
+* @param[in]	None
+* @return 		Frames per second
+**********************************************************************/
+uint32_t ADC_StreamGetRate(void)
+{
+	return adc_rate;
+}
+
+
+/*********************************************************************//**
+* @brief 		State of the acquisition
+* @param[in]	None
+* @return 		ADC_STREAM_IDLE, ADC_STREAM_RUNNING or ADC_STREAM_ERROR
+**********************************************************************/
+uint32_t ADC_StreamGetStatus(void)
+{
+	return adc_status;
+}
+
+
+/*********************************************************************//**
+* @brief 		Conversions overwritten before GPDMA read them, a sign
+* 				the bus or DMA priority cannot keep up with the rate
+* @param[in]	None
+* @return 		Count since ADC_StreamStart()
+**********************************************************************/
+uint32_t ADC_StreamGetOverruns(void)
+{
+	return adc_overruns;
+}
+
 /**
  * @}
  */
@@ -459,4 +771,3 @@ FlagStatus	ADC_GlobalGetStatus(LPC_ADC_TypeDef *ADCx, uint32_t StatusType)
  */
 
 /* --------------------------------- End Of File ------------------------------ */
-
@@ -34,38 +34,32 @@ uint16_t CANAF_gstd_cnt = 0;
 uint16_t CANAF_ext_cnt = 0;
 uint16_t CANAF_gext_cnt = 0;
 
+/* Mailboxes, index 0 for CAN1 and 1 for CAN2 */
+static CAN_RX_FRAME_Type can_rx[2][CAN_RX_RING];
+static __IO uint32_t can_rx_head[2], can_rx_tail[2];	// head written by the ISR only
+
+/* TX queue sorted by priority, lowest value first, FIFO among equals */
+static CAN_MSG_Type can_tx[2][CAN_TX_QUEUE];
+static uint8_t can_tx_prio[2][CAN_TX_QUEUE];
+static uint8_t can_tx_num[2];
+static uint8_t can_txb_prio[2][3];		// PRIO field loaded in each TX buffer
+
+static CAN_STATS_Type can_stats[2];
+static uint8_t can_active[2];
+
+/* Latest value of each FullCAN object. The ISR fills the slot that is not
+ * published and then bumps seq, whose low bit selects the published slot */
+static struct {
+	CAN_RX_FRAME_Type slot[2];
+	__IO uint32_t seq;
+} can_fc_sig[MAX_HW_FULLCAN_OBJ];
+static uint8_t can_fc_active;
+
 /* End of Private Variables ----------------------------------------------------*/
 /**
  * @}
  */
 
-/*----------------- INTERRUPT SERVICE ROUTINES --------------------------*/
-/*********************************************************************//**
- * @brief		CAN_IRQ Handler, control receive message operation
- * param[in]	none
- * @return 		none
- **********************************************************************/
-void CAN_IRQHandler()
-{
-	uint8_t IntStatus;
-//	uint32_t data1;
-	/* Get CAN status */
-	IntStatus = CAN_GetCTRLStatus(LPC_CAN1, CANCTRL_STS);
-	//check receive buffer status
-	if((IntStatus>>0)&0x01)
-	{
-		CAN_ReceiveMsg(LPC_CAN1,&RXMsg);
-		printf(LPC_UART0,"\n\rReceived buffer:\n\r");
-		PrintMessage(&RXMsg);
-		//Validate received and transmited message
-		if(Check_Message(&TXMsg, &RXMsg))
-			printf(LPC_UART0,"\n\rSelf test is SUCCESSFUL!!!");
-		else
-			printf(LPC_UART0,"\n\rSelf test is FAIL!!!");
-	}
-}
-
-
 /* Private Variables ---------------------------------------------------------- */
 static void can_SetBaudrate (LPC_CAN_TypeDef *CANx, uint32_t baudrate);
 
@@ -124,9 +118,327 @@ static void can_SetBaudrate (LPC_CAN_TypeDef *CANx, uint32_t baudrate)
 	/* Return to normal operating */
 	CANx->MOD = 0;
 }
+
+
+/*********************************************************************//**
+ * @brief 		Time stamp of a received frame
+ * @param[in] 	None
+ * @return 		Microseconds from now_us()
+ *
+ * Note: the controller has no time stamp of its own, the ISR takes one
+ * as it empties the receive buffer, on the same clock as the UART and
+ * EMAC stamps.
+ ***********************************************************************/
+static uint32_t can_stamp (void)
+{
+	return now_us();
+}
+
+
+/*********************************************************************//**
+ * @brief 		Load the best queued frames into the free TX buffers,
+ * 				called with interrupts masked or from the ISR
+ * @param[in] 	CANx: CAN peripheral
+ * @param[in] 	ch: mailbox index, 0 for CAN1
+ * @return 		None
+ *
+ * Note: Transmit Priority Mode is set, so of the three buffers the one
+ * with the lowest PRIO field goes on the bus first, and of equal PRIO
+ * fields the lowest buffer number. A frame is therefore never loaded
+ * below a busy higher numbered buffer holding the same priority, which
+ * would let it overtake that earlier frame.
+ ***********************************************************************/
+static void can_tx_kick (LPC_CAN_TypeDef *CANx, uint8_t ch)
+{
+	__IO uint32_t *buf;
+	CAN_MSG_Type *msg;
+	uint8_t b, i;
+
+	for (b = 0; (b < 3) && (can_tx_num[ch] != 0); b++)
+	{
+		if (!(CANx->SR & (CAN_SR_TBS1 << (8 * b))))
+		{
+			continue;
+		}
+		for (i = b + 1; i < 3; i++)
+		{
+			if (!(CANx->SR & (CAN_SR_TBS1 << (8 * i))) && \
+					(can_txb_prio[ch][i] == can_tx_prio[ch][0]))
+			{
+				break;
+			}
+		}
+		if (i < 3)
+		{
+			continue;
+		}
+		msg = &can_tx[ch][0];
+		buf = &CANx->TFI1 + (4 * b);
+		buf[0] = CAN_TFI_PRIO(can_tx_prio[ch][0]) | CAN_TFI_DLC(msg->len) | \
+				((msg->type == REMOTE_FRAME) ? CAN_TFI_RTR : 0) | \
+				((msg->format == EXT_ID_FORMAT) ? CAN_TFI_FF : 0);
+		buf[1] = msg->id;
+		buf[2] = (msg->dataA[0])|((msg->dataA[1])<<8)|((msg->dataA[2])<<16)|((msg->dataA[3])<<24);
+		buf[3] = (msg->dataB[0])|((msg->dataB[1])<<8)|((msg->dataB[2])<<16)|((msg->dataB[3])<<24);
+		CANx->CMR = CAN_CMR_TR | (CAN_CMR_STB1 << b);
+		can_txb_prio[ch][b] = can_tx_prio[ch][0];
+
+		can_tx_num[ch]--;
+		for (i = 0; i < can_tx_num[ch]; i++)
+		{
+			can_tx[ch][i] = can_tx[ch][i + 1];
+			can_tx_prio[ch][i] = can_tx_prio[ch][i + 1];
+		}
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief 		Service one controller: empty its receive buffer into
+ * 				the ring, refill the TX buffers and count errors
+ * @param[in] 	CANx: CAN peripheral
+ * @param[in] 	ch: mailbox index, 0 for CAN1
+ * @return 		None
+ ***********************************************************************/
+static void can_service (LPC_CAN_TypeDef *CANx, uint8_t ch)
+{
+	CAN_RX_FRAME_Type *f;
+	uint32_t icr, rfs, data, head;
+
+	icr = CANx->ICR;							// read clears all but RI
+
+	while (CANx->SR & CAN_SR_RBS)
+	{
+		head = can_rx_head[ch];
+		if ((head - can_rx_tail[ch]) < CAN_RX_RING)
+		{
+			f = &can_rx[ch][head & (CAN_RX_RING - 1)];
+			f->stamp = can_stamp();
+			rfs = CANx->RFS;
+			f->msg.format = (rfs & CAN_RFS_FF) ? EXT_ID_FORMAT : STD_ID_FORMAT;
+			f->msg.type = (rfs & CAN_RFS_RTR) ? REMOTE_FRAME : DATA_FRAME;
+			f->msg.len = (uint8_t)((rfs >> 16) & 0x0F);
+			f->msg.id = CANx->RID;
+			data = CANx->RDA;
+			f->msg.dataA[0] = data; f->msg.dataA[1] = data >> 8;
+			f->msg.dataA[2] = data >> 16; f->msg.dataA[3] = data >> 24;
+			data = CANx->RDB;
+			f->msg.dataB[0] = data; f->msg.dataB[1] = data >> 8;
+			f->msg.dataB[2] = data >> 16; f->msg.dataB[3] = data >> 24;
+			can_rx_head[ch] = head + 1;
+			can_stats[ch].rxFrames++;
+		}
+		else
+		{
+			can_stats[ch].rxDropped++;
+		}
+		CANx->CMR = CAN_CMR_RRB;
+	}
+
+	if (icr & CAN_ICR_DOI)
+	{
+		can_stats[ch].rxOverruns++;
+		CANx->CMR = CAN_CMR_CDO;
+	}
+	if (icr & CAN_ICR_BEI)
+	{
+		can_stats[ch].busErrors++;
+	}
+	if (icr & (CAN_ICR_EPI | CAN_ICR_EI))
+	{
+		can_stats[ch].errorPassive++;
+	}
+	if (icr & CAN_ICR_ALI)
+	{
+		can_stats[ch].arbLost++;
+	}
+	if (icr & CAN_ICR_TI1)
+	{
+		can_stats[ch].txFrames += (CANx->SR & CAN_SR_TCS1) ? 1 : 0;
+	}
+	if (icr & CAN_ICR_TI2)
+	{
+		can_stats[ch].txFrames += (CANx->SR & CAN_SR_TCS2) ? 1 : 0;
+	}
+	if (icr & CAN_ICR_TI3)
+	{
+		can_stats[ch].txFrames += (CANx->SR & CAN_SR_TCS3) ? 1 : 0;
+	}
+	if (icr & (CAN_ICR_TI1 | CAN_ICR_TI2 | CAN_ICR_TI3))
+	{
+		can_tx_kick(CANx, ch);
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief 		Order of two AF entries in the table: section first, then
+ * 				controller and identifier
+ * @param[in] 	a, b: entries to compare
+ * @return 		<0, 0 or >0 as a sorts before, with or after b
+ ***********************************************************************/
+static int32_t can_af_cmp (const CAN_AF_ENTRY_Type *a, const CAN_AF_ENTRY_Type *b)
+{
+	uint32_t ka, kb;
+
+	if (a->type != b->type)
+	{
+		return (a->type < b->type) ? -1 : 1;
+	}
+	ka = ((uint32_t)a->controller << 29) | a->lowerID;
+	kb = ((uint32_t)b->controller << 29) | b->lowerID;
+	if (ka == kb)
+	{
+		ka = a->upperID;
+		kb = b->upperID;
+	}
+	return (ka < kb) ? -1 : ((ka > kb) ? 1 : 0);
+}
+
+
+/*********************************************************************//**
+ * @brief 		Shell sort of an AF entry list in place
+ * @param[in] 	list: entries
+ * @param[in] 	count: number of entries
+ * @return 		None
+ ***********************************************************************/
+static void can_af_sort (CAN_AF_ENTRY_Type *list, uint16_t count)
+{
+	CAN_AF_ENTRY_Type tmp;
+	uint16_t gap = 1, i, j;
+
+	while (gap < count / 3)
+	{
+		gap = gap * 3 + 1;					// 1, 4, 13, 40, 121, 364
+	}
+	for (; gap > 0; gap /= 3)
+	{
+		for (i = gap; i < count; i++)
+		{
+			tmp = list[i];
+			for (j = i; (j >= gap) && (can_af_cmp(&list[j - gap], &tmp) > 0); j -= gap)
+			{
+				list[j] = list[j - gap];
+			}
+			list[j] = tmp;
+		}
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief 		Binary search of a standard ID in a section of 16 bit
+ * 				entries, the way the acceptance filter walks it
+ * @param[in] 	first: index of the first halfword (2 per AF RAM word)
+ * @param[in] 	num: number of halfwords
+ * @param[in] 	key: (controller << 13) | identifier
+ * @param[out] 	index: halfword index of the match, NULL if not needed
+ * @return 		The matching entry, or 0xFFFF if none
+ ***********************************************************************/
+static uint16_t can_af_find16 (uint32_t first, uint32_t num, uint16_t key, uint32_t *index)
+{
+	uint32_t lo = first, hi = first + num, mid;
+	uint16_t entry;
+
+	while (lo < hi)
+	{
+		mid = (lo + hi) >> 1;
+		entry = (uint16_t)(LPC_CANAF_RAM->mask[mid >> 1] >> ((mid & 1) ? 0 : 16));
+		if ((entry & 0xE7FF) == key)
+		{
+			if (index != NULL)
+			{
+				*index = mid;
+			}
+			return entry;
+		}
+		if ((entry & 0xE7FF) < key)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+	return 0xFFFF;
+}
+
+
+/*********************************************************************//**
+ * @brief 		Copy an updated FullCAN object and publish it
+ * @param[in] 	obj: object number, 0 .. FullCAN entries - 1
+ * @param[in] 	stamp: time stamp for the frame
+ * @return 		TRUE if a complete update was copied
+ *
+ * Note: SEM is 01 while the acceptance filter writes an object and 11
+ * once done. Clearing it claims the object (and its FCANIC bit), if it
+ * is still 00 after the copy the filter did not touch it meanwhile.
+ ***********************************************************************/
+static Bool can_fc_copy (uint32_t obj, uint32_t stamp)
+{
+	__IO uint32_t *p = &LPC_CANAF_RAM->mask[(LPC_CANAF->ENDofTable >> 2) + (obj * 3)];
+	CAN_RX_FRAME_Type *f;
+	uint32_t w0, a, b, tries;
+
+	for (tries = 0; tries < 3; tries++)
+	{
+		w0 = p[0];
+		if ((w0 & 0x03000000) != 0x03000000)
+		{
+			return FALSE;						// being written, interrupts again
+		}
+		p[0] = w0 & ~0x03000000;
+		a = p[1];
+		b = p[2];
+		if ((p[0] & 0x03000000) != 0)
+		{
+			continue;
+		}
+
+		f = &can_fc_sig[obj].slot[(can_fc_sig[obj].seq + 1) & 1];
+		f->stamp = stamp;
+		f->msg.id = w0 & 0x7FF;
+		f->msg.len = (uint8_t)((w0 >> 16) & 0x0F);
+		f->msg.format = STD_ID_FORMAT;
+		f->msg.type = (w0 & (1 << 30)) ? REMOTE_FRAME : DATA_FRAME;
+		f->msg.dataA[0] = a; f->msg.dataA[1] = a >> 8;
+		f->msg.dataA[2] = a >> 16; f->msg.dataA[3] = a >> 24;
+		f->msg.dataB[0] = b; f->msg.dataB[1] = b >> 8;
+		f->msg.dataB[2] = b >> 16; f->msg.dataB[3] = b >> 24;
+		__DMB();								// slot complete before it is published
+		can_fc_sig[obj].seq++;
+		return TRUE;
+	}
+	return FALSE;
+}
 /* End of Private Functions ----------------------------------------------------*/
 
 
+/*----------------- INTERRUPT SERVICE ROUTINES --------------------------*/
+/*********************************************************************//**
+ * @brief		CAN_IRQ Handler, shared by CAN1 and CAN2, services the
+ * 				mailboxes of the controllers started with CAN_MailboxInit()
+ * param[in]	none
+ * @return 		none
+ **********************************************************************/
+void CAN_IRQHandler()
+{
+	if (can_active[0])
+	{
+		can_service(LPC_CAN1, 0);
+	}
+	if (can_active[1])
+	{
+		can_service(LPC_CAN2, 1);
+	}
+	if (can_fc_active)
+	{
+		CAN_FullCANService();
+	}
+}
+
+
 /* Public Functions ----------------------------------------------------------- */
 /** @addtogroup CAN_Public_Functions
  * @{
@@ -147,12 +459,8 @@ void CAN_Config (void)
 	//Enable self-test mode
 	CAN_ModeConfig(LPC_CAN1, CAN_SELFTEST_MODE, ENABLE);
 
-	//Enable Interrupt
-	CAN_IRQCmd(LPC_CAN1, CANINT_RIE, ENABLE);
-	CAN_IRQCmd(LPC_CAN1, CANINT_TIE1, ENABLE);
-
-	//Enable CAN Interrupt
-	NVIC_EnableIRQ(CAN_IRQn);
+	//Receive and transmit through the mailboxes
+	CAN_MailboxInit(LPC_CAN1);
 	CAN_SetAFMode(LPC_CANAF,CAN_AccBP);
 	CAN_InitMessage();
 }
@@ -586,6 +894,242 @@ CAN_ERROR CAN_SetupAFLUT(LPC_CANAF_TypeDef* CANAFx, AF_SectionDef* AFSection)
 	}
 	return CAN_OK;
 }
+
+/********************************************************************//**
+ * @brief		Build the whole Acceptance Filter Look-Up Table from an
+ * 				unsorted list of entries
+ * @param[in]	CANAFx	pointer to LPC_CANAF_TypeDef
+ * 				Should be: LPC_CANAF
+ * @param[in]	list	entries of any type in any order, sorted in place
+ * @param[in]	count	number of entries
+ * @return 		CAN Error	could be:
+ * 				- CAN_OBJECTS_FULL_ERROR: the table and FullCAN objects
+ * 				  do not fit in the AF RAM
+ * 				- CAN_AF_ENTRY_ERROR: invalid controller, ID or group
+ * 				- CAN_OK: table loaded
+ *
+ * Note: the entries are sorted, duplicates dropped and every section is
+ * packed in one pass, so loading N IDs costs N log N compares and one
+ * AF RAM write per word instead of the O(N^2) shifting of the
+ * CAN_LoadXXXEntry() functions. The filter is off and interrupts are
+ * masked only while the finished image is written, the previous table
+ * stays active until then.
+ *********************************************************************/
+CAN_ERROR CAN_BuildAFLUT(LPC_CANAF_TypeDef* CANAFx, CAN_AF_ENTRY_Type* list, uint16_t count)
+{
+	uint16_t num[5] = {0, 0, 0, 0, 0};
+	uint16_t i, n, half, total;
+	uint32_t entry, word = 0, primask;
+	CAN_AF_ENTRY_Type *e;
+
+	CHECK_PARAM(PARAM_CANAFx(CANAFx));
+
+	for (i = 0; i < count; i++)
+	{
+		e = &list[i];
+		if ((e->type > GROUP_EXTEND_ENTRY) || (e->controller > CAN2_CTRL) || (e->disable > MSG_DISABLE))
+		{
+			return CAN_AF_ENTRY_ERROR;
+		}
+		if (e->type <= GROUP_STANDARD_ENTRY)
+		{
+			if ((e->lowerID > 0x7FF) || ((e->type == GROUP_STANDARD_ENTRY) && \
+				((e->upperID > 0x7FF) || (e->upperID < e->lowerID))))
+			{
+				return CAN_AF_ENTRY_ERROR;
+			}
+		}
+		else if ((e->lowerID > 0x1FFFFFFF) || ((e->type == GROUP_EXTEND_ENTRY) && \
+				((e->upperID > 0x1FFFFFFF) || (e->upperID < e->lowerID))))
+		{
+			return CAN_AF_ENTRY_ERROR;
+		}
+		if (e->type != GROUP_STANDARD_ENTRY && e->type != GROUP_EXTEND_ENTRY)
+		{
+			e->upperID = 0;						// not part of the sort key
+		}
+	}
+
+	can_af_sort(list, count);
+
+	// Drop duplicates and count the sections
+	for (i = 0, n = 0; i < count; i++)
+	{
+		if ((n != 0) && (can_af_cmp(&list[n - 1], &list[i]) == 0))
+		{
+			list[n - 1].disable &= list[i].disable;	// enabled if any copy is
+			continue;
+		}
+		list[n++] = list[i];
+		num[list[i].type]++;
+	}
+
+	// Two standard IDs per word, a FullCAN ID also owns a 3 word object
+	total = ((num[FULLCAN_ENTRY] + 1) >> 1) + ((num[EXPLICIT_STANDARD_ENTRY] + 1) >> 1) + \
+			num[GROUP_STANDARD_ENTRY] + num[EXPLICIT_EXTEND_ENTRY] + (num[GROUP_EXTEND_ENTRY] << 1);
+	if ((num[FULLCAN_ENTRY] > MAX_HW_FULLCAN_OBJ) || \
+		(total + num[FULLCAN_ENTRY] * 3 > CAN_AF_RAM_WORDS))
+	{
+		return CAN_OBJECTS_FULL_ERROR;
+	}
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	CANAFx->AFMR = 0x01;
+
+	total = 0;
+	half = 0;
+	for (i = 0; i < n; i++)
+	{
+		e = &list[i];
+		switch (e->type)
+		{
+		case FULLCAN_ENTRY:
+		case EXPLICIT_STANDARD_ENTRY:
+			entry = (e->controller << 13) | (e->disable << 12) | e->lowerID;
+			if (e->type == FULLCAN_ENTRY)
+			{
+				entry |= (1 << 11);
+			}
+			if (half == 0)
+			{
+				word = entry << 16;
+				half = 1;
+			}
+			else
+			{
+				LPC_CANAF_RAM->mask[total++] = word | entry;
+				half = 0;
+			}
+			// An odd section ends with a disabled, highest ID entry
+			if ((half != 0) && ((i + 1 == n) || (list[i + 1].type != e->type)))
+			{
+				LPC_CANAF_RAM->mask[total++] = word | 0x0000FFFF;
+				half = 0;
+			}
+			break;
+
+		case GROUP_STANDARD_ENTRY:
+			entry = (e->controller << 13) | (e->disable << 12);
+			LPC_CANAF_RAM->mask[total++] = ((entry | e->lowerID) << 16) | (entry | e->upperID);
+			break;
+
+		case EXPLICIT_EXTEND_ENTRY:
+			LPC_CANAF_RAM->mask[total++] = (e->controller << 29) | e->lowerID;
+			break;
+
+		default:
+			LPC_CANAF_RAM->mask[total++] = (e->controller << 29) | e->lowerID;
+			LPC_CANAF_RAM->mask[total++] = (e->controller << 29) | e->upperID;
+			break;
+		}
+	}
+
+	// FullCAN message objects follow the table
+	for (i = 0; i < num[FULLCAN_ENTRY] * 3; i++)
+	{
+		LPC_CANAF_RAM->mask[total + i] = 0;
+	}
+
+	CANAF_FullCAN_cnt = num[FULLCAN_ENTRY];
+	CANAF_std_cnt = num[EXPLICIT_STANDARD_ENTRY];
+	CANAF_gstd_cnt = num[GROUP_STANDARD_ENTRY];
+	CANAF_ext_cnt = num[EXPLICIT_EXTEND_ENTRY];
+	CANAF_gext_cnt = num[GROUP_EXTEND_ENTRY];
+
+	CANAFx->SFF_sa = ((CANAF_FullCAN_cnt + 1)>>1)<<2;
+	CANAFx->SFF_GRP_sa = CANAFx->SFF_sa + (((CANAF_std_cnt+1)>>1)<< 2);
+	CANAFx->EFF_sa = CANAFx->SFF_GRP_sa + (CANAF_gstd_cnt << 2);
+	CANAFx->EFF_GRP_sa = CANAFx->EFF_sa + (CANAF_ext_cnt << 2);
+	CANAFx->ENDofTable = CANAFx->EFF_GRP_sa + (CANAF_gext_cnt << 3);
+
+	FULLCAN_ENABLE = (CANAF_FullCAN_cnt != 0) ? ENABLE : DISABLE;
+	CANAFx->AFMR = (FULLCAN_ENABLE == ENABLE) ? 0x04 : 0x00;
+	__set_PRIMASK(primask);
+
+	return CAN_OK;
+}
+
+/********************************************************************//**
+ * @brief		Model of the acceptance filter: search the loaded table
+ * 				for an identifier as the hardware does
+ * @param[in]	controller	CAN1_CTRL or CAN2_CTRL
+ * @param[in]	id			Received identifier
+ * @param[in]	format		STD_ID_FORMAT or EXT_ID_FORMAT
+ * @return 		TRUE if a frame with this ID would be accepted
+ *
+ * Note: explicit sections are binary searched, so an entry that is out
+ * of order is missed just like by the filter. Use it to check a table
+ * built with CAN_BuildAFLUT() or the CAN_LoadXXXEntry() functions.
+ *********************************************************************/
+Bool CAN_AFLookup(uint8_t controller, uint32_t id, CAN_ID_FORMAT_Type format)
+{
+	uint32_t i, lo, hi, mid, entry;
+	uint16_t key;
+
+	if (LPC_CANAF->AFMR & 0x02)
+	{
+		return TRUE;							// bypass accepts everything
+	}
+	if (LPC_CANAF->AFMR & 0x01)
+	{
+		return FALSE;
+	}
+
+	if (format == STD_ID_FORMAT)
+	{
+		key = (controller << 13) | (id & 0x7FF);
+		entry = can_af_find16(0, LPC_CANAF->SFF_sa >> 1, key, NULL);
+		if ((entry == 0xFFFF) || (entry & (1 << 12)))
+		{
+			entry = can_af_find16(LPC_CANAF->SFF_sa >> 1, \
+					(LPC_CANAF->SFF_GRP_sa - LPC_CANAF->SFF_sa) >> 1, key, NULL);
+		}
+		if ((entry != 0xFFFF) && !(entry & (1 << 12)))
+		{
+			return TRUE;
+		}
+		for (i = LPC_CANAF->SFF_GRP_sa >> 2; i < (LPC_CANAF->EFF_sa >> 2); i++)
+		{
+			entry = LPC_CANAF_RAM->mask[i];
+			if ((((entry >> 16) & 0xE7FF) <= key) && ((entry & 0xE7FF) >= key) && \
+				!(entry & ((1 << 28) | (1 << 12))))
+			{
+				return TRUE;
+			}
+		}
+		return FALSE;
+	}
+
+	entry = (controller << 29) | (id & 0x1FFFFFFF);
+	lo = LPC_CANAF->EFF_sa >> 2;
+	hi = LPC_CANAF->EFF_GRP_sa >> 2;
+	while (lo < hi)
+	{
+		mid = (lo + hi) >> 1;
+		if (LPC_CANAF_RAM->mask[mid] == entry)
+		{
+			return TRUE;
+		}
+		if (LPC_CANAF_RAM->mask[mid] < entry)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+	for (i = LPC_CANAF->EFF_GRP_sa >> 2; i < (LPC_CANAF->ENDofTable >> 2); i += 2)
+	{
+		if ((LPC_CANAF_RAM->mask[i] <= entry) && (LPC_CANAF_RAM->mask[i + 1] >= entry))
+		{
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
 /********************************************************************//**
  * @brief		Add Explicit ID into AF Look-Up Table dynamically.
  * @param[in]	CANx pointer to LPC_CAN_TypeDef, should be:
@@ -740,12 +1284,15 @@ CAN_ERROR CAN_LoadExplicitEntry(LPC_CAN_TypeDef* CANx, uint32_t id, CAN_ID_FORMA
 				}
 			}
 		}
+		//update address values, only an even count opened a new word
+		if ((CANAF_std_cnt & 0x0001) == 0)
+		{
+			LPC_CANAF->SFF_GRP_sa +=0x04 ;
+			LPC_CANAF->EFF_sa     +=0x04 ;
+			LPC_CANAF->EFF_GRP_sa +=0x04;
+			LPC_CANAF->ENDofTable +=0x04;
+		}
 		CANAF_std_cnt++;
-		//update address values
-		LPC_CANAF->SFF_GRP_sa +=0x04 ;
-		LPC_CANAF->EFF_sa     +=0x04 ;
-		LPC_CANAF->EFF_GRP_sa +=0x04;
-		LPC_CANAF->ENDofTable +=0x04;
  	}
 
 /*********** Add Explicit Extended Identifier Frame Format entry *********/
@@ -972,13 +1519,16 @@ CAN_ERROR CAN_LoadFullCANEntry (LPC_CAN_TypeDef* CANx, uint16_t id)
 		buf2 = tmp2;
 		cnt1+=3;
 	}
+	//update address values, only an even count opened a new word
+	if ((CANAF_FullCAN_cnt & 0x0001) == 0)
+	{
+		LPC_CANAF->SFF_sa 	  +=0x04;
+		LPC_CANAF->SFF_GRP_sa +=0x04 ;
+		LPC_CANAF->EFF_sa     +=0x04 ;
+		LPC_CANAF->EFF_GRP_sa +=0x04;
+		LPC_CANAF->ENDofTable +=0x04;
+	}
 	CANAF_FullCAN_cnt++;
-	//update address values
-	LPC_CANAF->SFF_sa 	  +=0x04;
-	LPC_CANAF->SFF_GRP_sa +=0x04 ;
-	LPC_CANAF->EFF_sa     +=0x04 ;
-	LPC_CANAF->EFF_GRP_sa +=0x04;
-	LPC_CANAF->ENDofTable +=0x04;
 
 	LPC_CANAF->AFMR = 0x04;
  	return CAN_OK;
@@ -1651,6 +2201,257 @@ Status CAN_ReceiveMsg (LPC_CAN_TypeDef *CANx, CAN_MSG_Type *CAN_Msg)
 	return SUCCESS;
 }
 
+/********************************************************************//**
+ * @brief		Start the interrupt driven mailboxes of a controller
+ * @param[in]	CANx pointer to LPC_CAN_TypeDef, should be:
+ * 				- LPC_CAN1: CAN1 peripheral
+ * 				- LPC_CAN2: CAN2 peripheral
+ * @return 		None
+ *
+ * Note: call after CAN_Init(). The ISR moves every received frame into
+ * a ring of CAN_RX_RING frames read with CAN_GetMsg(), and keeps the
+ * three TX buffers loaded from the queue filled by CAN_QueueMsg().
+ *********************************************************************/
+void CAN_MailboxInit(LPC_CAN_TypeDef *CANx)
+{
+	CAN_STATS_Type zero = {0};
+	uint8_t ch = (CANx == LPC_CAN1) ? 0 : 1;
+	uint32_t primask;
+
+	CHECK_PARAM(PARAM_CANx(CANx));
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	can_rx_head[ch] = 0;
+	can_rx_tail[ch] = 0;
+	can_tx_num[ch] = 0;
+	can_stats[ch] = zero;
+	can_active[ch] = 1;
+	__set_PRIMASK(primask);
+
+	CAN_ModeConfig(CANx, CAN_TXPRIORITY_MODE, ENABLE);
+	CANx->IER |= CAN_IER_RIE | CAN_IER_TIE1 | CAN_IER_TIE2 | CAN_IER_TIE3 | \
+				CAN_IER_DOIE | CAN_IER_BEIE | CAN_IER_EPIE | CAN_IER_EIE | CAN_IER_ALIE;
+	NVIC_EnableIRQ(CAN_IRQn);
+}
+
+/********************************************************************//**
+ * @brief		Queue a message for transmission
+ * @param[in]	CANx pointer to LPC_CAN_TypeDef, should be:
+ * 				- LPC_CAN1: CAN1 peripheral
+ * 				- LPC_CAN2: CAN2 peripheral
+ * @param[in]	CAN_Msg point to the CAN_MSG_Type Struct, copied
+ * @param[in]	prio	Priority, 0 is sent first, equal priorities in order
+ * @return 		Status:
+ * 				- SUCCESS: message queued or loaded in a TX buffer
+ * 				- ERROR: queue full, the message is counted as dropped
+ *
+ * Note: a message only overtakes the queued ones, not those already
+ * loaded in one of the three TX buffers. Messages of equal priority
+ * reach the bus in the order they were queued.
+ *********************************************************************/
+Status CAN_QueueMsg(LPC_CAN_TypeDef *CANx, CAN_MSG_Type *CAN_Msg, uint8_t prio)
+{
+	uint8_t ch = (CANx == LPC_CAN1) ? 0 : 1;
+	uint32_t primask;
+	uint8_t i;
+
+	CHECK_PARAM(PARAM_CANx(CANx));
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if (can_tx_num[ch] == CAN_TX_QUEUE)
+	{
+		can_stats[ch].txDropped++;
+		__set_PRIMASK(primask);
+		return ERROR;
+	}
+	for (i = can_tx_num[ch]; (i > 0) && (can_tx_prio[ch][i - 1] > prio); i--)
+	{
+		can_tx[ch][i] = can_tx[ch][i - 1];
+		can_tx_prio[ch][i] = can_tx_prio[ch][i - 1];
+	}
+	can_tx[ch][i] = *CAN_Msg;
+	can_tx_prio[ch][i] = prio;
+	can_tx_num[ch]++;
+	can_tx_kick(CANx, ch);
+	__set_PRIMASK(primask);
+
+	return SUCCESS;
+}
+
+/********************************************************************//**
+ * @brief		Take the oldest received frame
+ * @param[in]	CANx pointer to LPC_CAN_TypeDef, should be:
+ * 				- LPC_CAN1: CAN1 peripheral
+ * 				- LPC_CAN2: CAN2 peripheral
+ * @param[out]	frame	Frame and its receive time
+ * @return 		Status:
+ * 				- SUCCESS: frame copied
+ * 				- ERROR: ring empty
+ *
+ * Note: single reader. Only the ISR moves the head and only this
+ * function the tail, so no lock is taken.
+ *********************************************************************/
+Status CAN_GetMsg(LPC_CAN_TypeDef *CANx, CAN_RX_FRAME_Type *frame)
+{
+	uint8_t ch = (CANx == LPC_CAN1) ? 0 : 1;
+	uint32_t tail = can_rx_tail[ch];
+
+	CHECK_PARAM(PARAM_CANx(CANx));
+
+	if (tail == can_rx_head[ch])
+	{
+		return ERROR;
+	}
+	*frame = can_rx[ch][tail & (CAN_RX_RING - 1)];
+	can_rx_tail[ch] = tail + 1;
+	return SUCCESS;
+}
+
+/********************************************************************//**
+ * @brief		Number of frames waiting in the RX ring
+ * @param[in]	CANx pointer to LPC_CAN_TypeDef, should be:
+ * 				- LPC_CAN1: CAN1 peripheral
+ * 				- LPC_CAN2: CAN2 peripheral
+ * @return 		Frames CAN_GetMsg() returns without waiting
+ *********************************************************************/
+uint32_t CAN_GetRxCount(LPC_CAN_TypeDef *CANx)
+{
+	uint8_t ch = (CANx == LPC_CAN1) ? 0 : 1;
+
+	return can_rx_head[ch] - can_rx_tail[ch];
+}
+
+/********************************************************************//**
+ * @brief		Copy the mailbox counters of a controller
+ * @param[in]	CANx pointer to LPC_CAN_TypeDef, should be:
+ * 				- LPC_CAN1: CAN1 peripheral
+ * 				- LPC_CAN2: CAN2 peripheral
+ * @param[out]	stats	Counters since CAN_MailboxInit()
+ * @return 		None
+ *********************************************************************/
+void CAN_GetStats(LPC_CAN_TypeDef *CANx, CAN_STATS_Type *stats)
+{
+	uint8_t ch = (CANx == LPC_CAN1) ? 0 : 1;
+	uint32_t primask;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	*stats = can_stats[ch];
+	__set_PRIMASK(primask);
+}
+
+/********************************************************************//**
+ * @brief		Publish FullCAN objects from the CAN interrupt
+ * @param[in]	None
+ * @return 		None
+ *
+ * Note: call after the table is loaded with FullCAN entries. Every
+ * object then keeps its latest frame in a signal read with
+ * CAN_FullCANRead(), earlier updates that were not read are replaced.
+ *********************************************************************/
+void CAN_FullCANStart(void)
+{
+	uint32_t i, primask;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	for (i = 0; i < MAX_HW_FULLCAN_OBJ; i++)
+	{
+		can_fc_sig[i].seq = 0;
+	}
+	can_fc_active = 1;
+	__set_PRIMASK(primask);
+
+	LPC_CANAF->FCANIE = 0x01;
+	NVIC_EnableIRQ(CAN_IRQn);
+}
+
+/********************************************************************//**
+ * @brief		Harvest every updated FullCAN object in one pass
+ * @param[in]	None
+ * @return 		Number of objects published
+ *
+ * Note: runs from CAN_IRQHandler() once started, or can be polled. The
+ * pending bits of FCANIC0/FCANIC1 are walked with CLZ, so the cost
+ * depends on the objects updated, not on the objects defined.
+ *********************************************************************/
+uint32_t CAN_FullCANService(void)
+{
+	uint32_t pend, bit, w, n = 0, stamp;
+
+	stamp = can_stamp();
+	for (w = 0; w < 2; w++)
+	{
+		pend = (w == 0) ? LPC_CANAF->FCANIC0 : LPC_CANAF->FCANIC1;
+		while (pend != 0)
+		{
+			bit = 31 - __CLZ(pend);
+			pend &= ~(1UL << bit);
+			if (can_fc_copy((w * 32) + bit, stamp))
+			{
+				n++;
+			}
+		}
+	}
+	return n;
+}
+
+/********************************************************************//**
+ * @brief		Object number of a FullCAN identifier
+ * @param[in]	controller	CAN1_CTRL or CAN2_CTRL
+ * @param[in]	id			11 bit identifier
+ * @return 		Object number for CAN_FullCANRead(), or -1 if the ID
+ * 				is not in the FullCAN section
+ *
+ * Note: objects follow the sorted FullCAN entries, look the number up
+ * once after the table is loaded.
+ *********************************************************************/
+int32_t CAN_FullCANFindObj(uint8_t controller, uint16_t id)
+{
+	uint32_t index;
+
+	if (can_af_find16(0, LPC_CANAF->SFF_sa >> 1, (controller << 13) | (id & 0x7FF), &index) == 0xFFFF)
+	{
+		return -1;
+	}
+	return (int32_t)index;
+}
+
+/********************************************************************//**
+ * @brief		Latest frame of a FullCAN object
+ * @param[in]	obj		Object number, see CAN_FullCANFindObj()
+ * @param[out]	frame	Frame and its receive time
+ * @return 		Number of updates published so far, 0 if none (frame
+ * 				is then left untouched)
+ *
+ * Note: lock free. If the ISR published twice during the copy, the slot
+ * being copied may have been reused, so the copy is taken again.
+ *********************************************************************/
+uint32_t CAN_FullCANRead(uint16_t obj, CAN_RX_FRAME_Type *frame)
+{
+	uint32_t seq;
+
+	if (obj >= MAX_HW_FULLCAN_OBJ)
+	{
+		return 0;
+	}
+	do
+	{
+		seq = can_fc_sig[obj].seq;
+		if (seq == 0)
+		{
+			return 0;
+		}
+		__DMB();
+		*frame = can_fc_sig[obj].slot[seq & 1];
+		__DMB();
+	} while ((can_fc_sig[obj].seq - seq) >= 2);
+
+	return seq;
+}
+
 /********************************************************************//**
  * @brief		Receive FullCAN Object
  * @param[in]	CANAFx: CAN Acceptance Filter register, should be: LPC_CANAF
@@ -19,6 +19,139 @@
  * otherwise the default FW library configuration file must be included instead
  */
 
+/* Private Variables ---------------------------------------------------------- */
+/** @defgroup DAC_Private_Variables DAC Private Variables
+ * @{
+ */
+
+/** Quarter sine period, 511 * sin(i * pi / 128) */
+static const uint16_t dac_quarter_sine[65] = {
+	  0,  13,  25,  38,  50,  63,  75,  87, 100, 112, 124, 136, 148,
+	160, 172, 184, 196, 207, 218, 230, 241, 252, 263, 273, 284, 294,
+	304, 314, 324, 334, 343, 352, 361, 370, 379, 387, 395, 403, 410,
+	418, 425, 432, 438, 445, 451, 456, 462, 467, 472, 477, 481, 485,
+	489, 492, 496, 499, 501, 503, 505, 507, 509, 510, 510, 511, 511,
+};
+
+/** Sine period as DACR words, built on first use */
+static uint32_t dac_sine[DAC_SINE_POINTS];
+static int32_t dac_sine_amp = -1;				// amplitude dac_sine holds
+
+static GPDMA_LLI_Type dac_lli[DAC_WAVE_MAX_LLI];
+static int32_t dac_dma_ch = -1;
+static __IO uint32_t dac_mode = DAC_WAVE_IDLE;
+
+/** Stream: ring of 10 bit samples feeding two DMA blocks */
+static uint32_t dac_blk[2][DAC_STREAM_BLOCK];
+static uint8_t dac_blk_next;					// block the DMA finishes next
+static uint16_t dac_ring[DAC_STREAM_RING];
+static __IO uint32_t dac_head, dac_tail;
+static uint32_t dac_last;						// DACR word repeated on underrun
+static uint32_t dac_underruns;
+
+/**
+ * @}
+ */
+
+
+/* Private Functions ---------------------------------------------------------- */
+/*********************************************************************//**
+ * @brief		Fill a stream block from the ring
+ * @param[out]	blk		DAC_STREAM_BLOCK DACR words
+ * @return 		None
+ **********************************************************************/
+static void dac_stream_fill (uint32_t *blk)
+{
+	uint32_t i, tail = dac_tail;
+
+	for (i = 0; i < DAC_STREAM_BLOCK; i++)
+	{
+		if (tail != dac_head)
+		{
+			dac_last = DAC_VALUE(dac_ring[tail & (DAC_STREAM_RING - 1)]);
+			tail++;
+		}
+		else
+		{
+			dac_underruns++;					// hold the last level
+		}
+		blk[i] = dac_last;
+	}
+	dac_tail = tail;
+}
+
+
+/*********************************************************************//**
+ * @brief		Stream block completion (called from DMA_IRQHandler), the
+ * 				DMA already plays the other block, refill this one
+ * @param[in]	ChannelNum	GPDMA channel
+ * @param[in]	Status		GPDMA_CB_DONE or GPDMA_CB_ERROR
+ * @return 		None
+ **********************************************************************/
+static void dac_stream_dma_done (uint32_t ChannelNum, uint32_t Status)
+{
+	if (Status != GPDMA_CB_DONE)
+	{
+		DAC_WaveStop();
+		return;
+	}
+	dac_stream_fill(dac_blk[dac_blk_next]);
+	dac_blk_next ^= 1;
+}
+
+
+/*********************************************************************//**
+ * @brief		Pace the DAC from its timeout counter and start GPDMA
+ * 				on the chain in dac_lli
+ * @param[in]	rate		Samples per second
+ * @param[in]	Callback	Block completion handler, or NULL
+ * @return 		SUCCESS, or ERROR if the rate does not fit the 16 bit
+ * 				counter or no DMA channel is free
+ **********************************************************************/
+static Status dac_dma_start (uint32_t rate, GPDMA_Callback_Type Callback)
+{
+	GPDMA_Channel_CFG_Type cfg;
+	DAC_CONVERTER_CFG_Type dacCfg;
+	uint32_t cnt;
+
+	if (rate == 0)
+	{
+		return ERROR;
+	}
+	cnt = CLKPWR_GetPCLK(CLKPWR_PCLKSEL_DAC) / rate;
+	if ((cnt == 0) || (cnt > 0xFFFF))
+	{
+		return ERROR;
+	}
+
+	if (dac_dma_ch < 0)
+	{
+		dac_dma_ch = GPDMA_ChannelAlloc(GPDMA_PRIO_HIGH);
+		if (dac_dma_ch < 0)
+		{
+			return ERROR;
+		}
+	}
+	GPDMA_SetCallback(dac_dma_ch, Callback);
+
+	cfg.ChannelNum = dac_dma_ch;
+	cfg.TransferType = GPDMA_TRANSFERTYPE_M2P;
+	cfg.SrcConn = 0;
+	cfg.DstConn = GPDMA_CONN_DAC;
+	GPDMA_SetupLLI(&cfg, &dac_lli[0]);
+
+	// DACR is loaded from its buffer on each timeout, then DMA refills it
+	DAC_SetDMATimeOut(LPC_DAC, cnt);
+	dacCfg.DBLBUF_ENA = 1;
+	dacCfg.CNT_ENA = 1;
+	dacCfg.DMA_ENA = 1;
+	DAC_ConfigDAConverterControl(LPC_DAC, &dacCfg);
+
+	GPDMA_ChannelCmd(dac_dma_ch, ENABLE);
+	return SUCCESS;
+}
+/* End of Private Functions --------------------------------------------------- */
+
 
 /* Public Functions ----------------------------------------------------------- */
 /** @addtogroup DAC_Public_Functions
@@ -137,6 +270,191 @@ void DAC_SetDMATimeOut(LPC_DAC_TypeDef *DACx, uint32_t time_out)
 	DACx->DACCNTVAL = DAC_CCNT_VALUE(time_out);
 }
 
+/*********************************************************************//**
+ * @brief		Repeat a table of samples without CPU load
+ * @param[in]	table	DACR words, build them with DAC_VALUE(), must stay
+ * 						valid while playing
+ * @param[in]	count	Samples in the table
+ * @param[in]	rate	Samples per second
+ * @return 		SUCCESS, or ERROR if too long, the rate is out of range
+ * 				or no DMA channel is free
+ *
+ * Note: the table is a circular GPDMA chain and the DAC timeout counter
+ * paces each sample, no interrupt is taken while it plays.
+ **********************************************************************/
+Status DAC_WavePlay (const uint32_t *table, uint32_t count, uint32_t rate)
+{
+	uint32_t ctrl, num;
+
+	DAC_WaveStop();
+
+	ctrl = GPDMA_MakeControl(GPDMA_TRANSFERTYPE_M2P, 0, GPDMA_CONN_DAC, 0);
+	num = GPDMA_BuildLLI(dac_lli, DAC_WAVE_MAX_LLI, (uint32_t)table, \
+			GPDMA_GetPeriphAddr(GPDMA_CONN_DAC), count, ctrl);
+	if (num == 0)
+	{
+		return ERROR;
+	}
+	dac_lli[num - 1].NextLLI = (uint32_t)&dac_lli[0];
+	dac_lli[num - 1].Control &= ~GPDMA_DMACCxControl_I;
+
+	if (dac_dma_start(rate, NULL) != SUCCESS)
+	{
+		return ERROR;
+	}
+	dac_mode = DAC_WAVE_TABLE;
+	return SUCCESS;
+}
+
+
+/*********************************************************************//**
+ * @brief		Play a sine wave centred on mid scale
+ * @param[in]	freq		Frequency in Hz
+ * @param[in]	amplitude	Peak in DAC steps, 0..511
+ * @return 		SUCCESS or ERROR, see DAC_WavePlay()
+ *
+ * Note: the period is expanded from a quarter wave table the first time
+ * an amplitude is asked for and kept for the following calls.
+ **********************************************************************/
+Status DAC_WaveSine (uint32_t freq, uint16_t amplitude)
+{
+	uint32_t i, q;
+	int32_t v;
+
+	if (amplitude > 511)
+	{
+		amplitude = 511;
+	}
+
+	if (dac_sine_amp != amplitude)
+	{
+		DAC_WaveStop();							// the old table may be playing
+		for (i = 0; i < DAC_SINE_POINTS; i++)
+		{
+			// Quarter index 0..64 by symmetry, sign from the half period
+			q = (i % (DAC_SINE_POINTS / 2)) * 256 / DAC_SINE_POINTS;
+			if (q > 64) q = 128 - q;
+			v = ((int32_t)dac_quarter_sine[q] * amplitude) / 511;
+			if (i >= (DAC_SINE_POINTS / 2)) v = -v;
+			dac_sine[i] = DAC_VALUE((512 + v));
+		}
+		dac_sine_amp = amplitude;
+	}
+
+	return DAC_WavePlay(dac_sine, DAC_SINE_POINTS, freq * DAC_SINE_POINTS);
+}
+
+
+/*********************************************************************//**
+ * @brief		Stop table or stream playback, AOUT keeps its last level
+ * @param[in]	None
+ * @return 		None
+ **********************************************************************/
+void DAC_WaveStop (void)
+{
+	if (dac_mode == DAC_WAVE_IDLE)
+	{
+		return;
+	}
+	GPDMA_ChannelCmd(dac_dma_ch, DISABLE);
+	LPC_DAC->DACCTRL &= ~DAC_DACCTRL_MASK;
+	dac_mode = DAC_WAVE_IDLE;
+}
+
+
+/*********************************************************************//**
+ * @brief		Current mode of the waveform engine
+ * @param[in]	None
+ * @return 		DAC_WAVE_IDLE, DAC_WAVE_TABLE or DAC_WAVE_STREAM
+ **********************************************************************/
+uint32_t DAC_WaveGetMode (void)
+{
+	return dac_mode;
+}
+
+
+/*********************************************************************//**
+ * @brief		Start gapless playback of the samples queued with
+ * 				DAC_StreamWrite()
+ * @param[in]	rate	Samples per second
+ * @return 		SUCCESS or ERROR, see DAC_WavePlay()
+ *
+ * Note: two blocks alternate in a circular GPDMA chain. When one has
+ * played out the DMA interrupt refills it from the ring while the other
+ * plays, so the output never pauses. An empty ring holds the last level
+ * and counts an underrun per sample.
+ **********************************************************************/
+Status DAC_StreamStart (uint32_t rate)
+{
+	uint32_t ctrl;
+
+	DAC_WaveStop();
+
+	dac_last = DAC_VALUE(512);
+	dac_underruns = 0;
+	dac_stream_fill(dac_blk[0]);
+	dac_stream_fill(dac_blk[1]);
+	dac_blk_next = 0;
+
+	ctrl = GPDMA_MakeControl(GPDMA_TRANSFERTYPE_M2P, 0, GPDMA_CONN_DAC, 0);
+	GPDMA_BuildLLI(&dac_lli[0], 1, (uint32_t)dac_blk[0], GPDMA_GetPeriphAddr(GPDMA_CONN_DAC), \
+			DAC_STREAM_BLOCK, ctrl);
+	GPDMA_BuildLLI(&dac_lli[1], 1, (uint32_t)dac_blk[1], GPDMA_GetPeriphAddr(GPDMA_CONN_DAC), \
+			DAC_STREAM_BLOCK, ctrl);
+	dac_lli[0].NextLLI = (uint32_t)&dac_lli[1];
+	dac_lli[1].NextLLI = (uint32_t)&dac_lli[0];
+
+	if (dac_dma_start(rate, dac_stream_dma_done) != SUCCESS)
+	{
+		return ERROR;
+	}
+	dac_mode = DAC_WAVE_STREAM;
+	return SUCCESS;
+}
+
+
+/*********************************************************************//**
+ * @brief		Queue samples for the stream
+ * @param[in]	samples		10 bit values
+ * @param[in]	count		Number of samples
+ * @return 		Number of samples queued, less than count once the ring
+ * 				is full
+ **********************************************************************/
+uint32_t DAC_StreamWrite (const uint16_t *samples, uint32_t count)
+{
+	uint32_t i, head = dac_head;
+
+	for (i = 0; (i < count) && ((head - dac_tail) < DAC_STREAM_RING); i++)
+	{
+		dac_ring[head & (DAC_STREAM_RING - 1)] = samples[i];
+		head++;
+	}
+	dac_head = head;
+	return i;
+}
+
+
+/*********************************************************************//**
+ * @brief		Room left in the stream ring
+ * @param[in]	None
+ * @return 		Samples DAC_StreamWrite() accepts now
+ **********************************************************************/
+uint32_t DAC_StreamFree (void)
+{
+	return DAC_STREAM_RING - (dac_head - dac_tail);
+}
+
+
+/*********************************************************************//**
+ * @brief		Samples played while the ring was empty
+ * @param[in]	None
+ * @return 		Count since DAC_StreamStart()
+ **********************************************************************/
+uint32_t DAC_StreamGetUnderruns (void)
+{
+	return dac_underruns;
+}
+
 /**
  * @}
  */
@@ -50,54 +50,80 @@
 static unsigned short *rptr;
 static unsigned short *tptr;
 
-/*
- * NXP: Here AHBRAM1 section still not be used, so a mount of this section
- * will be used to store buffer data get from receive packet buffer of EMAC
- */
-static unsigned short *pgBuf = (unsigned short *)LPC_AHBRAM1_BASE;
-
 
 /* MII Mgmt Configuration register - Clock divider setting */
 const uint8_t EMAC_clkdiv[] = { 4, 6, 8, 10, 14, 20, 28 };
 
-/* EMAC local DMA Descriptors */
-
-/** Rx Descriptor data array */
-static RX_Desc Rx_Desc[EMAC_NUM_RX_FRAG];
-
-/** Rx Status data array - Must be 8-Byte aligned */
-#if defined ( __CC_ARM   )
-static __align(8) RX_Stat Rx_Stat[EMAC_NUM_RX_FRAG];
-#elif defined ( __ICCARM__ )
-#pragma data_alignment=8
-static RX_Stat Rx_Stat[EMAC_NUM_RX_FRAG];
-#elif defined   (  __GNUC__  )
-static __attribute__ ((aligned (8))) RX_Stat Rx_Stat[EMAC_NUM_RX_FRAG];
-#endif
-
-/** Tx Descriptor data array */
-static TX_Desc Tx_Desc[EMAC_NUM_TX_FRAG];
-/** Tx Status data array */
-static TX_Stat Tx_Stat[EMAC_NUM_TX_FRAG];
-
-/* EMAC local DMA buffers */
-/** Rx buffer data */
-static uint32_t rx_buf[EMAC_NUM_RX_FRAG][EMAC_ETH_MAX_FLEN>>2];
-/** Tx buffer data */
-static uint32_t tx_buf[EMAC_NUM_TX_FRAG][EMAC_ETH_MAX_FLEN>>2];
+/*
+ * EMAC local DMA Descriptors and packet buffers
+ * The Ethernet DMA only masters the AHB SRAM, so the whole layout is placed
+ * at the start of AHBRAM0 and runs on into AHBRAM1. Rx_Stat must be 8-Byte
+ * aligned, which holds since it follows Rx_Desc (8 bytes per entry).
+ */
+typedef struct {
+	RX_Desc  RxDesc[EMAC_NUM_RX_FRAG];
+	RX_Stat  RxStat[EMAC_NUM_RX_FRAG];
+	TX_Desc  TxDesc[EMAC_NUM_TX_FRAG];
+	TX_Stat  TxStat[EMAC_NUM_TX_FRAG];
+	uint32_t Pool[EMAC_PBUF_NUM][EMAC_ETH_MAX_FLEN>>2];
+} EMAC_RAM_Type;
+
+#define EMAC_RAM		((EMAC_RAM_Type *)EMAC_AHBRAM_BASE)
+#define Rx_Desc			(EMAC_RAM->RxDesc)
+#define Rx_Stat			(EMAC_RAM->RxStat)
+#define Tx_Desc			(EMAC_RAM->TxDesc)
+#define Tx_Stat			(EMAC_RAM->TxStat)
+
+/** Packet buffer headers, one per pool slot */
+static EMAC_PBUF_Type emac_pbuf[EMAC_PBUF_NUM];
+/** Head of the free buffer list */
+static EMAC_PBUF_Type *emac_pbuf_free;
+
+/** Buffer currently owned by each RX descriptor */
+static EMAC_PBUF_Type *rx_pbuf[EMAC_NUM_RX_FRAG];
+/** now_us() when each RX descriptor was seen filled */
+static uint32_t rx_stamp[EMAC_NUM_RX_FRAG];
+/** Next RX descriptor to stamp */
+static uint32_t rx_stamped;
+/** Frame chain to release once each TX descriptor is sent (set on the last fragment) */
+static EMAC_PBUF_Type *tx_pbuf[EMAC_NUM_TX_FRAG];
+/** Oldest TX descriptor whose buffers have not been released yet */
+static uint32_t tx_clean;
+
+/** Interrupt status harvested by ENET_IRQHandler, with the ring indices at that time */
+typedef struct {
+	uint32_t Status;			/**< Masked IntStatus bits */
+	uint16_t RxIndex;			/**< RxProduceIndex */
+	uint16_t TxIndex;			/**< TxConsumeIndex */
+} EMAC_EVENT_Type;
+
+/* Single producer (ISR) / single consumer (EMAC_Poll) event queue */
+static EMAC_EVENT_Type emac_evt[EMAC_EVT_QUEUE_SIZE];
+static __IO uint32_t emac_evt_head;
+static __IO uint32_t emac_evt_tail;
+/** Status bits that did not fit in the queue, merged until the next poll */
+static __IO uint32_t emac_evt_lost;
+
+/** Event counters, only written by ENET_IRQHandler */
+static EMAC_COUNTERS_Type emac_cnt;
+
+/** Receive callback run by EMAC_Poll() */
+static EMAC_RxCallback_Type emac_rx_cb;
 
 /**
  * @}
  */
 
 /* Private Functions ---------------------------------------------------------- */
+static void pbuf_init (void);
+static void emac_event_process (uint32_t Status, uint32_t RxIndex, uint32_t TxIndex);
 static void rx_descr_init (void);
+static void rx_stamp_frames (void);
 static void tx_descr_init (void);
 static int32_t write_PHY (uint32_t PhyReg, uint16_t Value);
 static int32_t  read_PHY (uint32_t PhyReg);
 
 static void setEmacAddr(uint8_t abStationAddr[]);
-static int32_t emac_CRCCalc(uint8_t frame_no_fcs[], int32_t frame_len);
 
 
 /*----------------- INTERRUPT SERVICE ROUTINES --------------------------*/
@@ -105,121 +131,44 @@ static int32_t emac_CRCCalc(uint8_t frame_no_fcs[], int32_t frame_len);
  * @brief		Ethernet service routine handler
  * @param[in]	none
  * @return 		none
+ *
+ * Note: Only counts the interrupt sources and queues them with the current
+ * ring indices, all processing is deferred to EMAC_Poll().
  **********************************************************************/
 void ENET_IRQHandler (void)
 {
-	EMAC_PACKETBUF_Type RxDatbuf;
-	uint32_t RxLen;
-
 	/* EMAC Ethernet Controller Interrupt function. */
-	uint32_t int_stat;
+	uint32_t int_stat, head, next;
+
 	// Get EMAC interrupt status
 	while ((int_stat = (LPC_EMAC->IntStatus & LPC_EMAC->IntEnable)) != 0) {
 		// Clear interrupt status
 		LPC_EMAC->IntClear = int_stat;
-		/* scan interrupt status source */
-
-		/* ---------- receive overrun ------------*/
-		if((int_stat & EMAC_INT_RX_OVERRUN))
-		{
-			RXOverrunCount++;
-			printf(LPC_UART0,"Rx overrun\n\r");
-		}
 
-		/*-----------  receive error -------------*/
-		/* Note:
-		 * The EMAC doesn't distinguish the frame type and frame length,
-		 * so, e.g. when the IP(0x8000) or ARP(0x0806) packets are received,
-		 * it compares the frame type with the max length and gives the
-		 * "Range" error. In fact, this bit is not an error indication,
-		 * but simply a statement by the chip regarding the status of
-		 * the received frame
-		 */
-		if ((int_stat & EMAC_INT_RX_ERR))
-		{
-			if (EMAC_CheckReceiveDataStatus(EMAC_RINFO_RANGE_ERR) == RESET){
-				RXErrorCount++;
-				printf(LPC_UART0,"Rx error: \n\r");
-			}
-		}
-
-		/* ---------- RX Finished Process Descriptors ----------*/
-		if ((int_stat & EMAC_INT_RX_FIN))
-		{
-			RxFinishedCount++;
-			printf(LPC_UART0,"Rx finish\n\r");
-		}
-
-		/* ---------- Receive Done -----------------------------*/
-		/* Note: All packets are greater than (TX_PACKET_SIZE + 4)
-		 * will be ignore!
-		 */
-		if ((int_stat & EMAC_INT_RX_DONE))
-		{
-			/* Packet received, check if packet is valid. */
-			if (EMAC_CheckReceiveIndex()){
-				if (!EMAC_CheckReceiveDataStatus(EMAC_RINFO_LAST_FLAG)){
-					goto rel;
-				}
-				// Get data size, trip out 4-bytes CRC field, note that length in (-1) style format
-				RxLen = EMAC_GetReceiveDataSize() - 3;
-				// Note that packet added 4-bytes CRC created by yourself
-				if ((RxLen > (TX_PACKET_SIZE + 4)) || (EMAC_CheckReceiveDataStatus(EMAC_RINFO_ERR_MASK))) {
-					/* Invalid frame, ignore it and free buffer */
-					goto rel;
-				}
-				ReceiveLength = RxLen;
-				// Valid Frame, just copy it
-				RxDatbuf.pbDataBuf = (uint32_t *)gRxBuf;
-				RxDatbuf.ulDataLen = RxLen;
-				EMAC_ReadPacketBuffer(&RxDatbuf);
-				PacketReceived = TRUE;
-
-		rel:
-				/* Release frame from EMAC buffer */
-				EMAC_UpdateRxConsumeIndex();
-			}
-			printf(LPC_UART0,"Rx done\n\r");
-			RxDoneCount++;
-		}
-
-		/*------------------- Transmit Underrun -----------------------*/
-		if ((int_stat & EMAC_INT_TX_UNDERRUN))
-		{
-			TXUnderrunCount++;
-			printf(LPC_UART0,"Tx under-run\n\r");
-		}
-
-		/*------------------- Transmit Error --------------------------*/
-		if ((int_stat & EMAC_INT_TX_ERR))
-		{
-			TXErrorCount++;
-			printf(LPC_UART0,"Tx error\n\r");
-		}
-
-		/* ----------------- TX Finished Process Descriptors ----------*/
-		if ((int_stat & EMAC_INT_TX_FIN))
-		{
-			TxFinishedCount++;
-			printf(LPC_UART0,"Tx finish\n\r");
-		}
-
-		/* ----------------- Transmit Done ----------------------------*/
-		if ((int_stat & EMAC_INT_TX_DONE))
-		{
-			TxDoneCount++;
-			printf(LPC_UART0,"Tx done\n\r");
-		}
-#if ENABLE_WOL
-		/* ------------------ Wakeup Event Interrupt ------------------*/
-		/* Never gone here since interrupt in this
-		 * functionality has been disable, even if in wake-up mode
-		 */
-		if ((int_stat & EMAC_INT_WAKEUP))
-		{
-			WOLCount++;
+		/* scan interrupt status source */
+		if (int_stat & EMAC_INT_RX_OVERRUN)  emac_cnt.RxOverrun++;
+		if (int_stat & EMAC_INT_RX_ERR)      emac_cnt.RxError++;
+		if (int_stat & EMAC_INT_RX_FIN)      emac_cnt.RxFinished++;
+		if (int_stat & EMAC_INT_RX_DONE)     emac_cnt.RxDone++;
+		if (int_stat & EMAC_INT_RX_DONE)     rx_stamp_frames();
+		if (int_stat & EMAC_INT_TX_UNDERRUN) emac_cnt.TxUnderrun++;
+		if (int_stat & EMAC_INT_TX_ERR)      emac_cnt.TxError++;
+		if (int_stat & EMAC_INT_TX_FIN)      emac_cnt.TxFinished++;
+		if (int_stat & EMAC_INT_TX_DONE)     emac_cnt.TxDone++;
+		if (int_stat & EMAC_INT_WAKEUP)      emac_cnt.Wakeup++;
+
+		/* Queue the event for the bottom half */
+		head = emac_evt_head;
+		next = (head + 1) & (EMAC_EVT_QUEUE_SIZE - 1);
+		if (next == emac_evt_tail) {
+			emac_cnt.QueueFull++;
+			emac_evt_lost |= int_stat;
+		} else {
+			emac_evt[head].Status  = int_stat;
+			emac_evt[head].RxIndex = LPC_EMAC->RxProduceIndex;
+			emac_evt[head].TxIndex = LPC_EMAC->TxConsumeIndex;
+			emac_evt_head = next;
 		}
-#endif
 	}
 }
 
@@ -262,7 +211,7 @@ void PacketGen(uint8_t *txptr)
 	}
 
 	// Calculate CRC
-	crcValue = crc32_bfr( txptr, TX_PACKET_SIZE );
+	crcValue = CRC32_Calc( txptr, TX_PACKET_SIZE );
 
 	// Add 4-byte CRC
 	*(txptr+TX_PACKET_SIZE) = (0xff & crcValue);
@@ -272,9 +221,68 @@ void PacketGen(uint8_t *txptr)
 }
 
 
+/*--------------------------- pbuf_init -------------------------------------*/
+/*********************************************************************//**
+ * @brief 		Puts every packet buffer of the pool on the free list
+ * @param[in] 	None
+ * @return 		None
+ ***********************************************************************/
+static void pbuf_init (void)
+{
+	uint32_t i;
+
+	emac_pbuf_free = NULL;
+	for (i = EMAC_PBUF_NUM; i; i--)
+	{
+		emac_pbuf[i-1].index   = i-1;
+		emac_pbuf[i-1].payload = (uint8_t *)EMAC_RAM->Pool[i-1];
+		emac_pbuf[i-1].len     = 0;
+		emac_pbuf[i-1].next    = emac_pbuf_free;
+		emac_pbuf_free = &emac_pbuf[i-1];
+	}
+}
+
+
+/*--------------------------- emac_event_process ----------------------------*/
+/*********************************************************************//**
+ * @brief 		Handles one queued EMAC event in thread context
+ * @param[in] 	Status	Interrupt status bits of the event
+ * @param[in] 	RxIndex	RxProduceIndex when the event was raised
+ * @param[in] 	TxIndex	TxConsumeIndex when the event was raised
+ * @return 		None
+ ***********************************************************************/
+static void emac_event_process (uint32_t Status, uint32_t RxIndex, uint32_t TxIndex)
+{
+	if (Status & EMAC_INT_TX_DONE) {
+		/* Give sent frames back to the pool */
+		EMAC_TxReclaim();
+	}
+
+#ifdef EMAC_LOG_MODE
+	/* Note:
+	 * The EMAC doesn't distinguish the frame type and frame length,
+	 * so, e.g. when the IP(0x8000) or ARP(0x0806) packets are received,
+	 * it compares the frame type with the max length and gives the
+	 * "Range" error. Such frames are still delivered, see EMAC_RINFO_ERR_MASK.
+	 */
+	if (Status & EMAC_INT_RX_OVERRUN)  printf(LPC_UART0,"Rx overrun\n\r");
+	if (Status & EMAC_INT_RX_ERR)      printf(LPC_UART0,"Rx error: \n\r");
+	if (Status & EMAC_INT_RX_FIN)      printf(LPC_UART0,"Rx finish\n\r");
+	if (Status & EMAC_INT_RX_DONE)     printf(LPC_UART0,"Rx done %d\n\r", RxIndex);
+	if (Status & EMAC_INT_TX_UNDERRUN) printf(LPC_UART0,"Tx under-run\n\r");
+	if (Status & EMAC_INT_TX_ERR)      printf(LPC_UART0,"Tx error\n\r");
+	if (Status & EMAC_INT_TX_FIN)      printf(LPC_UART0,"Tx finish\n\r");
+	if (Status & EMAC_INT_TX_DONE)     printf(LPC_UART0,"Tx done %d\n\r", TxIndex);
+#else
+	(void)RxIndex;
+	(void)TxIndex;
+#endif
+}
+
+
 /*--------------------------- rx_descr_init ---------------------------------*/
 /*********************************************************************//**
- * @brief 		Initializes RX Descriptor
+ * @brief 		Initializes RX Descriptor, each one owning a pool buffer
  * @param[in] 	None
  * @return 		None
  ***********************************************************************/
@@ -285,7 +293,8 @@ static void rx_descr_init (void)
 
 	for (i = 0; i < EMAC_NUM_RX_FRAG; i++)
 	{
-		Rx_Desc[i].Packet  = (uint32_t)&rx_buf[i];
+		rx_pbuf[i]         = EMAC_PbufAlloc();
+		Rx_Desc[i].Packet  = (uint32_t)rx_pbuf[i]->payload;
 		Rx_Desc[i].Ctrl    = EMAC_RCTRL_INT | (EMAC_ETH_MAX_FLEN - 1);
 		Rx_Stat[i].Info    = 0;
 		Rx_Stat[i].HashCRC = 0;
@@ -298,12 +307,34 @@ static void rx_descr_init (void)
 
 	/* Rx Descriptors Point to 0 */
 	LPC_EMAC->RxConsumeIndex  = 0;
+	rx_stamped = 0;
+}
+
+
+/*--------------------------- rx_stamp_frames -------------------------------*/
+/*********************************************************************//**
+ * @brief 		Time stamps the RX descriptors filled since the last call,
+ * 				called from ENET_IRQHandler or with interrupts masked
+ * @param[in] 	None
+ * @return 		None
+ ***********************************************************************/
+static void rx_stamp_frames (void)
+{
+	uint32_t now = now_us();
+	uint32_t produce = LPC_EMAC->RxProduceIndex;
+
+	while (rx_stamped != produce) {
+		rx_stamp[rx_stamped] = now;
+		if (++rx_stamped == EMAC_NUM_RX_FRAG) {
+			rx_stamped = 0;
+		}
+	}
 }
 
 
 /*--------------------------- tx_descr_init ---- ----------------------------*/
 /*********************************************************************//**
- * @brief 		Initializes TX Descriptor
+ * @brief 		Initializes TX Descriptor, buffers are attached on send
  * @param[in] 	None
  * @return 		None
  ***********************************************************************/
@@ -313,10 +344,12 @@ static void tx_descr_init (void) {
 
 	for (i = 0; i < EMAC_NUM_TX_FRAG; i++)
 	{
-		Tx_Desc[i].Packet = (uint32_t)&tx_buf[i];
+		tx_pbuf[i]        = NULL;
+		Tx_Desc[i].Packet = 0;
 		Tx_Desc[i].Ctrl   = 0;
 		Tx_Stat[i].Info   = 0;
 	}
+	tx_clean = 0;
 
 	/* Set EMAC Transmit Descriptor Registers. */
 	LPC_EMAC->TxDescriptor       = (uint32_t)&Tx_Desc[0];
@@ -398,49 +431,6 @@ static void setEmacAddr(uint8_t abStationAddr[])
 }
 
 
-/*********************************************************************//**
- * @brief		Calculates CRC code for number of bytes in the frame
- * @param[in]	frame_no_fcs	Pointer to the first byte of the frame
- * @param[in]	frame_len		length of the frame without the FCS
- * @return		the CRC as a 32 bit integer
- **********************************************************************/
-static int32_t emac_CRCCalc(uint8_t frame_no_fcs[], int32_t frame_len)
-{
-	int i; 		// iterator
-	int j; 		// another iterator
-	char byte; 	// current byte
-	int crc; 	// CRC result
-	int q0, q1, q2, q3; // temporary variables
-	crc = 0xFFFFFFFF;
-	for (i = 0; i < frame_len; i++) {
-		byte = *frame_no_fcs++;
-		for (j = 0; j < 2; j++) {
-			if (((crc >> 28) ^ (byte >> 3)) & 0x00000001) {
-				q3 = 0x04C11DB7;
-			} else {
-				q3 = 0x00000000;
-			}
-			if (((crc >> 29) ^ (byte >> 2)) & 0x00000001) {
-				q2 = 0x09823B6E;
-			} else {
-				q2 = 0x00000000;
-			}
-			if (((crc >> 30) ^ (byte >> 1)) & 0x00000001) {
-				q1 = 0x130476DC;
-			} else {
-				q1 = 0x00000000;
-			}
-			if (((crc >> 31) ^ (byte >> 0)) & 0x00000001) {
-				q0 = 0x2608EDB8;
-			} else {
-				q0 = 0x00000000;
-			}
-			crc = (crc << 4) ^ q3 ^ q2 ^ q1 ^ q0;
-			byte >>= 4;
-		}
-	}
-	return crc;
-}
 /* End of Private Functions --------------------------------------------------- */
 
 
@@ -546,6 +536,8 @@ void EMAC_Config(void)
  *  In default state after initializing, only Rx Done and Tx Done interrupt are enabled,
  *  all remain interrupts are disabled
  *  (Ref. from LPC17xx UM)
+ *  The packet buffer pool is rebuilt as well, so any buffer still held by
+ *  the application is invalid after this call.
  **********************************************************************/
 Status EMAC_Init(EMAC_CFG_Type *EMAC_ConfigStruct)
 {
@@ -628,10 +620,16 @@ Status EMAC_Init(EMAC_CFG_Type *EMAC_ConfigStruct)
 	// Set EMAC address
 	setEmacAddr(EMAC_ConfigStruct->pbEMAC_Addr);
 
-	/* Initialize Tx and Rx DMA Descriptors */
+	/* Initialize packet buffer pool, Tx and Rx DMA Descriptors */
+	pbuf_init ();
 	rx_descr_init ();
 	tx_descr_init ();
 
+	/* Empty the deferred event queue */
+	emac_evt_head = 0;
+	emac_evt_tail = 0;
+	emac_evt_lost = 0;
+
 	// Set Receive Filter register: enable broadcast and multicast
 	LPC_EMAC->RxFilterCtrl = EMAC_RFC_MCAST_EN | EMAC_RFC_BCAST_EN | EMAC_RFC_PERFECT_EN;
 
@@ -925,12 +923,12 @@ void EMAC_SetHashFilter(uint8_t dstMAC_addr[], FunctionalState NewState)
 {
 	uint32_t *pReg;
 	uint32_t tmp;
-	int32_t crc;
+	uint32_t crc;
 
 	// Calculate the CRC from the destination MAC address
-	crc = emac_CRCCalc(dstMAC_addr, 6);
-	// Extract the value from CRC to get index value for hash filter table
-	crc = (crc >> 23) & 0x3F;
+	crc = CRC32_Update(CRC32_INIT, dstMAC_addr, 6);
+	// The hash uses the non-reflected CRC register, bits [28:23]
+	crc = (__RBIT(crc) >> 23) & 0x3F;
 
 	pReg = (crc > 31) ? ((uint32_t *)&LPC_EMAC->HashFilterH) \
 								: ((uint32_t *)&LPC_EMAC->HashFilterL);
@@ -1014,21 +1012,54 @@ FlagStatus EMAC_GetWoLStatus(uint32_t ulWoLMode)
  * @param[in]	pDataStruct		Pointer to a EMAC_PACKETBUF_Type structure
  * 							data that contain specified information about
  * 							Packet data buffer.
- * @return		None
+ * @return		SUCCESS if the descriptor is ready, the caller then starts
+ * 				it with EMAC_UpdateTxProduceIndex().
+ * 				ERROR if the length is out of range, the TX ring is full or
+ * 				the pool is empty; the descriptor is left untouched.
+ *
+ * Note: The data is copied into a buffer taken from the pool, which is
+ * released again once the frame has been sent. EMAC_SendFrame() avoids
+ * the copy altogether.
  **********************************************************************/
-void EMAC_WritePacketBuffer(EMAC_PACKETBUF_Type *pDataStruct)
+Status EMAC_WritePacketBuffer(EMAC_PACKETBUF_Type *pDataStruct)
 {
-	uint32_t idx,len;
+	uint32_t idx, len, primask;
 	uint32_t *sp,*dp;
+	EMAC_PBUF_Type *p;
+
+	if ((pDataStruct->ulDataLen == 0) || (pDataStruct->ulDataLen > EMAC_ETH_MAX_FLEN)) {
+		return ERROR;
+	}
+
+	primask = __get_PRIMASK();
+	__disable_irq();
 
+	EMAC_TxReclaim();
 	idx = LPC_EMAC->TxProduceIndex;
+	// One descriptor always stays empty to tell a full ring from an empty one
+	if ((tx_clean + EMAC_NUM_TX_FRAG - idx - 1) % EMAC_NUM_TX_FRAG == 0) {
+		__set_PRIMASK(primask);
+		return ERROR;
+	}
+	p = EMAC_PbufAlloc();
+	if (p == NULL) {
+		__set_PRIMASK(primask);
+		return ERROR;
+	}
+
+	__set_PRIMASK(primask);
+
 	sp  = (uint32_t *)pDataStruct->pbDataBuf;
-	dp  = (uint32_t *)Tx_Desc[idx].Packet;
+	dp  = (uint32_t *)p->payload;
 	/* Copy frame data to EMAC packet buffers. */
 	for (len = (pDataStruct->ulDataLen + 3) >> 2; len; len--) {
 		*dp++ = *sp++;
 	}
+	p->len = pDataStruct->ulDataLen;
+	tx_pbuf[idx] = p;
+	Tx_Desc[idx].Packet = (uint32_t)p->payload;
 	Tx_Desc[idx].Ctrl = (pDataStruct->ulDataLen - 1) | (EMAC_TCTRL_INT | EMAC_TCTRL_LAST);
+	return SUCCESS;
 }
 
 /*********************************************************************//**
@@ -1055,6 +1086,275 @@ void EMAC_ReadPacketBuffer(EMAC_PACKETBUF_Type *pDataStruct)
 	}
 }
 
+/*********************************************************************//**
+ * @brief		Take a packet buffer from the pool
+ * @param[in]	None
+ * @return		Pointer to a buffer with payload at its start and len 0,
+ * 				or NULL if the pool is empty
+ *
+ * Note: Safe to call from interrupt context.
+ **********************************************************************/
+EMAC_PBUF_Type *EMAC_PbufAlloc(void)
+{
+	EMAC_PBUF_Type *p;
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	p = emac_pbuf_free;
+	if (p != NULL) {
+		emac_pbuf_free = p->next;
+	}
+	__set_PRIMASK(primask);
+
+	if (p != NULL) {
+		p->next = NULL;
+		p->len  = 0;
+	}
+	return p;
+}
+
+/*********************************************************************//**
+ * @brief		Return a packet buffer chain to the pool
+ * @param[in]	p	First buffer of the chain, NULL is ignored
+ * @return		None
+ *
+ * Note: Every buffer linked through 'next' is released and its payload
+ * pointer reset to the start of the buffer. Safe to call from interrupt
+ * context.
+ **********************************************************************/
+void EMAC_PbufFree(EMAC_PBUF_Type *p)
+{
+	EMAC_PBUF_Type *next;
+	uint32_t primask;
+
+	while (p != NULL) {
+		next = p->next;
+		p->payload = (uint8_t *)EMAC_RAM->Pool[p->index];
+		p->len = 0;
+
+		primask = __get_PRIMASK();
+		__disable_irq();
+		p->next = emac_pbuf_free;
+		emac_pbuf_free = p;
+		__set_PRIMASK(primask);
+
+		p = next;
+	}
+}
+
+/*********************************************************************//**
+ * @brief		Hand the next received frame to the application by reference
+ * @param[in]	None
+ * @return		Buffer holding the frame (CRC stripped), or NULL if no valid
+ * 				frame is pending or no spare buffer is left to refill the ring
+ *
+ * Note: The descriptor is refilled with a fresh pool buffer before the
+ * frame is released, so the receive ring never runs short. Erroneous frames
+ * are recycled in place. The caller owns the returned buffer and must give
+ * it back with EMAC_PbufFree() (or pass it to EMAC_SendFrame()).
+ **********************************************************************/
+EMAC_PBUF_Type *EMAC_ReceiveFrame(void)
+{
+	uint32_t idx, info, primask;
+	EMAC_PBUF_Type *p, *fresh;
+
+	/* Frames not seen by the ISR (RX interrupt off) are stamped now */
+	primask = __get_PRIMASK();
+	__disable_irq();
+	rx_stamp_frames();
+	__set_PRIMASK(primask);
+
+	while (EMAC_CheckReceiveIndex() == TRUE) {
+		idx  = LPC_EMAC->RxConsumeIndex;
+		info = Rx_Stat[idx].Info;
+
+		if (!(info & EMAC_RINFO_LAST_FLAG) || (info & EMAC_RINFO_ERR_MASK)) {
+			/* Invalid frame, keep the buffer on the descriptor */
+			EMAC_UpdateRxConsumeIndex();
+			continue;
+		}
+
+		fresh = EMAC_PbufAlloc();
+		if (fresh == NULL) {
+			/* Leave the frame in the ring until buffers come back */
+			return NULL;
+		}
+
+		p = rx_pbuf[idx];
+		// Size is in (-1) style format, strip the 4-bytes CRC field
+		p->len = (info & EMAC_RINFO_SIZE) - 3;
+		p->stamp = rx_stamp[idx];
+
+		rx_pbuf[idx] = fresh;
+		Rx_Desc[idx].Packet = (uint32_t)fresh->payload;
+		EMAC_UpdateRxConsumeIndex();
+		return p;
+	}
+	return NULL;
+}
+
+/*********************************************************************//**
+ * @brief		Queue a frame for transmission without copying it
+ * @param[in]	p	First buffer of the frame, further fragments linked
+ * 					through 'next'. Each fragment takes one TX descriptor.
+ * @return		SUCCESS if the frame was queued, the driver then owns the
+ * 				chain and releases it once sent.
+ * 				ERROR if there are not enough free descriptors or a fragment
+ * 				length is out of range, the caller keeps the chain.
+ **********************************************************************/
+Status EMAC_SendFrame(EMAC_PBUF_Type *p)
+{
+	uint32_t idx, frags, avail, primask;
+	EMAC_PBUF_Type *q;
+
+	frags = 0;
+	for (q = p; q != NULL; q = q->next) {
+		if ((q->len == 0) || (q->len > EMAC_ETH_MAX_FLEN)) {
+			return ERROR;
+		}
+		frags++;
+	}
+	if (frags == 0) {
+		return ERROR;
+	}
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+
+	EMAC_TxReclaim();
+	idx = LPC_EMAC->TxProduceIndex;
+	// One descriptor always stays empty to tell a full ring from an empty one
+	avail = (tx_clean + EMAC_NUM_TX_FRAG - idx - 1) % EMAC_NUM_TX_FRAG;
+	if (frags > avail) {
+		__set_PRIMASK(primask);
+		return ERROR;
+	}
+
+	for (q = p; q != NULL; q = q->next) {
+		Tx_Desc[idx].Packet = (uint32_t)q->payload;
+		if (q->next == NULL) {
+			Tx_Desc[idx].Ctrl = (q->len - 1) | (EMAC_TCTRL_INT | EMAC_TCTRL_LAST);
+			tx_pbuf[idx] = p;
+		} else {
+			Tx_Desc[idx].Ctrl = (q->len - 1);
+			tx_pbuf[idx] = NULL;
+		}
+		if (++idx == EMAC_NUM_TX_FRAG) idx = 0;
+	}
+	/* Start frame transmission */
+	LPC_EMAC->TxProduceIndex = idx;
+
+	__set_PRIMASK(primask);
+	return SUCCESS;
+}
+
+/*********************************************************************//**
+ * @brief		Release the buffers of every frame the EMAC has finished
+ * 				sending
+ * @param[in]	None
+ * @return		None
+ *
+ * Note: Called by the send functions and by EMAC_Poll() for each queued
+ * TX Done event, never from the interrupt. The application only needs
+ * it to get buffers back while it neither sends nor polls.
+ **********************************************************************/
+void EMAC_TxReclaim(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint32_t cons;
+
+	__disable_irq();
+	cons = LPC_EMAC->TxConsumeIndex;
+	while (tx_clean != cons) {
+		if (tx_pbuf[tx_clean] != NULL) {
+			EMAC_PbufFree(tx_pbuf[tx_clean]);
+			tx_pbuf[tx_clean] = NULL;
+		}
+		if (++tx_clean == EMAC_NUM_TX_FRAG) tx_clean = 0;
+	}
+	__set_PRIMASK(primask);
+}
+
+/*********************************************************************//**
+ * @brief		EMAC bottom half, to be called from the main loop
+ * @param[in]	None
+ * @return		None
+ *
+ * Note: Drains the events queued by ENET_IRQHandler (logging them if
+ * EMAC_LOG_SEL is set, releasing sent frames) and then passes every
+ * received frame to the callback installed with EMAC_SetRxCallback().
+ * Without a callback, frames are left in the ring for EMAC_ReceiveFrame()
+ * or the webserver functions.
+ **********************************************************************/
+void EMAC_Poll(void)
+{
+	uint32_t tail, stat, primask;
+	EMAC_PBUF_Type *p;
+
+	while ((tail = emac_evt_tail) != emac_evt_head) {
+		emac_event_process(emac_evt[tail].Status, emac_evt[tail].RxIndex,
+						   emac_evt[tail].TxIndex);
+		emac_evt_tail = (tail + 1) & (EMAC_EVT_QUEUE_SIZE - 1);
+	}
+
+	/* Events merged while the queue was full */
+	primask = __get_PRIMASK();
+	__disable_irq();
+	stat = emac_evt_lost;
+	emac_evt_lost = 0;
+	__set_PRIMASK(primask);
+	if (stat) {
+		emac_event_process(stat, LPC_EMAC->RxProduceIndex, LPC_EMAC->TxConsumeIndex);
+	}
+
+	/* Frame processing */
+	if (emac_rx_cb != NULL) {
+		while ((p = EMAC_ReceiveFrame()) != NULL) {
+			emac_rx_cb(p);
+		}
+	}
+}
+
+/*********************************************************************//**
+ * @brief		Install the receive callback run by EMAC_Poll()
+ * @param[in]	Callback	Function taking ownership of each received
+ * 							frame, NULL to leave frames in the ring
+ * @return		None
+ **********************************************************************/
+void EMAC_SetRxCallback(EMAC_RxCallback_Type Callback)
+{
+	emac_rx_cb = Callback;
+}
+
+/*********************************************************************//**
+ * @brief		Read a consistent snapshot of the EMAC event counters
+ * @param[in]	pCounters	Pointer to a EMAC_COUNTERS_Type to fill
+ * @return		None
+ **********************************************************************/
+void EMAC_GetCounters(EMAC_COUNTERS_Type *pCounters)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	*pCounters = emac_cnt;
+	__set_PRIMASK(primask);
+}
+
+/*********************************************************************//**
+ * @brief		Reset all EMAC event counters to zero
+ * @param[in]	None
+ * @return		None
+ **********************************************************************/
+void EMAC_ClearCounters(void)
+{
+	EMAC_COUNTERS_Type zero = {0};
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	emac_cnt = zero;
+	__set_PRIMASK(primask);
+}
+
 /*********************************************************************//**
  * @brief 		Enable/Disable interrupt for each type in EMAC
  * @param[in]	ulIntType	Interrupt Type, should be:
@@ -1285,15 +1585,10 @@ void DummyReadFrame_EMAC(unsigned short Size)    // discards an EVEN number of b
 // returns the frame length
 unsigned short StartReadFrame(void) {
 	unsigned short RxLen;
-	EMAC_PACKETBUF_Type RxPack;
 
 	RxLen = EMAC_GetReceiveDataSize() - 3;
-	// Copy packet to data buffer
-	RxPack.pbDataBuf = (uint32_t *)pgBuf;
-	RxPack.ulDataLen = RxLen;
-	EMAC_ReadPacketBuffer(&RxPack);
-	// Point to the data buffer
-	rptr = (unsigned short *)pgBuf;
+	// Read the frame in place, it stays owned by the descriptor until EndReadFrame()
+	rptr = (unsigned short *)Rx_Desc[LPC_EMAC->RxConsumeIndex].Packet;
 	return(RxLen);
 }
 
@@ -1347,8 +1642,9 @@ void CopyToFrame_EMAC(void *Source, unsigned int Size)
 	// NXP: Added for compatibility with old style
 	TxPack.ulDataLen = Size;
 	TxPack.pbDataBuf = (uint32_t *)Source;
-	EMAC_WritePacketBuffer(&TxPack);
-	EMAC_UpdateTxProduceIndex();
+	if (EMAC_WritePacketBuffer(&TxPack) == SUCCESS) {
+		EMAC_UpdateTxProduceIndex();
+	}
 }
 
 
@@ -0,0 +1,715 @@
+/******************************************************************//**
+* @file		lpc17xx_gpdma.c
+* @brief	Contains all functions support for GPDMA firmware library
+* 			on LPC17xx
+* @version	1.0
+* @date		20. June. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* Peripheral group ----------------------------------------------------------- */
+/** @addtogroup GPDMA
+ * @{
+ */
+
+/* Includes ------------------------------------------------------------------- */
+#include "lpc17xx_gpdma.h"
+
+/* If this source file built with example, the LPC17xx FW library configuration
+ * file in each example directory ("lpc17xx_libcfg.h") must be included,
+ * otherwise the default FW library configuration file must be included instead
+ */
+
+
+/* Private Variables ---------------------------------------------------------- */
+/** @defgroup GPDMA_Private_Variables GPDMA Private Variables
+ * @{
+ */
+
+/**
+ * @brief Lookup Table of Connection Type matched with
+ * Peripheral Data (FIFO) register base address
+ */
+static volatile const void *GPDMA_LUTPerAddr[] = {
+		(&LPC_SSP0->DR),				// SSP0 Tx
+		(&LPC_SSP0->DR),				// SSP0 Rx
+		(&LPC_SSP1->DR),				// SSP1 Tx
+		(&LPC_SSP1->DR),				// SSP1 Rx
+		(&LPC_ADC->ADGDR),				// ADC
+		(&LPC_I2S->I2STXFIFO), 			// I2S Tx
+		(&LPC_I2S->I2SRXFIFO), 			// I2S Rx
+		(&LPC_DAC->DACR),				// DAC
+		(&LPC_UART0->THR),			// UART0 Tx
+		(&LPC_UART0->RBR),			// UART0 Rx
+		(&LPC_UART1->THR),			// UART1 Tx
+		(&LPC_UART1->RBR),			// UART1 Rx
+		(&LPC_UART2->THR),			// UART2 Tx
+		(&LPC_UART2->RBR),			// UART2 Rx
+		(&LPC_UART3->THR),			// UART3 Tx
+		(&LPC_UART3->RBR),			// UART3 Rx
+		(&LPC_TIM0->MR0),				// MAT0.0
+		(&LPC_TIM0->MR1),				// MAT0.1
+		(&LPC_TIM1->MR0),				// MAT1.0
+		(&LPC_TIM1->MR1),				// MAT1.1
+		(&LPC_TIM2->MR0),				// MAT2.0
+		(&LPC_TIM2->MR1),				// MAT2.1
+		(&LPC_TIM3->MR0),				// MAT3.0
+		(&LPC_TIM3->MR1),				// MAT3.1
+};
+
+/**
+ * @brief Lookup Table of GPDMA Channel Number matched with
+ * GPDMA channel pointer
+ */
+static LPC_GPDMACH_TypeDef * const pGPDMACh[GPDMA_NUM_CHANNELS] = {
+		LPC_GPDMACH0,	// GPDMA Channel 0
+		LPC_GPDMACH1,	// GPDMA Channel 1
+		LPC_GPDMACH2,	// GPDMA Channel 2
+		LPC_GPDMACH3,	// GPDMA Channel 3
+		LPC_GPDMACH4,	// GPDMA Channel 4
+		LPC_GPDMACH5,	// GPDMA Channel 5
+		LPC_GPDMACH6,	// GPDMA Channel 6
+		LPC_GPDMACH7,	// GPDMA Channel 7
+};
+
+/**
+ * @brief Optimized Peripheral Source and Destination burst size
+ */
+static const uint8_t GPDMA_LUTPerBurst[] = {
+		GPDMA_BSIZE_4,				// SSP0 Tx
+		GPDMA_BSIZE_4,				// SSP0 Rx
+		GPDMA_BSIZE_4,				// SSP1 Tx
+		GPDMA_BSIZE_4,				// SSP1 Rx
+		GPDMA_BSIZE_1,				// ADC
+		GPDMA_BSIZE_32,				// I2S channel 0
+		GPDMA_BSIZE_32,				// I2S channel 1
+		GPDMA_BSIZE_1,				// DAC
+		GPDMA_BSIZE_1,				// UART0 Tx
+		GPDMA_BSIZE_1,				// UART0 Rx
+		GPDMA_BSIZE_1,				// UART1 Tx
+		GPDMA_BSIZE_1,				// UART1 Rx
+		GPDMA_BSIZE_1,				// UART2 Tx
+		GPDMA_BSIZE_1,				// UART2 Rx
+		GPDMA_BSIZE_1,				// UART3 Tx
+		GPDMA_BSIZE_1,				// UART3 Rx
+		GPDMA_BSIZE_1,				// MAT0.0
+		GPDMA_BSIZE_1,				// MAT0.1
+		GPDMA_BSIZE_1,				// MAT1.0
+		GPDMA_BSIZE_1,				// MAT1.1
+		GPDMA_BSIZE_1,				// MAT2.0
+		GPDMA_BSIZE_1,				// MAT2.1
+		GPDMA_BSIZE_1,				// MAT3.0
+		GPDMA_BSIZE_1,				// MAT3.1
+};
+
+/**
+ * @brief Optimized Peripheral Source and Destination transfer width
+ */
+static const uint8_t GPDMA_LUTPerWid[] = {
+		GPDMA_WIDTH_BYTE,				// SSP0 Tx
+		GPDMA_WIDTH_BYTE,				// SSP0 Rx
+		GPDMA_WIDTH_BYTE,				// SSP1 Tx
+		GPDMA_WIDTH_BYTE,				// SSP1 Rx
+		GPDMA_WIDTH_WORD,				// ADC
+		GPDMA_WIDTH_WORD,				// I2S channel 0
+		GPDMA_WIDTH_WORD, 				// I2S channel 1
+		GPDMA_WIDTH_WORD,				// DAC
+		GPDMA_WIDTH_BYTE,				// UART0 Tx
+		GPDMA_WIDTH_BYTE,				// UART0 Rx
+		GPDMA_WIDTH_BYTE,				// UART1 Tx
+		GPDMA_WIDTH_BYTE,				// UART1 Rx
+		GPDMA_WIDTH_BYTE,				// UART2 Tx
+		GPDMA_WIDTH_BYTE,				// UART2 Rx
+		GPDMA_WIDTH_BYTE,				// UART3 Tx
+		GPDMA_WIDTH_BYTE,				// UART3 Rx
+		GPDMA_WIDTH_WORD,				// MAT0.0
+		GPDMA_WIDTH_WORD,				// MAT0.1
+		GPDMA_WIDTH_WORD,				// MAT1.0
+		GPDMA_WIDTH_WORD,				// MAT1.1
+		GPDMA_WIDTH_WORD,				// MAT2.0
+		GPDMA_WIDTH_WORD,				// MAT2.1
+		GPDMA_WIDTH_WORD,				// MAT3.0
+		GPDMA_WIDTH_WORD,				// MAT3.1
+};
+
+/** Bit mask of channels handed out by GPDMA_ChannelAlloc() */
+static volatile uint32_t GPDMA_ChannelUsed = 0;
+
+/** Completion/error callback for each channel */
+static volatile GPDMA_Callback_Type GPDMA_Callback[GPDMA_NUM_CHANNELS];
+
+/**
+ * @}
+ */
+
+/* Private Functions ---------------------------------------------------------- */
+/** @defgroup GPDMA_Private_Functions GPDMA Private Functions
+ * @{
+ */
+
+static uint32_t GPDMA_MakeConfig(GPDMA_Channel_CFG_Type *GPDMAChannelConfig);
+
+/*********************************************************************//**
+ * @brief		Build the channel configuration word for a transfer and
+ * 				route UART/MAT requests through DMAREQSEL
+ * @param[in]	GPDMAChannelConfig Pointer to a GPDMA_Channel_CFG_Type
+ * 				structure, only TransferType, SrcConn and DstConn are used
+ * @return		Value for DMACCxConfig register, channel left disabled
+ **********************************************************************/
+static uint32_t GPDMA_MakeConfig(GPDMA_Channel_CFG_Type *GPDMAChannelConfig)
+{
+	uint32_t tmp1, tmp2;
+
+	/* Re-Configure DMA Request Select for source peripheral */
+	if (GPDMAChannelConfig->SrcConn > 15)
+	{
+		LPC_SC->DMAREQSEL |= (1<<(GPDMAChannelConfig->SrcConn - 16));
+	}
+	else if (GPDMAChannelConfig->SrcConn > 7)
+	{
+		LPC_SC->DMAREQSEL &= ~(1<<(GPDMAChannelConfig->SrcConn - 8));
+	}
+
+	/* Re-Configure DMA Request Select for Destination peripheral */
+	if (GPDMAChannelConfig->DstConn > 15)
+	{
+		LPC_SC->DMAREQSEL |= (1<<(GPDMAChannelConfig->DstConn - 16));
+	}
+	else if (GPDMAChannelConfig->DstConn > 7)
+	{
+		LPC_SC->DMAREQSEL &= ~(1<<(GPDMAChannelConfig->DstConn - 8));
+	}
+
+	/* MAT requests share the request lines of UART 8..15 */
+	tmp1 = GPDMAChannelConfig->SrcConn;
+	tmp1 = ((tmp1 > 15) ? (tmp1 - 8) : tmp1);
+	tmp2 = GPDMAChannelConfig->DstConn;
+	tmp2 = ((tmp2 > 15) ? (tmp2 - 8) : tmp2);
+
+	switch (GPDMAChannelConfig->TransferType)
+	{
+	case GPDMA_TRANSFERTYPE_M2M:
+		tmp1 = 0;
+		tmp2 = 0;
+		break;
+	case GPDMA_TRANSFERTYPE_M2P:
+		tmp1 = 0;
+		break;
+	case GPDMA_TRANSFERTYPE_P2M:
+		tmp2 = 0;
+		break;
+	default:
+		break;
+	}
+
+	return (GPDMA_DMACCxConfig_IE | GPDMA_DMACCxConfig_ITC \
+			| GPDMA_DMACCxConfig_TransferType((uint32_t)GPDMAChannelConfig->TransferType) \
+			| GPDMA_DMACCxConfig_SrcPeripheral(tmp1) \
+			| GPDMA_DMACCxConfig_DestPeripheral(tmp2));
+}
+
+/**
+ * @}
+ */
+
+/*----------------- INTERRUPT SERVICE ROUTINES --------------------------*/
+/*********************************************************************//**
+ * @brief		GPDMA interrupt handler sub-routine
+ * 				Clears terminal count and error flags of every channel
+ * 				and calls the callback registered for it. Channel 0 has
+ * 				the highest priority so it is serviced first.
+ * @param[in]	None
+ * @return 		None
+ **********************************************************************/
+void DMA_IRQHandler(void)
+{
+	uint32_t tc, err, ch;
+	GPDMA_Callback_Type cb;
+
+	tc = LPC_GPDMA->DMACIntTCStat & GPDMA_DMACIntTCStat_BITMASK;
+	err = LPC_GPDMA->DMACIntErrStat & GPDMA_DMACIntErrStat_BITMASK;
+
+	LPC_GPDMA->DMACIntTCClear = tc;
+	LPC_GPDMA->DMACIntErrClr = err;
+
+	for (ch = 0; (tc | err) != 0; ch++)
+	{
+		if ((tc | err) & GPDMA_DMACIntStat_Ch(ch))
+		{
+			cb = GPDMA_Callback[ch];
+			if (cb != NULL)
+			{
+				cb(ch, (err & GPDMA_DMACIntErrStat_Ch(ch)) ? GPDMA_CB_ERROR : GPDMA_CB_DONE);
+			}
+			tc &= ~GPDMA_DMACIntTCStat_Ch(ch);
+			err &= ~GPDMA_DMACIntErrStat_Ch(ch);
+		}
+	}
+}
+
+/* Public Functions ----------------------------------------------------------- */
+/** @addtogroup GPDMA_Public_Functions
+ * @{
+ */
+
+/********************************************************************//**
+ * @brief 		Initialize GPDMA controller
+ * 					- Turn on power and clock
+ * 					- Disable and reset all channels
+ * 					- Enable controller and DMA interrupt
+ * @param 		None
+ * @return 		None
+ *********************************************************************/
+void GPDMA_Init(void)
+{
+	uint32_t ch;
+
+	/* Enable GPDMA clock */
+	CLKPWR_ConfigPPWR (CLKPWR_PCONP_PCGPDMA, ENABLE);
+
+	// Reset all channel configuration register
+	for (ch = 0; ch < GPDMA_NUM_CHANNELS; ch++)
+	{
+		pGPDMACh[ch]->DMACCConfig = 0;
+		GPDMA_Callback[ch] = NULL;
+	}
+	GPDMA_ChannelUsed = 0;
+
+	/* Clear all DMA interrupt and error flag */
+	LPC_GPDMA->DMACIntTCClear = GPDMA_DMACIntTCClear_BITMASK;
+	LPC_GPDMA->DMACIntErrClr = GPDMA_DMACIntErrClr_BITMASK;
+
+	/* Enable DMA channels, little endian */
+	LPC_GPDMA->DMACConfig = GPDMA_DMACConfig_E;
+	while (!(LPC_GPDMA->DMACConfig & GPDMA_DMACConfig_E));
+
+	NVIC_EnableIRQ(DMA_IRQn);
+}
+
+/********************************************************************//**
+ * @brief 		Get the data register address of a DMA peripheral
+ * @param[in]	Conn	Connection type, should be one of GPDMA_CONN_x
+ * @return 		Physical address of the peripheral data register
+ *********************************************************************/
+uint32_t GPDMA_GetPeriphAddr(uint32_t Conn)
+{
+	CHECK_PARAM(PARAM_GPDMA_CONN(Conn));
+
+	return ((uint32_t)GPDMA_LUTPerAddr[Conn]);
+}
+
+/********************************************************************//**
+ * @brief 		Build a DMACCxControl word (without transfer size) for a
+ * 				transfer, using the optimized burst size and width of
+ * 				the peripheral connection
+ * @param[in]	TransferType	Transfer type, should be GPDMA_TRANSFERTYPE_x
+ * @param[in]	SrcConn		Source connection, used for P2M and P2P
+ * @param[in]	DstConn		Destination connection, used for M2P and P2P
+ * @param[in]	TransferWidth	Transfer width, used for M2M only
+ * @return 		Control word, OR with GPDMA_DMACCxControl_TransferSize()
+ * 				and GPDMA_DMACCxControl_I as required
+ *********************************************************************/
+uint32_t GPDMA_MakeControl(uint32_t TransferType, uint32_t SrcConn, uint32_t DstConn,
+						uint32_t TransferWidth)
+{
+	CHECK_PARAM(PARAM_GPDMA_TRANSFERTYPE(TransferType));
+
+	switch (TransferType)
+	{
+	// Memory to memory
+	case GPDMA_TRANSFERTYPE_M2M:
+		CHECK_PARAM(PARAM_GPDMA_WIDTH(TransferWidth));
+		return (GPDMA_DMACCxControl_SBSize(GPDMA_BSIZE_32) \
+				| GPDMA_DMACCxControl_DBSize(GPDMA_BSIZE_32) \
+				| GPDMA_DMACCxControl_SWidth(TransferWidth) \
+				| GPDMA_DMACCxControl_DWidth(TransferWidth) \
+				| GPDMA_DMACCxControl_SI \
+				| GPDMA_DMACCxControl_DI);
+
+	// Memory to peripheral
+	case GPDMA_TRANSFERTYPE_M2P:
+		CHECK_PARAM(PARAM_GPDMA_CONN(DstConn));
+		return (GPDMA_DMACCxControl_SBSize((uint32_t)GPDMA_LUTPerBurst[DstConn]) \
+				| GPDMA_DMACCxControl_DBSize((uint32_t)GPDMA_LUTPerBurst[DstConn]) \
+				| GPDMA_DMACCxControl_SWidth((uint32_t)GPDMA_LUTPerWid[DstConn]) \
+				| GPDMA_DMACCxControl_DWidth((uint32_t)GPDMA_LUTPerWid[DstConn]) \
+				| GPDMA_DMACCxControl_SI);
+
+	// Peripheral to memory
+	case GPDMA_TRANSFERTYPE_P2M:
+		CHECK_PARAM(PARAM_GPDMA_CONN(SrcConn));
+		return (GPDMA_DMACCxControl_SBSize((uint32_t)GPDMA_LUTPerBurst[SrcConn]) \
+				| GPDMA_DMACCxControl_DBSize((uint32_t)GPDMA_LUTPerBurst[SrcConn]) \
+				| GPDMA_DMACCxControl_SWidth((uint32_t)GPDMA_LUTPerWid[SrcConn]) \
+				| GPDMA_DMACCxControl_DWidth((uint32_t)GPDMA_LUTPerWid[SrcConn]) \
+				| GPDMA_DMACCxControl_DI);
+
+	// Peripheral to peripheral
+	case GPDMA_TRANSFERTYPE_P2P:
+		CHECK_PARAM(PARAM_GPDMA_CONN(SrcConn));
+		CHECK_PARAM(PARAM_GPDMA_CONN(DstConn));
+		return (GPDMA_DMACCxControl_SBSize((uint32_t)GPDMA_LUTPerBurst[SrcConn]) \
+				| GPDMA_DMACCxControl_DBSize((uint32_t)GPDMA_LUTPerBurst[DstConn]) \
+				| GPDMA_DMACCxControl_SWidth((uint32_t)GPDMA_LUTPerWid[SrcConn]) \
+				| GPDMA_DMACCxControl_DWidth((uint32_t)GPDMA_LUTPerWid[DstConn]));
+
+	default:
+		return 0;
+	}
+}
+
+/********************************************************************//**
+ * @brief 		Split a transfer of any length into a chain of Linked
+ * 				List Items of at most GPDMA_MAX_XFER_SIZE transfers each
+ * @param[in]	pLLI		Array of LLI to fill, must be word aligned
+ * @param[in]	NumLLI		Number of entries available in pLLI
+ * @param[in]	SrcAddr		Source address of the whole transfer
+ * @param[in]	DstAddr		Destination address of the whole transfer
+ * @param[in]	Count		Number of source-width transfers
+ * @param[in]	Control		Control word from GPDMA_MakeControl(), SI/DI
+ * 							decide whether the addresses advance per item
+ * @return 		Number of LLI used, 0 if NumLLI is too small or Count is 0.
+ * 				Only the last item raises the terminal count interrupt,
+ * 				the caller may link it back to pLLI[0] for a circular ring.
+ *********************************************************************/
+uint32_t GPDMA_BuildLLI(GPDMA_LLI_Type *pLLI, uint32_t NumLLI, uint32_t SrcAddr,
+						uint32_t DstAddr, uint32_t Count, uint32_t Control)
+{
+	uint32_t i, num, chunk, bytes;
+
+	num = (Count + GPDMA_MAX_XFER_SIZE - 1) / GPDMA_MAX_XFER_SIZE;
+	if ((num == 0) || (num > NumLLI))
+	{
+		return 0;
+	}
+
+	Control &= ~(GPDMA_DMACCxControl_TransferSize(0xFFF) | GPDMA_DMACCxControl_I);
+
+	for (i = 0; i < num; i++)
+	{
+		chunk = MIN(Count, GPDMA_MAX_XFER_SIZE);
+		// Source width defines the byte count moved by each item
+		bytes = chunk << GPDMA_DMACCxControl_GetSWidth(Control);
+
+		pLLI[i].SrcAddr = SrcAddr;
+		pLLI[i].DstAddr = DstAddr;
+		pLLI[i].Control = Control | GPDMA_DMACCxControl_TransferSize(chunk);
+		pLLI[i].NextLLI = (uint32_t)&pLLI[i + 1];
+
+		if (Control & GPDMA_DMACCxControl_SI)
+		{
+			SrcAddr += bytes;
+		}
+		if (Control & GPDMA_DMACCxControl_DI)
+		{
+			DstAddr += bytes;
+		}
+		Count -= chunk;
+	}
+
+	pLLI[num - 1].NextLLI = 0;
+	pLLI[num - 1].Control |= GPDMA_DMACCxControl_I;
+
+	return num;
+}
+
+/********************************************************************//**
+ * @brief 		Setup GPDMA channel peripheral according to the specified
+ *              parameters in the GPDMAChannelConfig.
+ * @param[in]	GPDMAChannelConfig Pointer to a GPDMA_Channel_CFG_Type
+ * 									structure that contains the configuration
+ * 									information for the specified GPDMA channel peripheral.
+ * @return		ERROR: if selected channel is enabled before
+ * 				SUCCESS: if channel is configured successfully
+ * Note: 		TransferSize is limited to GPDMA_MAX_XFER_SIZE, use
+ * 				GPDMA_BuildLLI() and GPDMA_SetupLLI() for longer transfers
+ *********************************************************************/
+Status GPDMA_Setup(GPDMA_Channel_CFG_Type *GPDMAChannelConfig)
+{
+	LPC_GPDMACH_TypeDef *pDMAch;
+	uint32_t ctrl;
+
+	CHECK_PARAM(PARAM_GPDMA_CHANNEL(GPDMAChannelConfig->ChannelNum));
+	CHECK_PARAM(PARAM_GPDMA_TRANSFERTYPE(GPDMAChannelConfig->TransferType));
+
+	if (LPC_GPDMA->DMACEnbldChns & (GPDMA_DMACEnbldChns_Ch(GPDMAChannelConfig->ChannelNum)))
+	{
+		// This channel is enabled, return ERROR, need to release this channel first
+		return ERROR;
+	}
+
+	// Get Channel pointer
+	pDMAch = pGPDMACh[GPDMAChannelConfig->ChannelNum];
+
+	// Reset the Interrupt status
+	LPC_GPDMA->DMACIntTCClear = GPDMA_DMACIntTCClear_Ch(GPDMAChannelConfig->ChannelNum);
+	LPC_GPDMA->DMACIntErrClr = GPDMA_DMACIntErrClr_Ch(GPDMAChannelConfig->ChannelNum);
+
+	// Clear DMA configure
+	pDMAch->DMACCControl = 0x00;
+	pDMAch->DMACCConfig = 0x00;
+
+	/* Assign Linker List Item value */
+	pDMAch->DMACCLLI = GPDMAChannelConfig->DMALLI & GPDMA_DMACCxLLI_BITMASK;
+
+	ctrl = GPDMA_MakeControl(GPDMAChannelConfig->TransferType, GPDMAChannelConfig->SrcConn,
+							GPDMAChannelConfig->DstConn, GPDMAChannelConfig->TransferWidth);
+
+	/* Set value to Channel Control Registers */
+	switch (GPDMAChannelConfig->TransferType)
+	{
+	// Memory to memory
+	case GPDMA_TRANSFERTYPE_M2M:
+		pDMAch->DMACCSrcAddr = GPDMAChannelConfig->SrcMemAddr;
+		pDMAch->DMACCDestAddr = GPDMAChannelConfig->DstMemAddr;
+		break;
+	// Memory to peripheral
+	case GPDMA_TRANSFERTYPE_M2P:
+		pDMAch->DMACCSrcAddr = GPDMAChannelConfig->SrcMemAddr;
+		pDMAch->DMACCDestAddr = (uint32_t)GPDMA_LUTPerAddr[GPDMAChannelConfig->DstConn];
+		break;
+	// Peripheral to memory
+	case GPDMA_TRANSFERTYPE_P2M:
+		pDMAch->DMACCSrcAddr = (uint32_t)GPDMA_LUTPerAddr[GPDMAChannelConfig->SrcConn];
+		pDMAch->DMACCDestAddr = GPDMAChannelConfig->DstMemAddr;
+		break;
+	// Peripheral to peripheral
+	case GPDMA_TRANSFERTYPE_P2P:
+		pDMAch->DMACCSrcAddr = (uint32_t)GPDMA_LUTPerAddr[GPDMAChannelConfig->SrcConn];
+		pDMAch->DMACCDestAddr = (uint32_t)GPDMA_LUTPerAddr[GPDMAChannelConfig->DstConn];
+		break;
+	// Do not support any more transfer type, return ERROR
+	default:
+		return ERROR;
+	}
+
+	pDMAch->DMACCControl = ctrl \
+			| GPDMA_DMACCxControl_TransferSize(GPDMAChannelConfig->TransferSize) \
+			| GPDMA_DMACCxControl_I;
+
+	/* Enable DMA channels, little endian */
+	LPC_GPDMA->DMACConfig = GPDMA_DMACConfig_E;
+	while (!(LPC_GPDMA->DMACConfig & GPDMA_DMACConfig_E));
+
+	// Configure DMA Channel, enable Error Counter and Terminate counter
+	pDMAch->DMACCConfig = GPDMA_MakeConfig(GPDMAChannelConfig);
+
+	return SUCCESS;
+}
+
+/********************************************************************//**
+ * @brief 		Setup GPDMA channel to run a Linked List chain built by
+ * 				GPDMA_BuildLLI(), the channel registers are loaded from
+ * 				the first item
+ * @param[in]	GPDMAChannelConfig Pointer to a GPDMA_Channel_CFG_Type
+ * 				structure, only ChannelNum, TransferType, SrcConn and
+ * 				DstConn are used
+ * @param[in]	pLLI	First item of the chain
+ * @return		ERROR: if selected channel is enabled before
+ * 				SUCCESS: if channel is configured successfully
+ *********************************************************************/
+Status GPDMA_SetupLLI(GPDMA_Channel_CFG_Type *GPDMAChannelConfig, GPDMA_LLI_Type *pLLI)
+{
+	LPC_GPDMACH_TypeDef *pDMAch;
+
+	CHECK_PARAM(PARAM_GPDMA_CHANNEL(GPDMAChannelConfig->ChannelNum));
+	CHECK_PARAM(PARAM_GPDMA_TRANSFERTYPE(GPDMAChannelConfig->TransferType));
+
+	if (LPC_GPDMA->DMACEnbldChns & (GPDMA_DMACEnbldChns_Ch(GPDMAChannelConfig->ChannelNum)))
+	{
+		return ERROR;
+	}
+
+	pDMAch = pGPDMACh[GPDMAChannelConfig->ChannelNum];
+
+	LPC_GPDMA->DMACIntTCClear = GPDMA_DMACIntTCClear_Ch(GPDMAChannelConfig->ChannelNum);
+	LPC_GPDMA->DMACIntErrClr = GPDMA_DMACIntErrClr_Ch(GPDMAChannelConfig->ChannelNum);
+
+	pDMAch->DMACCConfig = 0x00;
+	pDMAch->DMACCSrcAddr = pLLI->SrcAddr;
+	pDMAch->DMACCDestAddr = pLLI->DstAddr;
+	pDMAch->DMACCLLI = pLLI->NextLLI & GPDMA_DMACCxLLI_BITMASK;
+	pDMAch->DMACCControl = pLLI->Control;
+
+	LPC_GPDMA->DMACConfig = GPDMA_DMACConfig_E;
+	while (!(LPC_GPDMA->DMACConfig & GPDMA_DMACConfig_E));
+
+	pDMAch->DMACCConfig = GPDMA_MakeConfig(GPDMAChannelConfig);
+
+	return SUCCESS;
+}
+
+/*********************************************************************//**
+ * @brief		Enable/Disable DMA channel
+ * @param[in]	channelNum	GPDMA channel, should be in range from 0 to 7
+ * @param[in]	NewState	New State of this command, should be:
+ * 					- ENABLE.
+ * 					- DISABLE.
+ * @return		None
+ **********************************************************************/
+void GPDMA_ChannelCmd(uint8_t channelNum, FunctionalState NewState)
+{
+	LPC_GPDMACH_TypeDef *pDMAch;
+
+	CHECK_PARAM(PARAM_GPDMA_CHANNEL(channelNum));
+	CHECK_PARAM(PARAM_FUNCTIONALSTATE(NewState));
+
+	// Get Channel pointer
+	pDMAch = pGPDMACh[channelNum];
+
+	if (NewState == ENABLE)
+	{
+		pDMAch->DMACCConfig |= GPDMA_DMACCxConfig_E;
+	}
+	else
+	{
+		pDMAch->DMACCConfig &= (~GPDMA_DMACCxConfig_E) & GPDMA_DMACCxConfig_BITMASK;
+	}
+}
+
+/*********************************************************************//**
+ * @brief		Allocate a free DMA channel
+ * @param[in]	Priority	Search order, should be:
+ * 					- GPDMA_PRIO_HIGH: lowest free channel number
+ * 					- GPDMA_PRIO_LOW: highest free channel number
+ * @return		Channel number (0..7), or (-1) if all channels are in use
+ * Note: 		Safe to call from interrupt context
+ **********************************************************************/
+int32_t GPDMA_ChannelAlloc(uint32_t Priority)
+{
+	uint32_t primask, i, ch;
+	int32_t ret = -1;
+
+	CHECK_PARAM(PARAM_GPDMA_PRIO(Priority));
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	for (i = 0; i < GPDMA_NUM_CHANNELS; i++)
+	{
+		ch = (Priority == GPDMA_PRIO_HIGH) ? i : (GPDMA_NUM_CHANNELS - 1 - i);
+		if (!(GPDMA_ChannelUsed & _BIT(ch)))
+		{
+			GPDMA_ChannelUsed |= _BIT(ch);
+			GPDMA_Callback[ch] = NULL;
+			ret = (int32_t)ch;
+			break;
+		}
+	}
+	__set_PRIMASK(primask);
+
+	return ret;
+}
+
+/*********************************************************************//**
+ * @brief		Stop a DMA channel and return it to the allocator
+ * @param[in]	channelNum	GPDMA channel, should be in range from 0 to 7
+ * @return		None
+ **********************************************************************/
+void GPDMA_ChannelFree(uint8_t channelNum)
+{
+	uint32_t primask;
+
+	CHECK_PARAM(PARAM_GPDMA_CHANNEL(channelNum));
+
+	GPDMA_ChannelCmd(channelNum, DISABLE);
+	LPC_GPDMA->DMACIntTCClear = GPDMA_DMACIntTCClear_Ch(channelNum);
+	LPC_GPDMA->DMACIntErrClr = GPDMA_DMACIntErrClr_Ch(channelNum);
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	GPDMA_Callback[channelNum] = NULL;
+	GPDMA_ChannelUsed &= ~_BIT(channelNum);
+	__set_PRIMASK(primask);
+}
+
+/*********************************************************************//**
+ * @brief		Register the completion/error callback of a channel
+ * @param[in]	channelNum	GPDMA channel, should be in range from 0 to 7
+ * @param[in]	Callback	Function called from DMA_IRQHandler, or NULL
+ * @return		None
+ **********************************************************************/
+void GPDMA_SetCallback(uint8_t channelNum, GPDMA_Callback_Type Callback)
+{
+	CHECK_PARAM(PARAM_GPDMA_CHANNEL(channelNum));
+
+	GPDMA_Callback[channelNum] = Callback;
+}
+
+/*********************************************************************//**
+ * @brief		Check if corresponding channel does have an active interrupt
+ * 				request or not
+ * @param[in]	type		type of status, should be:
+ * 					- GPDMA_STAT_INT: 		GPDMA Interrupt Status
+ * 					- GPDMA_STAT_INTTC: 	GPDMA Interrupt Terminal Count Request Status
+ * 					- GPDMA_STAT_INTERR:	GPDMA Interrupt Error Status
+ * 					- GPDMA_STAT_RAWINTTC:	GPDMA Raw Interrupt Terminal Count Status
+ * 					- GPDMA_STAT_RAWINTERR:	GPDMA Raw Error Interrupt Status
+ * 					- GPDMA_STAT_ENABLED_CH:GPDMA Enabled Channel Status
+ * @param[in]	channel		GPDMA channel, should be in range from 0 to 7
+ * @return		IntStatus	status of DMA channel interrupt after masking
+ * 				Should be:
+ * 					- SET: the corresponding channel does have an active interrupt request
+ * 					- RESET: the corresponding channel has no active interrupt request
+ **********************************************************************/
+IntStatus GPDMA_IntGetStatus(GPDMA_Status_Type type, uint8_t channel)
+{
+	CHECK_PARAM(PARAM_GPDMA_STAT(type));
+	CHECK_PARAM(PARAM_GPDMA_CHANNEL(channel));
+
+	switch (type)
+	{
+	case GPDMA_STAT_INT: //check status of DMA channel interrupts
+		if (LPC_GPDMA->DMACIntStat & (GPDMA_DMACIntStat_Ch(channel)))
+			return SET;
+		return RESET;
+	case GPDMA_STAT_INTTC: // check terminal count interrupt request status for DMA
+		if (LPC_GPDMA->DMACIntTCStat & GPDMA_DMACIntTCStat_Ch(channel))
+			return SET;
+		return RESET;
+	case GPDMA_STAT_INTERR: //check interrupt status for DMA channels
+		if (LPC_GPDMA->DMACIntErrStat & GPDMA_DMACIntTCClear_Ch(channel))
+			return SET;
+		return RESET;
+	case GPDMA_STAT_RAWINTTC: //check status of the terminal count interrupt for DMA channels
+		if (LPC_GPDMA->DMACRawIntTCStat & GPDMA_DMACIntTCStat_Ch(channel))
+			return SET;
+		return RESET;
+	case GPDMA_STAT_RAWINTERR: //check status of the error interrupt for DMA channels
+		if (LPC_GPDMA->DMACRawIntErrStat & GPDMA_DMACIntErrStat_Ch(channel))
+			return SET;
+		return RESET;
+	default: //check enable status for DMA channels
+		if (LPC_GPDMA->DMACEnbldChns & GPDMA_DMACEnbldChns_Ch(channel))
+			return SET;
+		return RESET;
+	}
+}
+
+/*********************************************************************//**
+ * @brief		Clear one or more interrupt requests on DMA channels
+ * @param[in]	type		type of interrupt request, should be:
+ * 					- GPDMA_STATCLR_INTTC: 	GPDMA Interrupt Terminal Count Request Clear
+ * 					- GPDMA_STATCLR_INTERR: GPDMA Interrupt Error Clear
+ * @param[in]	channel		GPDMA channel, should be in range from 0 to 7
+ * @return		None
+ **********************************************************************/
+void GPDMA_ClearIntPending(GPDMA_StateClear_Type type, uint8_t channel)
+{
+	CHECK_PARAM(PARAM_GPDMA_STATCLR(type));
+	CHECK_PARAM(PARAM_GPDMA_CHANNEL(channel));
+
+	if (type == GPDMA_STATCLR_INTTC) // clears the terminal count interrupt request on DMA channel
+		LPC_GPDMA->DMACIntTCClear = GPDMA_DMACIntTCClear_Ch(channel);
+	else // clear the error interrupt request
+		LPC_GPDMA->DMACIntErrClr = GPDMA_DMACIntErrClr_Ch(channel);
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+/* --------------------------------- End Of File ------------------------------ */
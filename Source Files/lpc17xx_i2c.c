@@ -13,6 +13,7 @@
 
 /* Includes ------------------------------------------------------------------- */
 #include "lpc17xx_i2c.h"
+#include "lpc_swtimer.h"
 
 
 /* If this source file built with example, the LPC17xx FW library configuration
@@ -34,6 +35,22 @@ typedef struct
   int32_t		dir;								/* Current direction phase, 0 - write, 1 - read */
 } I2C_CFG_T;
 
+/** @brief Job queue and transfer state of one I2C peripheral */
+typedef struct {
+	LPC_I2C_TypeDef *I2Cx;		/**< I2C peripheral */
+	IRQn_Type IRQn;				/**< I2C interrupt */
+	uint8_t SdaPin;				/**< SDA on port 0, for bus recovery */
+	uint8_t SclPin;				/**< SCL on port 0, for bus recovery */
+	uint8_t Funcnum;			/**< PINSEL function of SDA and SCL */
+	I2C_JOB_Type * __IO head;	/**< Active job, NULL when idle */
+	I2C_JOB_Type *tail;			/**< Last queued job */
+	uint8_t dir;				/**< Phase of the active job, 0 - write, 1 - read */
+	uint8_t tries;				/**< Restarts of the active job */
+	uint8_t failed;				/**< Status of a job waiting for bus recovery, 0 if none */
+	SWTIMER_Type timer;			/**< Timeout of the active job, then bus recovery */
+	__IO Bool polled;			/**< A polled transfer owns the bus */
+} I2C_ENGINE_Type;
+
 /**
  * @}
  */
@@ -49,6 +66,19 @@ static uint32_t I2C_SlaveComplete[3];
 
 static uint32_t I2C_MonitorBufferIndex;
 
+/**
+ * @brief Job queues of I2C0 (P0.27/P0.28), I2C1 (P0.19/P0.20) and
+ * I2C2 (P0.10/P0.11)
+ */
+static I2C_ENGINE_Type i2c_engine[3] = {
+	{ LPC_I2C0, I2C0_IRQn, 27, 28, 1 },
+	{ LPC_I2C1, I2C1_IRQn, 19, 20, 3 },
+	{ LPC_I2C2, I2C2_IRQn, 10, 11, 2 },
+};
+
+/** Jobs carrying interrupt mode I2C_MasterTransferData() requests */
+static I2C_JOB_Type i2c_xfer_job[3];
+
 /* Private Functions ---------------------------------------------------------- */
 
 /* Get I2C number */
@@ -69,6 +99,11 @@ static uint32_t I2C_GetByte (LPC_I2C_TypeDef *I2Cx, uint8_t *retdat, Bool ack);
 /* I2C set clock (hz) */
 static void I2C_SetClock (LPC_I2C_TypeDef *I2Cx, uint32_t target_clock);
 
+/* Job queue engine */
+static void i2c_job_start (I2C_ENGINE_Type *eng);
+static void i2c_job_finish (I2C_ENGINE_Type *eng, uint32_t status);
+static void i2c_job_retire (I2C_ENGINE_Type *eng, uint32_t status);
+
 /*--------------------------------------------------------------------------------*/
 /********************************************************************//**
  * @brief		Convert from I2C peripheral to number
@@ -216,9 +251,382 @@ static void I2C_SetClock (LPC_I2C_TypeDef *I2Cx, uint32_t target_clock)
 	I2Cx->I2SCLH = (uint32_t)(temp / 2);
 	I2Cx->I2SCLL = (uint32_t)(temp - I2Cx->I2SCLH);
 }
+
+
+/*********************************************************************//**
+ * @brief		Busy wait about half an SCL period at 100kHz
+ * @param[in]	None
+ * @return 		None
+ **********************************************************************/
+static void i2c_recovery_delay (void)
+{
+	__IO uint32_t i;
+
+	for (i = 125; i > 0; i--);
+}
+
+
+/*********************************************************************//**
+ * @brief		Free a bus whose SDA is held low by a slave that lost
+ * 				track of the transfer, then leave it idle with a STOP
+ * @param[in]	eng		Engine of the bus
+ * @return 		None
+ *
+ * Note: SCL is clocked by hand up to I2C_RECOVERY_CLOCKS times until
+ * the slave releases SDA, as in the I2C specification (section 3.1.16).
+ **********************************************************************/
+static void i2c_bus_recover (I2C_ENGINE_Type *eng)
+{
+	PINSEL_CFG_Type PinCfg;
+	uint32_t sda = _BIT(eng->SdaPin);
+	uint32_t scl = _BIT(eng->SclPin);
+	uint32_t i;
+
+	eng->I2Cx->I2CONCLR = I2C_I2CONCLR_I2ENC | I2C_I2CONCLR_STAC \
+						| I2C_I2CONCLR_SIC | I2C_I2CONCLR_AAC;
+
+	// Both lines as open drain GPIO, released
+	GPIO_SetValue(0, sda | scl);
+	GPIO_SetDir(0, sda | scl, 1);
+	PinCfg.Portnum = 0;
+	PinCfg.Pinmode = 0;
+	PinCfg.OpenDrain = PINSEL_PINMODE_OPENDRAIN;
+	PinCfg.Funcnum = 0;
+	PinCfg.Pinnum = eng->SdaPin;
+	PINSEL_ConfigPin(&PinCfg);
+	PinCfg.Pinnum = eng->SclPin;
+	PINSEL_ConfigPin(&PinCfg);
+
+	for (i = 0; (i < I2C_RECOVERY_CLOCKS) && !(GPIO_ReadValue(0) & sda); i++)
+	{
+		GPIO_ClearValue(0, scl);
+		i2c_recovery_delay();
+		GPIO_SetValue(0, scl);
+		i2c_recovery_delay();
+	}
+
+	// STOP: SDA rises while SCL is high
+	GPIO_ClearValue(0, scl);
+	i2c_recovery_delay();
+	GPIO_ClearValue(0, sda);
+	i2c_recovery_delay();
+	GPIO_SetValue(0, scl);
+	i2c_recovery_delay();
+	GPIO_SetValue(0, sda);
+	i2c_recovery_delay();
+
+	PinCfg.Funcnum = eng->Funcnum;
+	PinCfg.Pinnum = eng->SdaPin;
+	PINSEL_ConfigPin(&PinCfg);
+	PinCfg.Pinnum = eng->SclPin;
+	PINSEL_ConfigPin(&PinCfg);
+
+	eng->I2Cx->I2CONSET = I2C_I2CONSET_I2EN;
+}
+
+
+/*********************************************************************//**
+ * @brief		Start the job at the head of the queue with a START
+ * @param[in]	eng		Engine with a queued head job
+ * @return 		None
+ **********************************************************************/
+static void i2c_job_start (I2C_ENGINE_Type *eng)
+{
+	I2C_JOB_Type *job = eng->head;
+
+	job->status = I2C_JOB_ACTIVE;
+	job->tx_count = 0;
+	job->rx_count = 0;
+	job->Code = 0;
+	eng->dir = 0;
+	eng->tries = 0;
+	SWTIMER_Start(&eng->timer, (job->Timeout != 0) ? job->Timeout : I2C_JOB_TIMEOUT, 0);
+
+	eng->I2Cx->I2CONSET = I2C_I2CONSET_STA;
+	NVIC_EnableIRQ(eng->IRQn);
+}
+
+
+/*********************************************************************//**
+ * @brief		Send a (repeated) START for the active job again, or give
+ * 				up when its restarts are used
+ * @param[in]	eng		Engine with an active job
+ * @param[in]	status	Job status when giving up
+ * @return 		None
+ **********************************************************************/
+static void i2c_job_restart (I2C_ENGINE_Type *eng, uint32_t status)
+{
+	I2C_JOB_Type *job = eng->head;
+	LPC_I2C_TypeDef *I2Cx = eng->I2Cx;
+
+	if (eng->tries < ((job->Retries != 0) ? job->Retries : I2C_JOB_RETRIES))
+	{
+		eng->tries++;
+		eng->dir = 0;
+		job->tx_count = 0;
+		job->rx_count = 0;
+		// After an arbitration loss the START waits for the bus to be free
+		I2Cx->I2CONSET = I2C_I2CONSET_STA;
+		I2Cx->I2CONCLR = I2C_I2CONCLR_AAC | I2C_I2CONCLR_SIC;
+	}
+	else
+	{
+		i2c_job_finish(eng, status);
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief		End the active job with a STOP and start the next one
+ * @param[in]	eng		Engine with an active job
+ * @param[in]	status	I2C_JOB_DONE, I2C_JOB_NACK or I2C_JOB_ERROR
+ * @return 		None
+ *
+ * Note: after a lost arbitration or a bus error the bus must be clocked
+ * free, which busy-waits. The peripheral is stopped and the recovery
+ * is left to i2c_job_timeout(), out of the I2C interrupt; the job ends
+ * there.
+ **********************************************************************/
+static void i2c_job_finish (I2C_ENGINE_Type *eng, uint32_t status)
+{
+	LPC_I2C_TypeDef *I2Cx = eng->I2Cx;
+
+	if (status == I2C_JOB_ERROR)
+	{
+		I2Cx->I2CONCLR = I2C_I2CONCLR_I2ENC | I2C_I2CONCLR_STAC \
+						| I2C_I2CONCLR_SIC | I2C_I2CONCLR_AAC;
+		NVIC_DisableIRQ(eng->IRQn);
+		eng->failed = (uint8_t)status;
+		SWTIMER_Start(&eng->timer, 1, 0);
+		return;
+	}
+
+	SWTIMER_Stop(&eng->timer);
+	I2Cx->I2CONCLR = I2C_I2CONCLR_STAC | I2C_I2CONCLR_AAC;
+	I2Cx->I2CONSET = I2C_I2CONSET_STO;
+	I2Cx->I2CONCLR = I2C_I2CONCLR_SIC;
+
+	i2c_job_retire(eng, status);
+}
+
+
+/*********************************************************************//**
+ * @brief		Remove the active job from the queue, run its callback and
+ * 				start the next one
+ * @param[in]	eng		Engine with an active job, its bus left idle
+ * @param[in]	status	Final I2C_JOB_x status
+ * @return 		None
+ *
+ * Note: I2C_JobSubmit() may preempt this from any interrupt when it runs
+ * from i2c_job_timeout(), so the queue is only changed with interrupts
+ * masked, as there. The callback runs with them enabled.
+ **********************************************************************/
+static void i2c_job_retire (I2C_ENGINE_Type *eng, uint32_t status)
+{
+	I2C_JOB_Type *job;
+	uint32_t primask;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	job = eng->head;
+	eng->head = job->next;
+	if (eng->head == NULL)
+	{
+		eng->tail = NULL;
+		NVIC_DisableIRQ(eng->IRQn);
+	}
+	job->next = NULL;
+	job->status = status;
+	__set_PRIMASK(primask);
+
+	if (job->Callback != NULL)
+	{
+		job->Callback(job);
+	}
+
+	// The callback may have submitted to an idle bus, which started it already
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if ((eng->head != NULL) && (eng->head->status == I2C_JOB_QUEUED) && !eng->polled)
+	{
+		i2c_job_start(eng);
+	}
+	__set_PRIMASK(primask);
+}
+
+
+/*********************************************************************//**
+ * @brief		Timer callback of an engine: fail the active job when its
+ * 				Timeout ran out, or finish one i2c_job_finish() gave up
+ * 				on, after clocking the bus free
+ * @param[in]	arg		Engine, see I2C_ENGINE_Type
+ * @return 		None
+ *
+ * Note: runs in the SWTIMER dispatch context (PendSV at the lowest
+ * priority, or the main loop), so the busy-waiting i2c_bus_recover()
+ * holds up no interrupt.
+ **********************************************************************/
+static void i2c_job_timeout (void *arg)
+{
+	I2C_ENGINE_Type *eng = (I2C_ENGINE_Type *)arg;
+	uint32_t status;
+
+	NVIC_DisableIRQ(eng->IRQn);
+	// A timer restarted for the next job after this expiry was taken
+	if ((eng->head != NULL) && (eng->head->status == I2C_JOB_ACTIVE) \
+			&& !SWTIMER_IsRunning(&eng->timer))
+	{
+		status = (eng->failed != 0) ? eng->failed : I2C_JOB_TIMEOUT_ERR;
+		eng->failed = 0;
+		i2c_bus_recover(eng);
+		i2c_job_retire(eng, status);
+	}
+	if ((eng->head != NULL) && !eng->polled)
+	{
+		NVIC_EnableIRQ(eng->IRQn);
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief		Take a bus for a polled transfer once its queue is empty,
+ * 				jobs submitted meanwhile wait for i2c_poll_unlock()
+ * @param[in]	eng		Engine of the bus
+ * @return 		None
+ **********************************************************************/
+static void i2c_poll_lock (I2C_ENGINE_Type *eng)
+{
+	uint32_t primask;
+	Bool idle;
+
+	do
+	{
+		primask = __get_PRIMASK();
+		__disable_irq();
+		idle = (eng->head == NULL) ? TRUE : FALSE;
+		if (idle)
+		{
+			eng->polled = TRUE;
+		}
+		__set_PRIMASK(primask);
+	} while (!idle);
+}
+
+
+/*********************************************************************//**
+ * @brief		Hand a bus back to its queue after a polled transfer
+ * @param[in]	eng		Engine of the bus
+ * @return 		None
+ **********************************************************************/
+static void i2c_poll_unlock (I2C_ENGINE_Type *eng)
+{
+	uint32_t primask;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	eng->polled = FALSE;
+	if (eng->head != NULL)
+	{
+		i2c_job_start(eng);
+	}
+	__set_PRIMASK(primask);
+}
+
+
+/*********************************************************************//**
+ * @brief		Report an interrupt mode I2C_MasterTransferData() request
+ * 				through its I2C_M_SETUP_Type, as the old handler did
+ * @param[in]	job		Finished i2c_xfer_job[] entry
+ * @return 		None
+ **********************************************************************/
+static void i2c_xfer_done (I2C_JOB_Type *job)
+{
+	I2C_M_SETUP_Type *cfg = (I2C_M_SETUP_Type *)job->Arg;
+
+	cfg->tx_count = job->tx_count;
+	cfg->rx_count = job->rx_count;
+	cfg->status = job->Code;
+	if (job->status == I2C_JOB_DONE)
+	{
+		cfg->status |= I2C_SETUP_STATUS_DONE;
+	}
+	else if (job->status == I2C_JOB_NACK)
+	{
+		cfg->status |= I2C_SETUP_STATUS_NOACKF;
+	}
+	else if (job->Code == I2C_I2STAT_M_TX_ARB_LOST)
+	{
+		cfg->status |= I2C_SETUP_STATUS_ARBF;
+	}
+
+	I2C_MasterComplete[job - i2c_xfer_job] = TRUE;
+	if (cfg->callback != NULL)
+	{
+		cfg->callback();
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief		Dispatch an I2C interrupt to the master job queue or to a
+ * 				slave transfer set up by I2C_SlaveTransferData()
+ * @param[in]	num		I2C number, 0..2
+ * @return 		None
+ **********************************************************************/
+static void i2c_irq (uint8_t num)
+{
+	LPC_I2C_TypeDef *I2Cx = i2c_engine[num].I2Cx;
+
+	if (i2c_engine[num].head != NULL)
+	{
+		I2C_MasterHandler(I2Cx);
+	}
+	else if (i2cdat[num].txrx_setup != 0)
+	{
+		I2C_SlaveHandler(I2Cx);
+	}
+	else
+	{
+		I2Cx->I2CONCLR = I2C_I2CONCLR_SIC;
+	}
+}
 /* End of Private Functions --------------------------------------------------- */
 
 
+/*----------------- INTERRUPT SERVICE ROUTINES --------------------------*/
+/*********************************************************************//**
+ * @brief		I2C0 interrupt handler, services the I2C0 job queue
+ * @param[in]	None
+ * @return 		None
+ **********************************************************************/
+void I2C0_IRQHandler (void)
+{
+	i2c_irq(0);
+}
+
+
+/*********************************************************************//**
+ * @brief		I2C1 interrupt handler, services the I2C1 job queue
+ * @param[in]	None
+ * @return 		None
+ **********************************************************************/
+void I2C1_IRQHandler (void)
+{
+	i2c_irq(1);
+}
+
+
+/*********************************************************************//**
+ * @brief		I2C2 interrupt handler, services the I2C2 job queue
+ * @param[in]	None
+ * @return 		None
+ **********************************************************************/
+void I2C2_IRQHandler (void)
+{
+	i2c_irq(2);
+}
+
+
 /* Public Functions ----------------------------------------------------------- */
 /** @addtogroup I2C_Public_Functions
  * @{
@@ -298,6 +706,8 @@ void I2C_Config (LPC_I2C_TypeDef *I2Cx)
  *********************************************************************/
 void I2C_Init(LPC_I2C_TypeDef *I2Cx, uint32_t clockrate)
 {
+	I2C_ENGINE_Type *eng;
+
 	CHECK_PARAM(PARAM_I2Cx(I2Cx));
 
 	if (I2Cx==LPC_I2C0)
@@ -333,6 +743,13 @@ void I2C_Init(LPC_I2C_TypeDef *I2Cx, uint32_t clockrate)
     I2C_SetClock(I2Cx, clockrate);
     /* Set I2C operation to default */
     I2Cx->I2CONCLR = (I2C_I2CONCLR_AAC | I2C_I2CONCLR_STAC | I2C_I2CONCLR_I2ENC);
+
+    /* Job timeouts run on the software timer wheel */
+    eng = &i2c_engine[I2C_getNum(I2Cx)];
+    if (!SWTIMER_IsRunning(&eng->timer))
+    {
+        SWTIMER_Init(&eng->timer, i2c_job_timeout, eng);
+    }
 }
 
 /*********************************************************************//**
@@ -441,7 +858,8 @@ void I2C_IntCmd (LPC_I2C_TypeDef *I2Cx, Bool NewState)
 
 
 /*********************************************************************//**
- * @brief 		General Master Interrupt handler for I2C peripheral
+ * @brief 		General Master Interrupt handler for I2C peripheral, runs
+ * 				the active job of the bus one state at a time
  * @param[in]	I2Cx	I2C peripheral selected, should be:
  * 				- LPC_I2C
  * 				- LPC_I2C1
@@ -450,219 +868,118 @@ void I2C_IntCmd (LPC_I2C_TypeDef *I2Cx, Bool NewState)
  **********************************************************************/
 void I2C_MasterHandler (LPC_I2C_TypeDef  *I2Cx)
 {
-	int32_t tmp;
+	I2C_ENGINE_Type *eng;
+	I2C_JOB_Type *job;
 	uint8_t returnCode;
-	I2C_M_SETUP_Type *txrx_setup;
 
-	tmp = I2C_getNum(I2Cx);
-	txrx_setup = (I2C_M_SETUP_Type *) i2cdat[tmp].txrx_setup;
+	eng = &i2c_engine[I2C_getNum(I2Cx)];
+	job = eng->head;
 
 	returnCode = (I2Cx->I2STAT & I2C_STAT_CODE_BITMASK);
-	// Save current status
-	txrx_setup->status = returnCode;
 	// there's no relevant information
 	if (returnCode == I2C_I2STAT_NO_INF)
+	{
+		return;
+	}
+	if ((job == NULL) || (job->status != I2C_JOB_ACTIVE))
 	{
 		I2Cx->I2CONCLR = I2C_I2CONCLR_SIC;
 		return;
 	}
+	// Save current status
+	job->Code = returnCode;
 
-	/* ----------------------------- TRANSMIT PHASE --------------------------*/
-	if (i2cdat[tmp].dir == 0)
+	switch (returnCode)
 	{
-		switch (returnCode)
+	/* A start/repeat start condition has been transmitted -------------------*/
+	case I2C_I2STAT_M_TX_START:
+	case I2C_I2STAT_M_TX_RESTART:
+		I2Cx->I2CONCLR = I2C_I2CONCLR_STAC;
+		// SLA+W, also for an address probe without data
+		if ((eng->dir == 0) && ((job->tx_length != 0) || (job->rx_length == 0)))
 		{
-		/* A start/repeat start condition has been transmitted -------------------*/
-		case I2C_I2STAT_M_TX_START:
-		case I2C_I2STAT_M_TX_RESTART:
-			I2Cx->I2CONCLR = I2C_I2CONCLR_STAC;
-			/*
-			 * If there's any transmit data, then start to
-			 * send SLA+W right now, otherwise check whether if there's
-			 * any receive data for next state.
-			 */
-			if ((txrx_setup->tx_data != NULL) && (txrx_setup->tx_length != 0))
-			{
-				I2Cx->I2DAT = (txrx_setup->sl_addr7bit << 1);
-				I2Cx->I2CONCLR = I2C_I2CONCLR_SIC;
-			}
-			else
-			{
-				goto next_stage;
-			}
-			break;
-
-		/* SLA+W has been transmitted, ACK has been received ----------------------*/
-		case I2C_I2STAT_M_TX_SLAW_ACK:
-		/* Data has been transmitted, ACK has been received */
-		case I2C_I2STAT_M_TX_DAT_ACK:
-			/* Send more data */
-			if ((txrx_setup->tx_count < txrx_setup->tx_length) && (txrx_setup->tx_data != NULL))
-			{
-				I2Cx->I2DAT =  *(uint8_t *)(txrx_setup->tx_data + txrx_setup->tx_count);
-				txrx_setup->tx_count++;
-				I2Cx->I2CONCLR = I2C_I2CONCLR_SIC;
-			}
-			// no more data, switch to next stage
-			else
-			{
-next_stage:
-				// change direction
-				i2cdat[tmp].dir = 1;
-				// Check if any data to receive
-				if ((txrx_setup->rx_length != 0) && (txrx_setup->rx_data != NULL))
-				{
-					// check whether if we need to issue an repeat start
-					if ((txrx_setup->tx_length != 0) && (txrx_setup->tx_data != NULL))
-					{
-						// Send out an repeat start command
-						I2Cx->I2CONSET = I2C_I2CONSET_STA;
-						I2Cx->I2CONCLR = I2C_I2CONCLR_AAC | I2C_I2CONCLR_SIC;
-					}
-					// Don't need issue an repeat start, just goto send SLA+R
-					else
-					{
-						goto send_slar;
-					}
-				}
-				// no more data send, the go to end stage now
-				else
-				{
-					// success, goto end stage
-					txrx_setup->status |= I2C_SETUP_STATUS_DONE;
-					goto end_stage;
-				}
-			}
-			break;
-
-		/* SLA+W has been transmitted, NACK has been received ----------------------*/
-		case I2C_I2STAT_M_TX_SLAW_NACK:
-		/* Data has been transmitted, NACK has been received -----------------------*/
-		case I2C_I2STAT_M_TX_DAT_NACK:
-			// update status
-			txrx_setup->status |= I2C_SETUP_STATUS_NOACKF;
-			goto retry;
-		/* Arbitration lost in SLA+R/W or Data bytes -------------------------------*/
-		case I2C_I2STAT_M_TX_ARB_LOST:
-			// update status
-			txrx_setup->status |= I2C_SETUP_STATUS_ARBF;
-		default:
-			goto retry;
+			I2Cx->I2DAT = (job->sl_addr7bit << 1);
 		}
-	}
-
-	/* ----------------------------- RECEIVE PHASE --------------------------*/
-	else if (i2cdat[tmp].dir == 1)
-	{
-		switch (returnCode)
+		else
 		{
-			/* A start/repeat start condition has been transmitted ---------------------*/
-		case I2C_I2STAT_M_RX_START:
-		case I2C_I2STAT_M_RX_RESTART:
-			I2Cx->I2CONCLR = I2C_I2CONCLR_STAC;
-			/*
-			 * If there's any receive data, then start to
-			 * send SLA+R right now, otherwise check whether if there's
-			 * any receive data for end of state.
-			 */
-			if ((txrx_setup->rx_data != NULL) && (txrx_setup->rx_length != 0))
-			{
-send_slar:
-				I2Cx->I2DAT = (txrx_setup->sl_addr7bit << 1) | 0x01;
-				I2Cx->I2CONCLR = I2C_I2CONCLR_SIC;
-			}
-			else
-			{
-				// Success, goto end stage
-				txrx_setup->status |= I2C_SETUP_STATUS_DONE;
-				goto end_stage;
-			}
-			break;
+			eng->dir = 1;
+			I2Cx->I2DAT = (job->sl_addr7bit << 1) | 0x01;
+		}
+		I2Cx->I2CONCLR = I2C_I2CONCLR_SIC;
+		break;
 
-		/* SLA+R has been transmitted, ACK has been received -----------------*/
-		case I2C_I2STAT_M_RX_SLAR_ACK:
-			if (txrx_setup->rx_count < (txrx_setup->rx_length - 1))
-			{
-				/*Data will be received,  ACK will be return*/
-				I2Cx->I2CONSET = I2C_I2CONSET_AA;
-			}
-			else
-			{
-				/*Last data will be received,  NACK will be return*/
-				I2Cx->I2CONCLR = I2C_I2CONSET_AA;
-			}
+	/* SLA+W or data has been transmitted, ACK has been received --------------*/
+	case I2C_I2STAT_M_TX_SLAW_ACK:
+	case I2C_I2STAT_M_TX_DAT_ACK:
+		if (job->tx_count < job->tx_length)
+		{
+			I2Cx->I2DAT = job->tx_data[job->tx_count++];
 			I2Cx->I2CONCLR = I2C_I2CONCLR_SIC;
-			break;
+		}
+		else if (job->rx_length != 0)
+		{
+			// Repeated start for the read phase
+			eng->dir = 1;
+			I2Cx->I2CONSET = I2C_I2CONSET_STA;
+			I2Cx->I2CONCLR = I2C_I2CONCLR_SIC;
+		}
+		else
+		{
+			i2c_job_finish(eng, I2C_JOB_DONE);
+		}
+		break;
 
-		/* Data has been received, ACK has been returned ----------------------*/
-		case I2C_I2STAT_M_RX_DAT_ACK:
-			// Note save data and increase counter first, then check later
-			/* Save data  */
-			if ((txrx_setup->rx_data != NULL) && (txrx_setup->rx_count < txrx_setup->rx_length))
-			{
-				*(uint8_t *)(txrx_setup->rx_data + txrx_setup->rx_count) = (I2Cx->I2DAT & I2C_I2DAT_BITMASK);
-				txrx_setup->rx_count++;
-			}
-			if (txrx_setup->rx_count < (txrx_setup->rx_length - 1))
-			{
-				/*Data will be received,  ACK will be return*/
-				I2Cx->I2CONSET = I2C_I2CONSET_AA;
-			}
-			else
-			{
-				/*Last data will be received,  NACK will be return*/
-				I2Cx->I2CONCLR = I2C_I2CONSET_AA;
-			}
+	/* SLA+W, data or SLA+R has been transmitted, NACK has been received -----*/
+	case I2C_I2STAT_M_TX_SLAW_NACK:
+	case I2C_I2STAT_M_TX_DAT_NACK:
+	case I2C_I2STAT_M_RX_SLAR_NACK:
+		i2c_job_restart(eng, I2C_JOB_NACK);
+		break;
 
-			I2Cx->I2CONCLR = I2C_I2CONCLR_SIC;
-			break;
+	/* Arbitration lost in SLA+R/W or Data bytes -----------------------------*/
+	case I2C_I2STAT_M_TX_ARB_LOST:
+		i2c_job_restart(eng, I2C_JOB_ERROR);
+		break;
 
-		/* Data has been received, NACK has been return -------------------------*/
-		case I2C_I2STAT_M_RX_DAT_NACK:
-			/* Save the last data */
-			if ((txrx_setup->rx_data != NULL) && (txrx_setup->rx_count < txrx_setup->rx_length))
-			{
-				*(uint8_t *)(txrx_setup->rx_data + txrx_setup->rx_count) = (I2Cx->I2DAT & I2C_I2DAT_BITMASK);
-				txrx_setup->rx_count++;
-			}
-			// success, go to end stage
-			txrx_setup->status |= I2C_SETUP_STATUS_DONE;
-			goto end_stage;
-
-		/* SLA+R has been transmitted, NACK has been received ------------------*/
-		case I2C_I2STAT_M_RX_SLAR_NACK:
-			// update status
-			txrx_setup->status |= I2C_SETUP_STATUS_NOACKF;
-			goto retry;
-
-		/* Arbitration lost ----------------------------------------------------*/
-		case I2C_I2STAT_M_RX_ARB_LOST:
-			// update status
-			txrx_setup->status |= I2C_SETUP_STATUS_ARBF;
-		default:
-retry:
-			// check if retransmission is available
-			if (txrx_setup->retransmissions_count < txrx_setup->retransmissions_max)
-			{
-				// Clear tx count
-				txrx_setup->tx_count = 0;
-				I2Cx->I2CONSET = I2C_I2CONSET_STA;
-				I2Cx->I2CONCLR = I2C_I2CONCLR_AAC | I2C_I2CONCLR_SIC;
-				txrx_setup->retransmissions_count++;
-			}
-			// End of stage
-			else
-			{
-end_stage:
-				// Disable interrupt
-				I2C_IntCmd(I2Cx, 0);
-				// Send stop
-				I2C_Stop(I2Cx);
+	/* SLA+R has been transmitted, ACK has been received ---------------------*/
+	case I2C_I2STAT_M_RX_SLAR_ACK:
+		if (job->rx_length > 1)
+		{
+			/*Data will be received,  ACK will be return*/
+			I2Cx->I2CONSET = I2C_I2CONSET_AA;
+		}
+		else
+		{
+			/*Last data will be received,  NACK will be return*/
+			I2Cx->I2CONCLR = I2C_I2CONCLR_AAC;
+		}
+		I2Cx->I2CONCLR = I2C_I2CONCLR_SIC;
+		break;
 
-				I2C_MasterComplete[tmp] = TRUE;
-			}
-			break;
+	/* Data has been received, ACK has been returned -------------------------*/
+	case I2C_I2STAT_M_RX_DAT_ACK:
+		job->rx_data[job->rx_count++] = (I2Cx->I2DAT & I2C_I2DAT_BITMASK);
+		if ((job->rx_length - job->rx_count) > 1)
+		{
+			I2Cx->I2CONSET = I2C_I2CONSET_AA;
+		}
+		else
+		{
+			I2Cx->I2CONCLR = I2C_I2CONCLR_AAC;
 		}
+		I2Cx->I2CONCLR = I2C_I2CONCLR_SIC;
+		break;
+
+	/* Data has been received, NACK has been return --------------------------*/
+	case I2C_I2STAT_M_RX_DAT_NACK:
+		job->rx_data[job->rx_count++] = (I2Cx->I2DAT & I2C_I2DAT_BITMASK);
+		i2c_job_finish(eng, I2C_JOB_DONE);
+		break;
+
+	/* Bus error or a slave state, the bus is recovered ----------------------*/
+	default:
+		i2c_job_finish(eng, I2C_JOB_ERROR);
+		break;
 	}
 }
 
@@ -841,6 +1158,9 @@ s_int_end:
  * - In case of using I2C to transmit followed by receive data, transmit length,
  * transmit data pointer, receive length and receive data pointer should be set
  * corresponding.
+ * - A polled transfer waits for the job queue of the bus to drain, jobs
+ * submitted meanwhile start when it returns. An interrupt transfer is
+ * queued as a job, see I2C_JobSubmit().
  **********************************************************************/
 Status I2C_MasterTransferData(LPC_I2C_TypeDef *I2Cx, I2C_M_SETUP_Type *TransferCfg, \
 								I2C_TRANSFER_OPT_Type Opt)
@@ -849,6 +1169,7 @@ Status I2C_MasterTransferData(LPC_I2C_TypeDef *I2Cx, I2C_M_SETUP_Type *TransferC
 	uint8_t *rxdat;
 	uint32_t CodeStatus;
 	uint8_t tmp;
+	I2C_JOB_Type *job;
 
 	// reset all default state
 	txdat = (uint8_t *) TransferCfg->tx_data;
@@ -860,6 +1181,8 @@ Status I2C_MasterTransferData(LPC_I2C_TypeDef *I2Cx, I2C_M_SETUP_Type *TransferC
 
 	if (Opt == I2C_TRANSFER_POLLING)
 	{
+		i2c_poll_lock(&i2c_engine[I2C_getNum(I2Cx)]);
+
 		/* First Start condition -------------------------------------------------------------- */
 		TransferCfg->retransmissions_count = 0;
 retry:
@@ -1027,31 +1350,106 @@ retry:
 
 		/* Send STOP condition ------------------------------------------------- */
 		I2C_Stop(I2Cx);
+		i2c_poll_unlock(&i2c_engine[I2C_getNum(I2Cx)]);
 		return SUCCESS;
 
 error:
 		// Send stop condition
 		I2C_Stop(I2Cx);
+		i2c_poll_unlock(&i2c_engine[I2C_getNum(I2Cx)]);
 		return ERROR;
 	}
 
 	else if (Opt == I2C_TRANSFER_INTERRUPT)
 	{
-		// Setup tx_rx data, callback and interrupt handler
+		// Carry the request in this bus's transfer job
 		tmp = I2C_getNum(I2Cx);
-		i2cdat[tmp].txrx_setup = (uint32_t) TransferCfg;
-		// Set direction phase, write first
-		i2cdat[tmp].dir = 0;
+		job = &i2c_xfer_job[tmp];
+		I2C_MasterComplete[tmp] = FALSE;
+
+		job->sl_addr7bit = TransferCfg->sl_addr7bit;
+		job->tx_data = TransferCfg->tx_data;
+		job->tx_length = (TransferCfg->tx_data != NULL) ? TransferCfg->tx_length : 0;
+		job->rx_data = TransferCfg->rx_data;
+		job->rx_length = (TransferCfg->rx_data != NULL) ? TransferCfg->rx_length : 0;
+		job->Retries = (TransferCfg->retransmissions_max > 255) ? 255 : TransferCfg->retransmissions_max;
+		job->Timeout = 0;
+		job->Callback = i2c_xfer_done;
+		job->Arg = TransferCfg;
+
+		return I2C_JobSubmit(I2Cx, job);
+	}
 
-		/* First Start condition -------------------------------------------------------------- */
-		I2Cx->I2CONCLR = I2C_I2CONCLR_SIC;
-		I2Cx->I2CONSET = I2C_I2CONSET_STA;
-		I2C_IntCmd(I2Cx, 1);
+	return ERROR;
+}
 
-		return (SUCCESS);
+/*********************************************************************//**
+ * @brief		Queue an asynchronous master transaction on an I2C bus
+ * @param[in]	I2Cx	I2C peripheral selected, should be:
+ * 				- LPC_I2C0
+ * 				- LPC_I2C1
+ * 				- LPC_I2C2
+ * @param[in]	job		Transaction, see I2C_JOB_Type
+ * @return		SUCCESS, or ERROR if the job is already queued
+ *
+ * Note: Jobs run in submission order, entirely from I2Cx_IRQHandler: a
+ * write phase, a repeated start and a read phase. A job with neither
+ * only probes the address (ACK polling). NACKs and lost arbitration
+ * restart the job up to Retries times. A software timer fails it with
+ * I2C_JOB_TIMEOUT_ERR once Timeout ms have passed and clocks the bus
+ * free from the SWTIMER dispatch context, so a stuck slave cannot
+ * stall the queue. Call I2C_Init() first.
+ **********************************************************************/
+Status I2C_JobSubmit(LPC_I2C_TypeDef *I2Cx, I2C_JOB_Type *job)
+{
+	I2C_ENGINE_Type *eng;
+	uint32_t primask;
+
+	CHECK_PARAM(PARAM_I2Cx(I2Cx));
+
+	if ((job->status == I2C_JOB_QUEUED) || (job->status == I2C_JOB_ACTIVE))
+	{
+		return ERROR;
 	}
 
-	return ERROR;
+	eng = &i2c_engine[I2C_getNum(I2Cx)];
+	job->next = NULL;
+	job->status = I2C_JOB_QUEUED;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if (eng->head == NULL)
+	{
+		eng->head = job;
+		eng->tail = job;
+		if (!eng->polled)
+		{
+			i2c_job_start(eng);
+		}
+	}
+	else
+	{
+		eng->tail->next = job;
+		eng->tail = job;
+	}
+	__set_PRIMASK(primask);
+
+	return SUCCESS;
+}
+
+/*********************************************************************//**
+ * @brief		Check whether an I2C bus still has jobs to run
+ * @param[in]	I2Cx	I2C peripheral selected, should be:
+ * 				- LPC_I2C0
+ * 				- LPC_I2C1
+ * 				- LPC_I2C2
+ * @return		TRUE while a job is queued or running
+ **********************************************************************/
+Bool I2C_JobBusy(LPC_I2C_TypeDef *I2Cx)
+{
+	CHECK_PARAM(PARAM_I2Cx(I2Cx));
+
+	return (i2c_engine[I2C_getNum(I2Cx)].head != NULL) ? TRUE : FALSE;
 }
 
 /*********************************************************************//**
@@ -21,6 +21,471 @@
  */
 
 
+/* Private Macros ------------------------------------------------------------- */
+/** @defgroup SSP_Private_Macros SSP Private Macros
+ * @{
+ */
+
+/** Depth of the Tx and Rx FIFOs, frames in flight are kept within it */
+#define SSP_FIFO_DEPTH			8
+
+/** Job buffers hold halfwords above 8 data bits */
+#define SSP_JOB_WIDE(job)		((job)->Databit > SSP_DATABIT_8)
+
+/**
+ * @}
+ */
+
+
+/* Private Types -------------------------------------------------------------- */
+/** @defgroup SSP_Private_Types SSP Private Types
+ * @{
+ */
+
+/** @brief Job queue and transfer state of one SSP peripheral */
+typedef struct {
+	LPC_SSP_TypeDef *SSPx;		/**< SSP peripheral */
+	IRQn_Type IRQn;				/**< SSP interrupt */
+	uint32_t TxConn;			/**< GPDMA connection of the Tx FIFO */
+	uint32_t RxConn;			/**< GPDMA connection of the Rx FIFO */
+	SSP_JOB_Type * __IO head;	/**< Active job, NULL when idle */
+	SSP_JOB_Type *tail;			/**< Last queued job */
+	uint32_t tx_cnt;			/**< Frames of the active job written to the Tx FIFO */
+	uint32_t rx_cnt;			/**< Frames of the active job read from the Rx FIFO */
+#ifdef SSP_JOB_DMA_MODE
+	int32_t tx_ch;				/**< GPDMA channel feeding the Tx FIFO, -1 if none */
+	int32_t rx_ch;				/**< GPDMA channel draining the Rx FIFO, -1 if none */
+	uint32_t dma_len;			/**< Frames of the running DMA segment, 0 in interrupt mode */
+	uint32_t sink;				/**< Rx target of jobs that discard received frames */
+	GPDMA_LLI_Type tx_lli;		/**< Tx segment descriptor */
+	GPDMA_LLI_Type rx_lli;		/**< Rx segment descriptor */
+#endif
+} SSP_ENGINE_Type;
+
+/**
+ * @}
+ */
+
+
+/* Private Variables ---------------------------------------------------------- */
+/** @defgroup SSP_Private_Variables SSP Private Variables
+ * @{
+ */
+
+static SSP_ENGINE_Type ssp_engine[2] = {
+#ifdef SSP_JOB_DMA_MODE
+	{ LPC_SSP0, SSP0_IRQn, GPDMA_CONN_SSP0_Tx, GPDMA_CONN_SSP0_Rx, NULL, NULL, 0, 0, -1, -1 },
+	{ LPC_SSP1, SSP1_IRQn, GPDMA_CONN_SSP1_Tx, GPDMA_CONN_SSP1_Rx, NULL, NULL, 0, 0, -1, -1 },
+#else
+	{ LPC_SSP0, SSP0_IRQn, GPDMA_CONN_SSP0_Tx, GPDMA_CONN_SSP0_Rx },
+	{ LPC_SSP1, SSP1_IRQn, GPDMA_CONN_SSP1_Tx, GPDMA_CONN_SSP1_Rx },
+#endif
+};
+
+/** Jobs behind SSP_ReadWrite() in SSP_TRANSFER_INTERRUPT mode */
+static SSP_JOB_Type ssp_rw_job[2];
+
+#ifdef SSP_JOB_DMA_MODE
+/** Tx source of jobs without transmit data */
+static const uint16_t ssp_ones = 0xFFFF;
+#endif
+
+/**
+ * @}
+ */
+
+
+/* Private Functions ---------------------------------------------------------- */
+static void ssp_job_start (SSP_ENGINE_Type *eng);
+
+/*********************************************************************//**
+ * @brief		Engine of an SSP peripheral
+ * @param[in]	SSPx	LPC_SSP0 or LPC_SSP1
+ * @return 		Engine
+ **********************************************************************/
+static SSP_ENGINE_Type *ssp_get_engine (LPC_SSP_TypeDef *SSPx)
+{
+	return (SSPx == LPC_SSP0) ? &ssp_engine[0] : &ssp_engine[1];
+}
+
+
+/*********************************************************************//**
+ * @brief		Top up the Tx FIFO, never more than SSP_FIFO_DEPTH frames
+ * 				ahead of the receiver so the Rx FIFO cannot overrun
+ * @param[in]	eng		Engine with an active job
+ * @return 		None
+ **********************************************************************/
+static void ssp_job_fill (SSP_ENGINE_Type *eng)
+{
+	SSP_JOB_Type *job = eng->head;
+	LPC_SSP_TypeDef *SSPx = eng->SSPx;
+
+	while ((eng->tx_cnt < job->length) && ((eng->tx_cnt - eng->rx_cnt) < SSP_FIFO_DEPTH)
+			&& (SSPx->SR & SSP_SR_TNF))
+	{
+		if (job->tx_data == NULL)
+		{
+			SSPx->DR = 0xFFFF;
+		}
+		else if (SSP_JOB_WIDE(job))
+		{
+			SSPx->DR = ((const uint16_t *)job->tx_data)[eng->tx_cnt];
+		}
+		else
+		{
+			SSPx->DR = ((const uint8_t *)job->tx_data)[eng->tx_cnt];
+		}
+		eng->tx_cnt++;
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief		Empty the Rx FIFO into the active job
+ * @param[in]	eng		Engine with an active job
+ * @return 		None
+ **********************************************************************/
+static void ssp_job_drain (SSP_ENGINE_Type *eng)
+{
+	SSP_JOB_Type *job = eng->head;
+	LPC_SSP_TypeDef *SSPx = eng->SSPx;
+	uint16_t tmp;
+
+	while (SSPx->SR & SSP_SR_RNE)
+	{
+		tmp = (uint16_t)SSPx->DR;
+		if ((job->rx_data != NULL) && (eng->rx_cnt < job->length))
+		{
+			if (SSP_JOB_WIDE(job))
+			{
+				((uint16_t *)job->rx_data)[eng->rx_cnt] = tmp;
+			}
+			else
+			{
+				((uint8_t *)job->rx_data)[eng->rx_cnt] = (uint8_t)tmp;
+			}
+		}
+		eng->rx_cnt++;
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief		Retire the active job and start the next queued one
+ * @param[in]	eng		Engine with an active job
+ * @param[in]	status	SSP_JOB_DONE or SSP_JOB_ERROR
+ * @return 		None
+ **********************************************************************/
+static void ssp_job_finish (SSP_ENGINE_Type *eng, uint32_t status)
+{
+	SSP_JOB_Type *job = eng->head;
+	LPC_SSP_TypeDef *SSPx = eng->SSPx;
+
+	SSPx->IMSC = 0;
+	if (status == SSP_JOB_ERROR)
+	{
+		// Let the frames still in flight go before the next job
+		while (SSPx->SR & SSP_SR_BSY);
+		while (SSPx->SR & SSP_SR_RNE)
+		{
+			(void)SSPx->DR;
+		}
+		SSPx->ICR = SSP_ICR_BITMASK;
+	}
+
+	if ((job->CsPin != 0) && !job->KeepCs)
+	{
+		GPIO_SetValue(job->CsPort, job->CsPin);
+	}
+
+	eng->head = job->next;
+	if (eng->head == NULL)
+	{
+		eng->tail = NULL;
+	}
+	job->next = NULL;
+	job->status = status;
+
+	if (job->Callback != NULL)
+	{
+		job->Callback(job);
+	}
+
+	// The callback may have submitted to an idle bus, which started it already
+	if ((eng->head != NULL) && (eng->head->status == SSP_JOB_QUEUED))
+	{
+		ssp_job_start(eng);
+	}
+}
+
+
+#ifdef SSP_JOB_DMA_MODE
+static void ssp_dma_done (uint32_t ChannelNum, uint32_t Status);
+
+/*********************************************************************//**
+ * @brief		Program and start the next DMA segment of the active job,
+ * 				at most GPDMA_MAX_XFER_SIZE frames
+ * @param[in]	eng		Engine with an active job and both channels
+ * @return 		None
+ **********************************************************************/
+static void ssp_dma_segment (SSP_ENGINE_Type *eng)
+{
+	SSP_JOB_Type *job = eng->head;
+	GPDMA_Channel_CFG_Type cfg;
+	uint32_t width, txctrl, rxctrl, src, dst;
+
+	eng->dma_len = MIN(job->length - eng->rx_cnt, GPDMA_MAX_XFER_SIZE);
+	width = SSP_JOB_WIDE(job) ? GPDMA_WIDTH_HALFWORD : GPDMA_WIDTH_BYTE;
+
+	txctrl = GPDMA_MakeControl(GPDMA_TRANSFERTYPE_M2P, 0, eng->TxConn, 0);
+	rxctrl = GPDMA_MakeControl(GPDMA_TRANSFERTYPE_P2M, eng->RxConn, 0, 0);
+	txctrl &= ~(GPDMA_DMACCxControl_SWidth(0x07) | GPDMA_DMACCxControl_DWidth(0x07));
+	rxctrl &= ~(GPDMA_DMACCxControl_SWidth(0x07) | GPDMA_DMACCxControl_DWidth(0x07));
+	txctrl |= GPDMA_DMACCxControl_SWidth(width) | GPDMA_DMACCxControl_DWidth(width);
+	rxctrl |= GPDMA_DMACCxControl_SWidth(width) | GPDMA_DMACCxControl_DWidth(width);
+
+	if (job->tx_data == NULL)
+	{
+		txctrl &= ~GPDMA_DMACCxControl_SI;
+		src = (uint32_t)&ssp_ones;
+	}
+	else
+	{
+		src = (uint32_t)job->tx_data + (eng->rx_cnt << width);
+	}
+	if (job->rx_data == NULL)
+	{
+		rxctrl &= ~GPDMA_DMACCxControl_DI;
+		dst = (uint32_t)&eng->sink;
+	}
+	else
+	{
+		dst = (uint32_t)job->rx_data + (eng->rx_cnt << width);
+	}
+
+	GPDMA_BuildLLI(&eng->rx_lli, 1, GPDMA_GetPeriphAddr(eng->RxConn), dst, eng->dma_len, rxctrl);
+	GPDMA_BuildLLI(&eng->tx_lli, 1, src, GPDMA_GetPeriphAddr(eng->TxConn), eng->dma_len, txctrl);
+	// Only the Rx channel signals completion, it finishes last
+	eng->tx_lli.Control &= ~GPDMA_DMACCxControl_I;
+
+	cfg.ChannelNum = eng->rx_ch;
+	cfg.TransferType = GPDMA_TRANSFERTYPE_P2M;
+	cfg.SrcConn = eng->RxConn;
+	cfg.DstConn = 0;
+	GPDMA_SetupLLI(&cfg, &eng->rx_lli);
+
+	cfg.ChannelNum = eng->tx_ch;
+	cfg.TransferType = GPDMA_TRANSFERTYPE_M2P;
+	cfg.SrcConn = 0;
+	cfg.DstConn = eng->TxConn;
+	GPDMA_SetupLLI(&cfg, &eng->tx_lli);
+
+	GPDMA_ChannelCmd(eng->rx_ch, ENABLE);
+	GPDMA_ChannelCmd(eng->tx_ch, ENABLE);
+}
+
+
+/*********************************************************************//**
+ * @brief		Move the active job with GPDMA, allocating the two
+ * 				channels of the engine on first use
+ * @param[in]	eng		Engine with an active job
+ * @return 		FALSE if no channels are free, use the interrupt instead
+ **********************************************************************/
+static Bool ssp_dma_start (SSP_ENGINE_Type *eng)
+{
+	if (eng->rx_ch < 0)
+	{
+		eng->rx_ch = GPDMA_ChannelAlloc(GPDMA_PRIO_HIGH);
+		if (eng->rx_ch < 0)
+		{
+			return FALSE;
+		}
+		GPDMA_SetCallback(eng->rx_ch, ssp_dma_done);
+	}
+	if (eng->tx_ch < 0)
+	{
+		eng->tx_ch = GPDMA_ChannelAlloc(GPDMA_PRIO_LOW);
+		if (eng->tx_ch < 0)
+		{
+			return FALSE;
+		}
+		GPDMA_SetCallback(eng->tx_ch, ssp_dma_done);
+	}
+
+	ssp_dma_segment(eng);
+	eng->SSPx->DMACR = SSP_DMA_RXDMA_EN | SSP_DMA_TXDMA_EN;
+	return TRUE;
+}
+
+
+/*********************************************************************//**
+ * @brief		DMA segment completion (called from DMA_IRQHandler)
+ * @param[in]	ChannelNum	GPDMA channel
+ * @param[in]	Status		GPDMA_CB_DONE or GPDMA_CB_ERROR
+ * @return 		None
+ **********************************************************************/
+static void ssp_dma_done (uint32_t ChannelNum, uint32_t Status)
+{
+	SSP_ENGINE_Type *eng;
+	uint32_t i;
+
+	for (i = 0; i < 2; i++)
+	{
+		eng = &ssp_engine[i];
+		if ((eng->dma_len == 0) ||
+			((eng->rx_ch != (int32_t)ChannelNum) && (eng->tx_ch != (int32_t)ChannelNum)))
+		{
+			continue;
+		}
+
+		if (Status == GPDMA_CB_ERROR)
+		{
+			GPDMA_ChannelCmd(eng->rx_ch, DISABLE);
+			GPDMA_ChannelCmd(eng->tx_ch, DISABLE);
+		}
+		else
+		{
+			eng->rx_cnt += eng->dma_len;
+			eng->tx_cnt = eng->rx_cnt;
+			if (eng->rx_cnt < eng->head->length)
+			{
+				ssp_dma_segment(eng);
+				return;
+			}
+		}
+
+		eng->SSPx->DMACR = 0;
+		eng->dma_len = 0;
+		ssp_job_finish(eng, (Status == GPDMA_CB_ERROR) ? SSP_JOB_ERROR : SSP_JOB_DONE);
+		return;
+	}
+}
+#endif
+
+
+/*********************************************************************//**
+ * @brief		Start the job at the head of the queue: frame size, chip
+ * 				select, then DMA or the first FIFO load
+ * @param[in]	eng		Engine with a queued job at its head
+ * @return 		None
+ **********************************************************************/
+static void ssp_job_start (SSP_ENGINE_Type *eng)
+{
+	SSP_JOB_Type *job = eng->head;
+	LPC_SSP_TypeDef *SSPx = eng->SSPx;
+
+	job->status = SSP_JOB_ACTIVE;
+	eng->tx_cnt = 0;
+	eng->rx_cnt = 0;
+
+	SSPx->CR0 = (SSPx->CR0 & ~SSP_CR0_DSS(16)) | job->Databit;
+	while (SSPx->SR & SSP_SR_RNE)
+	{
+		(void)SSPx->DR;
+	}
+	SSPx->ICR = SSP_ICR_BITMASK;
+
+	if (job->CsPin != 0)
+	{
+		GPIO_ClearValue(job->CsPort, job->CsPin);
+	}
+
+#ifdef SSP_JOB_DMA_MODE
+	if ((job->length >= SSP_JOB_DMA_MIN) && ssp_dma_start(eng))
+	{
+		return;
+	}
+#endif
+
+	ssp_job_fill(eng);
+	SSPx->IMSC = SSP_IMSC_ROR | SSP_IMSC_RT | SSP_IMSC_RX;
+}
+
+
+/*********************************************************************//**
+ * @brief		Interrupt mode job service: move received frames, refill
+ * 				the Tx FIFO and retire the job once every frame is back
+ * @param[in]	eng		Engine of the interrupting SSP
+ * @return 		None
+ **********************************************************************/
+static void ssp_job_irq (SSP_ENGINE_Type *eng)
+{
+	LPC_SSP_TypeDef *SSPx = eng->SSPx;
+
+	if ((eng->head == NULL) || (eng->head->status != SSP_JOB_ACTIVE))
+	{
+		SSPx->IMSC = 0;
+		return;
+	}
+
+	if (SSPx->RIS & SSP_RIS_ROR)
+	{
+		ssp_job_finish(eng, SSP_JOB_ERROR);
+		return;
+	}
+
+	ssp_job_drain(eng);
+	SSPx->ICR = SSP_ICR_RT;
+
+	if (eng->rx_cnt >= eng->head->length)
+	{
+		ssp_job_finish(eng, SSP_JOB_DONE);
+	}
+	else
+	{
+		ssp_job_fill(eng);
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief		Completion of an SSP_ReadWrite() interrupt transfer,
+ * 				reports the counts in the caller's SSP_DATA_SETUP_Type
+ * @param[in]	job		Finished job
+ * @return 		None
+ **********************************************************************/
+static void ssp_rw_done (SSP_JOB_Type *job)
+{
+	SSP_DATA_SETUP_Type *dataCfg = (SSP_DATA_SETUP_Type *)job->Arg;
+	uint32_t bytes = job->length << (SSP_JOB_WIDE(job) ? 1 : 0);
+
+	if (job->status == SSP_JOB_DONE)
+	{
+		dataCfg->tx_cnt = bytes;
+		dataCfg->rx_cnt = bytes;
+		dataCfg->status = SSP_STAT_DONE;
+	}
+	else
+	{
+		dataCfg->status = SSP_RIS_ROR | SSP_STAT_ERROR;
+	}
+}
+/* End of Private Functions --------------------------------------------------- */
+
+
+/*----------------- INTERRUPT SERVICE ROUTINES --------------------------*/
+/*********************************************************************//**
+ * @brief		SSP0 interrupt handler, services the SSP0 job queue
+ * @param[in]	None
+ * @return 		None
+ **********************************************************************/
+void SSP0_IRQHandler (void)
+{
+	ssp_job_irq(&ssp_engine[0]);
+}
+
+
+/*********************************************************************//**
+ * @brief		SSP1 interrupt handler, services the SSP1 job queue
+ * @param[in]	None
+ * @return 		None
+ **********************************************************************/
+void SSP1_IRQHandler (void)
+{
+	ssp_job_irq(&ssp_engine[1]);
+}
+
+
 /* Public Functions ----------------------------------------------------------- */
 /** @addtogroup SSP_Public_Functions
  * @{
@@ -258,9 +723,12 @@ static void setSSPclock (LPC_SSP_TypeDef *SSPx, uint32_t target_clock)
 *                    that contains the configuration information for the
 *                    specified SSP peripheral.
 * @return 		None
+* Note:			Also empties the job queue and enables the SSP interrupt,
+* 				which only fires while a job is running
  *********************************************************************/
 void SSP_Init(LPC_SSP_TypeDef *SSPx, SSP_CFG_Type *SSP_ConfigStruct)
 {
+	SSP_ENGINE_Type *eng;
 	uint32_t tmp;
 
 	CHECK_PARAM(PARAM_SSPx(SSPx));
@@ -290,6 +758,20 @@ void SSP_Init(LPC_SSP_TypeDef *SSPx, SSP_CFG_Type *SSP_ConfigStruct)
 
 	// Set clock rate for SSP peripheral
 	setSSPclock(SSPx, SSP_ConfigStruct->ClockRate);
+
+	// Empty job queue
+	eng = ssp_get_engine(SSPx);
+	SSPx->IMSC = 0;
+	eng->head = NULL;
+	eng->tail = NULL;
+#ifdef SSP_JOB_DMA_MODE
+	eng->dma_len = 0;
+	if (!(LPC_SC->PCONP & CLKPWR_PCONP_PCGPDMA))
+	{
+		GPDMA_Init();
+	}
+#endif
+	NVIC_EnableIRQ(eng->IRQn);
 }
 
 /*********************************************************************//**
@@ -478,6 +960,10 @@ uint16_t SSP_ReceiveData(LPC_SSP_TypeDef* SSPx)
  * 				In interrupt mode, always return (0)
  * 				Return (-1) if error.
  * Note: This function can be used in both master and slave mode.
+ * In interrupt mode the transfer is queued behind any SSP jobs and the
+ * function returns at once; dataCfg->status becomes SSP_STAT_DONE or
+ * SSP_STAT_ERROR from the SSP interrupt. dataCfg and the buffers must
+ * stay valid until then.
  ***********************************************************************/
 int32_t SSP_ReadWrite (LPC_SSP_TypeDef *SSPx, SSP_DATA_SETUP_Type *dataCfg, \
 						SSP_TRANSFER_Type xfType)
@@ -489,25 +975,26 @@ int32_t SSP_ReadWrite (LPC_SSP_TypeDef *SSPx, SSP_DATA_SETUP_Type *dataCfg, \
     uint32_t stat;
     uint32_t tmp;
     int32_t dataword;
+    SSP_JOB_Type *job;
 
     dataCfg->rx_cnt = 0;
     dataCfg->tx_cnt = 0;
     dataCfg->status = 0;
 
-
-	/* Clear all remaining data in RX FIFO */
-	while (SSPx->SR & SSP_SR_RNE){
-		tmp = (uint32_t) SSP_ReceiveData(SSPx);
-	}
-
-	// Clear status
-	SSPx->ICR = SSP_ICR_BITMASK;
 	if(SSP_GetDataSize(SSPx)>8)
 		dataword = 1;
 	else dataword = 0;
 
 	// Polling mode ----------------------------------------------------------------------
 	if (xfType == SSP_TRANSFER_POLLING){
+		/* Clear all remaining data in RX FIFO */
+		while (SSPx->SR & SSP_SR_RNE){
+			tmp = (uint32_t) SSP_ReceiveData(SSPx);
+		}
+
+		// Clear status
+		SSPx->ICR = SSP_ICR_BITMASK;
+
 		if (dataword == 0){
 			rdata8 = (uint8_t *)dataCfg->rx_data;
 			wdata8 = (uint8_t *)dataCfg->tx_data;
@@ -585,69 +1072,88 @@ int32_t SSP_ReadWrite (LPC_SSP_TypeDef *SSPx, SSP_DATA_SETUP_Type *dataCfg, \
 
 	// Interrupt mode ----------------------------------------------------------------------
 	else if (xfType == SSP_TRANSFER_INTERRUPT){
+		job = &ssp_rw_job[(SSPx == LPC_SSP0) ? 0 : 1];
+		if ((job->status == SSP_JOB_QUEUED) || (job->status == SSP_JOB_ACTIVE)){
+			return (-1);
+		}
+		job->CsPin = 0;
+		job->Databit = SSP_GetDataSize(SSPx);
+		job->tx_data = dataCfg->tx_data;
+		job->rx_data = dataCfg->rx_data;
+		job->length = dataCfg->length >> (SSP_JOB_WIDE(job) ? 1 : 0);
+		job->KeepCs = FALSE;
+		job->Callback = ssp_rw_done;
+		job->Arg = dataCfg;
+		if (job->length == 0){
+			dataCfg->status = SSP_STAT_DONE;
+			return (0);
+		}
+		return (SSP_JobSubmit(SSPx, job) == SUCCESS) ? 0 : (-1);
+	}
 
-		while ((SSPx->SR & SSP_SR_TNF) && (dataCfg->tx_cnt != dataCfg->length)){
-			// Write data to buffer
-			if(dataCfg->tx_data == NULL){
-				if (dataword == 0){
-					SSP_SendData(SSPx, 0xFF);
-					dataCfg->tx_cnt++;
-				} else {
-					SSP_SendData(SSPx, 0xFFFF);
-					dataCfg->tx_cnt += 2;
-				}
-			} else {
-				if (dataword == 0){
-					SSP_SendData(SSPx, (*(uint8_t *)((uint32_t)dataCfg->tx_data + dataCfg->tx_cnt)));
-					dataCfg->tx_cnt++;
-				} else {
-					SSP_SendData(SSPx, (*(uint16_t *)((uint32_t)dataCfg->tx_data + dataCfg->tx_cnt)));
-					dataCfg->tx_cnt += 2;
-				}
-			}
+	return (-1);
+}
 
-			// Check error
-			if ((stat = SSPx->RIS) & SSP_RIS_ROR){
-				// save status and return
-				dataCfg->status = stat | SSP_STAT_ERROR;
-				return (-1);
-			}
+/*********************************************************************//**
+ * @brief		Queue an asynchronous transaction on an SSP bus
+ * @param[in]	SSPx	SSP peripheral, should be:
+ * 						- LPC_SSP0: SSP0 peripheral
+ * 						- LPC_SSP1: SSP1 peripheral
+ * @param[in]	job		Transaction, see SSP_JOB_Type
+ * @return		SUCCESS, or ERROR if the job is already queued or empty
+ *
+ * Note: Jobs run in submission order, each one asserting its chip select
+ * and setting its frame size. The next job starts from the interrupt
+ * that retires the previous one, so devices on the same bus (GLCD and
+ * EEPROM) are multiplexed without the caller waiting. Polled transfers
+ * on the bus must wait for SSP_JobBusy() to return FALSE.
+ **********************************************************************/
+Status SSP_JobSubmit(LPC_SSP_TypeDef *SSPx, SSP_JOB_Type *job)
+{
+	SSP_ENGINE_Type *eng;
+	uint32_t primask;
 
-			// Check for any data available in RX FIFO
-			while ((SSPx->SR & SSP_SR_RNE) && (dataCfg->rx_cnt != dataCfg->length)){
-				// Read data from SSP data
-				tmp = SSP_ReceiveData(SSPx);
+	CHECK_PARAM(PARAM_SSPx(SSPx));
 
-				// Store data to destination
-				if (dataCfg->rx_data != NULL)
-				{
-					if (dataword == 0){
-						*(uint8_t *)((uint32_t)dataCfg->rx_data + dataCfg->rx_cnt) = (uint8_t) tmp;
-					} else {
-						*(uint16_t *)((uint32_t)dataCfg->rx_data + dataCfg->rx_cnt) = (uint16_t) tmp;
-					}
-				}
-				// Increase counter
-				if (dataword == 0){
-					dataCfg->rx_cnt++;
-				} else {
-					dataCfg->rx_cnt += 2;
-				}
-			}
-		}
+	if ((job->length == 0) || (job->status == SSP_JOB_QUEUED) || (job->status == SSP_JOB_ACTIVE))
+	{
+		return ERROR;
+	}
 
-		// If there more data to sent or receive
-		if ((dataCfg->rx_cnt != dataCfg->length) || (dataCfg->tx_cnt != dataCfg->length)){
-			// Enable all interrupt
-			SSPx->IMSC = SSP_IMSC_BITMASK;
-		} else {
-			// Save status
-			dataCfg->status = SSP_STAT_DONE;
-		}
-		return (0);
+	eng = ssp_get_engine(SSPx);
+	job->next = NULL;
+	job->status = SSP_JOB_QUEUED;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if (eng->head == NULL)
+	{
+		eng->head = job;
+		eng->tail = job;
+		ssp_job_start(eng);
 	}
+	else
+	{
+		eng->tail->next = job;
+		eng->tail = job;
+	}
+	__set_PRIMASK(primask);
 
-	return (-1);
+	return SUCCESS;
+}
+
+/*********************************************************************//**
+ * @brief		Check whether an SSP bus still has jobs to run
+ * @param[in]	SSPx	SSP peripheral, should be:
+ * 						- LPC_SSP0: SSP0 peripheral
+ * 						- LPC_SSP1: SSP1 peripheral
+ * @return		TRUE while a job is queued or running
+ **********************************************************************/
+Bool SSP_JobBusy(LPC_SSP_TypeDef *SSPx)
+{
+	CHECK_PARAM(PARAM_SSPx(SSPx));
+
+	return (ssp_get_engine(SSPx)->head != NULL) ? TRUE : FALSE;
 }
 
 /*********************************************************************//**
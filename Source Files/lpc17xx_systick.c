@@ -19,7 +19,59 @@
  * Variables
  */
 __IO uint32_t delay_timer;
-uint32_t led_timer;
+static __IO uint32_t systick_count;   // ticks since SYSTICK_Config()
+static __IO uint32_t systick_step = 1; // ticks the next interrupt stands for
+static uint32_t systick_reload;       // RELOAD of one tick
+static SWTIMER_Type systick_heartbeat;
+static uint32_t systick_stopped;     // core clock the counter was stopped at
+static uint32_t systick_late;        // clocks the period ends after its tick boundary
+
+/* Fewest clocks SYSTICK_Idle() leaves before a tick boundary when it
+ * restarts the counter, enough to see it reload */
+#define SYSTICK_IDLE_MARGIN   64
+
+/*********************************************************************//**
+ * @brief 		Heartbeat timer callback, toggles P3.25 every led_delay
+ * 				ticks (re-read each time, so it can change at run time)
+ * @param		arg: unused
+ * @return 		None
+ ***********************************************************************/
+static void systick_heartbeat_cb (void *arg)
+{
+	LPC_GPIO3->FIOPIN ^= _BIT(25); //Toggle P3.25 Hearbeat led
+	SWTIMER_Start(&systick_heartbeat, led_delay + 1, 0);
+}
+
+/*********************************************************************//**
+ * @brief 		Stop SysTick, interrupts masked
+ * @param		None
+ * @return 		Clocks that were left to the end of its period
+ ***********************************************************************/
+static uint32_t systick_stop (void)
+{
+	systick_stopped = (uint32_t)now_cycles();
+	SysTick->CTRL &= ~ST_CTRL_ENABLE;
+	return SysTick->VAL;
+}
+
+/*********************************************************************//**
+ * @brief 		Restart SysTick stopped by systick_stop() on a new period,
+ * 				then have the period after it make up for the stop
+ * @param[in]	load	RELOAD of the new period
+ * @return 		None
+ *
+ * Note: the new period ends systick_late clocks after its tick boundary,
+ * the clocks the counter stood still.
+ ***********************************************************************/
+static void systick_restart (uint32_t load)
+{
+	SysTick->LOAD = load;
+	SysTick->VAL = 0;
+	systick_late = (uint32_t)now_cycles() - systick_stopped; // same path to CTRL as the stop
+	SysTick->CTRL |= ST_CTRL_ENABLE;
+	while (SysTick->VAL == 0);          // took the new period
+	SysTick->LOAD = systick_reload - systick_late;
+}
 
 /*----------------- INTERRUPT SERVICE ROUTINES --------------------------*/
 /*********************************************************************//**
@@ -29,20 +81,34 @@ uint32_t led_timer;
  ***********************************************************************/
 void SysTick_Handler(void)
 {
-    if(led_timer)
-    {
-    	--led_timer;
-    }
-    else
-    {
-    	LPC_GPIO3->FIOPIN ^= _BIT(25); //Toggle P3.25 Hearbeat led
-    	led_timer=led_delay;
-    }
+	uint32_t step = systick_step;
+
+	systick_step = 1;
+#if (SWTIMER_TICKLESS == 1)
+	if (SysTick->CTRL & ST_CTRL_COUNTFLAG)
+	{
+		/* The counter wrapped: back to one tick after an idle stretch.
+		 * A tick SYSTICK_Idle() pended itself keeps its correction */
+		SysTick->LOAD = systick_reload;
+		systick_late = 0;
+	}
+#endif
+	systick_count += step;
 
-	if(delay_timer)
+	if(delay_timer > step)
     {
-      --delay_timer;           /*decrement Delay Timer */
+      delay_timer -= step;     /*decrement Delay Timer */
     }
+	else
+	{
+	  delay_timer = 0;
+	}
+
+	while(step--)
+	{
+	  SWTIMER_Tick();          /* timer wheel: heartbeat led, I2C job timeouts */
+	}
+	(void)now_cycles();        /* see each CYCCNT wrap, well within 2^32 cycles */
 	
 	//Clear System Tick counter flag
 	SYSTICK_ClearCounterFlag();
@@ -56,14 +122,127 @@ void SysTick_Handler(void)
  * @brief 		Delay Function
  * @param		value in ms
  * @return 		None
+ *
+ * Note: the caller still waits, but the core sleeps in SYSTICK_Idle()
+ * instead of spinning, and timer callbacks keep running meanwhile.
+ * The end is taken from now_us(), so the delay does not depend on the
+ * SysTick phase at the call: the last tick is spent polling the timer.
  ***********************************************************************/
 void delay_ms (uint32_t dly_ticks) 
 {
-  delay_timer = dly_ticks;
-  while(delay_timer)
+  uint32_t start, us, elapsed, chunk;
+
+  start = now_us();
+  while(dly_ticks)
   {
-    /* do nothing */
-  } 
+    chunk = (dly_ticks > 1000000) ? 1000000 : dly_ticks; /* 1000 s, fits in us */
+    dly_ticks -= chunk;
+    us = chunk * 1000;
+
+    while((elapsed = now_us() - start) < us)
+    {
+      if((us - elapsed) > 1000)
+      {
+        delay_timer = (us - elapsed) / 1000; /* bounds the tickless stretch */
+        SYSTICK_Idle();
+      }
+    }
+    start += us;
+  }
+  delay_timer = 0;
+}
+
+/*********************************************************************//**
+ * @brief 		Sleep until the next interrupt, call from the idle loop
+ * @param		None
+ * @return 		None
+ *
+ * Note: with SWTIMER_TICKLESS, SysTick is first stretched up to the next
+ * timer expiry or the end of delay_ms(), so an idle core is not woken
+ * every millisecond. Another interrupt ends the stretch early, the
+ * ticks that passed are then accounted for and the tick phase is kept.
+ * The counter stands still while it is reprogrammed: those clocks are
+ * measured on the core clock (SysTick must run from it) and taken off
+ * the period after, so the phase does not slip from wake to wake.
+ ***********************************************************************/
+void SYSTICK_Idle(void)
+{
+#if (SWTIMER_TICKLESS == 1)
+	uint32_t primask, per, n, val, rest, ahead, passed;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+
+	per = systick_reload + 1;
+	n = SWTIMER_NextExpiry();
+	if ((delay_timer != 0) && (delay_timer < n))
+	{
+		n = delay_timer;
+	}
+	if (n > (ST_RELOAD_RELOAD(0xFFFFFFFF) / per))
+	{
+		n = ST_RELOAD_RELOAD(0xFFFFFFFF) / per;
+	}
+	if ((n <= 1) || (systick_step != 1) || (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)
+		|| (SysTick->VAL < (systick_late + SYSTICK_IDLE_MARGIN)))
+	{
+		__WFI();
+		__set_PRIMASK(primask);
+		return;
+	}
+
+	/* Stretch the current tick to n ticks, keeping what already elapsed.
+	 * VAL counts down to the tick boundary whatever LOAD it started from,
+	 * systick_late clocks past it after a restart */
+	val = systick_stop() - systick_late;
+	systick_restart((n - 1) * per + val - 1);
+	systick_step = n;
+
+	__WFI();
+
+	if (!(SCB->ICSR & SCB_ICSR_PENDSTSET_Msk))
+	{
+		/* Woken early. The stretch ends systick_late clocks after the
+		 * n-th tick boundary, wait out its last clocks rather than cut them */
+		while (SysTick->VAL < (systick_late + SYSTICK_IDLE_MARGIN))
+		{
+			if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)
+			{
+				break;
+			}
+		}
+	}
+	if (!(SCB->ICSR & SCB_ICSR_PENDSTSET_Msk))
+	{
+		/* Cut the stretch at the next tick boundary, the ticks already
+		 * passed are accounted now */
+		val = systick_stop() - systick_late; // clocks to the n-th boundary
+		rest = val % per;
+		ahead = (val + per - 1) / per;      // boundaries still to come
+		passed = n - ahead;
+		if (rest == 0)
+		{
+			rest = per;
+		}
+		else if (rest < SYSTICK_IDLE_MARGIN)
+		{
+			/* Too close to catch the reload: count that tick now and
+			 * run on to the boundary after it */
+			passed++;
+			rest += per;
+		}
+		systick_restart(rest - 1);
+		systick_step = (passed != 0) ? passed : 1;
+		if (passed != 0)
+		{
+			SCB->ICSR = SCB_ICSR_PENDSTSET_Msk;
+		}
+	}
+
+	__set_PRIMASK(primask);
+#else
+	__WFI();
+#endif
 }
 
  /*********************************************************************//**
@@ -73,12 +252,19 @@ void delay_ms (uint32_t dly_ticks)
  **********************************************************************/
 void SYSTICK_Config(void)
 {
+  //Free running timebase, delay_ms() counts on it
+  TIMEBASE_Init();
+
   //Initialize System Tick with 10ms time interval
   SYSTICK_InternalInit(1);
   //Enable System Tick interrupt
   SYSTICK_IntCmd(ENABLE);
   //Enable System Tick Counter
   SYSTICK_Cmd(ENABLE);
+
+  //Heartbeat led on the timer wheel
+  SWTIMER_Init(&systick_heartbeat, systick_heartbeat_cb, NULL);
+  SWTIMER_Start(&systick_heartbeat, 1, 0);
 }
 
 /*********************************************************************//**
@@ -111,6 +297,7 @@ void SYSTICK_InternalInit(uint32_t time)
 		 * with time base is millisecond
 		 */
 		SysTick->LOAD = (cclk/1000)*time - 1;
+		systick_reload = SysTick->LOAD;
 	}
 }
 
@@ -144,6 +331,7 @@ void SYSTICK_ExternalInit(uint32_t freq, uint32_t time)
 		 */
 		maxtime = (freq/1000)*time - 1;
 		SysTick->LOAD = (freq/1000)*time - 1;
+		systick_reload = SysTick->LOAD;
 	}
 }
 
@@ -185,6 +373,18 @@ void SYSTICK_IntCmd(FunctionalState NewState)
 		SysTick->CTRL &= ~ST_CTRL_TICKINT;
 }
 
+/*********************************************************************//**
+ * @brief 		Get the number of System Tick interrupts since start,
+ * 				1 ms each with SYSTICK_Config(). Wraps after 49 days,
+ * 				compare with (uint32_t)(now - start) >= period.
+ * @param		None
+ * @return 		Tick count
+ **********************************************************************/
+uint32_t SYSTICK_GetTick(void)
+{
+	return systick_count;
+}
+
 /*********************************************************************//**
  * @brief 		Get current value of System Tick counter
  * @param[in]	None
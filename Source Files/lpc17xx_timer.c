@@ -19,10 +19,6 @@
  * file in each example directory ("lpc17xx_libcfg.h") must be included,
  * otherwise the default FW library configuration file must be included instead
  */
-/* Private Variables ----------------------------------------------------------- */
-uint8_t tim_init=0;
-
-
 /* Private Functions ---------------------------------------------------------- */
 
 static uint32_t getPClock (uint32_t timernum);
@@ -404,13 +400,22 @@ void TIM3_Config (void)
 * 				- TIM_MR3: Configure for Ext Match channel 3 for only Timer2
 * 				- TIM_CR0: Configure for Capture channel 0
 * 				- TIM_CR1: Configure for Capture channel 1
-* @return 		None
+* @return 		SUCCESS, or ERROR for TIMEBASE_TIM
+*
+* Note: TIMEBASE_TIM is kept running by the timebase, it can not be
+* configured here. Change TIMEBASE_TIM_SEL to free it.
 *********************************************************************/
-void TIM_Config(LPC_TIM_TypeDef *TIMx, TIM_PCFG_TYPE PCfg)
+Status TIM_Config(LPC_TIM_TypeDef *TIMx, TIM_PCFG_TYPE PCfg)
 {
 	// Pin configuration for TIM
 	PINSEL_CFG_Type PinCfg;
 
+	CHECK_PARAM(PARAM_TIM_FREE(TIMx));
+	if (TIMx == TIMEBASE_TIM)
+	{
+		return ERROR;
+	}
+
 	if (TIMx == LPC_TIM0)
 	{
 		switch (PCfg)
@@ -554,6 +559,7 @@ void TIM_Config(LPC_TIM_TypeDef *TIMx, TIM_PCFG_TYPE PCfg)
 		// Pin Configuration
 		TIM3_Config();    // Timer3 Configuration
 	}
+	return SUCCESS;
 }
 
 
@@ -704,15 +710,20 @@ void TIM_ConfigStructInit(TIM_MODE_OPT TimerCounterMode, void *TIM_ConfigStruct)
  * @param[in]	TIM_ConfigStruct pointer to TIM_TIMERCFG_Type
  * 				that contains the configuration information for the
  *                    specified Timer peripheral.
- * @return 		None
+ * @return 		SUCCESS, or ERROR for TIMEBASE_TIM, which is left running
  **********************************************************************/
-void TIM_Init(LPC_TIM_TypeDef *TIMx, TIM_MODE_OPT TimerCounterMode, void *TIM_ConfigStruct)
+Status TIM_Init(LPC_TIM_TypeDef *TIMx, TIM_MODE_OPT TimerCounterMode, void *TIM_ConfigStruct)
 {
 	TIM_TIMERCFG_Type *pTimeCfg;
 	TIM_COUNTERCFG_Type *pCounterCfg;
 
 	CHECK_PARAM(PARAM_TIMx(TIMx));
 	CHECK_PARAM(PARAM_TIM_MODE_OPT(TimerCounterMode));
+	CHECK_PARAM(PARAM_TIM_FREE(TIMx));
+	if (TIMx == TIMEBASE_TIM)
+	{
+		return ERROR;
+	}
 
 	//set power
 
@@ -775,7 +786,7 @@ void TIM_Init(LPC_TIM_TypeDef *TIMx, TIM_MODE_OPT TimerCounterMode, void *TIM_Co
 
 	// Clear interrupt pending
 	TIMx->IR = 0xFFFFFFFF;
-
+	return SUCCESS;
 }
 
 /*********************************************************************//**
@@ -785,11 +796,16 @@ void TIM_Init(LPC_TIM_TypeDef *TIMx, TIM_MODE_OPT TimerCounterMode, void *TIM_Co
  * 				- LPC_TIM1: TIMER1 peripheral
  * 				- LPC_TIM2: TIMER2 peripheral
  * 				- LPC_TIM3: TIMER3 peripheral
- * @return 		None
+ * @return 		SUCCESS, or ERROR for TIMEBASE_TIM, which is left running
  **********************************************************************/
-void TIM_DeInit (LPC_TIM_TypeDef *TIMx)
+Status TIM_DeInit (LPC_TIM_TypeDef *TIMx)
 {
 	CHECK_PARAM(PARAM_TIMx(TIMx));
+	CHECK_PARAM(PARAM_TIM_FREE(TIMx));
+	if (TIMx == TIMEBASE_TIM)
+	{
+		return ERROR;
+	}
 	// Disable timer/counter
 	TIMx->TCR = 0x00;
 
@@ -804,8 +820,9 @@ void TIM_DeInit (LPC_TIM_TypeDef *TIMx)
 		CLKPWR_ConfigPPWR (CLKPWR_PCONP_PCTIM2, DISABLE);
 
 	else if (TIMx== LPC_TIM3)
-		CLKPWR_ConfigPPWR (CLKPWR_PCONP_PCTIM2, DISABLE);
+		CLKPWR_ConfigPPWR (CLKPWR_PCONP_PCTIM3, DISABLE);
 
+	return SUCCESS;
 }
 
 /*********************************************************************//**
@@ -823,6 +840,11 @@ void TIM_DeInit (LPC_TIM_TypeDef *TIMx)
 void TIM_Cmd(LPC_TIM_TypeDef *TIMx, FunctionalState NewState)
 {
 	CHECK_PARAM(PARAM_TIMx(TIMx));
+	CHECK_PARAM(PARAM_TIM_FREE(TIMx));
+	if (TIMx == TIMEBASE_TIM)
+	{
+		return;
+	}
 	if (NewState == ENABLE)
 	{
 		TIMx->TCR	|=  TIM_ENABLE;
@@ -847,6 +869,11 @@ void TIM_Cmd(LPC_TIM_TypeDef *TIMx, FunctionalState NewState)
 void TIM_ResetCounter(LPC_TIM_TypeDef *TIMx)
 {
 	CHECK_PARAM(PARAM_TIMx(TIMx));
+	CHECK_PARAM(PARAM_TIM_FREE(TIMx));
+	if (TIMx == TIMEBASE_TIM)
+	{
+		return;
+	}
 	TIMx->TCR |= TIM_RESET;
 	TIMx->TCR &= ~TIM_RESET;
 }
@@ -1006,7 +1033,7 @@ uint32_t TIM_GetCaptureValue(LPC_TIM_TypeDef *TIMx, TIM_COUNTER_INPUT_OPT Captur
 }
 
 /********************************************************************//**
-* @brief Micro Sec delay function using Timer 3(Polling Mode)
+* @brief Micro sec counter, kept for older code, see lpc_timebase.c
 **********************************************************************/
 
 /** @defgroup micro_sec_Public_Functions micro_sec Public Functions
@@ -1014,63 +1041,26 @@ uint32_t TIM_GetCaptureValue(LPC_TIM_TypeDef *TIMx, TIM_COUNTER_INPUT_OPT Captur
  */
 
 /*********************************************************************//**
- * @brief	Initialization of the timer3(Polling Mode)
+ * @brief	Start the microsecond counter
  * @param[in]	None
  * @return 		None
+ *
+ * Note: same as TIMEBASE_Init(), the counter is never stopped again.
  **********************************************************************/
 void US_TimerInit(void)
 {
-	if(tim_init)		
-	{
-		return;
-	}
-	tim_init=1;
-
-	LPC_SC->PCONP |= 1<<23;	/* Power on timer 3 */
-	LPC_TIM3->CTCR = 0; /* Timer mode  */
-	LPC_TIM3->TCR = 2;  /* Reset timer */
-	LPC_TIM3->PR = ((SystemCoreClock/4)/1000000)-1; /* Set the prescaler value 
-													   for 1us */
-	LPC_TIM3->TCR = 1;	/* Start the counter */
-}
-
-/*********************************************************************//**
- * @brief	stops the timer
- * @param[in]	None
- * @return 		value
- **********************************************************************/
-inline void US_TimerStop(void)
-{
-	LPC_TIM3->TCR = 0;		/* Disable the counter */
+	TIMEBASE_Init();
 }
 
 /*********************************************************************//**
  * @brief	read the timer counter value
  * @param[in]	None
- * @return 		value
- **********************************************************************/
-uint32_t US_TimerRead()
-{
-	if (!tim_init)
-	{
-		US_TimerInit();
-	}
-	return LPC_TIM3->TC;	// retuen timer counter value
-}
-
-
-/*********************************************************************//**
- * @brief	micro sec delay function
- * @param[in]	value in micro sec
- * @return 		None
+ * @return 		Microseconds, see now_us()
  **********************************************************************/
-void delay_us(uint32_t us)
+uint32_t US_TimerRead(void)
 {
-	uint32_t start  = US_TimerRead();		/* Read timer counter value */
-	while ((US_TimerRead() - start) < us);	/* delay loop */
-	LPC_SC->PCONP |= 0<<23;		/* disable the timer 3 */
-	LPC_TIM3->TCR = 0;
-	tim_init=0;
+	TIMEBASE_Init();
+	return now_us();
 }
 
 
@@ -16,44 +16,71 @@
 
 /* Global Variables------------------------------------------------------------ */
 uint16 EscFlag=0;
-uchar TrgLvlU0=0,TrgLvlU2=0;
-Bool UART0_RxReady=0,UART2_RxReady=0;
+
+/* Ring storage, sized per port */
+static __IO uint8_t uart0_tx[UART0_RING_BUFSIZE], uart0_rx[UART0_RING_BUFSIZE];
+static __IO uint8_t uart1_tx[UART1_RING_BUFSIZE], uart1_rx[UART1_RING_BUFSIZE];
+static __IO uint8_t uart2_tx[UART2_RING_BUFSIZE], uart2_rx[UART2_RING_BUFSIZE];
+static __IO uint8_t uart3_tx[UART3_RING_BUFSIZE], uart3_rx[UART3_RING_BUFSIZE];
+
+/* Port descriptors: peripheral, interrupt, NVIC priority, Tx DMA connection, rings, trigger level */
+UART_PORT_Type UART_Port[UART_NUM_PORTS] =
+{
+	{ LPC_UART0, UART0_IRQn, ((0x01<<3)|0x01), GPDMA_CONN_UART0_Tx,
+	  { uart0_tx, uart0_rx, UART0_RING_BUFSIZE-1, UART0_RING_BUFSIZE-1 }, 1 },
+	{ (LPC_UART_TypeDef *)LPC_UART1, UART1_IRQn, ((0x01<<3)|0x01), GPDMA_CONN_UART1_Tx,
+	  { uart1_tx, uart1_rx, UART1_RING_BUFSIZE-1, UART1_RING_BUFSIZE-1 }, 1 },
+	{ LPC_UART2, UART2_IRQn, 2, GPDMA_CONN_UART2_Tx,
+	  { uart2_tx, uart2_rx, UART2_RING_BUFSIZE-1, UART2_RING_BUFSIZE-1 }, 1 },
+	{ LPC_UART3, UART3_IRQn, 2, GPDMA_CONN_UART3_Tx,
+	  { uart3_tx, uart3_rx, UART3_RING_BUFSIZE-1, UART3_RING_BUFSIZE-1 }, 1 },
+};
 
 /* Private Functions ---------------------------------------------------------- */
 static Status uart_set_divisors(LPC_UART_TypeDef *UARTx, uint32_t baudrate);
 void UART_IntTransmit(LPC_UART_TypeDef *UARTx);
 void UART_IntReceive(LPC_UART_TypeDef *UARTx);
 
+/* printf() output span, queued with one UART_Send() when full */
+typedef struct
+{
+	LPC_UART_TypeDef *UARTx;
+	uint32_t len;
+	uint8_t  buf[UART_PRINTF_SPAN];
+} UART_SPAN_Type;
+
+static Bool uart_line_status(UART_PORT_Type *port, uint8_t lsr);
+
 #ifdef INTERRUPT_MODE
+static void uart_tx_kick(UART_PORT_Type *port);
+
 /*********************************************************************//**
- * @brief	UART0 interrupt handler sub-routine
- * @param	None
+ * @brief	UART interrupt handler body shared by all ports
+ * @param	port	Descriptor of the interrupting UART
  * @return	None
  **********************************************************************/
-void UART0_IRQHandler(void)
+static void uart_irq_handler(UART_PORT_Type *port)
 {
-	// Call Standard UART 0 interrupt handler
-	uint32_t intsrc, tmp, tmp1;
+	LPC_UART_TypeDef *UARTx = port->UARTx;
+	uint32_t intsrc, tmp;
 
 	// Determine the interrupt source
-	intsrc = UART_GetIntId(LPC_UART0);
+	intsrc = UART_GetIntId(UARTx);
 	tmp = intsrc & UART_IIR_INTID_MASK;
 
-	// Receive Line Status
+	// Receive Line Status: count the error, drop the bad character and go on
 	if (tmp == UART_IIR_INTID_RLS)
 	{
-		// Check line status
-		tmp1 = UART_GetLineStatus(LPC_UART0);
-		// Mask out the Receive Ready and Transmit Holding empty status
-		tmp1 &= (UART_LSR_OE | UART_LSR_PE | UART_LSR_FE | UART_LSR_BI | UART_LSR_RXFE);
-		// If any error exist
-		if (tmp1)
-		{
-			while(tmp1)
-			{
-				; //implement error handling here
-			}
-		}
+		uart_line_status(port, UART_GetLineStatus(UARTx));
+		UART_IntReceive(UARTx);
+	}
+
+	// Modem status change (UART1 only), reading MSR clears it
+	if (!(intsrc & UART_IIR_INTSTAT_PEND) && (tmp == UART1_IIR_INTID_MODEM)
+		&& (port == &UART_Port[1]))
+	{
+		port->ModemStat = UART_FullModemGetStatus(LPC_UART1);
+		port->ModemEvents++;
 	}
 
 #ifdef AB_MODE
@@ -63,16 +90,16 @@ void UART0_IRQHandler(void)
     {
         // Clear interrupt pending
         if(intsrc & UART_IIR_ABEO_INT)
-            UART_ABClearIntPending(LPC_UART0, UART_AUTOBAUD_INTSTAT_ABEO);
+            UART_ABClearIntPending(UARTx, UART_AUTOBAUD_INTSTAT_ABEO);
         if (intsrc & UART_IIR_ABTO_INT)
-            UART_ABClearIntPending(LPC_UART0, UART_AUTOBAUD_INTSTAT_ABTO);
+            UART_ABClearIntPending(UARTx, UART_AUTOBAUD_INTSTAT_ABTO);
         if (Synchronous == RESET)
         {
             /* Interrupt caused by End of auto-baud */
             if (intsrc & UART_AUTOBAUD_INTSTAT_ABEO)
             {
                 // Disable AB interrupt
-                UART_IntConfig(LPC_UART0, UART_INTCFG_ABEO, DISABLE);
+                UART_IntConfig(UARTx, UART_INTCFG_ABEO, DISABLE);
                 // Set Sync flag
                 Synchronous = SET;
             }
@@ -81,7 +108,7 @@ void UART0_IRQHandler(void)
             if (intsrc & UART_AUTOBAUD_INTSTAT_ABTO)
             {
                 /* Just clear this bit - Add your code here */
-                UART_ABClearIntPending(LPC_UART0, UART_AUTOBAUD_INTSTAT_ABTO);
+                UART_ABClearIntPending(UARTx, UART_AUTOBAUD_INTSTAT_ABTO);
             }
         }
     }
@@ -90,15 +117,35 @@ void UART0_IRQHandler(void)
 	// Receive Data Available or Character time-out
 	if ((tmp == UART_IIR_INTID_RDA) || (tmp == UART_IIR_INTID_CTI))
 	{
-		UART0_RxReady=1;
-		UART_IntReceive(LPC_UART0);
+		UART_IntReceive(UARTx);
 	}
 	// Transmit Holding Empty
 	if (tmp == UART_IIR_INTID_THRE)
 	{
-		UART_IntTransmit(LPC_UART0);
+		UART_IntTransmit(UARTx);
 	}
+}
+
+
+/*********************************************************************//**
+ * @brief	UART0 interrupt handler sub-routine
+ * @param	None
+ * @return	None
+ **********************************************************************/
+void UART0_IRQHandler(void)
+{
+	uart_irq_handler(&UART_Port[0]);
+}
+
 
+/*********************************************************************//**
+ * @brief	UART1 interrupt handler sub-routine
+ * @param	None
+ * @return	None
+ **********************************************************************/
+void UART1_IRQHandler(void)
+{
+	uart_irq_handler(&UART_Port[1]);
 }
 
 
@@ -109,76 +156,45 @@ void UART0_IRQHandler(void)
  **********************************************************************/
 void UART2_IRQHandler(void)
 {
-	// Call Standard UART 2 interrupt handler
-	uint32_t intsrc, tmp, tmp1;
-
-	/* Determine the interrupt source */
-	intsrc = UART_GetIntId(LPC_UART2);
-	tmp = intsrc & UART_IIR_INTID_MASK;
+	uart_irq_handler(&UART_Port[2]);
+}
 
-	// Receive Line Status
-	if (tmp == UART_IIR_INTID_RLS)
-	{
-		// Check line status
-		tmp1 = UART_GetLineStatus(LPC_UART2);
-		// Mask out the Receive Ready and Transmit Holding empty status
-		tmp1 &= (UART_LSR_OE | UART_LSR_PE | UART_LSR_FE | UART_LSR_BI | UART_LSR_RXFE);
-		// If any error exist
-		if (tmp1)
-		{
-			while(tmp1)
-			{
-				; //implement error handling here
-			}
-		}
-	}
 
-#ifdef AB_MODE
-    intsrc &= (UART_IIR_ABEO_INT | UART_IIR_ABTO_INT);
-    // Check if End of auto-baudrate interrupt or Auto baudrate time out
-    if (intsrc)
-    {
-        // Clear interrupt pending
-        if(intsrc & UART_IIR_ABEO_INT)
-            UART_ABClearIntPending(LPC_UART2, UART_AUTOBAUD_INTSTAT_ABEO);
-        if (intsrc & UART_IIR_ABTO_INT)
-            UART_ABClearIntPending(LPC_UART2, UART_AUTOBAUD_INTSTAT_ABTO);
-        if (Synchronous == RESET)
-        {
-            /* Interrupt caused by End of auto-baud */
-            if (intsrc & UART_AUTOBAUD_INTSTAT_ABEO)
-            {
-                // Disable AB interrupt
-                UART_IntConfig(LPC_UART2, UART_INTCFG_ABEO, DISABLE);
-                // Set Sync flag
-                Synchronous = SET;
-            }
+/*********************************************************************//**
+ * @brief	UART3 interrupt handler sub-routine
+ * @param	None
+ * @return	None
+ **********************************************************************/
+void UART3_IRQHandler(void)
+{
+	uart_irq_handler(&UART_Port[3]);
+}
 
-            /* Auto-Baudrate Time-Out interrupt (not implemented) */
-            if (intsrc & UART_AUTOBAUD_INTSTAT_ABTO)
-            {
-                /* Just clear this bit - Add your code here */
-                UART_ABClearIntPending(LPC_UART2, UART_AUTOBAUD_INTSTAT_ABTO);
-            }
-        }
-    }
 #endif
 
-	// Receive Data Available or Character time-out
-	if ((tmp == UART_IIR_INTID_RDA) || (tmp == UART_IIR_INTID_CTI))
-	{
-		UART2_RxReady=1;
-		UART_IntReceive(LPC_UART2);
-	}
-	// Transmit Holding Empty
-	if (tmp == UART_IIR_INTID_THRE)
+/*********************************************************************//**
+ * @brief		Get the descriptor of a UART peripheral
+ * @param[in]	UARTx	UART peripheral selected, should be:
+ *  			- LPC_UART0: UART0 peripheral
+ * 				- LPC_UART1: UART1 peripheral
+ * 				- LPC_UART2: UART2 peripheral
+ * 				- LPC_UART3: UART3 peripheral
+ * @return 		Port descriptor, NULL for an unknown peripheral
+ **********************************************************************/
+UART_PORT_Type *UART_GetPort(LPC_UART_TypeDef *UARTx)
+{
+	uint32_t i;
+
+	for (i = 0; i < UART_NUM_PORTS; i++)
 	{
-		UART_IntTransmit(LPC_UART2);
+		if (UART_Port[i].UARTx == UARTx)
+		{
+			return &UART_Port[i];
+		}
 	}
+	return NULL;
 }
 
-#endif
-
 /*********************************************************************//**
  * @brief		Determines best dividers to get a target clock rate
  * @param[in]	UARTx	Pointer to selected UART peripheral, should be:
@@ -335,6 +351,9 @@ void UART_Config(LPC_UART_TypeDef *UARTx, long int baud)
 	UART_FIFO_CFG_Type UARTFIFOConfigStruct;
 	// Pin configuration for UART
 	PINSEL_CFG_Type PinCfg;
+#ifdef INTERRUPT_MODE
+	UART_PORT_Type *port;
+#endif
 
 	// DeInit NVIC and SCBNVIC
 //	NVIC_DeInit();
@@ -399,6 +418,21 @@ void UART_Config(LPC_UART_TypeDef *UARTx, long int baud)
 		PINSEL_ConfigPin(&PinCfg);
 	}
 
+	else if(UARTx == LPC_UART3)
+	{
+		/*
+		 * Initialize UART3 pin connect
+		 */
+		PinCfg.Funcnum = 2;
+		PinCfg.OpenDrain = 0;
+		PinCfg.Pinmode = 0;
+		PinCfg.Pinnum = 0;
+		PinCfg.Portnum = 0;
+		PINSEL_ConfigPin(&PinCfg);
+		PinCfg.Pinnum = 1;
+		PINSEL_ConfigPin(&PinCfg);
+	}
+
 	/* Initialize UART Configuration parameter structure to default state:
 	 * Baudrate = 9600bps
 	 * 8 data bit
@@ -420,6 +454,14 @@ void UART_Config(LPC_UART_TypeDef *UARTx, long int baud)
 	 * 				- FIFO_State = ENABLE
 	 */
 	UART_FIFOConfigStructInit(&UARTFIFOConfigStruct);
+#ifdef UART_TX_DMA_MODE
+	// Tx FIFO requests the GPDMA channel draining the ring
+	UARTFIFOConfigStruct.FIFO_DMAMode = ENABLE;
+	if (!(LPC_SC->PCONP & CLKPWR_PCONP_PCGPDMA))
+	{
+		GPDMA_Init();
+	}
+#endif
 
 	// Initialize FIFO for UARTx peripheral
 	UART_FIFOConfig(UARTx, &UARTFIFOConfigStruct);
@@ -439,44 +481,36 @@ void UART_Config(LPC_UART_TypeDef *UARTx, long int baud)
 	UART_IntConfig(UARTx, UART_INTCFG_RBR, ENABLE);
 	/* Enable UART line status interrupt */
 	UART_IntConfig(UARTx, UART_INTCFG_RLS, ENABLE);
+	/* UART1 only: modem status interrupt, updates ModemStat/ModemEvents */
+	if (((LPC_UART1_TypeDef *)UARTx) == LPC_UART1)
+	{
+		UART_IntConfig(UARTx, UART1_INTCFG_MS, ENABLE);
+	}
 
 	/**
 	 * Do not enable transmit interrupt here, since it is handled by
-	 * UART_Send() function, just to reset Tx Interrupt state for the
-	 * first time
+	 * UART_Send() function, the Tx state is reset with the ring below
 	 */
-	TxIntStat = RESET;
+
+	port = UART_GetPort(UARTx);
 
 	// Reset ring buf head and tail idx
-//	__BUF_RESET(rb.rx_head);
-//	__BUF_RESET(rb.rx_tail);
-//	__BUF_RESET(rb.tx_head);
-//	__BUF_RESET(rb.tx_tail);
+	__BUF_RESET(port->rb.rx_head);
+	__BUF_RESET(port->rb.rx_tail);
+	__BUF_RESET(port->rb.tx_head);
+	__BUF_RESET(port->rb.tx_tail);
+	port->rb.tx_busy = RESET;
+	port->rb.tx_drop = 0;
+	port->rb.rx_drop = 0;
+#ifdef UART_TX_DMA_MODE
+	port->rb.tx_dma_ch = -1;
+#endif
+	port->RxCount = 0;
+	port->TxCount = 0;
 
-	if(UARTx == LPC_UART0)
-	{
-		// Reset ring buf head and tail idx
-		__BUF_RESET(rb0.rx_head);
-		__BUF_RESET(rb0.rx_tail);
-		__BUF_RESET(rb0.tx_head);
-		__BUF_RESET(rb0.tx_tail);
-		/* preemption = 1, sub-priority = 1 */
-		NVIC_SetPriority(UART0_IRQn, ((0x01<<3)|0x01));
-		/* Enable Interrupt for UART0 channel */
-		NVIC_EnableIRQ(UART0_IRQn);
-	}
-	else if(UARTx == LPC_UART2)
-	{
-		// Reset ring buf head and tail idx
-		__BUF_RESET(rb2.rx_head);
-		__BUF_RESET(rb2.rx_tail);
-		__BUF_RESET(rb2.tx_head);
-		__BUF_RESET(rb2.tx_tail);
-		/* preemption = 1, sub-priority = 1 */
-		NVIC_SetPriority(UART2_IRQn, 2);
-		/* Enable Interrupt for UART2 channel */
-		NVIC_EnableIRQ(UART2_IRQn);
-	}
+	NVIC_SetPriority(port->IRQn, port->IntPrio);
+	/* Enable Interrupt for UART channel */
+	NVIC_EnableIRQ(port->IRQn);
 
 #ifdef AB_MODE
     /* ---------------------- Auto baud rate section ----------------------- */
@@ -888,6 +922,133 @@ uint32_t UART_Send(LPC_UART_TypeDef *UARTx, uint8_t *txbuf, uint32_t buflen, TRA
 	return bSent;
 }
 
+#endif
+
+
+/*********************************************************************//**
+ * @brief		Account line errors reported by a Line Status Register
+ * 				read. The character at the top of the Rx FIFO belongs to
+ * 				a parity, framing or break error and is discarded.
+ * @param[in]	port	UART port descriptor
+ * @param[in]	lsr		Line status just read (reading clears the errors)
+ * @return 		TRUE if a character was discarded
+ **********************************************************************/
+static Bool uart_line_status(UART_PORT_Type *port, uint8_t lsr)
+{
+	if (lsr & UART_LSR_OE)
+	{
+		port->OverrunErr++;
+	}
+	if (lsr & UART_LSR_PE)
+	{
+		port->ParityErr++;
+	}
+	if (lsr & UART_LSR_FE)
+	{
+		port->FramingErr++;
+	}
+	if (lsr & UART_LSR_BI)
+	{
+		port->BreakCnt++;
+	}
+
+	if ((lsr & UART_LSR_RDR) && (lsr & (UART_LSR_PE | UART_LSR_FE | UART_LSR_BI)))
+	{
+		(void)port->UARTx->RBR;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+
+/*********************************************************************//**
+ * @brief		Take one received character of a port
+ * @param[in]	port	UART port descriptor
+ * @param[out]	c		Received character
+ * @return 		TRUE if a character was available
+ **********************************************************************/
+static Bool uart_rx_pop(UART_PORT_Type *port, uint8_t *c)
+{
+#ifdef INTERRUPT_MODE
+	UART_RING_BUFFER_T *rb = &port->rb;
+
+	// Single consumer, the Rx interrupt only moves rx_head
+	if (__BUF_IS_EMPTY(rb->rx_head, rb->rx_tail, rb->rx_mask))
+	{
+		return FALSE;
+	}
+	*c = rb->rx[rb->rx_tail];
+	__BUF_INCR(rb->rx_tail, rb->rx_mask);
+	return TRUE;
+#else
+	uint8_t lsr;
+
+	lsr = UART_GetLineStatus(port->UARTx);
+	if (uart_line_status(port, lsr) || !(lsr & UART_LSR_RDR))
+	{
+		return FALSE;
+	}
+	*c = port->UARTx->RBR & UART_RBR_MASKBIT;
+	port->RxTick = SYSTICK_GetTick();
+	port->RxStamp = now_us();
+	port->RxCount++;
+	return TRUE;
+#endif
+}
+
+
+/*********************************************************************//**
+ * @brief		Receive a block of data with a deadline and an optional
+ * 				inter-character gap ending the frame
+ * @param[in]	UARTx	UART peripheral selected, should be:
+ *  			- LPC_UART0: UART0 peripheral
+ * 				- LPC_UART1: UART1 peripheral
+ * 				- LPC_UART2: UART2 peripheral
+ * 				- LPC_UART3: UART3 peripheral
+ * @param[out]	rxbuf 	Pointer to Received buffer
+ * @param[in]	buflen 	Length of Received buffer
+ * @param[in]	timeout	Ticks (ms) to wait for buflen characters from the
+ * 						call, 0 takes what is pending, UART_WAIT_FOREVER
+ * 						has no deadline
+ * @param[in]	gap		Ticks (ms) of line silence after a character that
+ * 						end the frame, 0 disables the gap check
+ * @return 		Number of bytes received
+ *
+ * Note: the tick is SYSTICK_GetTick(), SYSTICK_Config() must be called
+ * before using a deadline or gap.
+ **********************************************************************/
+uint32_t UART_ReceiveTimeout(LPC_UART_TypeDef *UARTx, uint8_t *rxbuf, uint32_t buflen,
+							uint32_t timeout, uint32_t gap)
+{
+	UART_PORT_Type *port;
+	uint32_t start, bytes = 0;
+
+	port = UART_GetPort(UARTx);
+	start = SYSTICK_GetTick();
+
+	while (bytes < buflen)
+	{
+		if (uart_rx_pop(port, &rxbuf[bytes]))
+		{
+			bytes++;
+			continue;
+		}
+
+		// Nothing pending: end of frame or deadline
+		if (gap && bytes && ((uint32_t)(SYSTICK_GetTick() - port->RxTick) >= gap))
+		{
+			break;
+		}
+		if ((timeout != UART_WAIT_FOREVER) && ((uint32_t)(SYSTICK_GetTick() - start) >= timeout))
+		{
+			break;
+		}
+	}
+
+	return bytes;
+}
+
+
 /*********************************************************************//**
  * @brief		Receive a block of data via UART peripheral
  * @param[in]	UARTx	Selected UART peripheral used to send data,
@@ -898,76 +1059,60 @@ uint32_t UART_Send(LPC_UART_TypeDef *UARTx, uint8_t *txbuf, uint32_t buflen, TRA
  * 				- LPC_UART3: UART3 peripheral
  * @param[out]	rxbuf 	Pointer to Received buffer
  * @param[in]	buflen 	Length of Received buffer
- * @param[in] 	flag 	Flag mode, should be NONE_BLOCKING or BLOCKING
-
+ * @param[in] 	flag 	Flag mode, should be NONE_BLOCKING, BLOCKING or
+ * 						TIME_BLOCKING
  * @return 		Number of bytes received
  *
- * Note: when using UART in BLOCKING mode, a time-out condition is used
- * via defined symbol UART_BLOCKING_TIMEOUT.
+ * Note: TIME_BLOCKING gives up UART_RX_TIMEOUT_MS SysTick ticks after
+ * the call, see UART_ReceiveTimeout().
  **********************************************************************/
 uint32_t UART_Receive(LPC_UART_TypeDef *UARTx, uint8_t *rxbuf, uint32_t buflen, TRANSFER_BLOCK_Type flag)
 {
-	uint32_t bToRecv, bRecv, timeOut;
-	uint8_t *pChar = rxbuf;
-
-	bToRecv = buflen;
-
-	// Blocking mode
 	if (flag == BLOCKING)
 	{
-		bRecv = 0;
-		while (bToRecv)
-		{
-			while (!(UARTx->LSR & UART_LSR_RDR))
-			{
-				//Infinite Loop
-			}
-			// Get data from the buffer
-			(*pChar++) = UART_ReceiveByte(UARTx);
-			bToRecv--;
-			bRecv++;
-		}
+		return UART_ReceiveTimeout(UARTx, rxbuf, buflen, UART_WAIT_FOREVER, 0);
 	}
 	else if (flag == TIME_BLOCKING)
 	{
-		bRecv = 0;
-		while (bToRecv)
-		{
-			timeOut = UART_BLOCKING_TIMEOUT;
-			while (!(UARTx->LSR & UART_LSR_RDR))
-			{
-				if (timeOut == 0) break;
-				timeOut--;
-			}
-			// Time out!
-			if(timeOut == 0) break;
-			// Get data from the buffer
-			(*pChar++) = UART_ReceiveByte(UARTx);
-			bToRecv--;
-			bRecv++;
-		}
+		return UART_ReceiveTimeout(UARTx, rxbuf, buflen, UART_RX_TIMEOUT_MS, 0);
+	}
+	return UART_ReceiveTimeout(UARTx, rxbuf, buflen, 0, 0);
+}
+
+
+/*********************************************************************//**
+ * @brief		Wait until every byte queued before the call has left the
+ * 				transmitter (Tx ring drained, FIFO and shift register empty)
+ * @param[in]	UARTx	UART peripheral selected, should be:
+ *  			- LPC_UART0: UART0 peripheral
+ * 				- LPC_UART1: UART1 peripheral
+ * 				- LPC_UART2: UART2 peripheral
+ * 				- LPC_UART3: UART3 peripheral
+ * @return 		None
+ *
+ * Note: must not be called from an interrupt that blocks the UART or
+ * GPDMA interrupt.
+ **********************************************************************/
+void UART_TxFlush(LPC_UART_TypeDef *UARTx)
+{
+#ifdef INTERRUPT_MODE
+	UART_PORT_Type *port;
+
+	port = UART_GetPort(UARTx);
+	if (port != NULL)
+	{
+		while (port->rb.tx_busy == SET);
+	}
+#endif
+	if (((LPC_UART1_TypeDef *)UARTx) == LPC_UART1)
+	{
+		while (!(((LPC_UART1_TypeDef *)UARTx)->LSR & UART_LSR_TEMT));
 	}
-	// None blocking mode
 	else
 	{
-		bRecv = 0;
-		while (bToRecv)
-		{
-			if (!(UARTx->LSR & UART_LSR_RDR))
-			{
-				break;
-			}
-			else
-			{
-				(*pChar++) = UART_ReceiveByte(UARTx);
-				bRecv++;
-				bToRecv--;
-			}
-		}
+		while (!(UARTx->LSR & UART_LSR_TEMT));
 	}
-	return bRecv;
 }
-#endif
 
 
 /*********************************************************************//**
@@ -987,47 +1132,41 @@ int16 getche(LPC_UART_TypeDef *UARTx, TRANSFER_BLOCK_Type mode)
 	uint8_t key[1];
 	uint32_t idx, len;
 
-	    if(UARTx == LPC_UART0)
-	    {
-		    len = UART_Receive(UARTx, key, 1, mode);
-		    /* Got some data */
-		    idx = 0;
-		    while (idx < len)
-		    {
-		        if ( key[idx] == In_CR )
-	            {
-			        return(key[idx]);
-	            }
-	            else if ( key[idx] == In_DELETE || key[idx] == In_BACKSPACE )
-	            {
-	    	        return(key[idx]);
-	            }
-	            else if ( key[idx] == In_ESC )
-	            {
-	    	        EscFlag = 1;
-	    	        return ( In_ESC );
-	            }
-	            else if ( key[idx] >= ' ' )
-	            {
-	    	        return (key[idx]);
-	            }
-	            else
-	            {
-	    	        UART_Send(UARTx,&key[idx],1,BLOCKING);
-	            }
-		        idx++;
-		    }
-	    }
-	    else if(UARTx == LPC_UART2)
-	    {
-		    len = UART_Receive(UARTx, key, 1, mode);
-		    /* Got some data */
-		    idx = 0;
-		    while (idx < len)
-		    {
-		    	return(key[idx]);
-		    }
-	    }
+	len = UART_Receive(UARTx, key, 1, mode);
+
+	// Console keys are interpreted on UART0 only
+	if (UARTx != LPC_UART0)
+	{
+		return (len ? key[0] : 0);
+	}
+
+	/* Got some data */
+	idx = 0;
+	while (idx < len)
+	{
+		if ( key[idx] == In_CR )
+		{
+			return(key[idx]);
+		}
+		else if ( key[idx] == In_DELETE || key[idx] == In_BACKSPACE )
+		{
+			return(key[idx]);
+		}
+		else if ( key[idx] == In_ESC )
+		{
+			EscFlag = 1;
+			return ( In_ESC );
+		}
+		else if ( key[idx] >= ' ' )
+		{
+			return (key[idx]);
+		}
+		else
+		{
+			UART_Send(UARTx,&key[idx],1,BLOCKING);
+		}
+		idx++;
+	}
 
     return(0);
 }
@@ -1105,6 +1244,37 @@ uchar get_line(LPC_UART_TypeDef *UARTx, schar s[], uchar lim)
 }
 
 
+/*********************************************************************//**
+ * @brief		Queue the bytes collected in a printf() span
+ * @param[in]	span	Span to send, emptied on return
+ * @return 		None
+ **********************************************************************/
+static void uart_span_flush(UART_SPAN_Type *span)
+{
+	if (span->len)
+	{
+		UART_Send(span->UARTx, span->buf, span->len, BLOCKING);
+		span->len = 0;
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief		Add a byte to a printf() span, a full span is queued
+ * @param[in]	span	Span collecting the output
+ * @param[in]	c		Byte to add
+ * @return 		None
+ **********************************************************************/
+static void uart_span_put(UART_SPAN_Type *span, uint8_t c)
+{
+	span->buf[span->len++] = c;
+	if (span->len == UART_PRINTF_SPAN)
+	{
+		uart_span_flush(span);
+	}
+}
+
+
 /*********************************************************************//**
  * @brief		Modified version of Standard Printf statement
  *
@@ -1147,37 +1317,42 @@ int16 printf(LPC_UART_TypeDef *UARTx, const char *format, ...)
 #ifdef RTC_MODE
 	RTC_TIME_Type FullTime;
 #endif
+	UART_SPAN_Type span;
 	va_list ap;
 	va_start(ap, format);
 
+	span.UARTx = UARTx;
+	span.len = 0;
+
 	for(;;)
 	{
 		while((format_flag = *format++) != '%')      /* until full format string read */
 		{
 			if(!format_flag)
 			{                        /* until '%' or '\0' */
+				uart_span_flush(&span);
 				return (0);
 			}
-			UART_Send(UARTx,&format_flag,1,BLOCKING);
+			uart_span_put(&span, format_flag);
 		}
 
 		switch(format_flag = *format++)
 		{
 			case 'c':
 				format_flag = va_arg(ap, int);
-				UART_Send(UARTx,&format_flag,1,BLOCKING);
+				uart_span_put(&span, format_flag);
 
 				continue;
 
 			default:
-				UART_Send(UARTx,&format_flag,1,BLOCKING);
+				uart_span_put(&span, format_flag);
 
         		continue;
 
 			case 'b':
 				format_flag = va_arg(ap,int);
-				UART_Send(UARTx,&(hex[(uint16)format_flag >> 4]),1,BLOCKING);
-				UART_Send(UARTx,&(hex[(uint16)format_flag & 0x0F]),1,BLOCKING);
+				uart_span_put(&span, hex[(uint16)format_flag >> 4]);
+				uart_span_put(&span, hex[(uint16)format_flag & 0x0F]);
 
 				continue;
 
@@ -1185,24 +1360,27 @@ int16 printf(LPC_UART_TypeDef *UARTx, const char *format, ...)
 				ptr = va_arg(ap, schar *);
 				while(*ptr)
 				{
-					UART_Send(UARTx,&(*ptr++),1,BLOCKING);
+					uart_span_put(&span, *ptr++);
 				}
 
 				continue;
 #ifdef RTC_MODE
 			case 't':
+				uart_span_flush(&span);
 				RTC_GetFullTime (LPC_RTC, &FullTime);
 			    printf(UARTx, "%d02:%d02:%d02",FullTime.HOUR,FullTime.MIN,FullTime.SEC);
 
 				continue;
 
 			case 'y':
+				uart_span_flush(&span);
 				RTC_GetFullTime (LPC_RTC, &FullTime);
 			    printf(UARTx, "%d02/%d02/%d04",FullTime.DOM,FullTime.MONTH,FullTime.YEAR);
 
 				continue;
 
 			case 'a':
+				uart_span_flush(&span);
 				RTC_GetFullAlarmTime (LPC_RTC, &FullTime);
 				printf(UARTx, "Time: %d02:%d02:%d02",FullTime.HOUR,FullTime.MIN,FullTime.SEC);
 				printf(UARTx, "  Date: %d02/%d02/%d04",FullTime.DOM,FullTime.MONTH,FullTime.YEAR);
@@ -1215,7 +1393,7 @@ int16 printf(LPC_UART_TypeDef *UARTx, const char *format, ...)
 				u_val = va_arg(ap, uint32_t);
 				do
 				{
-					UART_Send(UARTx,&(hex[u_val/div_val]),1,BLOCKING);
+					uart_span_put(&span, hex[u_val/div_val]);
 					u_val %= div_val;
 					div_val /= base;
 				}while(div_val);
@@ -1233,7 +1411,7 @@ int16 printf(LPC_UART_TypeDef *UARTx, const char *format, ...)
 				{
 					u_val = - u_val;    /* applied to unsigned type, result still unsigned */
 					temp = '-';
-				    UART_Send(UARTx,&temp,1,BLOCKING);
+				    uart_span_put(&span, temp);
 				}
 
 				goto  CONVERSION_LOOP;
@@ -1249,12 +1427,12 @@ int16 printf(LPC_UART_TypeDef *UARTx, const char *format, ...)
 				while(div_val > 1 && div_val > u_val)
 				{
 					div_val /= base;
-					UART_Send(UARTx,&fill_char,1,BLOCKING);
+					uart_span_put(&span, fill_char);
 				}
 
 				do
 				{
-					UART_Send(UARTx,&(hex[u_val/div_val]),1,BLOCKING);
+					uart_span_put(&span, hex[u_val/div_val]);
 					u_val %= div_val;
 					div_val /= base;
 				}while(div_val);
@@ -1453,7 +1631,8 @@ FlagStatus UART_CheckBusy(LPC_UART_TypeDef *UARTx)
  **********************************************************************/
 void UART_FIFOConfig(LPC_UART_TypeDef *UARTx, UART_FIFO_CFG_Type *FIFOCfg)
 {
-	uint8_t tmp = 0;
+	uint8_t tmp = 0, trglvl;
+	UART_PORT_Type *port;
 
 	CHECK_PARAM(PARAM_UARTx(UARTx));
 	CHECK_PARAM(PARAM_UART_FIFO_LEVEL(FIFOCfg->FIFO_Level));
@@ -1465,32 +1644,20 @@ void UART_FIFOConfig(LPC_UART_TypeDef *UARTx, UART_FIFO_CFG_Type *FIFOCfg)
 	switch (FIFOCfg->FIFO_Level){
 	case UART_FIFO_TRGLEV0:
 		tmp |= UART_FCR_TRG_LEV0;
-		if(UARTx==LPC_UART0)
-			TrgLvlU0=1;
-		else if(UARTx==LPC_UART2)
-			TrgLvlU2=1;
+		trglvl = 1;
 		break;
 	case UART_FIFO_TRGLEV1:
 		tmp |= UART_FCR_TRG_LEV1;
-		if(UARTx==LPC_UART0)
-			TrgLvlU0=4;
-		else if(UARTx==LPC_UART2)
-			TrgLvlU2=4;
+		trglvl = 4;
 		break;
 	case UART_FIFO_TRGLEV2:
 		tmp |= UART_FCR_TRG_LEV2;
-		if(UARTx==LPC_UART0)
-			TrgLvlU0=8;
-		else if(UARTx==LPC_UART2)
-			TrgLvlU2=8;
+		trglvl = 8;
 		break;
 	case UART_FIFO_TRGLEV3:
 	default:
 		tmp |= UART_FCR_TRG_LEV3;
-		if(UARTx==LPC_UART0)
-			TrgLvlU0=14;
-		else if(UARTx==LPC_UART2)
-			TrgLvlU2=14;
+		trglvl = 14;
 		break;
 	}
 
@@ -1508,6 +1675,10 @@ void UART_FIFOConfig(LPC_UART_TypeDef *UARTx, UART_FIFO_CFG_Type *FIFOCfg)
 	}
 
 
+	// Characters per Rx interrupt, used by UART_Receive()
+	port = UART_GetPort(UARTx);
+	port->TrgLvl = trglvl;
+
 	//write to FIFO control register
 	if (((LPC_UART1_TypeDef *)UARTx) == LPC_UART1)
 	{
@@ -1975,11 +2146,11 @@ uint32_t UART_RS485Send(LPC_UART1_TypeDef *UARTx, uint8_t *pDatFrm, \
 		tmp &= ~(UART_LCR_PARITY_EVEN);
 		UARTx->LCR = tmp;
 		cnt = UART_Send((LPC_UART_TypeDef *)UARTx, pDatFrm, size, BLOCKING);
-		while (!(UARTx->LSR & UART_LSR_TEMT));
+		UART_TxFlush((LPC_UART_TypeDef *)UARTx);
 		UARTx->LCR = save;
 	} else {
 		cnt = UART_Send((LPC_UART_TypeDef *)UARTx, pDatFrm, size, BLOCKING);
-		while (!(UARTx->LSR & UART_LSR_TEMT));
+		UART_TxFlush((LPC_UART_TypeDef *)UARTx);
 	}
 	return cnt;
 }
@@ -2013,458 +2184,270 @@ uint32_t UART_RS485SendData(LPC_UART1_TypeDef *UARTx, uint8_t *pData, uint32_t s
 #ifdef INTERRUPT_MODE
 
 /********************************************************************//**
- * @brief 		UART0 receive function (ring buffer used)
- * @param[in]	None
+ * @brief 		UART receive function (ring buffer used), empties the
+ * 				Rx FIFO into the ring of the port
+ * @param[in]	UARTx	UART peripheral
  * @return 		None
  *********************************************************************/
 void UART_IntReceive(LPC_UART_TypeDef *UARTx)
 {
-	uint8_t tmpc=0;
+	UART_PORT_Type *port;
+	UART_RING_BUFFER_T *rb;
+	uint8_t tmpc;
 
-	if(UARTx==LPC_UART0)
+	port = UART_GetPort(UARTx);
+	rb = &port->rb;
+
+	while (UARTx->LSR & UART_LSR_RDR)
 	{
-		while(1)
-		{
-			// Call UART read function in UART driver
-			tmpc = UART_ReceiveByte(LPC_UART0);
+		// Call UART read function in UART driver
+		tmpc = UART_ReceiveByte(UARTx);
+		port->RxCount++;
+		port->RxTick = SYSTICK_GetTick();
+		port->RxStamp = now_us();
 
-			if (tmpc)
-			{
-				/* Check if buffer is more space
-				 * If no more space, remaining character will be trimmed out
-				 */
-				if (!__BUF_IS_FULL(rb0.rx_head,rb0.rx_tail))
-				{
-					rb0.rx[rb0.rx_head] = tmpc;
-					__BUF_INCR(rb0.rx_head);
-				}
-			}
-			// no more data
-			else
-			{
-				break;
-			}
+		/* Check if buffer is more space
+		 * If no more space, remaining character will be trimmed out
+		 */
+		if (!__BUF_IS_FULL(rb->rx_head, rb->rx_tail, rb->rx_mask))
+		{
+			rb->rx[rb->rx_head] = tmpc;
+			__BUF_INCR(rb->rx_head, rb->rx_mask);
 		}
-	}
-
-	if(UARTx==LPC_UART2)
-	{
-		while(1)
+		else
 		{
-			// Call UART read function in UART driver
-
-			tmpc = UART_ReceiveByte(LPC_UART2);
-
-			if (tmpc)
-			{
-				/* Check if buffer is more space
-				 * If no more space, remaining character will be trimmed out
-				 */
-				if (!__BUF_IS_FULL(rb2.rx_head,rb2.rx_tail))
-				{
-					rb2.rx[rb2.rx_head] = tmpc;
-					__BUF_INCR(rb2.rx_head);
-				}
-			}
-			// no more data
-			else
-			{
-				break;
-			}
+			rb->rx_drop++;
 		}
 	}
 }
 
 
+#ifdef UART_TX_DMA_MODE
+static void uart_tx_dma_done(uint32_t ChannelNum, uint32_t Status);
+
 /********************************************************************//**
- * @brief 		UART transmit function (ring buffer used)
- * @param[in]	None
+ * @brief 		Start a GPDMA transfer of the oldest contiguous part of
+ * 				the Tx ring, falls back to the THRE interrupt when no
+ * 				channel is free
+ * @param[in]	port	UART port descriptor
  * @return 		None
  *********************************************************************/
-void UART_IntTransmit(LPC_UART_TypeDef *UARTx)
+static void uart_tx_dma_start(UART_PORT_Type *port)
 {
-	uint32_t bToSend, bSent, timeOut, fifo_cnt;
-	uint8_t *pChar;
+	UART_RING_BUFFER_T *rb = &port->rb;
+	GPDMA_Channel_CFG_Type cfg;
+	uint32_t head, tail;
 
-	if(UARTx==LPC_UART0)
+	if (rb->tx_dma_ch < 0)
 	{
-		// Disable THRE interrupt
-		UART_IntConfig(UARTx, UART_INTCFG_THRE, DISABLE);
-
-		/* Wait for FIFO buffer empty, transfer UART_TX_FIFO_SIZE bytes
-		 * of data or break whenever ring buffers are empty */
-		/* Wait until THR empty */
-		while (UART_CheckBusy(UARTx) == SET);
-
-		while (!__BUF_IS_EMPTY(rb0.tx_head,rb0.tx_tail))
-		{
-			/* Move a piece of data into the transmit FIFO */
-			// None blocking mode
-			pChar = &rb0.tx[rb0.tx_tail];
-			bToSend = 1;
-			bSent = 0;
-			while (bToSend)
-			{
-				timeOut = UART_BLOCKING_TIMEOUT;
-				// Wait for THR empty with timeout
-				while (!(UARTx->LSR & UART_LSR_THRE))
-				{
-					if (timeOut == 0) break;
-					timeOut--;
-				}
-				// Time out!
-				if(timeOut == 0) break;
-				fifo_cnt = UART_TX_FIFO_SIZE;
-				while (fifo_cnt && bToSend)
-				{
-					UART_SendByte(UARTx, (*pChar++));
-					fifo_cnt--;
-					bToSend--;
-					bSent++;
-				}
-			}
-
-			if(bSent)
-			{
-				/* Update transmit ring FIFO tail pointer */
-				__BUF_INCR(rb0.tx_tail);
-			}
-			else
-			{
-				break;
-			}
-		}
-
-		/* If there is no more data to send, disable the transmit
-		   interrupt - else enable it or keep it enabled */
-		if (__BUF_IS_EMPTY(rb0.tx_head, rb0.tx_tail))
+		rb->tx_dma_ch = GPDMA_ChannelAlloc(GPDMA_PRIO_LOW);
+		if (rb->tx_dma_ch < 0)
 		{
-			UART_IntConfig(UARTx, UART_INTCFG_THRE, DISABLE);
-			// Reset Tx Interrupt state
-			TxIntStat = RESET;
-		}
-		else
-		{
-			// Set Tx Interrupt state
-			TxIntStat = SET;
-			UART_IntConfig(UARTx, UART_INTCFG_THRE, ENABLE);
+			UART_IntTransmit(port->UARTx);
+			return;
 		}
+		GPDMA_SetCallback(rb->tx_dma_ch, uart_tx_dma_done);
 	}
 
-	if(UARTx==LPC_UART2)
+	head = rb->tx_head;
+	tail = rb->tx_tail;
+	if (head == tail)
 	{
-		// Disable THRE interrupt
-		UART_IntConfig(UARTx, UART_INTCFG_THRE, DISABLE);
+		rb->tx_busy = RESET;
+		return;
+	}
 
-		/* Wait for FIFO buffer empty, transfer UART_TX_FIFO_SIZE bytes
-		 * of data or break whenever ring buffers are empty */
-		/* Wait until THR empty */
-		while (UART_CheckBusy(UARTx) == SET);
+	// Up to the end of the ring, the wrapped part follows on completion
+	rb->tx_dma_len = (head > tail) ? (head - tail) : (rb->tx_mask + 1 - tail);
 
-		while (!__BUF_IS_EMPTY(rb2.tx_head,rb2.tx_tail))
-		{
-			/* Move a piece of data into the transmit FIFO */
-			// None blocking mode
-			pChar = &rb2.tx[rb2.tx_tail];
-			bToSend = 1;
-			bSent = 0;
-			while (bToSend)
-			{
-				timeOut = UART_BLOCKING_TIMEOUT;
-				// Wait for THR empty with timeout
-				while (!(UARTx->LSR & UART_LSR_THRE))
-				{
-					if (timeOut == 0) break;
-					timeOut--;
-				}
-				// Time out!
-				if(timeOut == 0) break;
-				fifo_cnt = UART_TX_FIFO_SIZE;
-				while (fifo_cnt && bToSend)
-				{
-					UART_SendByte(UARTx, (*pChar++));
-					fifo_cnt--;
-					bToSend--;
-					bSent++;
-				}
-			}
-
-			if(bSent)
-			{
-				/* Update transmit ring FIFO tail pointer */
-				__BUF_INCR(rb2.tx_tail);
-			}
-			else
-			{
-				break;
-			}
-		}
-
-		/* If there is no more data to send, disable the transmit
-		   interrupt - else enable it or keep it enabled */
-		if (__BUF_IS_EMPTY(rb2.tx_head, rb2.tx_tail))
-		{
-			UART_IntConfig(UARTx, UART_INTCFG_THRE, DISABLE);
-			// Reset Tx Interrupt state
-			TxIntStat = RESET;
-		}
-		else
-		{
-			// Set Tx Interrupt state
-			TxIntStat = SET;
-			UART_IntConfig(UARTx, UART_INTCFG_THRE, ENABLE);
-		}
-	}
+	cfg.ChannelNum = rb->tx_dma_ch;
+	cfg.TransferSize = rb->tx_dma_len;
+	cfg.TransferWidth = 0;
+	cfg.SrcMemAddr = (uint32_t)&rb->tx[tail];
+	cfg.DstMemAddr = 0;
+	cfg.TransferType = GPDMA_TRANSFERTYPE_M2P;
+	cfg.SrcConn = 0;
+	cfg.DstConn = port->TxConn;
+	cfg.DMALLI = 0;
 
+	rb->tx_busy = SET;
+	GPDMA_Setup(&cfg);
+	GPDMA_ChannelCmd(rb->tx_dma_ch, ENABLE);
 }
 
 
-/*********************************************************************//**
- * @brief		Send a block of data via UART peripheral
- * @param[in]	UARTx	Selected UART peripheral used to send data, should be:
- *   			- LPC_UART0: UART0 peripheral
- * 				- LPC_UART1: UART1 peripheral
- * 				- LPC_UART2: UART2 peripheral
- * 				- LPC_UART3: UART3 peripheral
- * @param[in]	txbuf 	Pointer to Transmit buffer
- * @param[in]	buflen 	Length of Transmit buffer
- * @param[in] 	flag 	Flag used in  UART transfer, should be
- * 						NONE_BLOCKING or BLOCKING
- * @return 		Number of bytes sent.
- *
- * Note: when using UART in BLOCKING mode, a time-out condition is used
- * via defined symbol UART_BLOCKING_TIMEOUT.
- **********************************************************************/
-uint32_t UART_Send(LPC_UART_TypeDef *UARTx, uint8_t *txbuf, uint32_t buflen, TRANSFER_BLOCK_Type flag)
+/********************************************************************//**
+ * @brief 		Tx DMA completion, releases the sent bytes and starts
+ * 				the next part of the ring (called from DMA_IRQHandler)
+ * @param[in]	ChannelNum	GPDMA channel
+ * @param[in]	Status		GPDMA_CB_DONE or GPDMA_CB_ERROR
+ * @return 		None
+ *********************************************************************/
+static void uart_tx_dma_done(uint32_t ChannelNum, uint32_t Status)
 {
-	uint8_t *data = (uint8_t *) txbuf;
-	uint32_t bytes = 0;
+	UART_RING_BUFFER_T *rb;
+	uint32_t i;
 
-	if(UARTx==LPC_UART0)
+	for (i = 0; i < UART_NUM_PORTS; i++)
 	{
+		rb = &UART_Port[i].rb;
+		if (rb->tx_dma_ch == (int32_t)ChannelNum)
+		{
+			rb->tx_tail = (rb->tx_tail + rb->tx_dma_len) & rb->tx_mask;
+			rb->tx_dma_len = 0;
+			uart_tx_dma_start(&UART_Port[i]);
+			break;
+		}
+	}
+}
+#endif
 
-		/* Temporarily lock out UART transmit interrupts during this
-		   read so the UART transmit interrupt won't cause problems
-		   with the index values */
-		UART_IntConfig(UARTx, UART_INTCFG_THRE, DISABLE);
 
-		/* Loop until transmit run buffer is full or until n_bytes
-		   expires */
-		while ((buflen > 0) && (!__BUF_IS_FULL(rb0.tx_head, rb0.tx_tail)))
-		{
-			/* Write data from buffer into ring buffer */
-			rb0.tx[rb0.tx_head] = *data;
-			data++;
+/********************************************************************//**
+ * @brief 		Start draining the Tx ring of an idle UART, must be
+ * 				called with interrupts disabled
+ * @param[in]	port	UART port descriptor
+ * @return 		None
+ *********************************************************************/
+static void uart_tx_kick(UART_PORT_Type *port)
+{
+#ifdef UART_TX_DMA_MODE
+	uart_tx_dma_start(port);
+#else
+	UART_IntTransmit(port->UARTx);
+#endif
+}
 
-			/* Increment head pointer */
-			__BUF_INCR(rb0.tx_head);
 
-			/* Increment data count and decrement buffer size count */
-			bytes++;
-			buflen--;
-		}
+/********************************************************************//**
+ * @brief 		UART transmit function (ring buffer used), refills the
+ * 				Tx FIFO from the ring without waiting. Called from the
+ * 				THRE interrupt and to start an idle transmitter.
+ * @param[in]	UARTx	UART peripheral
+ * @return 		None
+ *********************************************************************/
+void UART_IntTransmit(LPC_UART_TypeDef *UARTx)
+{
+	UART_PORT_Type *port;
+	UART_RING_BUFFER_T *rb;
+	uint32_t fifo_cnt;
 
+	port = UART_GetPort(UARTx);
+	if (port == NULL)
+	{
+		return;
 	}
+	rb = &port->rb;
 
-	if(UARTx==LPC_UART2)
+	// THRE set: the whole Tx FIFO is free
+	if (UARTx->LSR & UART_LSR_THRE)
 	{
-		/* Temporarily lock out UART transmit interrupts during this
-		   read so the UART transmit interrupt won't cause problems
-		   with the index values */
-		UART_IntConfig(UARTx, UART_INTCFG_THRE, DISABLE);
-
-		/* Loop until transmit run buffer is full or until n_bytes
-		   expires */
-		while ((buflen > 0) && (!__BUF_IS_FULL(rb2.tx_head, rb2.tx_tail)))
+		fifo_cnt = UART_TX_FIFO_SIZE;
+		while (fifo_cnt && !__BUF_IS_EMPTY(rb->tx_head, rb->tx_tail, rb->tx_mask))
 		{
-			/* Write data from buffer into ring buffer */
-			rb2.tx[rb2.tx_head] = *data;
-			data++;
-
-			/* Increment head pointer */
-			__BUF_INCR(rb2.tx_head);
-
-			/* Increment data count and decrement buffer size count */
-			bytes++;
-			buflen--;
+			UART_SendByte(UARTx, rb->tx[rb->tx_tail]);
+			__BUF_INCR(rb->tx_tail, rb->tx_mask);
+			fifo_cnt--;
 		}
 	}
 
-	/**
-	 * Check if current Tx interrupt enable is reset,
-	 * that means the Tx interrupt must be re-enabled
-	 * due to call UART_IntTransmit() function to trigger
-	 * this interrupt type
-	 */
-
-
-	if (TxIntStat == RESET)
+	/* If there is no more data to send, disable the transmit
+	   interrupt - else enable it or keep it enabled */
+	if (__BUF_IS_EMPTY(rb->tx_head, rb->tx_tail, rb->tx_mask))
 	{
-		UART_IntTransmit(UARTx);
+		UART_IntConfig(UARTx, UART_INTCFG_THRE, DISABLE);
+		rb->tx_busy = RESET;
 	}
-	/**
-	 * Otherwise, re-enables Tx Interrupt
-	 */
 	else
 	{
+		rb->tx_busy = SET;
 		UART_IntConfig(UARTx, UART_INTCFG_THRE, ENABLE);
 	}
-
-	return bytes;
 }
 
+
 /*********************************************************************//**
- * @brief		Receive a block of data via UART peripheral
- * @param[in]	UARTx	Selected UART peripheral used to send data,
- * 				should be:
+ * @brief		Queue a block of data on the Tx ring of a UART peripheral,
+ * 				the ring is drained by the THRE interrupt or GPDMA
+ * @param[in]	UARTx	Selected UART peripheral used to send data, should be:
  *   			- LPC_UART0: UART0 peripheral
  * 				- LPC_UART1: UART1 peripheral
  * 				- LPC_UART2: UART2 peripheral
  * 				- LPC_UART3: UART3 peripheral
- * @param[out]	rxbuf 	Pointer to Received buffer
- * @param[in]	buflen 	Length of Received buffer
- * @param[in] 	flag 	Flag mode, should be NONE_BLOCKING or BLOCKING
-
- * @return 		Number of bytes received
+ * @param[in]	txbuf 	Pointer to Transmit buffer
+ * @param[in]	buflen 	Length of Transmit buffer
+ * @param[in] 	flag 	Flag used in  UART transfer, should be
+ * 						NONE_BLOCKING or BLOCKING
+ * @return 		Number of bytes queued.
  *
- * Note: when using UART in BLOCKING mode, a time-out condition is used
- * via defined symbol UART_BLOCKING_TIMEOUT.
+ * Note: NONE_BLOCKING queues what fits in the ring. BLOCKING applies
+ * TX_FULL_POLICY to the rest, dropped bytes are counted in tx_drop.
+ * Producers (tasks and interrupts) are serialized by a short critical
+ * section per call, the drain side never takes a lock.
  **********************************************************************/
-uint32_t UART_Receive(LPC_UART_TypeDef *UARTx, uint8_t *rxbuf, uint32_t buflen, TRANSFER_BLOCK_Type flag)
+uint32_t UART_Send(LPC_UART_TypeDef *UARTx, uint8_t *txbuf, uint32_t buflen, TRANSFER_BLOCK_Type flag)
 {
-	uint8_t *data = (uint8_t *) rxbuf,ind=0;
-	uint32_t bytes = 0,time=0;
-	if(UARTx==LPC_UART0)
-	{
-		ind=buflen/TrgLvlU0;
-		if((buflen%TrgLvlU0!=0) && (buflen>8))
-			ind++;
-		else if((buflen%TrgLvlU0!=0) && (buflen<8))
-			ind++;
+	UART_PORT_Type *port;
+	UART_RING_BUFFER_T *rb;
+	uint32_t primask, bytes = 0;
 
-		if(flag==TIME_BLOCKING)
-		{
-			time=UART_BLOCKING_TIMEOUT;
-			while((time!=0))
-			{
-				time--;
-				if(UART0_RxReady==1)
-				{
-					ind--;
-					UART0_RxReady=0;
-				}
-				if(ind==0)
-					break;
-			}
-		}
-		else if(flag==BLOCKING)
-		{
-			while(1)
-			{
-				while(UART0_RxReady!=1);
-				ind--;
-				UART0_RxReady=0;
-				if(ind==0)
-					break;
-			}
-		}
-		else if(flag==NONE_BLOCKING)
-		{
-			UART0_RxReady=0;
-		}
-		/* Temporarily lock out UART receive interrupts during this
-		   read so the UART receive interrupt won't cause problems
-		   with the index values */
-		UART_IntConfig(UARTx, UART_INTCFG_RBR, DISABLE);
-		/* Loop until receive buffer ring is empty or
-			until max_bytes expires */
-
-		while ((buflen > 0) && (!(__BUF_IS_EMPTY(rb0.rx_head, rb0.rx_tail))))
-		{
-			/* Read data from ring buffer into user buffer */
-			*data = rb0.rx[rb0.rx_tail];
-			data++;
+	port = UART_GetPort(UARTx);
+	rb = &port->rb;
 
-			/* Update tail pointer */
-			__BUF_INCR(rb0.rx_tail);
+	while (buflen)
+	{
+		primask = __get_PRIMASK();
+		__disable_irq();
 
-			/* Increment data count and decrement buffer size count */
+		/* Loop until transmit ring buffer is full or until n_bytes
+		   expires */
+		while ((buflen > 0) && (!__BUF_IS_FULL(rb->tx_head, rb->tx_tail, rb->tx_mask)))
+		{
+			rb->tx[rb->tx_head] = *txbuf++;
+			__BUF_INCR(rb->tx_head, rb->tx_mask);
 			bytes++;
 			buflen--;
 		}
 
-		/* Re-enable UART interrupts */
-		UART_IntConfig(UARTx, UART_INTCFG_RBR, ENABLE);
-	}
-
-	if((UARTx==LPC_UART2))
-	{
-		ind=buflen/TrgLvlU2;
-
-		if((buflen%TrgLvlU2!=0) && (buflen>8))
-			ind++;
-		else if((buflen%TrgLvlU2!=0) && (buflen<8))
-			ind++;
-
-		if(flag==TIME_BLOCKING)
+#if (TX_FULL_POLICY == UART_TX_FULL_OVERWRITE) && !defined(UART_TX_DMA_MODE)
+		// Make room by dropping the oldest bytes still queued
+		while ((buflen > 0) && (flag == BLOCKING))
 		{
-			time=UART_BLOCKING_TIMEOUT;
-			while((time!=0))
-			{
-				time--;
-				if(UART2_RxReady==1)
-				{
-					ind--;
-					UART2_RxReady=0;
-				}
-				if(ind==0)
-					break;
-			}
+			__BUF_INCR(rb->tx_tail, rb->tx_mask);
+			rb->tx_drop++;
+			rb->tx[rb->tx_head] = *txbuf++;
+			__BUF_INCR(rb->tx_head, rb->tx_mask);
+			bytes++;
+			buflen--;
 		}
-		else if(flag==BLOCKING)
+#endif
+
+		if (rb->tx_busy == RESET)
 		{
-			while(1)
-			{
-				while(UART2_RxReady!=1);
-				ind--;
-				UART2_RxReady=0;
-				if(ind==0)
-					break;
-			}
+			uart_tx_kick(port);
 		}
-		else if(flag==NONE_BLOCKING)
+		__set_PRIMASK(primask);
+
+		if ((buflen == 0) || (flag != BLOCKING))
 		{
-			UART2_RxReady=0;
+			break;
 		}
 
-		/* Temporarily lock out UART receive interrupts during this
-		   read so the UART receive interrupt won't cause problems
-		   with the index values */
-
-		UART_IntConfig(UARTx, UART_INTCFG_RBR, DISABLE);
-		/* Loop until receive buffer ring is empty or
-			until max_bytes expires */
-		while ((buflen > 0) && (!(__BUF_IS_EMPTY(rb2.rx_head, rb2.rx_tail))))
+#if (TX_FULL_POLICY == UART_TX_FULL_BLOCK)
+		// The Tx interrupt cannot run while a handler waits for it
+		if (__get_IPSR() == 0)
 		{
-			/* Read data from ring buffer into user buffer */
-			*data = rb2.rx[rb2.rx_tail];
-			data++;
-
-			/* Update tail pointer */
-			__BUF_INCR(rb2.rx_tail);
-
-			/* Increment data count and decrement buffer size count */
-			bytes++;
-			buflen--;
+			continue;
 		}
-
-		/* Re-enable UART interrupts */
-		UART_IntConfig(UARTx, UART_INTCFG_RBR, ENABLE);
-		UART2_RxReady=0;
+#endif
+		rb->tx_drop += buflen;
+		break;
 	}
 
-    return bytes;
+	port->TxCount += bytes;
+	return bytes;
 }
+
 #endif
 
 
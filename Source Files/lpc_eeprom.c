@@ -0,0 +1,329 @@
+/******************************************************************//**
+* @file		lpc_eeprom.c
+* @brief	Contains all functions support for the common serial E2PROM
+* 			engine: page splitting, ACK/WIP ready polling and
+* 			sequential reads on I2C, SPI and SSP parts
+* @version	1.0
+* @date		25. June. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* Peripheral group ----------------------------------------------------------- */
+/** @addtogroup E2P
+ * @{
+ */
+
+/* Includes ------------------------------------------------------------------- */
+#include "lpc_eeprom.h"
+
+
+/* Private Macros ------------------------------------------------------------- */
+/** @defgroup E2P_Private_Macros E2P Private Macros
+ * @{
+ */
+
+/** 25xx instruction set */
+#define E2P_SPI_WRITE			0x02		// Write data
+#define E2P_SPI_READ			0x03		// Read data
+#define E2P_SPI_RDSR			0x05		// Read status register
+#define E2P_SPI_WREN			0x06		// Set write enable latch
+
+/** Status register, write in progress */
+#define E2P_SPI_SR_WIP			0x01
+
+/**
+ * @}
+ */
+
+
+/* Private Variables ---------------------------------------------------------- */
+/** @defgroup E2P_Private_Variables E2P Private Variables
+ * @{
+ */
+
+/** Address bytes followed by one page, an I2C write is one transfer */
+static uint8_t e2p_buf[2 + E2P_MAX_PAGE];
+
+/**
+ * @}
+ */
+
+
+/* Private Functions ---------------------------------------------------------- */
+/*********************************************************************//**
+ * @brief		Polled transfer on the SPI or SSP bus of a device, chip
+ * 				select is handled by the caller
+ * @param[in]	spi: bus device
+ * @param[in]	tx: bytes to send, NULL sends 0xFF
+ * @param[out]	rx: received bytes, NULL discards them
+ * @param[in]	length: number of bytes
+ * @return 		TRUE if all bytes were transferred
+ **********************************************************************/
+static Bool e2p_spi_xfer (SPIBUS_DEVICE_Type *spi, const uint8_t *tx, uint8_t *rx, uint32_t length)
+{
+	SPI_DATA_SETUP_Type spiCfg;
+	SSP_DATA_SETUP_Type sspCfg;
+
+	if (spi->Bus == SPIBUS_SPI)
+	{
+		spiCfg.tx_data = (void *)tx;
+		spiCfg.rx_data = rx;
+		spiCfg.length = length;
+		return (SPI_ReadWrite(LPC_SPI, &spiCfg, SPI_TRANSFER_POLLING) == (int32_t)length) ? TRUE : FALSE;
+	}
+
+	sspCfg.tx_data = (void *)tx;
+	sspCfg.rx_data = rx;
+	sspCfg.length = length;
+	return (SSP_ReadWrite((spi->Bus == SPIBUS_SSP0) ? LPC_SSP0 : LPC_SSP1, &sspCfg, \
+			SSP_TRANSFER_POLLING) == (int32_t)length) ? TRUE : FALSE;
+}
+
+
+/*********************************************************************//**
+ * @brief		Send an SPI instruction with its address bytes, the
+ * 				device must be selected
+ * @param[in]	dev: E2PROM part
+ * @param[in]	cmd: E2P_SPI_READ or E2P_SPI_WRITE
+ * @param[in]	addr: byte address
+ * @return 		TRUE if sent
+ **********************************************************************/
+static Bool e2p_spi_cmd (E2P_DEVICE_Type *dev, uint8_t cmd, uint32_t addr)
+{
+	uint8_t hdr[3];
+	uint32_t n = 0;
+
+	if (dev->AddrBytes == 1)
+	{
+		hdr[n++] = cmd | (((addr >> 8) & 0x01) << 3);
+	}
+	else
+	{
+		hdr[n++] = cmd;
+		hdr[n++] = (uint8_t)(addr >> 8);
+	}
+	hdr[n++] = (uint8_t)addr;
+
+	return e2p_spi_xfer(dev->Spi, hdr, NULL, n);
+}
+
+
+/*********************************************************************//**
+ * @brief		Write and/or read an I2C part at an address, retrying
+ * 				while it does not acknowledge its slave address
+ * @param[in]	dev: E2PROM part
+ * @param[in]	addr: byte address
+ * @param[in]	tx: bytes written after the address, NULL if none
+ * @param[in]	tx_len: number of bytes to write, at most E2P_MAX_PAGE
+ * @param[out]	rx: bytes read after a repeated start, NULL if none
+ * @param[in]	rx_len: number of bytes to read
+ * @return 		SUCCESS, or ERROR on a bus error or after WriteTime ms
+ *
+ * Note: a part in its write cycle ignores its address. Retrying the
+ * next transfer until it is acknowledged (ACK polling) starts it as
+ * soon as the cycle ends instead of after a fixed delay.
+ **********************************************************************/
+static Status e2p_i2c_xfer (E2P_DEVICE_Type *dev, uint32_t addr, const uint8_t *tx, uint32_t tx_len, \
+							uint8_t *rx, uint32_t rx_len)
+{
+	I2C_M_SETUP_Type setup;
+	uint32_t n = 0, i, start;
+
+	if (dev->AddrBytes == 2)
+	{
+		e2p_buf[n++] = (uint8_t)(addr >> 8);
+	}
+	e2p_buf[n++] = (uint8_t)addr;
+	for (i = 0; i < tx_len; i++)
+	{
+		e2p_buf[n++] = tx[i];
+	}
+
+	setup.sl_addr7bit = dev->Id | ((addr >> (8 * dev->AddrBytes)) & 0x07);
+	setup.tx_data = e2p_buf;
+	setup.tx_length = n;
+	setup.rx_data = rx;
+	setup.rx_length = rx_len;
+	setup.retransmissions_max = 0;
+
+	start = SYSTICK_GetTick();
+	while (I2C_MasterTransferData(dev->I2Cx, &setup, I2C_TRANSFER_POLLING) == ERROR)
+	{
+		if ((setup.status & I2C_STAT_CODE_BITMASK) != I2C_I2STAT_M_TX_SLAW_NACK)
+		{
+			return ERROR;
+		}
+		if ((uint32_t)(SYSTICK_GetTick() - start) > dev->WriteTime)
+		{
+			return ERROR;
+		}
+	}
+	return SUCCESS;
+}
+
+
+/*********************************************************************//**
+ * @brief		Write one page, or part of one, without waiting for the
+ * 				write cycle to end
+ * @param[in]	dev: E2PROM part
+ * @param[in]	addr: byte address
+ * @param[in]	data: bytes to write, all within one page
+ * @param[in]	length: number of bytes
+ * @return 		SUCCESS or ERROR
+ **********************************************************************/
+static Status e2p_write_page (E2P_DEVICE_Type *dev, uint32_t addr, const uint8_t *data, uint32_t length)
+{
+	uint8_t cmd = E2P_SPI_WREN;
+	Bool ok;
+
+	if (dev->I2Cx != NULL)
+	{
+		return e2p_i2c_xfer(dev, addr, data, length, NULL, 0);
+	}
+
+	if (E2P_WaitReady(dev) != SUCCESS)
+	{
+		return ERROR;
+	}
+
+	SPIBUS_Select(dev->Spi);
+	ok = e2p_spi_xfer(dev->Spi, &cmd, NULL, 1);
+	SPIBUS_Release(dev->Spi);
+
+	SPIBUS_Select(dev->Spi);
+	ok = ok && e2p_spi_cmd(dev, E2P_SPI_WRITE, addr) && e2p_spi_xfer(dev->Spi, data, NULL, length);
+	SPIBUS_Release(dev->Spi);
+
+	return ok ? SUCCESS : ERROR;
+}
+/* End of Private Functions --------------------------------------------------- */
+
+
+/* Public Functions ----------------------------------------------------------- */
+/** @addtogroup E2P_Public_Functions
+ * @{
+ */
+
+/*********************************************************************//**
+ * @brief		Write any number of bytes at any address
+ * @param[in]	dev: E2PROM part
+ * @param[in]	addr: byte address
+ * @param[in]	data: bytes to write
+ * @param[in]	length: number of bytes
+ * @return 		SUCCESS, or ERROR if out of range or the part failed
+ *
+ * Note: the data is split at page boundaries. Each page starts as soon
+ * as the part reports the previous write cycle done, and the function
+ * returns once the last one is.
+ **********************************************************************/
+Status E2P_Write (E2P_DEVICE_Type *dev, uint32_t addr, const uint8_t *data, uint32_t length)
+{
+	uint32_t chunk;
+
+	if ((dev->PageSize > E2P_MAX_PAGE) || (addr + length > dev->Size))
+	{
+		return ERROR;
+	}
+
+	while (length != 0)
+	{
+		chunk = dev->PageSize - (addr & (dev->PageSize - 1));
+		if (chunk > length)
+		{
+			chunk = length;
+		}
+		if (e2p_write_page(dev, addr, data, chunk) != SUCCESS)
+		{
+			return ERROR;
+		}
+		addr += chunk;
+		data += chunk;
+		length -= chunk;
+	}
+
+	return E2P_WaitReady(dev);
+}
+
+
+/*********************************************************************//**
+ * @brief		Read any number of bytes in one sequential read
+ * @param[in]	dev: E2PROM part
+ * @param[in]	addr: byte address
+ * @param[out]	data: bytes read
+ * @param[in]	length: number of bytes
+ * @return 		SUCCESS, or ERROR if out of range or the part failed
+ **********************************************************************/
+Status E2P_Read (E2P_DEVICE_Type *dev, uint32_t addr, uint8_t *data, uint32_t length)
+{
+	Bool ok;
+
+	if ((length == 0) || (addr + length > dev->Size))
+	{
+		return ERROR;
+	}
+
+	if (dev->I2Cx != NULL)
+	{
+		return e2p_i2c_xfer(dev, addr, NULL, 0, data, length);
+	}
+
+	if (E2P_WaitReady(dev) != SUCCESS)
+	{
+		return ERROR;
+	}
+
+	SPIBUS_Select(dev->Spi);
+	ok = e2p_spi_cmd(dev, E2P_SPI_READ, addr) && e2p_spi_xfer(dev->Spi, NULL, data, length);
+	SPIBUS_Release(dev->Spi);
+
+	return ok ? SUCCESS : ERROR;
+}
+
+
+/*********************************************************************//**
+ * @brief		Wait for the write cycle of a part to end
+ * @param[in]	dev: E2PROM part
+ * @return 		SUCCESS, or ERROR if still busy after WriteTime ms
+ *
+ * Note: I2C parts are polled with an address-only write (ACK polling),
+ * SPI parts by reading the WIP bit of the status register.
+ **********************************************************************/
+Status E2P_WaitReady (E2P_DEVICE_Type *dev)
+{
+	uint8_t cmd[2] = { E2P_SPI_RDSR, 0xFF };
+	uint8_t sr[2];
+	uint32_t start;
+
+	if (dev->I2Cx != NULL)
+	{
+		return e2p_i2c_xfer(dev, 0, NULL, 0, NULL, 0);
+	}
+
+	start = SYSTICK_GetTick();
+	while (1)
+	{
+		SPIBUS_Select(dev->Spi);
+		sr[1] = E2P_SPI_SR_WIP;
+		e2p_spi_xfer(dev->Spi, cmd, sr, 2);
+		SPIBUS_Release(dev->Spi);
+
+		if (!(sr[1] & E2P_SPI_SR_WIP))
+		{
+			return SUCCESS;
+		}
+		if ((uint32_t)(SYSTICK_GetTick() - start) > dev->WriteTime)
+		{
+			return ERROR;
+		}
+	}
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+/* --------------------------------- End Of File ------------------------------ */
@@ -0,0 +1,877 @@
+/******************************************************************//**
+* @file		lpc_fat.c
+* @brief	Contains all functions support for the FAT16/FAT32 file
+* 			system with a set associative write-back sector cache
+* @version	1.0
+* @date		18. June. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* Peripheral group ----------------------------------------------------------- */
+/** @addtogroup FAT
+ * @{
+ */
+
+/* Includes ------------------------------------------------------------------- */
+#include "lpc_fat.h"
+
+
+/* Private Macros ------------------------------------------------------------- */
+/** @defgroup FAT_Private_Macros FAT Private Macros
+ * @{
+ */
+
+#define FAT_TYPE_NONE		0
+#define FAT_TYPE_16			16
+#define FAT_TYPE_32			32
+
+#define FAT_NO_SECTOR		0xFFFFFFFFUL	// empty cache line
+#define FAT_CLUST_EOC		0x0FFFFFFFUL	// end of chain, FAT16 values are widened to it
+#define FAT_CLUST_ERR		0xFFFFFFFFUL	// disk error while reading the FAT
+
+#define FAT_DIR_ENTRY_SIZE	32
+
+/* Fixed timestamp for new and modified entries: 1 Jan 2014, 00:00 */
+#define FAT_DEFAULT_DATE	(((2014 - 1980) << 9) | (1 << 5) | 1)
+#define FAT_DEFAULT_TIME	0
+
+/* Little endian access to on-disk structures, which are not aligned */
+#define LD16(p)			((uint16_t)((p)[0] | ((p)[1] << 8)))
+#define LD32(p)			((uint32_t)((p)[0] | ((p)[1] << 8) | ((p)[2] << 16) | ((uint32_t)(p)[3] << 24)))
+#define ST16(p,v)		do { (p)[0] = (uint8_t)(v); (p)[1] = (uint8_t)((v) >> 8); } while (0)
+#define ST32(p,v)		do { ST16(p, v); ST16((p) + 2, (v) >> 16); } while (0)
+
+/**
+ * @}
+ */
+
+
+/* Private Types -------------------------------------------------------------- */
+/** @defgroup FAT_Private_Types FAT Private Types
+ * @{
+ */
+
+/**
+ * @brief Sector cache line
+ */
+typedef struct {
+	uint32_t Data[FAT_SECTOR_SIZE / 4];	/**< Sector contents, word aligned */
+	uint32_t Sector;					/**< Cached sector, FAT_NO_SECTOR if empty */
+	uint32_t Stamp;						/**< Last use, for LRU eviction within the set */
+	uint8_t  Dirty;						/**< Needs writing back */
+} FAT_CACHE_LINE_Type;
+
+/**
+ * @brief Mounted volume
+ */
+typedef struct {
+	const FAT_DISK_Type *Disk;
+	uint8_t  Type;				/**< FAT_TYPE_16 or FAT_TYPE_32, FAT_TYPE_NONE if not mounted */
+	uint8_t  SecPerClus;		/**< Sectors per cluster */
+	uint8_t  NumFATs;			/**< Number of FAT copies */
+	uint8_t  FsInfoValid;		/**< FAT32 FSInfo free count not yet invalidated */
+	uint32_t FsInfo;			/**< FAT32 FSInfo sector, 0 if none */
+	uint32_t FatStart;			/**< First sector of the first FAT */
+	uint32_t FatSize;			/**< Sectors per FAT */
+	uint32_t RootStart;			/**< FAT16 root directory sector */
+	uint32_t RootSectors;		/**< FAT16 root directory length */
+	uint32_t RootCluster;		/**< FAT32 root directory cluster, 0 on FAT16 */
+	uint32_t DataStart;			/**< Sector of cluster 2 */
+	uint32_t Clusters;			/**< Number of data clusters */
+	uint32_t ClusBytes;			/**< Bytes per cluster */
+	uint32_t NextFree;			/**< Where the next free cluster search starts */
+} FAT_FS_Type;
+
+/**
+ * @}
+ */
+
+
+/* Private Variables ---------------------------------------------------------- */
+/** @defgroup FAT_Private_Variables FAT Private Variables
+ * @{
+ */
+
+static FAT_FS_Type fat_fs;
+static FAT_CACHE_LINE_Type fat_cache[FAT_CACHE_SECTORS];
+static uint32_t fat_cache_clock;
+
+/**
+ * @}
+ */
+
+
+/* Private Functions ---------------------------------------------------------- */
+/*********************************************************************//**
+ * @brief		SD card sector read for FAT_SdDisk
+ * @param[in]	sector, buf, count: see FAT_DISK_Type
+ * @return 		SUCCESS or ERROR
+ **********************************************************************/
+static Status fat_sd_read (uint32_t sector, uint8_t *buf, uint32_t count)
+{
+	return (SD_ReadBlocks(sector, buf, count) == SD_OK) ? SUCCESS : ERROR;
+}
+
+
+/*********************************************************************//**
+ * @brief		SD card sector write for FAT_SdDisk
+ * @param[in]	sector, buf, count: see FAT_DISK_Type
+ * @return 		SUCCESS or ERROR
+ **********************************************************************/
+static Status fat_sd_write (uint32_t sector, const uint8_t *buf, uint32_t count)
+{
+	return (SD_WriteBlocks(sector, buf, count) == SD_OK) ? SUCCESS : ERROR;
+}
+
+
+/*********************************************************************//**
+ * @brief		Write a cache line back, mirroring FAT sectors to every copy
+ * @param[in]	line: dirty cache line
+ * @return 		FAT_OK or FAT_ERR_DISK
+ **********************************************************************/
+static fat_error fat_cache_write (FAT_CACHE_LINE_Type *line)
+{
+	uint32_t sector = line->Sector;
+	uint8_t n;
+
+	if (fat_fs.Disk->Write(sector, (uint8_t *)line->Data, 1) != SUCCESS) return FAT_ERR_DISK;
+
+	if ((sector >= fat_fs.FatStart) && (sector < (fat_fs.FatStart + fat_fs.FatSize)))
+	{
+		for (n = 1; n < fat_fs.NumFATs; n++)
+		{
+			sector += fat_fs.FatSize;
+			if (fat_fs.Disk->Write(sector, (uint8_t *)line->Data, 1) != SUCCESS) return FAT_ERR_DISK;
+		}
+	}
+	line->Dirty = 0;
+	return FAT_OK;
+}
+
+
+/*********************************************************************//**
+ * @brief		Get a sector into the cache
+ * @param[in]	- sector: sector number
+ * 				- load: FALSE if the caller overwrites the whole sector
+ * @return 		Cache line, NULL on disk error
+ *
+ * Note: a sector can only live in the FAT_CACHE_WAYS lines of its set;
+ * on a miss the least recently used of them is written back if dirty and
+ * reused.
+ **********************************************************************/
+static FAT_CACHE_LINE_Type *fat_cache_get (uint32_t sector, Bool load)
+{
+	FAT_CACHE_LINE_Type *line = &fat_cache[(sector % FAT_CACHE_SETS) * FAT_CACHE_WAYS];
+	FAT_CACHE_LINE_Type *victim = line;
+	uint8_t w;
+
+	for (w = 0; w < FAT_CACHE_WAYS; w++, line++)
+	{
+		if (line->Sector == sector)
+		{
+			line->Stamp = ++fat_cache_clock;
+			return line;
+		}
+		if (line->Stamp < victim->Stamp) victim = line;
+	}
+
+	if (victim->Dirty && (fat_cache_write(victim) != FAT_OK)) return NULL;
+	victim->Sector = FAT_NO_SECTOR;
+	victim->Stamp = 0;
+	if (load && (fat_fs.Disk->Read(sector, (uint8_t *)victim->Data, 1) != SUCCESS)) return NULL;
+
+	victim->Sector = sector;
+	victim->Stamp = ++fat_cache_clock;
+	return victim;
+}
+
+
+/*********************************************************************//**
+ * @brief		Write back or drop the cached copies of a sector range
+ * @param[in]	- sector: first sector
+ * 				- count: number of sectors
+ * 				- drop: TRUE to discard the lines (range is about to be
+ * 					    overwritten), FALSE to write dirty ones back
+ * @return 		FAT_OK or FAT_ERR_DISK
+ **********************************************************************/
+static fat_error fat_cache_range (uint32_t sector, uint32_t count, Bool drop)
+{
+	FAT_CACHE_LINE_Type *line;
+	uint8_t n;
+
+	for (n = 0, line = fat_cache; n < FAT_CACHE_SECTORS; n++, line++)
+	{
+		if ((line->Sector == FAT_NO_SECTOR) ||
+			(line->Sector < sector) || (line->Sector >= (sector + count))) continue;
+
+		if (drop)
+		{
+			line->Sector = FAT_NO_SECTOR;
+			line->Stamp = 0;
+			line->Dirty = 0;
+		}
+		else if (line->Dirty && (fat_cache_write(line) != FAT_OK)) return FAT_ERR_DISK;
+	}
+	return FAT_OK;
+}
+
+
+/*********************************************************************//**
+ * @brief		First sector of a data cluster
+ * @param[in]	clus: cluster number (>= 2)
+ * @return 		sector number
+ **********************************************************************/
+static uint32_t fat_clust2sect (uint32_t clus)
+{
+	return fat_fs.DataStart + (clus - 2) * fat_fs.SecPerClus;
+}
+
+
+/*********************************************************************//**
+ * @brief		Read a FAT entry
+ * @param[in]	clus: cluster number
+ * @return 		next cluster, 0 if free, FAT_CLUST_EOC at end of chain,
+ * 				FAT_CLUST_ERR on disk error
+ **********************************************************************/
+static uint32_t fat_get (uint32_t clus)
+{
+	FAT_CACHE_LINE_Type *line;
+	uint32_t off, val;
+	uint8_t *p;
+
+	off = (fat_fs.Type == FAT_TYPE_16) ? (clus * 2) : (clus * 4);
+	line = fat_cache_get(fat_fs.FatStart + off / FAT_SECTOR_SIZE, TRUE);
+	if (line == NULL) return FAT_CLUST_ERR;
+	p = (uint8_t *)line->Data + (off % FAT_SECTOR_SIZE);
+
+	if (fat_fs.Type == FAT_TYPE_16)
+	{
+		val = LD16(p);
+		if (val >= 0xFFF7) val = FAT_CLUST_EOC;
+	}
+	else
+	{
+		val = LD32(p) & 0x0FFFFFFF;
+		if (val >= 0x0FFFFFF7) val = FAT_CLUST_EOC;
+	}
+	return val;
+}
+
+
+/*********************************************************************//**
+ * @brief		Write a FAT entry, the mirror copies follow on write back
+ * @param[in]	- clus: cluster number
+ * 				- val: next cluster, 0 or FAT_CLUST_EOC
+ * @return 		FAT_OK or FAT_ERR_DISK
+ **********************************************************************/
+static fat_error fat_set (uint32_t clus, uint32_t val)
+{
+	FAT_CACHE_LINE_Type *line;
+	uint32_t off;
+	uint8_t *p;
+
+	off = (fat_fs.Type == FAT_TYPE_16) ? (clus * 2) : (clus * 4);
+	line = fat_cache_get(fat_fs.FatStart + off / FAT_SECTOR_SIZE, TRUE);
+	if (line == NULL) return FAT_ERR_DISK;
+	p = (uint8_t *)line->Data + (off % FAT_SECTOR_SIZE);
+
+	if (fat_fs.Type == FAT_TYPE_16)
+	{
+		ST16(p, val);
+	}
+	else
+	{
+		val = (val & 0x0FFFFFFF) | (LD32(p) & 0xF0000000);	// upper 4 bits are reserved
+		ST32(p, val);
+	}
+	line->Dirty = 1;
+	return FAT_OK;
+}
+
+
+/*********************************************************************//**
+ * @brief		Allocate a free cluster and append it to a chain
+ * @param[in]	prev: last cluster of the chain, 0 to start a new chain
+ * @return 		new cluster, 0 if the volume is full or on disk error
+ *
+ * Note: the search resumes after the last allocated cluster, so a file
+ * written sequentially gets contiguous clusters without rescanning the FAT.
+ **********************************************************************/
+static uint32_t fat_alloc (uint32_t prev)
+{
+	FAT_CACHE_LINE_Type *line;
+	uint32_t clus, n, val;
+
+	clus = fat_fs.NextFree;
+	for (n = 0; n < fat_fs.Clusters; n++, clus++)
+	{
+		if ((clus < 2) || (clus >= (fat_fs.Clusters + 2))) clus = 2;
+
+		val = fat_get(clus);
+		if (val == FAT_CLUST_ERR) return 0;
+		if (val != 0) continue;
+
+		if (fat_set(clus, FAT_CLUST_EOC) != FAT_OK) return 0;
+		if (prev && (fat_set(prev, clus) != FAT_OK)) return 0;
+		fat_fs.NextFree = clus + 1;
+
+		/* The FSInfo free count is only a hint, mark it unknown once */
+		if (fat_fs.FsInfoValid)
+		{
+			line = fat_cache_get(fat_fs.FsInfo, TRUE);
+			if (line == NULL) return 0;
+			ST32((uint8_t *)line->Data + 488, 0xFFFFFFFFUL);
+			line->Dirty = 1;
+			fat_fs.FsInfoValid = 0;
+		}
+		return clus;
+	}
+	return 0;
+}
+
+
+/*********************************************************************//**
+ * @brief		Convert one path component to a space padded 8.3 name
+ * @param[in]	- path: points at the component, moved past it and any '/'
+ * 				- name: 11 byte result
+ * @return 		FAT_OK or FAT_ERR_PARAM
+ **********************************************************************/
+static fat_error fat_make_name (const char **path, uint8_t *name)
+{
+	const char *p = *path;
+	uint8_t i = 0, lim = 8, c;
+
+	for (c = 0; c < 11; c++) name[c] = ' ';
+
+	while ((*p != '/') && (*p != '\0'))
+	{
+		c = (uint8_t)*p++;
+		if (c == '.')
+		{
+			if ((lim == 11) || (i == 0)) return FAT_ERR_PARAM;
+			i = 8;
+			lim = 11;
+			continue;
+		}
+		if ((i >= lim) || (c <= ' ') || (c == '\\') || (c == ':') || (c == '*') || (c == '?')) return FAT_ERR_PARAM;
+		if ((c >= 'a') && (c <= 'z')) c -= 'a' - 'A';
+		name[i++] = c;
+	}
+	if (name[0] == ' ') return FAT_ERR_PARAM;
+	if (name[0] == 0xE5) name[0] = 0x05;
+
+	while (*p == '/') p++;
+	*path = p;
+	return FAT_OK;
+}
+
+
+/*********************************************************************//**
+ * @brief		Look a name up in a directory, optionally finding a free slot
+ * @param[in]	- dir: first cluster of the directory, 0 for the FAT16 root
+ * 				- name: 8.3 name to find
+ * 				- extend: TRUE to grow the directory when it has no free slot
+ * 				- sector, offset: where the entry is, or the free slot
+ * @return 		FAT_OK if found, FAT_ERR_NOT_FOUND (sector is 0 if no free
+ * 				slot either), FAT_ERR_FULL or FAT_ERR_DISK
+ **********************************************************************/
+static fat_error fat_dir_find (uint32_t dir, const uint8_t *name, Bool extend,
+							   uint32_t *sector, uint16_t *offset)
+{
+	FAT_CACHE_LINE_Type *line;
+	uint32_t clus = dir, prev = 0, sec, nsec, n;
+	uint16_t i;
+	uint8_t *p, k;
+
+	*sector = 0;
+	for (;;)
+	{
+		if (clus == 0)
+		{
+			sec = fat_fs.RootStart;
+			nsec = fat_fs.RootSectors;
+		}
+		else
+		{
+			sec = fat_clust2sect(clus);
+			nsec = fat_fs.SecPerClus;
+		}
+
+		for (n = 0; n < nsec; n++, sec++)
+		{
+			line = fat_cache_get(sec, TRUE);
+			if (line == NULL) return FAT_ERR_DISK;
+			p = (uint8_t *)line->Data;
+
+			for (i = 0; i < FAT_SECTOR_SIZE; i += FAT_DIR_ENTRY_SIZE)
+			{
+				if ((p[i] == 0x00) || (p[i] == 0xE5))
+				{
+					if (*sector == 0)
+					{
+						*sector = sec;
+						*offset = i;
+					}
+					if (p[i] == 0x00) return FAT_ERR_NOT_FOUND;	// end of directory
+					continue;
+				}
+				if ((p[i + 11] & FAT_ATTR_LFN) == FAT_ATTR_LFN) continue;
+				if (p[i + 11] & FAT_ATTR_VOLUME_ID) continue;
+
+				for (k = 0; (k < 11) && (p[i + k] == name[k]); k++);
+				if (k == 11)
+				{
+					*sector = sec;
+					*offset = i;
+					return FAT_OK;
+				}
+			}
+		}
+
+		if (clus == 0) return FAT_ERR_NOT_FOUND;	// fixed size FAT16 root
+		prev = clus;
+		clus = fat_get(clus);
+		if (clus == FAT_CLUST_ERR) return FAT_ERR_DISK;
+		if (clus == FAT_CLUST_EOC) break;
+		if ((clus < 2) || (clus >= (fat_fs.Clusters + 2))) return FAT_ERR_NO_FS;
+	}
+
+	if ((*sector != 0) || !extend) return FAT_ERR_NOT_FOUND;
+
+	/* Directory full, add a zeroed cluster */
+	clus = fat_alloc(prev);
+	if (clus == 0) return FAT_ERR_FULL;
+	sec = fat_clust2sect(clus);
+	for (n = 0; n < fat_fs.SecPerClus; n++)
+	{
+		line = fat_cache_get(sec + n, FALSE);
+		if (line == NULL) return FAT_ERR_DISK;
+		for (i = 0; i < (FAT_SECTOR_SIZE / 4); i++) line->Data[i] = 0;
+		line->Dirty = 1;
+	}
+	*sector = sec;
+	*offset = 0;
+	return FAT_ERR_NOT_FOUND;
+}
+
+
+/*********************************************************************//**
+ * @brief		Make fp->Cluster the cluster holding fp->Pos
+ * @param[in]	- fp: open file
+ * 				- alloc: TRUE to extend the chain (writing)
+ * @return 		FAT_OK, FAT_ERR_FULL, FAT_ERR_NO_FS or FAT_ERR_DISK
+ *
+ * Note: the chain is only walked from the start when seeking backwards;
+ * sequential access and appends step one FAT entry per cluster.
+ **********************************************************************/
+static fat_error fat_file_cluster (FAT_FILE_Type *fp, Bool alloc)
+{
+	uint32_t need = fp->Pos / fat_fs.ClusBytes;
+	uint32_t next;
+
+	if ((fp->Cluster == 0) || (need < fp->ClusIdx))
+	{
+		if (fp->FirstCluster == 0)
+		{
+			if (!alloc) return FAT_ERR_NO_FS;
+			fp->FirstCluster = fat_alloc(0);
+			if (fp->FirstCluster == 0) return FAT_ERR_FULL;
+			fp->Dirty = 1;
+		}
+		fp->Cluster = fp->FirstCluster;
+		fp->ClusIdx = 0;
+	}
+
+	while (fp->ClusIdx < need)
+	{
+		next = fat_get(fp->Cluster);
+		if (next == FAT_CLUST_ERR) return FAT_ERR_DISK;
+		if (next == FAT_CLUST_EOC)
+		{
+			if (!alloc) return FAT_ERR_NO_FS;
+			next = fat_alloc(fp->Cluster);
+			if (next == 0) return FAT_ERR_FULL;
+		}
+		else if ((next < 2) || (next >= (fat_fs.Clusters + 2))) return FAT_ERR_NO_FS;
+		fp->Cluster = next;
+		fp->ClusIdx++;
+	}
+	return FAT_OK;
+}
+/* End of Private Functions --------------------------------------------------- */
+
+
+/* Public Variables ----------------------------------------------------------- */
+const FAT_DISK_Type FAT_SdDisk = { fat_sd_read, fat_sd_write };
+
+
+/* Public Functions ----------------------------------------------------------- */
+/** @addtogroup FAT_Public_Functions
+ * @{
+ */
+
+/*********************************************************************//**
+ * @brief		Mount the FAT16/FAT32 volume of a disk
+ * @param[in]	disk: block device, e.g. &FAT_SdDisk after SD_Init()
+ * @return 		FAT_OK, FAT_ERR_DISK or FAT_ERR_NO_FS
+ *
+ * Note: sector 0 may hold the boot sector itself or an MBR, in which
+ * case the first partition is used. FAT12 is not supported.
+ **********************************************************************/
+fat_error FAT_Mount (const FAT_DISK_Type *disk)
+{
+	FAT_CACHE_LINE_Type *line;
+	uint32_t base = 0, total, rsvd, data;
+	uint16_t root_ents;
+	uint8_t *p, n;
+
+	fat_fs.Type = FAT_TYPE_NONE;
+	fat_fs.Disk = disk;
+	fat_cache_clock = 0;
+	for (n = 0; n < FAT_CACHE_SECTORS; n++)
+	{
+		fat_cache[n].Sector = FAT_NO_SECTOR;
+		fat_cache[n].Stamp = 0;
+		fat_cache[n].Dirty = 0;
+	}
+
+	line = fat_cache_get(0, TRUE);
+	if (line == NULL) return FAT_ERR_DISK;
+	p = (uint8_t *)line->Data;
+	if (LD16(p + 510) != 0xAA55) return FAT_ERR_NO_FS;
+
+	/* No jump instruction: take the first MBR partition */
+	if ((p[0] != 0xEB) && (p[0] != 0xE9))
+	{
+		base = LD32(p + 446 + 8);
+		line = fat_cache_get(base, TRUE);
+		if (line == NULL) return FAT_ERR_DISK;
+		p = (uint8_t *)line->Data;
+		if (LD16(p + 510) != 0xAA55) return FAT_ERR_NO_FS;
+	}
+
+	/* BIOS Parameter Block */
+	if ((LD16(p + 11) != FAT_SECTOR_SIZE) || (p[13] == 0) || (p[16] == 0)) return FAT_ERR_NO_FS;
+	fat_fs.SecPerClus = p[13];
+	fat_fs.NumFATs = p[16];
+	rsvd = LD16(p + 14);
+	root_ents = LD16(p + 17);
+	total = LD16(p + 19);
+	if (total == 0) total = LD32(p + 32);
+	fat_fs.FatSize = LD16(p + 22);
+	if (fat_fs.FatSize == 0) fat_fs.FatSize = LD32(p + 36);
+
+	fat_fs.FatStart = base + rsvd;
+	fat_fs.RootStart = fat_fs.FatStart + fat_fs.NumFATs * fat_fs.FatSize;
+	fat_fs.RootSectors = ((uint32_t)root_ents * FAT_DIR_ENTRY_SIZE + FAT_SECTOR_SIZE - 1) / FAT_SECTOR_SIZE;
+	fat_fs.DataStart = fat_fs.RootStart + fat_fs.RootSectors;
+	data = total - (fat_fs.DataStart - base);
+	fat_fs.Clusters = data / fat_fs.SecPerClus;
+	fat_fs.ClusBytes = (uint32_t)fat_fs.SecPerClus * FAT_SECTOR_SIZE;
+	fat_fs.NextFree = 2;
+	fat_fs.FsInfo = 0;
+	fat_fs.FsInfoValid = 0;
+
+	/* The FAT type is defined by the cluster count only */
+	if (fat_fs.Clusters < 4085) return FAT_ERR_NO_FS;
+	if (fat_fs.Clusters < 65525)
+	{
+		fat_fs.RootCluster = 0;
+		fat_fs.Type = FAT_TYPE_16;
+	}
+	else
+	{
+		fat_fs.RootCluster = LD32(p + 44);
+		if (LD16(p + 48) != 0)
+		{
+			fat_fs.FsInfo = base + LD16(p + 48);
+			fat_fs.FsInfoValid = 1;
+		}
+		fat_fs.Type = FAT_TYPE_32;
+	}
+	return FAT_OK;
+}
+
+
+/*********************************************************************//**
+ * @brief		Write every dirty cache line back to the disk
+ * @param[in]	none
+ * @return 		FAT_OK or FAT_ERR_DISK
+ **********************************************************************/
+fat_error FAT_Sync (void)
+{
+	uint8_t n;
+
+	for (n = 0; n < FAT_CACHE_SECTORS; n++)
+	{
+		if (fat_cache[n].Dirty && (fat_cache_write(&fat_cache[n]) != FAT_OK)) return FAT_ERR_DISK;
+	}
+	return FAT_OK;
+}
+
+
+/*********************************************************************//**
+ * @brief		Open a file
+ * @param[in]	- fp: handle to fill
+ * 				- path: 8.3 names separated by '/', e.g. "LOG/DATA.CSV"
+ * 				- mode: FAT_READ, FAT_WRITE, FAT_APPEND, FAT_CREATE
+ * @return 		FAT_OK or error code
+ **********************************************************************/
+fat_error FAT_Open (FAT_FILE_Type *fp, const char *path, uint8_t mode)
+{
+	FAT_CACHE_LINE_Type *line;
+	uint8_t name[11];
+	uint32_t dir, sector;
+	uint16_t offset;
+	uint8_t *e, i;
+	fat_error ret;
+
+	fp->Mode = 0;
+	if (fat_fs.Type == FAT_TYPE_NONE) return FAT_ERR_NO_FS;
+	if ((mode & (FAT_READ | FAT_WRITE | FAT_APPEND)) == 0) return FAT_ERR_PARAM;
+
+	/* Walk the directories */
+	dir = fat_fs.RootCluster;
+	while (*path == '/') path++;
+	for (;;)
+	{
+		ret = fat_make_name(&path, name);
+		if (ret != FAT_OK) return ret;
+		if (*path == '\0') break;
+
+		ret = fat_dir_find(dir, name, FALSE, &sector, &offset);
+		if (ret != FAT_OK) return ret;
+		line = fat_cache_get(sector, TRUE);
+		if (line == NULL) return FAT_ERR_DISK;
+		e = (uint8_t *)line->Data + offset;
+		if (!(e[11] & FAT_ATTR_DIRECTORY)) return FAT_ERR_NOT_FOUND;
+		dir = ((uint32_t)LD16(e + 20) << 16) | LD16(e + 26);
+		if (dir == 0) dir = fat_fs.RootCluster;	// ".." of a first level directory
+	}
+
+	ret = fat_dir_find(dir, name, (mode & FAT_CREATE) ? TRUE : FALSE, &sector, &offset);
+	if ((ret == FAT_ERR_NOT_FOUND) && (mode & FAT_CREATE))
+	{
+		if (sector == 0) return FAT_ERR_FULL;
+		line = fat_cache_get(sector, TRUE);
+		if (line == NULL) return FAT_ERR_DISK;
+		e = (uint8_t *)line->Data + offset;
+		for (i = 0; i < FAT_DIR_ENTRY_SIZE; i++) e[i] = 0;
+		for (i = 0; i < 11; i++) e[i] = name[i];
+		e[11] = FAT_ATTR_ARCHIVE;
+		ST16(e + 14, FAT_DEFAULT_TIME);
+		ST16(e + 16, FAT_DEFAULT_DATE);
+		ST16(e + 18, FAT_DEFAULT_DATE);
+		ST16(e + 22, FAT_DEFAULT_TIME);
+		ST16(e + 24, FAT_DEFAULT_DATE);
+		line->Dirty = 1;
+	}
+	else if (ret != FAT_OK) return ret;
+
+	line = fat_cache_get(sector, TRUE);
+	if (line == NULL) return FAT_ERR_DISK;
+	e = (uint8_t *)line->Data + offset;
+	if (e[11] & FAT_ATTR_DIRECTORY) return FAT_ERR_DENIED;
+	if ((mode & (FAT_WRITE | FAT_APPEND)) && (e[11] & FAT_ATTR_READ_ONLY)) return FAT_ERR_DENIED;
+
+	fp->FirstCluster = ((uint32_t)LD16(e + 20) << 16) | LD16(e + 26);
+	fp->Size = LD32(e + 28);
+	fp->Pos = (mode & FAT_APPEND) ? fp->Size : 0;
+	fp->Cluster = 0;
+	fp->ClusIdx = 0;
+	fp->DirSector = sector;
+	fp->DirOffset = offset;
+	fp->Dirty = 0;
+	fp->Mode = mode & (FAT_READ | FAT_WRITE | FAT_APPEND);
+	return FAT_OK;
+}
+
+
+/*********************************************************************//**
+ * @brief		Read from a file
+ * @param[in]	- fp: open file
+ * 				- buf: destination
+ * 				- len: bytes wanted
+ * 				- done: bytes actually read, less than len at end of file
+ * @return 		FAT_OK or error code
+ *
+ * Note: whole sectors go straight from the disk into buf, only partial
+ * sectors pass through the cache.
+ **********************************************************************/
+fat_error FAT_Read (FAT_FILE_Type *fp, void *buf, uint32_t len, uint32_t *done)
+{
+	FAT_CACHE_LINE_Type *line;
+	uint8_t *p = (uint8_t *)buf;
+	uint32_t coff, soff, sec, n, nsec;
+	fat_error ret = FAT_OK;
+
+	*done = 0;
+	if (!(fp->Mode & FAT_READ)) return FAT_ERR_DENIED;
+	if (len > (fp->Size - fp->Pos)) len = fp->Size - fp->Pos;
+
+	while (len)
+	{
+		ret = fat_file_cluster(fp, FALSE);
+		if (ret != FAT_OK) break;
+
+		coff = fp->Pos % fat_fs.ClusBytes;
+		sec = fat_clust2sect(fp->Cluster) + coff / FAT_SECTOR_SIZE;
+		soff = coff % FAT_SECTOR_SIZE;
+
+		if ((soff == 0) && (len >= FAT_SECTOR_SIZE))
+		{
+			/* Aligned run of whole sectors up to the end of the cluster */
+			nsec = len / FAT_SECTOR_SIZE;
+			if (nsec > (fat_fs.SecPerClus - coff / FAT_SECTOR_SIZE)) nsec = fat_fs.SecPerClus - coff / FAT_SECTOR_SIZE;
+			if (fat_cache_range(sec, nsec, FALSE) != FAT_OK) { ret = FAT_ERR_DISK; break; }
+			if (fat_fs.Disk->Read(sec, p, nsec) != SUCCESS) { ret = FAT_ERR_DISK; break; }
+			n = nsec * FAT_SECTOR_SIZE;
+		}
+		else
+		{
+			line = fat_cache_get(sec, TRUE);
+			if (line == NULL) { ret = FAT_ERR_DISK; break; }
+			n = FAT_SECTOR_SIZE - soff;
+			if (n > len) n = len;
+			for (nsec = 0; nsec < n; nsec++) p[nsec] = ((uint8_t *)line->Data)[soff + nsec];
+		}
+
+		p += n;
+		len -= n;
+		fp->Pos += n;
+		*done += n;
+	}
+	return ret;
+}
+
+
+/*********************************************************************//**
+ * @brief		Write to a file at the current position
+ * @param[in]	- fp: file opened with FAT_WRITE or FAT_APPEND
+ * 				- buf: source
+ * 				- len: number of bytes
+ * 				- done: bytes actually written
+ * @return 		FAT_OK or error code
+ *
+ * Note: a cluster aligned write of a whole cluster goes straight to the
+ * disk as one multi-block transfer, bypassing the cache. Anything smaller
+ * is merged in the cache and written back on eviction or FAT_Sync().
+ **********************************************************************/
+fat_error FAT_Write (FAT_FILE_Type *fp, const void *buf, uint32_t len, uint32_t *done)
+{
+	FAT_CACHE_LINE_Type *line;
+	const uint8_t *p = (const uint8_t *)buf;
+	uint32_t coff, soff, sec, n, i;
+	fat_error ret = FAT_OK;
+
+	*done = 0;
+	if (!(fp->Mode & (FAT_WRITE | FAT_APPEND))) return FAT_ERR_DENIED;
+	if (fp->Mode & FAT_APPEND) fp->Pos = fp->Size;
+
+	while (len)
+	{
+		ret = fat_file_cluster(fp, TRUE);
+		if (ret != FAT_OK) break;
+
+		coff = fp->Pos % fat_fs.ClusBytes;
+		sec = fat_clust2sect(fp->Cluster) + coff / FAT_SECTOR_SIZE;
+		soff = coff % FAT_SECTOR_SIZE;
+
+		if ((coff == 0) && (len >= fat_fs.ClusBytes))
+		{
+			/* Whole cluster */
+			fat_cache_range(sec, fat_fs.SecPerClus, TRUE);
+			if (fat_fs.Disk->Write(sec, p, fat_fs.SecPerClus) != SUCCESS) { ret = FAT_ERR_DISK; break; }
+			n = fat_fs.ClusBytes;
+		}
+		else
+		{
+			n = FAT_SECTOR_SIZE - soff;
+			if (n > len) n = len;
+			/* Old contents only matter if some of them stay valid */
+			line = fat_cache_get(sec, ((soff != 0) || ((n < FAT_SECTOR_SIZE) && (fp->Pos < fp->Size))) ? TRUE : FALSE);
+			if (line == NULL) { ret = FAT_ERR_DISK; break; }
+			for (i = 0; i < n; i++) ((uint8_t *)line->Data)[soff + i] = p[i];
+			line->Dirty = 1;
+		}
+
+		p += n;
+		len -= n;
+		fp->Pos += n;
+		*done += n;
+		if (fp->Pos > fp->Size)
+		{
+			fp->Size = fp->Pos;
+			fp->Dirty = 1;
+		}
+	}
+	return ret;
+}
+
+
+/*********************************************************************//**
+ * @brief		Move the read/write position
+ * @param[in]	- fp: open file
+ * 				- pos: new position, clipped to the file size
+ * @return 		FAT_OK or FAT_ERR_PARAM
+ **********************************************************************/
+fat_error FAT_Seek (FAT_FILE_Type *fp, uint32_t pos)
+{
+	if (fp->Mode == 0) return FAT_ERR_PARAM;
+	fp->Pos = (pos > fp->Size) ? fp->Size : pos;
+	return FAT_OK;
+}
+
+
+/*********************************************************************//**
+ * @brief		Update the directory entry and write all cached data back
+ * @param[in]	fp: open file
+ * @return 		FAT_OK or error code
+ **********************************************************************/
+fat_error FAT_Flush (FAT_FILE_Type *fp)
+{
+	FAT_CACHE_LINE_Type *line;
+	uint8_t *e;
+
+	if (fp->Mode == 0) return FAT_ERR_PARAM;
+
+	if (fp->Dirty)
+	{
+		line = fat_cache_get(fp->DirSector, TRUE);
+		if (line == NULL) return FAT_ERR_DISK;
+		e = (uint8_t *)line->Data + fp->DirOffset;
+		e[11] |= FAT_ATTR_ARCHIVE;
+		ST16(e + 20, fp->FirstCluster >> 16);
+		ST16(e + 26, fp->FirstCluster);
+		ST32(e + 28, fp->Size);
+		ST16(e + 22, FAT_DEFAULT_TIME);
+		ST16(e + 24, FAT_DEFAULT_DATE);
+		line->Dirty = 1;
+		fp->Dirty = 0;
+	}
+	return FAT_Sync();
+}
+
+
+/*********************************************************************//**
+ * @brief		Flush and close a file
+ * @param[in]	fp: open file
+ * @return 		FAT_OK or error code
+ **********************************************************************/
+fat_error FAT_Close (FAT_FILE_Type *fp)
+{
+	fat_error ret = FAT_Flush(fp);
+
+	if (ret == FAT_OK) fp->Mode = 0;
+	return ret;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+/* --------------------------------- End Of File ------------------------------ */
@@ -20,6 +20,9 @@
  * otherwise the default FW library configuration file must be included instead
  */
 
+/* Private Variables ---------------------------------------------------------- */
+/** AT24C16: 2K x 8 in eight 256 byte blocks, 16 byte pages */
+static E2P_DEVICE_Type at24c16 = {LPC_I2C0, NULL, E2P24C16_ID, 1, 16, 2048, 5};
 
 
 /** @addtogroup EEPROM_Public_Functions
@@ -36,25 +39,8 @@
  **********************************************************************/
 char I2C_Eeprom_Write_Byte (uint16 eep_address, uint8_t byte_data)
 {
-	/* Transmit setup */
-	I2C_M_SETUP_Type txsetup;
-	uint8_t set_addr;
-
-	set_addr =(eep_address & 0x7FF) >> 8;
- //   printf(LPC_UART0,"%x02",set_addr);
-
-    I2C_Tx_Buf[0] = (uchar)(eep_address & 0xFF);    // 2st byte extract
-    I2C_Tx_Buf[1] = byte_data;
-
-	txsetup.sl_addr7bit = E2P24C16_ID|set_addr;
-	txsetup.tx_data = I2C_Tx_Buf;
-	txsetup.tx_length = 2;
-	txsetup.rx_data = NULL;
-	txsetup.rx_length = 0;
-	txsetup.retransmissions_max = 3;
-
 	/* write byte to addr  */
-	if(I2C_MasterTransferData(LPC_I2C0, &txsetup, I2C_TRANSFER_POLLING)==SUCCESS) //return status
+	if(E2P_Write(&at24c16, eep_address, &byte_data, 1)==SUCCESS) //return status
 	{
 		return (0);
 	}
@@ -66,74 +52,22 @@ char I2C_Eeprom_Write_Byte (uint16 eep_address, uint8_t byte_data)
 
 
 /*********************************************************************//**
- * @brief	    Writes byte at given address
- * @param[in]	eep_address    Word Address range[0000 - 4000]
- * @param[in]   byte_data      Byte value
+ * @brief	    Writes array at given address, any length and alignment
+ * @param[in]	eep_address    Word Address range[0000 - 07FF]
+ * @param[in]   byte_data      buffer address
+ * @param[in]   length         size of buffer
  * @return 		status
  **********************************************************************/
 char I2C_Eeprom_Write (uint16_t eep_address, uint8_t* byte_data, uint16_t length)
 {
-	/* Transmit setup */
-	I2C_M_SETUP_Type txsetup;
-	uint16_t ip_len,new_length,i;
-	uint16 new_address;
-	uint8_t set_addr;
-
-	/* Intern page length(ip_len) gives length from address that can be occupied in page */
-	ip_len = 0x10 - (eep_address % 0x10);
-	new_address = eep_address + ip_len;
-
-	set_addr =(eep_address & 0x7FF) >> 8;
-//    printf(LPC_UART0,"%x02",set_addr);
-
-    I2C_Tx_Buf[0] = (uchar)(eep_address & 0xFF);    // 2st byte extract
-
-	if(length > ip_len)
+	/* Page split and ACK polling are done by the E2PROM engine */
+	if(E2P_Write(&at24c16, eep_address, byte_data, length)==SUCCESS) //return status
 	{
-		new_length = length - ip_len;
-
-		for(i=1;i<(ip_len+1);i++)
-		{
-			I2C_Tx_Buf[i]=*byte_data++;
-		}
-		txsetup.sl_addr7bit = E2P24C16_ID|set_addr;
-		txsetup.tx_data = I2C_Tx_Buf;
-		txsetup.tx_length = ip_len+1;
-		txsetup.rx_data = NULL;
-		txsetup.rx_length = 0;
-		txsetup.retransmissions_max = 50;
-
-		if(I2C_MasterTransferData(LPC_I2C0, &txsetup, I2C_TRANSFER_POLLING)==ERROR) //return status
-		{
-			return (-1);
-		}
-
-		// Recursive function
-		delay_ms(5);
-		I2C_Eeprom_Write(new_address,byte_data,new_length);
+		return (0);
 	}
-
-	if(length <= ip_len)
+	else
 	{
-		for(i=1;i<(length+1);i++)
-		{
-			I2C_Tx_Buf[i]=*byte_data++;
-		}
-		txsetup.sl_addr7bit = E2P24C16_ID|set_addr;
-		txsetup.tx_data = I2C_Tx_Buf;
-		txsetup.tx_length = length+1;
-		txsetup.rx_data = NULL;
-		txsetup.rx_length = 0;
-		txsetup.retransmissions_max = 50;
-
-		if(I2C_MasterTransferData(LPC_I2C0, &txsetup, I2C_TRANSFER_POLLING)==SUCCESS) //return status
-		{
-			return (0);
-		}
-		else
-		{
-			return (-1);
-		}
+		return (-1);
 	}
 }
 
@@ -145,25 +79,11 @@ char I2C_Eeprom_Write (uint16_t eep_address, uint8_t* byte_data, uint16_t length
  **********************************************************************/
 uint8_t I2C_Eeprom_Read_Byte (uint16_t eep_address)
 {
-	/* Receive setup */
-	I2C_M_SETUP_Type rxsetup;
-	uint8_t set_addr;
-
-	set_addr = (eep_address & 0x7FF) >> 8;
-//    printf(LPC_UART0,"%x02",set_addr);
-
-	I2C_Tx_Buf[0] = (uchar)(eep_address & 0xFF);    // 2st byte extract
-
-	rxsetup.sl_addr7bit = E2P24C16_ID|set_addr;
-	rxsetup.tx_data = I2C_Tx_Buf;	// Get address to read at writing address
-	rxsetup.tx_length = 1;
-	rxsetup.rx_data = I2C_Rx_Buf;
-	rxsetup.rx_length = 1;
-	rxsetup.retransmissions_max = 3;
+	uint8_t dat;
 
-	if (I2C_MasterTransferData(LPC_I2C0, &rxsetup, I2C_TRANSFER_POLLING) == SUCCESS)
+	if (E2P_Read(&at24c16, eep_address, &dat, 1) == SUCCESS)
 	{
-		return (I2C_Rx_Buf[0]);
+		return (dat);
 	}
 	else
 	{
@@ -179,23 +99,8 @@ uint8_t I2C_Eeprom_Read_Byte (uint16_t eep_address)
  **********************************************************************/
 char I2C_Eeprom_Read (uint16_t eep_address, uint8_t* buf_data, uint16_t length)
 {
-	/* Receive setup */
-	I2C_M_SETUP_Type rxsetup;
-	uint8_t set_addr;
-
-	set_addr = (eep_address & 0x7FF) >> 8;
- //   printf(LPC_UART0,"%x02",set_addr);
-
-	I2C_Tx_Buf[0] = (uchar)(eep_address & 0xFF);    // 2st byte extract
-
-	rxsetup.sl_addr7bit = E2P24C16_ID|set_addr;
-	rxsetup.tx_data = I2C_Tx_Buf;	// Get address to read at writing address
-	rxsetup.tx_length = 1;
-	rxsetup.rx_data = buf_data;
-	rxsetup.rx_length = length;
-	rxsetup.retransmissions_max = 3;
-
-	if (I2C_MasterTransferData(LPC_I2C0, &rxsetup, I2C_TRANSFER_POLLING) == SUCCESS)
+	/* One sequential read of any length */
+	if (E2P_Read(&at24c16, eep_address, buf_data, length) == SUCCESS)
 	{
 		return (0);
 	}
@@ -267,6 +172,15 @@ void Display_Eeprom_Loc (uint16 mem_start_address, uint16 mem_end_address)
 }
 
 
+/*********************************************************************//**
+ * @brief		Serial E2PROM descriptor of the AT24C16, for users of
+ * 				the lpc_eeprom engine such as the key/value store
+ * @return 		E2PROM part
+ **********************************************************************/
+E2P_DEVICE_Type *I2C_Eeprom_Device (void)
+{
+	return &at24c16;
+}
 
 
 /**
@@ -20,6 +20,9 @@
  * otherwise the default FW library configuration file must be included instead
  */
 
+/* Private Variables ---------------------------------------------------------- */
+/** M24256: 32K x 8, 64 byte pages */
+static E2P_DEVICE_Type m24256 = {LPC_I2C0, NULL, E2PM24256_ID, 2, 64, 32768, 5};
 
 
 /** @addtogroup EEPROM_Public_Functions
@@ -36,24 +39,8 @@
  **********************************************************************/
 char I2C_IEeprom_Write_Byte (uint16_t eep_address, uint8_t byte_data)
 {
-	/* Transmit setup */
-	I2C_M_SETUP_Type txsetup;
-
-	I2C_Tx_Buf[0] =(eep_address & 0x8FFF) >> 8;     // 1st byte extract
- //   printf(LPC_UART0,"%x02",set_addr);
-
-    I2C_Tx_Buf[1] = (uchar)(eep_address & 0xFF);    // 2st byte extract
-    I2C_Tx_Buf[2] = byte_data;
-
-	txsetup.sl_addr7bit = E2PM24256_ID;
-	txsetup.tx_data = I2C_Tx_Buf;
-	txsetup.tx_length = 3;
-	txsetup.rx_data = NULL;
-	txsetup.rx_length = 0;
-	txsetup.retransmissions_max = 50;
-
 	/* write byte to addr  */
-	if(I2C_MasterTransferData(LPC_I2C0, &txsetup, I2C_TRANSFER_POLLING)==SUCCESS) //return status
+	if(E2P_Write(&m24256, eep_address, &byte_data, 1)==SUCCESS) //return status
 	{
 		return (0);
 	}
@@ -72,66 +59,14 @@ char I2C_IEeprom_Write_Byte (uint16_t eep_address, uint8_t byte_data)
  **********************************************************************/
 char I2C_IEeprom_Write (uint16_t eep_address, uint8_t* byte_data, uint16_t length)
 {
-	/* Transmit setup */
-	I2C_M_SETUP_Type txsetup;
-	uint16_t ip_len,new_length,i;
-	uint16_t new_address;
-
-	/* Intern page length(ip_len) gives length from address that can be occupied in page */
-	ip_len = 0x40 - (eep_address % 0x40);
-	new_address = eep_address + ip_len;
-
-	I2C_Tx_Buf[0] =(eep_address & 0x8FFF) >> 8;     // 1st byte extract
-  //  printf(LPC_UART0,"%x02",I2C_Tx_Buf[0]);
-
-    I2C_Tx_Buf[1] = (uchar)(eep_address & 0xFF);    // 2st byte extract
-
-	if(length > ip_len)
+	/* Page split and ACK polling are done by the E2PROM engine */
+	if(E2P_Write(&m24256, eep_address, byte_data, length)==SUCCESS) //return status
 	{
-		new_length = length - ip_len;
-
-		for(i=2;i<(ip_len+2);i++)
-		{
-			I2C_Tx_Buf[i]=*byte_data++;
-		}
-		txsetup.sl_addr7bit = E2PM24256_ID;
-		txsetup.tx_data = I2C_Tx_Buf;
-		txsetup.tx_length = ip_len+2;
-		txsetup.rx_data = NULL;
-		txsetup.rx_length = 0;
-		txsetup.retransmissions_max = 50;
-
-		if(I2C_MasterTransferData(LPC_I2C0, &txsetup, I2C_TRANSFER_POLLING)==ERROR) //return status
-		{
-			return (-1);
-		}
-
-		// Recursive function
-		delay_ms(5);
-		I2C_IEeprom_Write(new_address,byte_data,new_length);
+		return (0);
 	}
-
-	if(length <= ip_len)
+	else
 	{
-		for(i=2;i<(length+2);i++)
-		{
-			I2C_Tx_Buf[i]=*byte_data++;
-		}
-		txsetup.sl_addr7bit = E2PM24256_ID;
-		txsetup.tx_data = I2C_Tx_Buf;
-		txsetup.tx_length = length+2;
-		txsetup.rx_data = NULL;
-		txsetup.rx_length = 0;
-		txsetup.retransmissions_max = 50;
-
-		if(I2C_MasterTransferData(LPC_I2C0, &txsetup, I2C_TRANSFER_POLLING)==SUCCESS) //return status
-		{
-			return (0);
-		}
-		else
-		{
-			return (-1);
-		}
+		return (-1);
 	}
 }
 
@@ -143,23 +78,11 @@ char I2C_IEeprom_Write (uint16_t eep_address, uint8_t* byte_data, uint16_t lengt
  **********************************************************************/
 uint8_t I2C_IEeprom_Read_Byte (uint16_t eep_address)
 {
-	/* Receive setup */
-	I2C_M_SETUP_Type rxsetup;
-
-	I2C_Tx_Buf[0] = (eep_address & 0x8FFF) >> 8;    // 1st byte extract
-//    printf(LPC_UART0,"%x02",set_addr);
-	I2C_Tx_Buf[1] = (uchar)(eep_address & 0xFF);    // 2st byte extract
-
-	rxsetup.sl_addr7bit = E2PM24256_ID;
-	rxsetup.tx_data = I2C_Tx_Buf;	// Get address to read at writing address
-	rxsetup.tx_length = 2;
-	rxsetup.rx_data = I2C_Rx_Buf;
-	rxsetup.rx_length = 1;
-	rxsetup.retransmissions_max = 3;
+	uint8_t dat;
 
-	if (I2C_MasterTransferData(LPC_I2C0, &rxsetup, I2C_TRANSFER_POLLING) == SUCCESS)
+	if (E2P_Read(&m24256, eep_address, &dat, 1) == SUCCESS)
 	{
-		return (I2C_Rx_Buf[0]);
+		return (dat);
 	}
 	else
 	{
@@ -175,22 +98,8 @@ uint8_t I2C_IEeprom_Read_Byte (uint16_t eep_address)
  **********************************************************************/
 char I2C_IEeprom_Read (uint16_t eep_address, uint8_t* buf_data, uint16_t length)
 {
-	/* Receive setup */
-	I2C_M_SETUP_Type rxsetup;
-
-	I2C_Tx_Buf[0] = (eep_address & 0x8FFF) >> 8;
- //   printf(LPC_UART0,"%x02",set_addr);
-
-	I2C_Tx_Buf[1] = (uchar)(eep_address & 0xFF);    // 2st byte extract
-
-	rxsetup.sl_addr7bit = E2PM24256_ID;
-	rxsetup.tx_data = I2C_Tx_Buf;	// Get address to read at writing address
-	rxsetup.tx_length = 2;
-	rxsetup.rx_data = buf_data;
-	rxsetup.rx_length = length;
-	rxsetup.retransmissions_max = 3;
-
-	if (I2C_MasterTransferData(LPC_I2C0, &rxsetup, I2C_TRANSFER_POLLING) == SUCCESS)
+	/* One sequential read of any length */
+	if (E2P_Read(&m24256, eep_address, buf_data, length) == SUCCESS)
 	{
 		return (0);
 	}
@@ -262,6 +171,15 @@ void Display_IEeprom_Loc (uint16_t mem_start_address, uint16_t mem_end_address)
 }
 
 
+/*********************************************************************//**
+ * @brief		Serial E2PROM descriptor of the M24256, for users of
+ * 				the lpc_eeprom engine such as the key/value store
+ * @return 		E2PROM part
+ **********************************************************************/
+E2P_DEVICE_Type *I2C_IEeprom_Device (void)
+{
+	return &m24256;
+}
 
 
 /**
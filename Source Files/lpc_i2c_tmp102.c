@@ -20,6 +20,44 @@
  * otherwise the default FW library configuration file must be included instead
  */
 
+/* Private Variables ---------------------------------------------------------- */
+static I2C_JOB_Type tmp102_job;                     /* background temperature read */
+static const uint8_t tmp102_reg = TMP_REG;
+static uint8_t tmp102_raw[2];
+static __IO int16_t tmp102_sample;                  /* 1/16 degC */
+static __IO Bool tmp102_valid = FALSE;
+
+
+/* Private Functions ---------------------------------------------------------- */
+/*********************************************************************//**
+ * @brief	    Completion of a background read, keeps the latest sample
+ * @param[in]	job    finished tmp102_job
+ * @return 		None
+ **********************************************************************/
+static void tmp102_sample_done(I2C_JOB_Type *job)
+{
+	int16_t raw;
+
+	if (job->status == I2C_JOB_DONE)
+	{
+		raw = (int16_t)((tmp102_raw[0]<<8)|tmp102_raw[1]);
+		if (tmp102_raw[1] & 0x01)                   /* EM flag: 13 bit result */
+		{
+			tmp102_sample = raw >> 3;
+		}
+		else
+		{
+			tmp102_sample = raw >> 4;
+		}
+		tmp102_valid = TRUE;
+	}
+	else
+	{
+		tmp102_valid = FALSE;
+	}
+}
+
+
 /** @addtogroup TMP_Public_Functions
  * @{
  */
@@ -311,6 +349,40 @@ uchar TMP102_Read_Temp(BIT_Type res)
 }
 
 
+/*********************************************************************//**
+ * @brief	    Queue a read of the temperature register without waiting,
+ *              call it at a fixed rate (e.g. from a timer) and pick the
+ *              result up with TMP102_Get_Sample()
+ * @param[in]	None
+ * @return 		SUCCESS, or ERROR while the previous read is pending
+ **********************************************************************/
+Status TMP102_Sample(void)
+{
+	tmp102_job.sl_addr7bit = TMP102_ID;
+	tmp102_job.tx_data = &tmp102_reg;
+	tmp102_job.tx_length = 1;
+	tmp102_job.rx_data = tmp102_raw;
+	tmp102_job.rx_length = 2;
+	tmp102_job.Retries = 0;
+	tmp102_job.Timeout = 0;
+	tmp102_job.Callback = tmp102_sample_done;
+
+	return I2C_JobSubmit(LPC_I2C0, &tmp102_job);
+}
+
+
+/*********************************************************************//**
+ * @brief	    Latest temperature read by TMP102_Sample()
+ * @param[out]	val    temperature in 1/16 degC (12 or 13 bit mode)
+ * @return 		TRUE if the last read succeeded
+ **********************************************************************/
+Bool TMP102_Get_Sample(int16_t *val)
+{
+	*val = tmp102_sample;
+	return tmp102_valid;
+}
+
+
 /**
  * @}
  */
@@ -25,6 +25,186 @@
  * otherwise the default FW library configuration file must be included instead
  */
 
+/* Private Variables ---------------------------------------------------------- */
+static Bool tsc_ready = FALSE;                      /* TSC2004_Init() done       */
+static Bool tsc_running = FALSE;                    /* TSC2004_Start() done      */
+
+static I2C_JOB_Type tsc_job;                        /* X/Y/Z1/Z2 burst read      */
+static uint8_t tsc_cmd;
+static uint8_t tsc_raw[8];
+
+static uint16_t tsc_wx[3], tsc_wy[3];               /* median window             */
+static uint8_t tsc_wn;                              /* samples in the window     */
+static int32_t tsc_fx, tsc_fy;                      /* IIR state, << TSC_IIR_SHIFT */
+static Bool tsc_down = FALSE;
+static TSC_EVENT_Type tsc_last_ev;                  /* last position reported    */
+static __IO uint32_t tsc_last_time;                 /* tick of the last sample   */
+
+static TSC_EVENT_Type tsc_ring[TSC_EVENT_RING];
+static __IO uint32_t tsc_head, tsc_tail;
+static uint32_t tsc_dropped;
+
+/* Default mapping of the 320x240 panel, x = X/11 - 24, y = Y/13 - 36 */
+static TSC_CAL_Type tsc_cal = {13, 0, 0, 11, -3432, -5148, 143};
+
+
+/* Private Functions ---------------------------------------------------------- */
+/*********************************************************************//**
+ * @brief	    Median of three values
+ * @param[in]	w    window
+ * @return 		median
+ **********************************************************************/
+static uint16_t tsc_median3(const uint16_t *w)
+{
+	if (w[0] > w[1])
+	{
+		if (w[1] > w[2]) return w[1];
+		return (w[0] > w[2]) ? w[2] : w[0];
+	}
+	if (w[0] > w[2]) return w[0];
+	return (w[1] > w[2]) ? w[2] : w[1];
+}
+
+
+/*********************************************************************//**
+ * @brief	    Queue an event, a move replaces a move not yet read
+ * @param[in]	ev    event
+ * @return 		None
+ *
+ * Note: called from the I2C interrupt, or with interrupts disabled.
+ **********************************************************************/
+static void tsc_push(const TSC_EVENT_Type *ev)
+{
+	uint32_t head = tsc_head;
+
+	if ((ev->type == TSC_EV_MOVE) && (head != tsc_tail) && \
+		(tsc_ring[(head - 1) & (TSC_EVENT_RING - 1)].type == TSC_EV_MOVE))
+	{
+		tsc_ring[(head - 1) & (TSC_EVENT_RING - 1)] = *ev;
+		return;
+	}
+	if ((head - tsc_tail) >= TSC_EVENT_RING)
+	{
+		tsc_dropped++;
+		return;
+	}
+	tsc_ring[head & (TSC_EVENT_RING - 1)] = *ev;
+	tsc_head = head + 1;
+}
+
+
+/*********************************************************************//**
+ * @brief	    End the current touch if no data came for TSC_PENUP_TIME
+ * @param[in]	None
+ * @return 		None
+ *
+ * Note: called from the I2C interrupt, or with interrupts disabled.
+ **********************************************************************/
+static void tsc_penup_check(void)
+{
+	if ((tsc_wn == 0) || ((uint32_t)(SYSTICK_GetTick() - tsc_last_time) <= TSC_PENUP_TIME))
+	{
+		return;
+	}
+	if (tsc_down)
+	{
+		tsc_last_ev.type = TSC_EV_RELEASE;
+		tsc_push(&tsc_last_ev);
+		tsc_down = FALSE;
+	}
+	tsc_wn = 0;
+}
+
+
+/*********************************************************************//**
+ * @brief	    Filter one conversion and turn it into an event
+ * @param[in]	x, y, z1, z2    12 bit results
+ * @return 		None
+ *
+ * Note: samples too light to be reliable are dropped by their touch
+ * resistance. The rest pass a median of three, which removes single
+ * spikes, then an IIR filter, which removes jitter, and are mapped to
+ * the screen with the calibration.
+ **********************************************************************/
+static void tsc_sample(uint16_t x, uint16_t y, uint16_t z1, uint16_t z2)
+{
+	uint32_t rt;
+	int32_t sx, sy;
+
+	if ((z1 == 0) || (z2 <= z1))
+	{
+		return;
+	}
+	rt = ((uint32_t)x * TSC_X_PLATE_OHMS) >> 12;
+	rt = (rt * (z2 - z1)) / z1;
+	if (rt > TSC_MAX_RT)
+	{
+		return;
+	}
+
+	tsc_penup_check();
+	tsc_last_time = SYSTICK_GetTick();
+
+	tsc_wx[tsc_wn % 3] = x;
+	tsc_wy[tsc_wn % 3] = y;
+	if (++tsc_wn < 3)
+	{
+		return;
+	}
+	if (tsc_wn == 6) tsc_wn = 3;                    /* keep the slot in step     */
+
+	x = tsc_median3(tsc_wx);
+	y = tsc_median3(tsc_wy);
+	if (!tsc_down)
+	{
+		tsc_fx = (int32_t)x << TSC_IIR_SHIFT;
+		tsc_fy = (int32_t)y << TSC_IIR_SHIFT;
+	}
+	else
+	{
+		tsc_fx += x - (tsc_fx >> TSC_IIR_SHIFT);
+		tsc_fy += y - (tsc_fy >> TSC_IIR_SHIFT);
+	}
+	x = tsc_fx >> TSC_IIR_SHIFT;
+	y = tsc_fy >> TSC_IIR_SHIFT;
+
+	sx = (int32_t)(((int64_t)tsc_cal.An * x + (int64_t)tsc_cal.Bn * y + tsc_cal.Cn) / tsc_cal.Div);
+	sy = (int32_t)(((int64_t)tsc_cal.Dn * x + (int64_t)tsc_cal.En * y + tsc_cal.Fn) / tsc_cal.Div);
+	tsc_last_ev.x = (sx < 0) ? 0 : ((sx >= WIDTH) ? (WIDTH - 1) : sx);
+	tsc_last_ev.y = (sy < 0) ? 0 : ((sy >= HEIGHT) ? (HEIGHT - 1) : sy);
+	tsc_last_ev.pressure = rt;
+	tsc_last_ev.type = tsc_down ? TSC_EV_MOVE : TSC_EV_PRESS;
+	tsc_down = TRUE;
+	tsc_push(&tsc_last_ev);
+}
+
+
+/*********************************************************************//**
+ * @brief	    Completion of a burst read started by PINTDAV
+ * @param[in]	job    finished tsc_job
+ * @return 		None
+ **********************************************************************/
+static void tsc_read_done(I2C_JOB_Type *job)
+{
+	if (job->status == I2C_JOB_DONE)
+	{
+		tsc_sample(((tsc_raw[0]<<8)|tsc_raw[1]) & MEAS_MASK, ((tsc_raw[2]<<8)|tsc_raw[3]) & MEAS_MASK,
+				   ((tsc_raw[4]<<8)|tsc_raw[5]) & MEAS_MASK, ((tsc_raw[6]<<8)|tsc_raw[7]) & MEAS_MASK);
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief	    PINTDAV falling edge: a conversion is ready, queue the
+ *              read of all four results
+ * @param[in]	None
+ * @return 		None
+ **********************************************************************/
+void TSC_PENIRQ_IRQHandler(void)
+{
+	EXTI_ClearEXTIFlag(TSC_PENIRQ_LINE);
+	I2C_JobSubmit(LPC_I2C0, &tsc_job);              /* ERROR if still pending    */
+}
 
 
 /** @addtogroup TSC2004_Public_Functions
@@ -46,9 +226,9 @@ void TSC2004_Init (void)
 	cmd = TSC2004_CMD1(MEAS_X_Y_Z1_Z2, MODE_12BIT, SWRST_TRUE);
 	I2C_TSC2004_Write_Byte(cmd);
 
-	/* Enable interrupt for PENIRQ and DAV */
+	/* PINTDAV signals data available, median/average filter on all axes */
 	cmd = TSC2004_CMD0(CFR2_REG, PND0_FALSE, WRITE_REG);
-	data = MEDIAN_VAL_FLTR_SIZE_1 |AVRG_VAL_FLTR_SIZE_7_8;
+	data = PINTS1 | MEDIAN_VAL_FLTR_SIZE_1 |AVRG_VAL_FLTR_SIZE_7_8 | MAV_FLTR_EN_X | MAV_FLTR_EN_Y | MAV_FLTR_EN_Z;
 	I2C_TSC2004_Write_Word(cmd, data);
 
 	/* Configure the TSC in TSMode 1 */
@@ -59,6 +239,8 @@ void TSC2004_Init (void)
 	/* Enable x, y, z1 and z2 conversion functions */
 	cmd = TSC2004_CMD1(MEAS_X_Y_Z1_Z2, MODE_12BIT, SWRST_FALSE);
 	I2C_TSC2004_Write_Byte(cmd);
+
+	tsc_ready = TRUE;
 }
 
 
@@ -143,15 +325,14 @@ uint16_t I2C_TSC2004_Read_Word (uint8_t Command)
 	rxsetup.rx_length = 2;
 	rxsetup.retransmissions_max = 3;
 
-	/* The protocol and raw data format from i2c interface:
-	 * * S Addr Wr [A] Comm [A] S Addr Rd [A] [DataHigh] A [DataLow] NA P
-	 * * Data are in Right Justified format.
-	 * */
-	word_data |= (I2C_Rx_Buf[0]&0x0F)<<8;
-	word_data |= (I2C_Rx_Buf[1]&0xFF);
-
 	if (I2C_MasterTransferData(LPC_I2C0, &rxsetup, I2C_TRANSFER_POLLING) == SUCCESS)
 	{
+		/* The protocol and raw data format from i2c interface:
+		 * * S Addr Wr [A] Comm [A] S Addr Rd [A] [DataHigh] A [DataLow] NA P
+		 * * Data are in Right Justified format.
+		 * */
+		word_data |= (I2C_Rx_Buf[0]&0x0F)<<8;
+		word_data |= (I2C_Rx_Buf[1]&0xFF);
 		return (word_data);
 	}
 	else
@@ -171,11 +352,10 @@ uint16_t TSC2004_Read_Reg (register_address reg)
 	uint16_t val;
 	uint8_t cmd;
 
-	TSC2004_Init ();					// Initialize Touch Screen
-
-	 // Prepare val Measurement
-	cmd = TSC2004_CMD0(reg, PND0_FALSE, READ_REG);
-	val = I2C_TSC2004_Read_Word(cmd);
+	if (!tsc_ready)
+	{
+		TSC2004_Init ();				// Initialize Touch Screen once
+	}
 
 	 // Read val Measurement
 	cmd = TSC2004_CMD0(reg, PND0_FALSE, READ_REG);
@@ -191,49 +371,166 @@ uint16_t TSC2004_Read_Reg (register_address reg)
  * @brief	    Read X,Y,Z1,Z2 Values
  * @param[in]	*tc    store values in structure
  * @return 		None
+ *
+ * Note: the four result registers are read in one burst, the register
+ * address increments after each word.
  **********************************************************************/
 void TSC2004_Read_Values (ts_event *tc)
 {
+	I2C_M_SETUP_Type rxsetup;
 	uint8_t cmd;
+	uint8_t buf[8];
 
-	TSC2004_Init ();					// Initialize Touch Screen
+	if (!tsc_ready)
+	{
+		TSC2004_Init ();				// Initialize Touch Screen once
+	}
 
-	 // Prepare X Measurement
 	cmd = TSC2004_CMD0(X_REG, PND0_FALSE, READ_REG);
-	tc->x = I2C_TSC2004_Read_Word(cmd);
 
-	 // Read X Measurement
-	cmd = TSC2004_CMD0(X_REG, PND0_FALSE, READ_REG);
-	tc->x = I2C_TSC2004_Read_Word(cmd);
+	rxsetup.sl_addr7bit = TSC2004_ID;
+	rxsetup.tx_data = &cmd;
+	rxsetup.tx_length = 1;
+	rxsetup.rx_data = buf;
+	rxsetup.rx_length = 8;
+	rxsetup.retransmissions_max = 3;
 
-	// Prepare Y Measurement
-	cmd = TSC2004_CMD0(Y_REG, PND0_FALSE, READ_REG);
-	tc->y = I2C_TSC2004_Read_Word(cmd);
+	if (I2C_MasterTransferData(LPC_I2C0, &rxsetup, I2C_TRANSFER_POLLING) != SUCCESS)
+	{
+		tc->x = tc->y = tc->z1 = tc->z2 = 0;
+		return;
+	}
 
-	// Read Y Measurement
-	cmd = TSC2004_CMD0(Y_REG, PND0_FALSE, READ_REG);
-	tc->y = I2C_TSC2004_Read_Word(cmd);
+	tc->x = ((buf[0]<<8)|buf[1]) & MEAS_MASK;
+	tc->y = ((buf[2]<<8)|buf[3]) & MEAS_MASK;
+	tc->z1 = ((buf[4]<<8)|buf[5]) & MEAS_MASK;
+	tc->z2 = ((buf[6]<<8)|buf[7]) & MEAS_MASK;
+}
 
-	// Prepare Z1 Measurement
-	cmd = TSC2004_CMD0(Z1_REG, PND0_FALSE, READ_REG);
-	tc->z1 = I2C_TSC2004_Read_Word(cmd);
 
-	// Read Z1 Measurement
-	cmd = TSC2004_CMD0(Z1_REG, PND0_FALSE, READ_REG);
-	tc->z1 = I2C_TSC2004_Read_Word(cmd);
+/*********************************************************************//**
+ * @brief	    Start the touch pipeline: PINTDAV edges queue burst reads
+ *              in the background, filtered events are picked up with
+ *              TSC2004_GetEvent(). Calling it again does nothing.
+ * @param[in]	None
+ * @return 		None
+ **********************************************************************/
+void TSC2004_Start (void)
+{
+	if (tsc_running)
+	{
+		return;
+	}
+	if (!tsc_ready)
+	{
+		TSC2004_Init ();
+	}
+
+	tsc_cmd = TSC2004_CMD0(X_REG, PND0_FALSE, READ_REG);
+	tsc_job.sl_addr7bit = TSC2004_ID;
+	tsc_job.tx_data = &tsc_cmd;
+	tsc_job.tx_length = 1;
+	tsc_job.rx_data = tsc_raw;
+	tsc_job.rx_length = 8;
+	tsc_job.Retries = 0;
+	tsc_job.Timeout = 0;
+	tsc_job.Callback = tsc_read_done;
+
+	tsc_running = TRUE;
+	EXTI_Config(TSC_PENIRQ_LINE, EXTI_MODE_EDGE_SENSITIVE, EXTI_POLARITY_FALLING_EDGE);
+
+	/* A conversion may already be pending with PINTDAV low */
+	I2C_JobSubmit(LPC_I2C0, &tsc_job);
+}
 
-	// Prepare Z2 Measurement
-	cmd = TSC2004_CMD0(Z2_REG, PND0_FALSE, READ_REG);
-	tc->z2 = I2C_TSC2004_Read_Word(cmd);
 
-	// Read Z2 Measurement
-	cmd = TSC2004_CMD0(Z2_REG, PND0_FALSE, READ_REG);
-	tc->z2 = I2C_TSC2004_Read_Word(cmd);
+/*********************************************************************//**
+ * @brief	    Take the next touch event
+ * @param[out]	ev    event
+ * @return 		TRUE if an event was returned
+ *
+ * Note: a touch is a TSC_EV_PRESS, any number of TSC_EV_MOVE (only the
+ * latest one is kept while not read) and a TSC_EV_RELEASE once no data
+ * came for TSC_PENUP_TIME ms.
+ **********************************************************************/
+Bool TSC2004_GetEvent (TSC_EVENT_Type *ev)
+{
+	uint32_t primask = __get_PRIMASK();
+	Bool ok = FALSE;
 
-	tc->x &= MEAS_MASK;
-	tc->y &= MEAS_MASK;
-	tc->z1 &= MEAS_MASK;
-	tc->z2 &= MEAS_MASK;
+	__disable_irq();
+	if (tsc_head == tsc_tail)
+	{
+		tsc_penup_check();
+	}
+	if (tsc_head != tsc_tail)
+	{
+		*ev = tsc_ring[tsc_tail & (TSC_EVENT_RING - 1)];
+		tsc_tail++;
+		ok = TRUE;
+	}
+	__set_PRIMASK(primask);
+
+	return ok;
+}
+
+
+/*********************************************************************//**
+ * @brief	    Number of events lost because the ring was full
+ * @param[in]	None
+ * @return 		count
+ **********************************************************************/
+uint32_t TSC2004_GetDropped (void)
+{
+	return tsc_dropped;
+}
+
+
+/*********************************************************************//**
+ * @brief	    Use a new panel to screen mapping
+ * @param[in]	cal    mapping, e.g. from TSC2004_Calibrate()
+ * @return 		None
+ **********************************************************************/
+void TSC2004_SetCalibration (const TSC_CAL_Type *cal)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	tsc_cal = *cal;
+	__set_PRIMASK(primask);
+}
+
+
+/*********************************************************************//**
+ * @brief	    Compute the mapping from three touched targets
+ * @param[in]	panel     three raw X/Y readings (TSC2004_Read_Values)
+ * @param[in]	screen    the three target positions on the screen
+ * @param[out]	cal       mapping
+ * @return 		SUCCESS, or ERROR if the points are on one line
+ **********************************************************************/
+Status TSC2004_Calibrate (const TSC_POINT_Type *panel, const TSC_POINT_Type *screen, TSC_CAL_Type *cal)
+{
+	const TSC_POINT_Type *p = panel, *s = screen;
+
+	cal->Div = ((p[0].x - p[2].x) * (p[1].y - p[2].y)) - ((p[1].x - p[2].x) * (p[0].y - p[2].y));
+	if (cal->Div == 0)
+	{
+		return ERROR;
+	}
+
+	cal->An = ((s[0].x - s[2].x) * (p[1].y - p[2].y)) - ((s[1].x - s[2].x) * (p[0].y - p[2].y));
+	cal->Bn = ((p[0].x - p[2].x) * (s[1].x - s[2].x)) - ((s[0].x - s[2].x) * (p[1].x - p[2].x));
+	cal->Cn = (int64_t)p[0].y * ((int64_t)p[2].x * s[1].x - (int64_t)p[1].x * s[2].x) +
+			  (int64_t)p[1].y * ((int64_t)p[0].x * s[2].x - (int64_t)p[2].x * s[0].x) +
+			  (int64_t)p[2].y * ((int64_t)p[1].x * s[0].x - (int64_t)p[0].x * s[1].x);
+
+	cal->Dn = ((s[0].y - s[2].y) * (p[1].y - p[2].y)) - ((s[1].y - s[2].y) * (p[0].y - p[2].y));
+	cal->En = ((p[0].x - p[2].x) * (s[1].y - s[2].y)) - ((s[0].y - s[2].y) * (p[1].x - p[2].x));
+	cal->Fn = (int64_t)p[0].y * ((int64_t)p[2].x * s[1].y - (int64_t)p[1].x * s[2].y) +
+			  (int64_t)p[1].y * ((int64_t)p[0].x * s[2].y - (int64_t)p[2].x * s[0].y) +
+			  (int64_t)p[2].y * ((int64_t)p[1].x * s[0].y - (int64_t)p[0].x * s[1].y);
+
+	return SUCCESS;
 }
 
 
@@ -261,10 +558,16 @@ void TSC2004_Read_Value_Test (void)
  **********************************************************************/
 void TSC2004_Draw_Test (void)
 {
-	ts_event ts;
+	TSC_EVENT_Type ev;
 
-	TSC2004_Read_Values (&ts);
-	GLCD_PutPixel (((ts.x)/11)-24,((ts.y)/13)-36,Black);
+	TSC2004_Start ();
+	while (TSC2004_GetEvent (&ev))
+	{
+		if (ev.type != TSC_EV_RELEASE)
+		{
+			GLCD_PutPixel (ev.x,ev.y,Black);
+		}
+	}
 }
 
 
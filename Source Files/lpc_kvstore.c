@@ -0,0 +1,569 @@
+/******************************************************************//**
+* @file		lpc_kvstore.c
+* @brief	Contains all functions support for the log-structured,
+* 			power-fail safe key/value store on the serial E2PROMs
+* @version	1.0
+* @date		27. June. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* Peripheral group ----------------------------------------------------------- */
+/** @addtogroup KV
+ * @{
+ */
+
+/* Includes ------------------------------------------------------------------- */
+#include "lpc_kvstore.h"
+
+
+/* Private Macros ------------------------------------------------------------- */
+/** @defgroup KV_Private_Macros KV Private Macros
+ * @{
+ */
+
+/** Bank header magic, "KV" */
+#define KV_MAGIC0				0x4B
+#define KV_MAGIC1				0x56
+
+/** Address of a byte in a bank */
+#define KV_ADDR(kv, bank, off)	((kv)->Base + ((uint32_t)(bank) * (kv)->BankSize) + (off))
+
+/**
+ * @}
+ */
+
+
+/* Private Variables ---------------------------------------------------------- */
+/** @defgroup KV_Private_Variables KV Private Variables
+ * @{
+ */
+
+/** One record, header and value */
+static uint8_t kv_buf[KV_REC_HDR + KV_MAX_VALUE];
+
+/**
+ * @}
+ */
+
+
+/* Private Functions ---------------------------------------------------------- */
+/*********************************************************************//**
+ * @brief		Store a 32 bit value little endian
+ * @param[out]	p: destination
+ * @param[in]	v: value
+ * @return 		none
+ **********************************************************************/
+static void kv_put32 (uint8_t *p, uint32_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	p[2] = (uint8_t)(v >> 16);
+	p[3] = (uint8_t)(v >> 24);
+}
+
+
+/*********************************************************************//**
+ * @brief		CRC of a record in kv_buf
+ * @param[in]	seq: sequence number of the bank the record belongs to
+ * @param[in]	length: value length
+ * @return 		CRC-16 over the sequence number, key, length and value
+ *
+ * Note: seeding with the bank sequence number stamps every record with
+ * the bank generation, so records left over from an older use of the
+ * bank never pass as live ones.
+ **********************************************************************/
+static uint16_t kv_crc (uint32_t seq, uint8_t length)
+{
+	uint8_t s[4];
+	uint16_t crc;
+
+	kv_put32(s, seq);
+	crc = CRC16_Update(CRC16_INIT, s, 4);
+	crc = CRC16_Update(crc, kv_buf, 2);
+	return CRC16_Update(crc, &kv_buf[KV_REC_HDR], length);
+}
+
+
+/*********************************************************************//**
+ * @brief		Read and check the header of a bank
+ * @param[in]	kv: store
+ * @param[in]	bank: 0 or 1
+ * @param[out]	seq: sequence number of the bank
+ * @return 		TRUE if the header is valid
+ **********************************************************************/
+static Bool kv_read_bank (KV_STORE_Type *kv, uint8_t bank, uint32_t *seq)
+{
+	uint8_t hdr[KV_BANK_HDR];
+
+	if (E2P_Read(kv->Dev, KV_ADDR(kv, bank, 0), hdr, KV_BANK_HDR) != SUCCESS)
+	{
+		return FALSE;
+	}
+	if ((hdr[0] != KV_MAGIC0) || (hdr[1] != KV_MAGIC1))
+	{
+		return FALSE;
+	}
+	if (CRC16_Calc(hdr, 6) != (uint16_t)(hdr[6] | (hdr[7] << 8)))
+	{
+		return FALSE;
+	}
+	*seq = hdr[2] | (hdr[3] << 8) | (hdr[4] << 16) | ((uint32_t)hdr[5] << 24);
+	return TRUE;
+}
+
+
+/*********************************************************************//**
+ * @brief		Write the header of a bank, this commits the bank
+ * @param[in]	kv: store
+ * @param[in]	bank: 0 or 1
+ * @param[in]	seq: sequence number
+ * @return 		SUCCESS or ERROR
+ **********************************************************************/
+static Status kv_write_bank (KV_STORE_Type *kv, uint8_t bank, uint32_t seq)
+{
+	uint8_t hdr[KV_BANK_HDR];
+	uint16_t crc;
+
+	hdr[0] = KV_MAGIC0;
+	hdr[1] = KV_MAGIC1;
+	kv_put32(&hdr[2], seq);
+	crc = CRC16_Calc(hdr, 6);
+	hdr[6] = (uint8_t)crc;
+	hdr[7] = (uint8_t)(crc >> 8);
+	return E2P_Write(kv->Dev, KV_ADDR(kv, bank, 0), hdr, KV_BANK_HDR);
+}
+
+
+/*********************************************************************//**
+ * @brief		Read the record at an offset of a bank into kv_buf
+ * @param[in]	kv: store
+ * @param[in]	bank: 0 or 1
+ * @param[in]	seq: sequence number of the bank
+ * @param[in]	off: record offset
+ * @return 		TRUE if a complete record with a good CRC is there
+ **********************************************************************/
+static Bool kv_read_record (KV_STORE_Type *kv, uint8_t bank, uint32_t seq, uint32_t off)
+{
+	uint8_t length;
+
+	if (off + KV_REC_HDR > kv->BankSize)
+	{
+		return FALSE;
+	}
+	if (E2P_Read(kv->Dev, KV_ADDR(kv, bank, off), kv_buf, KV_REC_HDR) != SUCCESS)
+	{
+		return FALSE;
+	}
+	length = kv_buf[1];
+	if ((kv_buf[0] >= KV_MAX_KEYS) || (length > KV_MAX_VALUE) || (off + KV_REC_HDR + length > kv->BankSize))
+	{
+		return FALSE;
+	}
+	if ((length != 0) && (E2P_Read(kv->Dev, KV_ADDR(kv, bank, off + KV_REC_HDR), &kv_buf[KV_REC_HDR], length) != SUCCESS))
+	{
+		return FALSE;
+	}
+	return (kv_crc(seq, length) == (uint16_t)(kv_buf[2] | (kv_buf[3] << 8))) ? TRUE : FALSE;
+}
+
+
+/*********************************************************************//**
+ * @brief		Seal the record in kv_buf with its CRC and write it
+ * @param[in]	kv: store
+ * @param[in]	bank: 0 or 1
+ * @param[in]	seq: sequence number of the bank
+ * @param[in]	off: record offset
+ * @return 		SUCCESS or ERROR
+ *
+ * Note: a write cut by a power failure leaves a record with a bad CRC.
+ * KV_Init() ends the log there and the previous value of the key stays
+ * in effect, the next record simply overwrites it.
+ **********************************************************************/
+static Status kv_write_record (KV_STORE_Type *kv, uint8_t bank, uint32_t seq, uint32_t off)
+{
+	uint16_t crc = kv_crc(seq, kv_buf[1]);
+
+	kv_buf[2] = (uint8_t)crc;
+	kv_buf[3] = (uint8_t)(crc >> 8);
+	return E2P_Write(kv->Dev, KV_ADDR(kv, bank, off), kv_buf, KV_REC_HDR + kv_buf[1]);
+}
+
+
+/*********************************************************************//**
+ * @brief		Overwrite a bank from an offset to its end with 0xFF
+ * @param[in]	kv: store
+ * @param[in]	bank: 0 or 1
+ * @param[in]	off: first byte to clear
+ * @return 		SUCCESS or ERROR
+ *
+ * Note: a cut compaction leaves records sealed with the sequence number
+ * the next attempt uses again. Clearing past the new tail before the
+ * header is written keeps KV_Init() from scanning into them; key 0xFF
+ * is never valid, so the log ends at the first cleared byte.
+ **********************************************************************/
+static Status kv_wipe (KV_STORE_Type *kv, uint8_t bank, uint32_t off)
+{
+	uint32_t i, chunk;
+
+	for (i = 0; i < sizeof(kv_buf); i++)
+	{
+		kv_buf[i] = 0xFF;
+	}
+
+	while (off < kv->BankSize)
+	{
+		chunk = kv->BankSize - off;
+		if (chunk > sizeof(kv_buf))
+		{
+			chunk = sizeof(kv_buf);
+		}
+		if (E2P_Write(kv->Dev, KV_ADDR(kv, bank, off), kv_buf, chunk) != SUCCESS)
+		{
+			return ERROR;
+		}
+		off += chunk;
+	}
+	return SUCCESS;
+}
+
+
+/*********************************************************************//**
+ * @brief		Copy the live records into the other bank and switch to it
+ * @param[in]	kv: store
+ * @param[in]	drop: key left behind, KV_MAX_KEYS for none
+ * @return 		SUCCESS or ERROR
+ *
+ * Note: the other bank only becomes valid when its header is written,
+ * after all records and after the rest of the bank is cleared. A power
+ * failure before that leaves the current bank in use, untouched.
+ **********************************************************************/
+static Status kv_compact (KV_STORE_Type *kv, uint8_t drop)
+{
+	uint16_t index[KV_MAX_KEYS];
+	uint8_t dst = kv->Bank ^ 1;
+	uint32_t seq = kv->Seq + 1;
+	uint32_t off = KV_BANK_HDR;
+	uint8_t key;
+
+	for (key = 0; key < KV_MAX_KEYS; key++)
+	{
+		index[key] = 0;
+		if ((kv->Index[key] == 0) || (key == drop))
+		{
+			continue;
+		}
+		if (!kv_read_record(kv, kv->Bank, kv->Seq, kv->Index[key]))
+		{
+			return ERROR;
+		}
+		if (kv_write_record(kv, dst, seq, off) != SUCCESS)
+		{
+			return ERROR;
+		}
+		index[key] = off;
+		off += KV_REC_HDR + kv->Length[key];
+	}
+
+	if ((kv_wipe(kv, dst, off) != SUCCESS) || (kv_write_bank(kv, dst, seq) != SUCCESS))
+	{
+		return ERROR;
+	}
+
+	for (key = 0; key < KV_MAX_KEYS; key++)
+	{
+		kv->Index[key] = index[key];
+	}
+	kv->Bank = dst;
+	kv->Seq = seq;
+	kv->Tail = off;
+	kv->Live = off - KV_BANK_HDR;
+	kv->Compactions++;
+	return SUCCESS;
+}
+
+
+/*********************************************************************//**
+ * @brief		Append the record in kv_buf, compacting first if the
+ * 				bank is full
+ * @param[in]	kv: store
+ * @param[in]	drop: key the compaction leaves behind, KV_MAX_KEYS for none
+ * @return 		SUCCESS, or ERROR if it does not fit even after compaction
+ **********************************************************************/
+static Status kv_append (KV_STORE_Type *kv, uint8_t drop)
+{
+	uint32_t size = KV_REC_HDR + kv_buf[1];
+	uint8_t rec[KV_REC_HDR + KV_MAX_VALUE];
+	uint32_t i;
+
+	if (kv->Tail + size > kv->BankSize)
+	{
+		// Compaction goes through kv_buf, keep the new record aside
+		for (i = 0; i < size; i++) rec[i] = kv_buf[i];
+		if (kv_compact(kv, drop) != SUCCESS)
+		{
+			return ERROR;
+		}
+		for (i = 0; i < size; i++) kv_buf[i] = rec[i];
+
+		if (kv->Tail + size > kv->BankSize)
+		{
+			return ERROR;
+		}
+	}
+
+	if (kv_write_record(kv, kv->Bank, kv->Seq, kv->Tail) != SUCCESS)
+	{
+		return ERROR;
+	}
+	kv->Tail += size;
+	return SUCCESS;
+}
+/* End of Private Functions --------------------------------------------------- */
+
+
+/* Public Functions ----------------------------------------------------------- */
+/** @addtogroup KV_Public_Functions
+ * @{
+ */
+
+/*********************************************************************//**
+ * @brief		Mount a store and build its RAM index
+ * @param[in]	kv: store
+ * @param[in]	dev: E2PROM part, e.g. I2C_IEeprom_Device()
+ * @param[in]	base: first byte of the region
+ * @param[in]	bank_size: bytes per bank, the region uses twice this
+ * @return 		SUCCESS, or ERROR if the region does not fit the part
+ *
+ * Note: the bank with a valid header and the higher sequence number is
+ * used, a blank region is formatted. Its records are scanned once up to
+ * the first one with a bad CRC, which is where the log ends; after that
+ * every lookup is a single index access.
+ **********************************************************************/
+Status KV_Init (KV_STORE_Type *kv, E2P_DEVICE_Type *dev, uint32_t base, uint32_t bank_size)
+{
+	uint32_t seq[2];
+	Bool ok[2];
+	uint8_t key;
+
+	kv->Dev = dev;
+	kv->Base = base;
+	kv->BankSize = bank_size;
+	kv->Compactions = 0;
+
+	if ((bank_size < KV_BANK_HDR + KV_REC_HDR + KV_MAX_VALUE) || (bank_size > 0xFFFF) || \
+		(base + 2 * bank_size > dev->Size))
+	{
+		return ERROR;
+	}
+
+	ok[0] = kv_read_bank(kv, 0, &seq[0]);
+	ok[1] = kv_read_bank(kv, 1, &seq[1]);
+	if (!ok[0] && !ok[1])
+	{
+		kv->Bank = 1;
+		kv->Seq = 0;
+		return KV_Format(kv);				// bank 0, sequence 1
+	}
+	kv->Bank = (ok[1] && (!ok[0] || ((int32_t)(seq[1] - seq[0]) > 0))) ? 1 : 0;
+	kv->Seq = seq[kv->Bank];
+
+	for (key = 0; key < KV_MAX_KEYS; key++)
+	{
+		kv->Index[key] = 0;
+	}
+	kv->Live = 0;
+	kv->Tail = KV_BANK_HDR;
+
+	while (kv_read_record(kv, kv->Bank, kv->Seq, kv->Tail))
+	{
+		key = kv_buf[0];
+		if (kv->Index[key] != 0)
+		{
+			kv->Live -= KV_REC_HDR + kv->Length[key];
+		}
+		if (kv_buf[1] != 0)
+		{
+			kv->Index[key] = kv->Tail;
+			kv->Length[key] = kv_buf[1];
+			kv->Live += KV_REC_HDR + kv_buf[1];
+		}
+		else
+		{
+			kv->Index[key] = 0;				// deleted
+		}
+		kv->Tail += KV_REC_HDR + kv_buf[1];
+	}
+	return SUCCESS;
+}
+
+
+/*********************************************************************//**
+ * @brief		Erase all keys
+ * @param[in]	kv: store set up by KV_Init()
+ * @return 		SUCCESS or ERROR
+ *
+ * Note: the bank not in use is cleared and then gets a new header, so
+ * the old contents stay valid until it is written.
+ **********************************************************************/
+Status KV_Format (KV_STORE_Type *kv)
+{
+	uint8_t key;
+	uint8_t bank = kv->Bank ^ 1;
+	uint32_t seq = kv->Seq + 1;
+
+	if ((kv_wipe(kv, bank, KV_BANK_HDR) != SUCCESS) || (kv_write_bank(kv, bank, seq) != SUCCESS))
+	{
+		return ERROR;
+	}
+	for (key = 0; key < KV_MAX_KEYS; key++)
+	{
+		kv->Index[key] = 0;
+	}
+	kv->Bank = bank;
+	kv->Seq = seq;
+	kv->Tail = KV_BANK_HDR;
+	kv->Live = 0;
+	return SUCCESS;
+}
+
+
+/*********************************************************************//**
+ * @brief		Store the value of a key
+ * @param[in]	kv: store
+ * @param[in]	key: 0 .. KV_MAX_KEYS-1
+ * @param[in]	data: value
+ * @param[in]	length: 1 .. KV_MAX_VALUE bytes
+ * @return 		SUCCESS, or ERROR if invalid, full or the part failed
+ *
+ * Note: the value is appended to the log, so repeated updates of one
+ * key spread over the whole bank instead of wearing out one page. An
+ * unchanged value is not written at all.
+ **********************************************************************/
+Status KV_Set (KV_STORE_Type *kv, uint8_t key, const void *data, uint8_t length)
+{
+	const uint8_t *src = (const uint8_t *)data;
+	uint8_t i;
+
+	if ((key >= KV_MAX_KEYS) || (length == 0) || (length > KV_MAX_VALUE))
+	{
+		return ERROR;
+	}
+
+	if ((kv->Index[key] != 0) && (kv->Length[key] == length) && \
+		kv_read_record(kv, kv->Bank, kv->Seq, kv->Index[key]))
+	{
+		for (i = 0; (i < length) && (kv_buf[KV_REC_HDR + i] == src[i]); i++);
+		if (i == length)
+		{
+			return SUCCESS;
+		}
+	}
+
+	kv_buf[0] = key;
+	kv_buf[1] = length;
+	for (i = 0; i < length; i++)
+	{
+		kv_buf[KV_REC_HDR + i] = src[i];
+	}
+
+	if (kv_append(kv, KV_MAX_KEYS) != SUCCESS)
+	{
+		return ERROR;
+	}
+	if (kv->Index[key] != 0)
+	{
+		kv->Live -= KV_REC_HDR + kv->Length[key];
+	}
+	kv->Live += KV_REC_HDR + length;
+	kv->Index[key] = kv->Tail - (KV_REC_HDR + length);
+	kv->Length[key] = length;
+	return SUCCESS;
+}
+
+
+/*********************************************************************//**
+ * @brief		Read the value of a key
+ * @param[in]	kv: store
+ * @param[in]	key: 0 .. KV_MAX_KEYS-1
+ * @param[out]	data: value
+ * @param[in]	size: size of data, a longer value is cut
+ * @return 		value length, 0 if the key is not set
+ **********************************************************************/
+uint8_t KV_Get (KV_STORE_Type *kv, uint8_t key, void *data, uint8_t size)
+{
+	uint8_t *dst = (uint8_t *)data;
+	uint8_t i;
+
+	if ((key >= KV_MAX_KEYS) || (kv->Index[key] == 0))
+	{
+		return 0;
+	}
+	if (!kv_read_record(kv, kv->Bank, kv->Seq, kv->Index[key]))
+	{
+		return 0;
+	}
+	for (i = 0; (i < kv_buf[1]) && (i < size); i++)
+	{
+		dst[i] = kv_buf[KV_REC_HDR + i];
+	}
+	return kv_buf[1];
+}
+
+
+/*********************************************************************//**
+ * @brief		Remove a key
+ * @param[in]	kv: store
+ * @param[in]	key: 0 .. KV_MAX_KEYS-1
+ * @return 		SUCCESS or ERROR
+ *
+ * Note: an empty record is appended, it is dropped by the next
+ * compaction. The key stays readable if the append fails, unless a
+ * compaction on the way already left it behind.
+ **********************************************************************/
+Status KV_Delete (KV_STORE_Type *kv, uint8_t key)
+{
+	if (key >= KV_MAX_KEYS)
+	{
+		return ERROR;
+	}
+	if (kv->Index[key] == 0)
+	{
+		return SUCCESS;
+	}
+
+	// A compaction on the way leaves the key behind, so a full bank
+	// still makes room for the empty record
+	kv_buf[0] = key;
+	kv_buf[1] = 0;
+	if (kv_append(kv, key) != SUCCESS)
+	{
+		return ERROR;
+	}
+	if (kv->Index[key] != 0)
+	{
+		kv->Live -= KV_REC_HDR + kv->Length[key];
+		kv->Index[key] = 0;
+	}
+	return SUCCESS;
+}
+
+
+/*********************************************************************//**
+ * @brief		Space left for records
+ * @param[in]	kv: store
+ * @return 		bytes available after a compaction
+ **********************************************************************/
+uint32_t KV_Free (KV_STORE_Type *kv)
+{
+	return kv->BankSize - KV_BANK_HDR - kv->Live;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+/* --------------------------------- End Of File ------------------------------ */
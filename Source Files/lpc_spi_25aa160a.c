@@ -26,6 +26,12 @@ const char *status_reg[4]={"   STATUS REGISTER:\r\n\n",
                            "WPEN X    X    X   --  BP1  BP0  WEL  WIP",
 };
 
+/** E2PROM on the SPI bus, CS on EEP_CS_PIN, mode 0, 8 bit frames */
+static SPIBUS_DEVICE_Type eep_dev = {SPIBUS_SPI, EEP_CS_PORT, EEP_CS_PIN, SPIBUS_MODE0, 8, EEP_MAX_CLOCK};
+
+/** 25AA160A: 2K x 8, 16 byte pages, 5 ms write cycle */
+static E2P_DEVICE_Type e2p_dev = {NULL, &eep_dev, 0, 2, 16, 2048, 5};
+
 
 void print_status_reg(void)
 {
@@ -55,7 +61,7 @@ uint8_t Spi_Eeprom_Read_Status_Reg (void)
 	SPI_DATA_SETUP_Type xferConfig;
 
 	Tx_Buf[0] = EEP_RDSR;                      /* Read Status 8bit msb    */
-	CS_Force (DISABLE);                        /* Select device           */
+	SPIBUS_Select(&eep_dev);                   /* Select device           */
 
 	xferConfig.tx_data = Tx_Buf;               /* Send Instruction Byte    */
 	xferConfig.rx_data = Rx_Buf;               /* Store byte in Rx_Buf[0]  */
@@ -66,7 +72,7 @@ uint8_t Spi_Eeprom_Read_Status_Reg (void)
 
 	if(Rx_Buf[0])
 	{
-		CS_Force (ENABLE);                     /* Select device           */
+		SPIBUS_Release(&eep_dev);              /* Select device           */
 		return(Rx_Buf[0]);                    /* Return value            */
 	}
 	else
@@ -118,23 +124,23 @@ uchar Spi_Eeprom_Write_Status_Reg (uint8_t status_reg)
 
 	WriteData[0] = EEP_WREN;
 
-	CS_Force (DISABLE);                            /* Select device           */
+	SPIBUS_Select(&eep_dev);                       /* Select device           */
 
 	xferConfig.tx_data = WriteData;            /* Send Instruction Byte    */
 	xferConfig.rx_data = Rx_Buf;               /* Store byte in Rx_Buf[0]  */
 	xferConfig.length = 1;
 	SPI_ReadWrite(LPC_SPI, &xferConfig, SPI_TRANSFER_POLLING);  /* Write Enable Latch      */
-	CS_Force (ENABLE);                          /* CS high inactive        */
+	SPIBUS_Release(&eep_dev);                   /* CS high inactive        */
 
-	CS_Force (DISABLE);                            /* Select device           */
+	SPIBUS_Select(&eep_dev);                       /* Select device           */
 	xferConfig.tx_data = Tx_Buf;               /* Send Instruction Byte    */
 	xferConfig.length = 2;
 	WriteStatus = SPI_ReadWrite(LPC_SPI, &xferConfig, SPI_TRANSFER_POLLING);
 
 	if(WriteStatus)
 	{
-		CS_Force (ENABLE);                          /* CS high inactive        */
-		delay_ms(4);
+		SPIBUS_Release(&eep_dev);                   /* CS high inactive        */
+		E2P_WaitReady(&e2p_dev);                    /* WIP polling             */
 		return(1);
 	}
 	else
@@ -150,32 +156,9 @@ uchar Spi_Eeprom_Write_Status_Reg (uint8_t status_reg)
  **********************************************************************/
 uchar Spi_Eeprom_Write_Byte (uint16 eep_address, uint8_t byte_data)
 {
-	SPI_DATA_SETUP_Type xferConfig;
-	uint8_t WriteData[1],WriteStatus =0;
-
-	Tx_Buf[0] = EEP_WRITE;                  /* WRITE IR 8bit msb       */
-	Tx_Buf[1] = (uchar)(eep_address>>8);    // 1st byte extract
-	Tx_Buf[2] = (uchar) eep_address;        // 2nd byte extract
-	Tx_Buf[3] = byte_data;                  /* byte data lsb           */
-
-	WriteData[0] = EEP_WREN;
-
-	CS_Force (DISABLE);
-	xferConfig.tx_data = WriteData;            /* Send Instruction Byte    */
-	xferConfig.rx_data = Rx_Buf;               /* Store byte in Rx_Buf[0]  */
-	xferConfig.length = 1;
-	SPI_ReadWrite(LPC_SPI, &xferConfig, SPI_TRANSFER_POLLING);  /* Write Enable Latch      */
-	CS_Force (ENABLE);
-
-	CS_Force (DISABLE);                              /* CS low active           */
-	xferConfig.tx_data = Tx_Buf;               /* Send Instruction Byte    */
-	xferConfig.length = 4;
-	WriteStatus = SPI_ReadWrite(LPC_SPI, &xferConfig, SPI_TRANSFER_POLLING);
-
-	if(WriteStatus)
+	/* WREN, WRITE and WIP polling are done by the E2PROM engine */
+	if(E2P_Write(&e2p_dev, eep_address, &byte_data, 1) == SUCCESS)
 	{
-		CS_Force (ENABLE);                            /* CS high inactive        */
-		delay_ms(4);
 		return(1);
 	}
 	else
@@ -192,76 +175,13 @@ uchar Spi_Eeprom_Write_Byte (uint16 eep_address, uint8_t byte_data)
  **********************************************************************/
 uchar Spi_Eeprom_Write (uint16_t eep_address, uint8_t *data_start, uint8_t length)
 {
-	SPI_DATA_SETUP_Type xferConfig;
-	uint8_t WriteData[1],WriteStatus =0,ip_len,new_length;
-	uint16 new_address;
-
-	WriteData[0] = EEP_WREN;
-
-	Tx_Buf[0] = EEP_WRITE;                  // WRITE IR 8bit msb
-	Tx_Buf[1] = (uchar)(eep_address>>8);    // 1st byte extract
-	Tx_Buf[2] = (uchar)eep_address;         // 2nd byte extract
-
-	/* Intern page length(ip_len) gives length from address that can be occupied in page */
-	ip_len = 0x10 - (eep_address % 0x10);
-	new_address = eep_address + ip_len;
-
-	if(length > ip_len)
-	{
-		new_length = length - ip_len;
-
-		CS_Force (DISABLE);
-		xferConfig.tx_data = WriteData;            /* Send Instruction Byte    */
-		xferConfig.rx_data = Rx_Buf;               /* Store byte in Rx_Buf[0]  */
-		xferConfig.length = 1;
-		SPI_ReadWrite(LPC_SPI, &xferConfig, SPI_TRANSFER_POLLING);  /* Write Enable Latch      */
-		CS_Force (ENABLE);
-
-		CS_Force (DISABLE);                            // CS low active
-		xferConfig.tx_data = Tx_Buf;                   /* Send Instruction Byte    */
-		xferConfig.length = 3;
-		SPI_ReadWrite(LPC_SPI, &xferConfig, SPI_TRANSFER_POLLING);
-
-		xferConfig.tx_data = data_start;               // Pass value
-		xferConfig.length = ip_len;
-		WriteStatus = SPI_ReadWrite(LPC_SPI, &xferConfig, SPI_TRANSFER_POLLING);
-
-		if(WriteStatus)
-		{
-			CS_Force (ENABLE);                            /* CS high inactive        */
-		}
-		else
-			return(0);
-		// Recursive function
-		delay_ms(4);
-		Spi_Eeprom_Write(new_address,(data_start + ip_len),new_length);
-	}
-
-	if(length <= ip_len+1)
+	/* Split at pages, each one starts as soon as WIP clears */
+	if(E2P_Write(&e2p_dev, eep_address, data_start, length) == SUCCESS)
 	{
-		CS_Force (DISABLE);
-		xferConfig.tx_data = WriteData;            /* Send Instruction Byte    */
-		xferConfig.rx_data = Rx_Buf;               /* Store byte in Rx_Buf[0]  */
-		xferConfig.length = 1;
-		SPI_ReadWrite(LPC_SPI, &xferConfig, SPI_TRANSFER_POLLING);  /* Write Enable Latch      */
-		CS_Force (ENABLE);
-
-		CS_Force (DISABLE);                            // CS low
-		xferConfig.tx_data = Tx_Buf;                   /* Send Instruction Byte    */
-		xferConfig.length = 3;
-		SPI_ReadWrite(LPC_SPI, &xferConfig, SPI_TRANSFER_POLLING);
-
-		xferConfig.tx_data = data_start;               // Pass value
-		xferConfig.length = length;
-		WriteStatus = SPI_ReadWrite(LPC_SPI, &xferConfig, SPI_TRANSFER_POLLING);
-		if(WriteStatus)
-		{
-			CS_Force (ENABLE);                            /* CS high inactive        */
-		}
-		else
-			return(0);
+		return(1);
 	}
-	return(1);
+	else
+		return(0);
 }
 
 
@@ -272,26 +192,11 @@ uchar Spi_Eeprom_Write (uint16_t eep_address, uint8_t *data_start, uint8_t lengt
  **********************************************************************/
 uint8_t Spi_Eeprom_Read_Byte (uint16 eep_address)
 {
-	SPI_DATA_SETUP_Type xferConfig;
-
-	Tx_Buf[0] = EEP_READ;                 /* READ IR 8bit msb        */
-	Tx_Buf[1] = (uchar)(eep_address>>8);  // 1st byte extract
-	Tx_Buf[2] = (uchar)eep_address;       // 2nd byte extract
-
-	CS_Force (DISABLE);
-	xferConfig.tx_data = Tx_Buf;               /* Send Instruction Byte    */
-	xferConfig.rx_data = Rx_Buf;               /* Store byte in Rx_Buf[0]  */
-	xferConfig.length = 3;
-	SPI_ReadWrite(LPC_SPI, &xferConfig, SPI_TRANSFER_POLLING);
-	xferConfig.tx_data = NULL;
-	xferConfig.rx_data = Rx_Buf;               /* Store byte in Rx_Buf[0]  */
-	xferConfig.length = 1;
-	SPI_ReadWrite(LPC_SPI, &xferConfig, SPI_TRANSFER_POLLING);
+	uint8_t dat;
 
-	if(Rx_Buf[0])
+	if(E2P_Read(&e2p_dev, eep_address, &dat, 1) == SUCCESS)
 	{
-		CS_Force (ENABLE);
-		return(Rx_Buf[0]);                    /* Return value            */
+		return(dat);                          /* Return value            */
 	}
 	else
 		return(0);
@@ -307,27 +212,9 @@ uint8_t Spi_Eeprom_Read_Byte (uint16 eep_address)
  **********************************************************************/
 uchar Spi_Eeprom_Read (uint16_t eep_address, uint8_t *dest_addr, uint8_t length)
 {
-	SPI_DATA_SETUP_Type xferConfig;
-	uchar ReadStatus =0;
-
-	Tx_Buf[0] = EEP_READ;                      // READ IR 8bit msb
-	Tx_Buf[1] = (uchar)(eep_address>>8);       // 1st byte extract
-	Tx_Buf[2] = (uchar)eep_address;            // 2nd byte extract
-
-	CS_Force (DISABLE);
-	xferConfig.tx_data = Tx_Buf;               /* Send Instruction Byte    */
-	xferConfig.rx_data = Rx_Buf;               /* Store byte in Rx_Buf[0]  */
-	xferConfig.length = 3;
-	SPI_ReadWrite(LPC_SPI, &xferConfig, SPI_TRANSFER_POLLING);
-	xferConfig.tx_data = NULL;
-	xferConfig.rx_data = dest_addr;               /* Store byte  */
-	xferConfig.length = length;
-	ReadStatus = SPI_ReadWrite(LPC_SPI, &xferConfig, SPI_TRANSFER_POLLING);
-
-	if(ReadStatus)
+	/* One sequential read of any length */
+	if(E2P_Read(&e2p_dev, eep_address, dest_addr, length) == SUCCESS)
 	{
-		CS_Force (ENABLE);
-		delay_ms(4);
 		return(1);                                // Return value
 	}
 	else
@@ -396,6 +283,15 @@ void Display_Eeprom_Loc (uint16 mem_start_address, uint16 mem_end_address)
 }
 
 
+/*********************************************************************//**
+ * @brief		Serial E2PROM descriptor of the 25AA160A, for users of
+ * 				the lpc_eeprom engine such as the key/value store
+ * @return 		E2PROM part
+ **********************************************************************/
+E2P_DEVICE_Type *Spi_Eeprom_Device (void)
+{
+	return &e2p_dev;
+}
 
 
 /**
@@ -0,0 +1,273 @@
+/******************************************************************//**
+* @file		lpc_spi_bus.c
+* @brief	Contains all functions support for the shared SPI/SSP bus
+* 			manager: per-device chip select, clock mode, frame size
+* 			and clock rate
+* @version	1.0
+* @date		23. June. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* Peripheral group ----------------------------------------------------------- */
+/** @addtogroup SPIBUS
+ * @{
+ */
+
+/* Includes ------------------------------------------------------------------- */
+#include "lpc_spi_bus.h"
+
+
+/* Private Variables ---------------------------------------------------------- */
+/** @defgroup SPIBUS_Private_Variables SPIBUS Private Variables
+ * @{
+ */
+
+/** Device each bus is programmed for, NULL if unknown */
+static SPIBUS_DEVICE_Type *spibus_owner[SPIBUS_NUM];
+
+/** Device whose chip select is asserted on each bus, NULL if none */
+static SPIBUS_DEVICE_Type *spibus_selected[SPIBUS_NUM];
+
+/** Number of times each bus was reprogrammed for another device */
+static uint32_t spibus_switches[SPIBUS_NUM];
+
+/**
+ * @}
+ */
+
+
+/* Private Functions ---------------------------------------------------------- */
+/*********************************************************************//**
+ * @brief		Peripheral clock of a bus
+ * @param[in]	bus: SPIBUS_SPI, SPIBUS_SSP0 or SPIBUS_SSP1
+ * @return 		PCLK in Hz
+ **********************************************************************/
+static uint32_t spibus_pclk (uint8_t bus)
+{
+	if (bus == SPIBUS_SPI) return CLKPWR_GetPCLK(CLKPWR_PCLKSEL_SPI);
+	if (bus == SPIBUS_SSP0) return CLKPWR_GetPCLK(CLKPWR_PCLKSEL_SSP0);
+	return CLKPWR_GetPCLK(CLKPWR_PCLKSEL_SSP1);
+}
+
+
+/*********************************************************************//**
+ * @brief		Compute the control and clock register values of a device
+ * @param[in]	dev: device descriptor
+ * @param[in]	pclk: peripheral clock of its bus
+ * @return 		none
+ *
+ * Note: the clock is the fastest one not above MaxClock. SPI divides
+ * PCLK by an even SPCCR >= 8, SSP by an even CPSR times (SCR + 1).
+ **********************************************************************/
+static void spibus_compute (SPIBUS_DEVICE_Type *dev, uint32_t pclk)
+{
+	uint32_t div, scr;
+
+	div = (pclk + dev->MaxClock - 1) / dev->MaxClock;	// at or under MaxClock
+
+	if (dev->Bus == SPIBUS_SPI)
+	{
+		dev->Ctrl = SPI_SPCR_BIT_EN | SPI_SPCR_MSTR | SPI_SPCR_BITS(dev->Databit);
+		if (dev->Mode & 0x01) dev->Ctrl |= SPI_SPCR_CPHA_SECOND;
+		if (dev->Mode & 0x02) dev->Ctrl |= SPI_SPCR_CPOL_LOW;
+
+		div = (div + 1) & ~1UL;
+		if (div < 8) div = 8;
+		if (div > 254) div = 254;
+		dev->Div = SPI_SPCCR_COUNTER(div);
+	}
+	else
+	{
+		dev->Ctrl = SSP_CR0_DSS(dev->Databit) | SSP_CR0_FRF_SPI;
+		if (dev->Mode & 0x01) dev->Ctrl |= SSP_CR0_CPHA_SECOND;
+		if (dev->Mode & 0x02) dev->Ctrl |= SSP_CR0_CPOL_HI;
+
+		// Smallest prescaler that leaves the rest to SCR
+		for (dev->Div = 2; dev->Div < 254; dev->Div += 2)
+		{
+			if (((div + dev->Div - 1) / dev->Div) <= 256) break;
+		}
+		scr = (div + dev->Div - 1) / dev->Div;
+		scr = (scr > 256) ? 255 : ((scr == 0) ? 0 : (scr - 1));
+		dev->Ctrl |= SSP_CR0_SCR(scr);
+	}
+	dev->Pclk = pclk;
+}
+
+
+/*********************************************************************//**
+ * @brief		Check that the registers of a bus still hold the values
+ * 				of a device
+ * @param[in]	dev: device descriptor with a valid cache
+ * @return 		TRUE if nothing reprogrammed the bus behind the manager,
+ * 				e.g. an SSP job with another frame size
+ **********************************************************************/
+static Bool spibus_programmed (SPIBUS_DEVICE_Type *dev)
+{
+	LPC_SSP_TypeDef *SSPx;
+
+	if (dev->Bus == SPIBUS_SPI)
+	{
+		return (((LPC_SPI->SPCR & SPI_SPCR_BITMASK) == dev->Ctrl) &&
+				((LPC_SPI->SPCCR & SPI_SPCCR_BITMASK) == dev->Div)) ? TRUE : FALSE;
+	}
+	SSPx = (dev->Bus == SPIBUS_SSP0) ? LPC_SSP0 : LPC_SSP1;
+	return (((SSPx->CR0 & SSP_CR0_BITMASK) == dev->Ctrl) &&
+			((SSPx->CPSR & SSP_CPSR_BITMASK) == dev->Div)) ? TRUE : FALSE;
+}
+
+
+/*********************************************************************//**
+ * @brief		Load the registers of a bus for a device
+ * @param[in]	dev: device descriptor with a valid cache
+ * @return 		none
+ **********************************************************************/
+static void spibus_program (SPIBUS_DEVICE_Type *dev)
+{
+	LPC_SSP_TypeDef *SSPx;
+
+	if (dev->Bus == SPIBUS_SPI)
+	{
+		LPC_SPI->SPCR = dev->Ctrl;
+		LPC_SPI->SPCCR = dev->Div;
+	}
+	else
+	{
+		SSPx = (dev->Bus == SPIBUS_SSP0) ? LPC_SSP0 : LPC_SSP1;
+		SSPx->CR0 = dev->Ctrl;
+		SSPx->CPSR = dev->Div;
+	}
+}
+/* End of Private Functions --------------------------------------------------- */
+
+
+/* Public Functions ----------------------------------------------------------- */
+/** @addtogroup SPIBUS_Public_Functions
+ * @{
+ */
+
+/*********************************************************************//**
+ * @brief		Program the bus for a device without touching its chip select
+ * @param[in]	dev: device descriptor
+ * @return 		none
+ *
+ * Note: the peripheral is only reprogrammed when the previous transaction
+ * on the bus was for another device, so back-to-back transactions to the
+ * same device cost nothing but the chip select. The owner is also
+ * dropped when the registers were changed behind the manager, as
+ * ssp_job_start() does for the frame size of a job.
+ * On SSP buses queued jobs (SSP_JobSubmit) are allowed to finish first,
+ * so this must be called from thread mode only: from a job callback or
+ * any other ISR the queue can not drain and the wait never ends.
+ **********************************************************************/
+void SPIBUS_Acquire (SPIBUS_DEVICE_Type *dev)
+{
+	LPC_SSP_TypeDef *SSPx;
+	uint32_t pclk;
+
+	if (dev->Bus != SPIBUS_SPI)
+	{
+		SSPx = (dev->Bus == SPIBUS_SSP0) ? LPC_SSP0 : LPC_SSP1;
+		CHECK_PARAM((__get_IPSR() == 0) || (SSP_JobBusy(SSPx) == FALSE));
+		while (SSP_JobBusy(SSPx));
+	}
+
+	if ((spibus_owner[dev->Bus] == dev) && (dev->Pclk != 0) && !spibus_programmed(dev))
+	{
+		spibus_owner[dev->Bus] = NULL;
+	}
+
+	if ((spibus_owner[dev->Bus] != dev) || (dev->Pclk == 0))
+	{
+		if (dev->Pclk == 0)
+		{
+			GPIO_SetDir(dev->CsPort, dev->CsPin, 1);
+			GPIO_SetValue(dev->CsPort, dev->CsPin);
+		}
+		// PCLK may have been changed for another device (SD_Init)
+		pclk = spibus_pclk(dev->Bus);
+		if (dev->Pclk != pclk)
+		{
+			spibus_compute(dev, pclk);
+		}
+		spibus_program(dev);
+		spibus_owner[dev->Bus] = dev;
+		spibus_switches[dev->Bus]++;
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief		Take the bus for a device and assert its chip select
+ * @param[in]	dev: device descriptor
+ * @return 		none
+ *
+ * Note: one device per bus is selected at a time, which is what lets
+ * devices share a chip select pin. A device left selected, e.g. by an
+ * early return, is released first, so the shared pin sees a fresh
+ * falling edge.
+ **********************************************************************/
+void SPIBUS_Select (SPIBUS_DEVICE_Type *dev)
+{
+	if ((spibus_selected[dev->Bus] != NULL) && (spibus_selected[dev->Bus] != dev))
+	{
+		SPIBUS_Release(spibus_selected[dev->Bus]);
+	}
+
+	SPIBUS_Acquire(dev);
+	spibus_selected[dev->Bus] = dev;
+	GPIO_ClearValue(dev->CsPort, dev->CsPin);
+}
+
+
+/*********************************************************************//**
+ * @brief		Release the chip select of a device, the bus stays
+ * 				programmed for it
+ * @param[in]	dev: device descriptor
+ * @return 		none
+ **********************************************************************/
+void SPIBUS_Release (SPIBUS_DEVICE_Type *dev)
+{
+	GPIO_SetValue(dev->CsPort, dev->CsPin);
+	if (spibus_selected[dev->Bus] == dev)
+	{
+		spibus_selected[dev->Bus] = NULL;
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief		Change the clock limit of a device, e.g. after card
+ * 				identification, takes effect on the next SPIBUS_Select()
+ * @param[in]	dev: device descriptor
+ * @param[in]	clock: new MaxClock in Hz
+ * @return 		none
+ *
+ * Note: also call it after changing the PCLK divider of the bus.
+ **********************************************************************/
+void SPIBUS_SetClock (SPIBUS_DEVICE_Type *dev, uint32_t clock)
+{
+	dev->MaxClock = clock;
+	dev->Pclk = 0;
+}
+
+
+/*********************************************************************//**
+ * @brief		Number of device switches on a bus
+ * @param[in]	bus: SPIBUS_SPI, SPIBUS_SSP0 or SPIBUS_SSP1
+ * @return 		times the peripheral was reprogrammed
+ **********************************************************************/
+uint32_t SPIBUS_GetSwitches (uint8_t bus)
+{
+	return spibus_switches[bus];
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+/* --------------------------------- End Of File ------------------------------ */
@@ -21,72 +21,226 @@
  */
 
 
-/** @addtogroup SD_Public_Functions
+/* Private Variables ---------------------------------------------------------- */
+/** @defgroup SD_Private_Variables SD Private Variables
  * @{
  */
 
-/* Public Functions ----------------------------------------------------------- */
+static sd_card_type sd_type = SD_CARD_UNKNOWN;	// set by SD_Init()
+static Bool sd_busy = FALSE;					// card may still be programming a write
+
+/** Card on the SPI bus, CS on SD_CS_PIN, mode 0, 8 bit frames */
+static SPIBUS_DEVICE_Type sd_dev = {SPIBUS_SPI, SD_CS_PORT, SD_CS_PIN, SPIBUS_MODE0, 8, SD_SPI_INIT_CLOCK};
+
+/**
+ * @}
+ */
+
+
+/* Private Functions ---------------------------------------------------------- */
 /*********************************************************************//**
- * @brief		check if SD card is inserted or not
+ * @brief		Exchange one byte on the SPI bus
+ * @param[in]	data: byte to send, 0xFF to just clock in data
+ * @return 		byte received
+ **********************************************************************/
+static uint8_t sd_xchg (uint8_t data)
+{
+	LPC_SPI->SPDR = data;
+	while (!(LPC_SPI->SPSR & SPI_SPSR_SPIF));
+	return (uint8_t)LPC_SPI->SPDR;
+}
+
+
+/*********************************************************************//**
+ * @brief		Assert CS, it then stays low for the whole transaction
  * @param[in]	none
- * @return 		SD_CONNECTED or SD_DISCONNECTED
+ * @return 		none
  **********************************************************************/
-sd_connect_status SD_GetCardConnectStatus (void)
+static void sd_select (void)
 {
-	sd_connect_status ret=SD_DISCONNECTED;
+	SPIBUS_Select(&sd_dev);
+}
 
-	if((GPIO_ReadValue(4)&_BIT(29))== 0)
-		ret = SD_CONNECTED;
 
-	return ret;
+/*********************************************************************//**
+ * @brief		Release CS and give the card 8 clocks to release DO
+ * @param[in]	none
+ * @return 		none
+ **********************************************************************/
+static void sd_deselect (void)
+{
+	SPIBUS_Release(&sd_dev);
+	sd_xchg(0xFF);
 }
 
 
 /*********************************************************************//**
- * @brief		Calculate CRC-7 as required by SD specification
- * @param[in]	- old_crc: 0x00 to start new CRC
- * 			    or value from previous call to continue.
- * 				- data: data byte to add to CRC computation
- * @return 		CRC-7 checksum which MUST be augmented by crc_7augment() before used
+ * @brief		Wait until the card stops holding DO low (busy), CS asserted
+ * @param[in]	timeout: time limit in ms
+ * @return 		TRUE if the card is ready, FALSE on timeout
  **********************************************************************/
-uint8_t CRC_7 (uint8_t old_crc, uint8_t data)
+static Bool sd_wait_ready (uint32_t timeout)
 {
-	uint8_t new_crc,x;
+	uint32_t start = SYSTICK_GetTick();
 
-	new_crc = old_crc;
-	for (x = 7; x >= 0; x--)
+	while (sd_xchg(0xFF) != 0xFF)
 	{
-		new_crc <<= 1;
-		new_crc |= GETBIT(data,x);
-		if (GETBIT(new_crc, 7) == 1)
-		{
-			new_crc ^= 0x89; /*CRC-7's polynomial is x^7 + x^3 + 1*/
-		}
-		if(x==0) break;
+		if ((uint32_t)(SYSTICK_GetTick() - start) >= timeout) return FALSE;
+	}
+	return TRUE;
+}
+
+
+/*********************************************************************//**
+ * @brief		Send a command frame, CS asserted
+ * @param[in]	- cmd: SD command code
+ * 			    - arg: 32-bit argument
+ * @return 		FALSE if a previous write never finished programming
+ *
+ * Note: a write left busy by SD_WriteBlocks() is drained here, so the
+ * card programs in the background until the next command needs the bus.
+ **********************************************************************/
+static Bool sd_send_cmd (uint8_t cmd, uint32_t arg)
+{
+	uint8_t n;
+
+	if (sd_busy)
+	{
+		if (!sd_wait_ready(SD_WRITE_TIMEOUT_MS)) return FALSE;
+		sd_busy = FALSE;
+	}
+
+	/* First byte has framing bits and command */
+	sd_cmd_buf[0] = 0x40 | (cmd & 0x3f);
+	sd_cmd_buf[1] = (uint8_t)(arg >> 24);
+	sd_cmd_buf[2] = (uint8_t)(arg >> 16);
+	sd_cmd_buf[3] = (uint8_t)(arg >> 8);
+	sd_cmd_buf[4] = (uint8_t)arg;
+	//calculate CRC
+	sd_cmd_buf[5] = (CRC7_Calc(sd_cmd_buf, 5) << 1) | 0x01;//stop bit
+
+	for (n = 0; n < SD_CMD_BLOCK_LENGTH; n++)
+	{
+		sd_xchg(sd_cmd_buf[n]);
 	}
-	return new_crc;
+	/* CMD12 is followed by a stuff byte while the data stream stops */
+	if (cmd == CMD12_STOP_TRANSMISSION) sd_xchg(0xFF);
+	return TRUE;
 }
 
 
 /*********************************************************************//**
- * @brief		Provides the zero-padding final step to CRC-7
- * @param[in]	- old_crc: value from last crc_7()call
- * @return 		Finalized CRC-7 checksum
+ * @brief		Send a command and get its R1 response, CS asserted
+ * @param[in]	- cmd: SD command code
+ * 			    - arg: 32-bit argument
+ * @return 		R1 response, 0xFF if the card did not answer
  **********************************************************************/
-uint8_t CRC_7Final (uint8_t old_crc)
+static uint8_t sd_command (uint8_t cmd, uint32_t arg)
 {
-	uint8_t new_crc,x;
+	uint8_t r1 = 0xFF;
+	uint8_t n;
 
-	new_crc = old_crc;
-	for (x = 0; x < 7; x++)
+	if (!sd_send_cmd(cmd, arg)) return 0xFF;
+
+	/* R1 comes within 8 bytes, start bit is 0 */
+	for (n = 0; n < 10; n++)
 	{
-		new_crc <<= 1;
-		if (GETBIT(new_crc, 7) == 1)
-		{
-			new_crc ^= 0x89; /*CRC-7's polynomial is x^7 + x^3 + 1*/
-		}
+		r1 = sd_xchg(0xFF);
+		if (GETBIT(r1,7) == 0) break;
 	}
-	return new_crc;
+	return r1;
+}
+
+
+/*********************************************************************//**
+ * @brief		Read one data block and check its CRC-16, CS asserted
+ * @param[in]	buffer: SD_BLOCK_SIZE bytes
+ * @return 		SD_OK, SD_ERROR_TIMEOUT, SD_ERROR_TOKEN or SD_ERROR_CRC
+ **********************************************************************/
+static sd_error sd_read_data (uint8_t *buffer)
+{
+	uint32_t start, i;
+	uint16_t crc;
+	uint8_t token;
+
+	/* Wait for start token */
+	start = SYSTICK_GetTick();
+	while ((token = sd_xchg(0xFF)) == 0xFF)
+	{
+		if ((uint32_t)(SYSTICK_GetTick() - start) >= SD_READ_TIMEOUT_MS) return SD_ERROR_TIMEOUT;
+	}
+	if (token != SD_TOKEN_START_BLOCK) return SD_ERROR_TOKEN;
+
+	for (i = 0; i < SD_BLOCK_SIZE; i++)
+	{
+		buffer[i] = sd_xchg(0xFF);
+	}
+	crc  = (uint16_t)sd_xchg(0xFF) << 8;
+	crc |= sd_xchg(0xFF);
+
+	if (crc != CRC16_Calc(buffer, SD_BLOCK_SIZE)) return SD_ERROR_CRC;
+	return SD_OK;
+}
+
+
+/*********************************************************************//**
+ * @brief		Send one data block with its CRC-16, CS asserted
+ * @param[in]	- buffer: SD_BLOCK_SIZE bytes
+ * 				- token: SD_TOKEN_START_BLOCK or SD_TOKEN_START_MULTI
+ * @return 		SD_OK, SD_ERROR_CRC or SD_ERROR_WRITE
+ **********************************************************************/
+static sd_error sd_write_data (const uint8_t *buffer, uint8_t token)
+{
+	uint32_t i;
+	uint16_t crc;
+	uint8_t resp;
+
+	crc = CRC16_Calc(buffer, SD_BLOCK_SIZE);
+
+	sd_xchg(token);
+	for (i = 0; i < SD_BLOCK_SIZE; i++)
+	{
+		sd_xchg(buffer[i]);
+	}
+	sd_xchg((uint8_t)(crc >> 8));
+	sd_xchg((uint8_t)crc);
+
+	resp = sd_xchg(0xFF) & SD_DATA_RESP_MASK;
+	if (resp == SD_DATA_RESP_ACCEPTED) return SD_OK;
+	if (resp == SD_DATA_RESP_CRC_ERR) return SD_ERROR_CRC;
+	return SD_ERROR_WRITE;
+}
+
+
+/*********************************************************************//**
+ * @brief		Convert a block number to a command address
+ * @param[in]	block: block number
+ * @return 		byte address for standard capacity cards, block otherwise
+ **********************************************************************/
+static uint32_t sd_block_addr (uint32_t block)
+{
+	return (sd_type == SD_CARD_V2_HC) ? block : (block * SD_BLOCK_SIZE);
+}
+
+
+/** @addtogroup SD_Public_Functions
+ * @{
+ */
+
+/* Public Functions ----------------------------------------------------------- */
+/*********************************************************************//**
+ * @brief		check if SD card is inserted or not
+ * @param[in]	none
+ * @return 		SD_CONNECTED or SD_DISCONNECTED
+ **********************************************************************/
+sd_connect_status SD_GetCardConnectStatus (void)
+{
+	sd_connect_status ret=SD_DISCONNECTED;
+
+	if((GPIO_ReadValue(4)&_BIT(29))== 0)
+		ret = SD_CONNECTED;
+
+	return ret;
 }
 
 
@@ -98,22 +252,19 @@ uint8_t CRC_7Final (uint8_t old_crc)
  * 						  NULL if nothing to receive.
  * 			    - length: number of data to send or receive
  * @return 		the actual data sent or received.
+ *
+ * Note: CS is left as it is, the caller frames the whole transaction.
  **********************************************************************/
 uint32_t SD_SendReceiveData_Polling (void* tx_buf, void* rx_buf, uint32_t length)
 {
 	// SPI Data Setup structure variable
 	SPI_DATA_SETUP_Type xferConfig;
 
-	CS_Force(DISABLE);
-	// delay_ms(1);
-
 	xferConfig.tx_data = tx_buf;
 	xferConfig.rx_data = rx_buf;
 	xferConfig.length = length;
 	SPI_ReadWrite(LPC_SPI, &xferConfig, SPI_TRANSFER_POLLING);
 
-	// delay_ms(1);
-	CS_Force(ENABLE);
 	return xferConfig.counter;
 }
 
@@ -123,27 +274,15 @@ uint32_t SD_SendReceiveData_Polling (void* tx_buf, void* rx_buf, uint32_t length
  * @param[in]	- cmd: SD command code
  * 			    - arg: pointer to array of 4x8 bytes, argument of command
  * @return 		n/a
+ *
+ * Note: selects the card, SD_WaitR1() deselects it once the response
+ * has been read.
  **********************************************************************/
 void SD_SendCommand(uint8_t cmd, uint8_t *arg)
 {
-	uint8_t crc = 0x00;
-
-	/* First byte has framing bits and command */
-	sd_cmd_buf[0] = 0x40 | (cmd & 0x3f);
-	sd_cmd_buf[1] = arg[0];
-	sd_cmd_buf[2] = arg[1];
-	sd_cmd_buf[3] = arg[2];
-	sd_cmd_buf[4] = arg[3];
-	//calculate CRC
-	crc = CRC_7(crc, sd_cmd_buf[0]);//start new crc-7
-	crc = CRC_7(crc, sd_cmd_buf[1]);
-	crc = CRC_7(crc, sd_cmd_buf[2]);
-	crc = CRC_7(crc, sd_cmd_buf[3]);
-	crc = CRC_7(crc, sd_cmd_buf[4]);
-	crc = CRC_7Final(crc);
-	sd_cmd_buf[5] = (crc << 1) | 0x01;//stop bit
-
-	SD_SendReceiveData_Polling(sd_cmd_buf,NULL,SD_CMD_BLOCK_LENGTH);
+	sd_select();
+	sd_send_cmd(cmd, ((uint32_t)arg[0] << 24) | ((uint32_t)arg[1] << 16) |
+					 ((uint32_t)arg[2] << 8) | arg[3]);
 }
 
 
@@ -157,54 +296,71 @@ void SD_SendCommand(uint8_t cmd, uint8_t *arg)
  **********************************************************************/
 sd_error SD_WaitR1 (uint8_t *buffer, uint32_t length, uint32_t timeout)
 {
-    uint32_t j;
-	uint8_t dummy[2];
+	uint32_t j;
+	uint8_t dummy;
 	uint8_t wait_idle;
+	sd_error ret = SD_OK;
 
 	/* No null pointers allowed */
-	if (buffer == NULL)	return SD_CMD_BAD_PARAMETER;
+	if (buffer == NULL)
+	{
+		sd_deselect();
+		return SD_CMD_BAD_PARAMETER;
+	}
 
 	/* Wait for start bit on R1 */
-	j=0;dummy[0]=0xFF;
-	while (GETBIT(dummy[0],7) == 1)
+	j=0;dummy=0xFF;
+	while (GETBIT(dummy,7) == 1)
 	{
-		if (j>timeout)return SD_ERROR_TIMEOUT;
-		dummy[0]=0x00;
-		SD_SendReceiveData_Polling(NULL,dummy,1);
+		if (j>timeout)
+		{
+			ret = SD_ERROR_TIMEOUT;
+			goto done;
+		}
+		dummy = sd_xchg(0xFF);
 		j++;
 	}
-	*buffer=dummy[0];//store R1
+	*buffer=dummy;//store R1
 	if (length > 0)//read followed data
 	{
 		/* Wait for start token on data portion, if any */
-		dummy[0] = 0xff;
+		dummy = 0xff;
 		j = 0;
-		while (dummy[0] != 0xfe)
+		while (dummy != 0xfe)
 		{
-			if (j > timeout)return SD_ERROR_TIMEOUT;
-			dummy[0]=0x00;
-			SD_SendReceiveData_Polling(NULL,dummy,1);
-			if ((dummy[0] != 0xff) && (dummy[0] != 0xfe)) // not idle or start token?
+			if (j > timeout)
+			{
+				ret = SD_ERROR_TIMEOUT;
+				goto done;
+			}
+			dummy = sd_xchg(0xFF);
+			if ((dummy != 0xff) && (dummy != 0xfe)) // not idle or start token?
 			{
-				return SD_ERROR_TOKEN;
+				ret = SD_ERROR_TOKEN;
+				goto done;
 			}
 			j++;
 		}
 		/* Read all bytes */
-		SD_SendReceiveData_Polling(NULL,(buffer+1),(length - 1));
+		for (j = 1; j < length; j++)
+		{
+			buffer[j] = sd_xchg(0xFF);
+		}
 	}
 	/* Some more bit clocks to finish internal SD operations */
-	dummy[0]=0x00;
+	dummy=0x00;
 	wait_idle=0;
-	while((dummy[0]!=0xff)&&(wait_idle<20))
+	while((dummy!=0xff)&&(wait_idle<20))
 	{
-		dummy[0]=0x00;
-		SD_SendReceiveData_Polling(NULL,dummy,1);
+		dummy = sd_xchg(0xFF);
 		for(j=0;j<1000;j++);
 		wait_idle++;
 	}
-	if(wait_idle>=20) return SD_ERROR_BUS_NOT_IDLE;
-	return SD_OK;
+	if(wait_idle>=20) ret = SD_ERROR_BUS_NOT_IDLE;
+
+done:
+	sd_deselect();
+	return ret;
 }
 
 
@@ -212,29 +368,30 @@ sd_error SD_WaitR1 (uint8_t *buffer, uint32_t length, uint32_t timeout)
  * @brief		Wait for SD card idle
  * @param[in]	- num_char: number characters (8 bits clock) to wait
  * @return 		device already in idle state or need more time
+ *
+ * Note: clocks with CS deasserted, as needed for the power-up sequence.
  **********************************************************************/
 sd_error SD_WaitDeviceIdle (uint32_t num_char)
 {
-	uint8_t dummy[2]={0,0};
+	uint8_t dummy=0;
 	uint32_t i=0;
 
-	while ((i < num_char) && (dummy[0] != 0xff))
+	SPIBUS_Acquire(&sd_dev);
+	SPIBUS_Release(&sd_dev);
+	while ((i < num_char) && (dummy != 0xff))
 	{
-		dummy[0]=0x00;
-		SD_SendReceiveData_Polling(NULL,dummy,1);
-		if (dummy[0] == 0xff)
+		dummy = sd_xchg(0xFF);
+		if (dummy == 0xff)
 		{
-			dummy[0]= 0x00;
-			SD_SendReceiveData_Polling(NULL,dummy,1);
-			if (dummy[0] == 0xff)
+			dummy = sd_xchg(0xFF);
+			if (dummy == 0xff)
 			{
-				dummy[0]= 0x00;
-				SD_SendReceiveData_Polling(NULL,dummy,1);
+				dummy = sd_xchg(0xFF);
 			}
 		}
 		i++;
 	}
-	if (dummy[0] != 0xff)return SD_ERROR_TIMEOUT;
+	if (dummy != 0xff)return SD_ERROR_TIMEOUT;
 
 	return SD_OK;
 }
@@ -244,17 +401,29 @@ sd_error SD_WaitDeviceIdle (uint32_t num_char)
  * @brief		Initialize SD card in SPI mode
  * @param[in]	- retries: number retry time
  * @return 		initialization successful or terminated with specific error code
+ *
+ * Note: identification runs at SD_SPI_INIT_CLOCK. SD v2 cards are told
+ * apart with CMD8 and SDHC/SDXC (block addressed) cards with the CCS bit
+ * read by CMD58. On success the SPI is switched to SD_SPI_FAST_CLOCK.
  **********************************************************************/
 sd_error SD_Init (uint8_t retries)
 {
 	uint8_t rxdata,errors;
-	uint8_t SD_arg[4]={0,0,0,0};
-	uint16_t i;
+	uint8_t resp[4];
+	uint32_t hcs, start;
+	uint8_t i;
+
+	sd_type = SD_CARD_UNKNOWN;
+	sd_busy = FALSE;
 
 	// check for SD card insertion
 	printf(LPC_UART0,"\n\rPlease plug-in SD card!");
 	while(SD_GetCardConnectStatus()==SD_DISCONNECTED);
 	printf(LPC_UART0,"...Connected!\n\r");
+
+	// Identification mode clock
+	SPIBUS_SetClock(&sd_dev, SD_SPI_INIT_CLOCK);
+
 	// Wait for bus idle
 	if(SD_WaitDeviceIdle(160) != SD_OK) return SD_ERROR_BUS_NOT_IDLE;
 	printf(LPC_UART0,"Initialize SD card in SPI mode...");
@@ -264,46 +433,284 @@ sd_error SD_Init (uint8_t retries)
 	/* This signals the SD card to fall back to SPI mode */
 	while(errors < retries)
 	{
-		SD_SendCommand(CMD0_GO_IDLE_STATE, SD_arg);
-		if(SD_WaitR1(&rxdata,0,1000)!= SD_OK)
+		sd_select();
+		rxdata = sd_command(CMD0_GO_IDLE_STATE, 0);
+		sd_deselect();
+		if(rxdata == R1_IDLE) break;
+		errors++;
+	}
+	if(errors >= retries)return SD_ERROR_CMD0;
+
+	/* SD v2 cards echo the voltage range and check pattern, v1 cards reject CMD8 */
+	sd_select();
+	rxdata = sd_command(CMD8_SEND_IF_COND, 0x000001AA);
+	for (i = 0; i < 4; i++) resp[i] = sd_xchg(0xFF);
+	sd_deselect();
+	if (rxdata == R1_IDLE)
+	{
+		if (((resp[2] & 0x0F) != 0x01) || (resp[3] != 0xAA)) return SD_ERROR_CMD8;
+		hcs = 0x40000000;	// host supports high capacity
+		sd_type = SD_CARD_V2;
+	}
+	else if (rxdata & R1_ILLEGAL)
+	{
+		hcs = 0;
+		sd_type = SD_CARD_V1;
+	}
+	else return SD_ERROR_CMD8;
+
+	/* Start its internal initialization process */
+	start = SYSTICK_GetTick();
+	do
+	{
+		if ((uint32_t)(SYSTICK_GetTick() - start) >= SD_INIT_TIMEOUT_MS)
 		{
-			errors++;
-			continue;
+			sd_type = SD_CARD_UNKNOWN;
+			return SD_ERROR_ACMD41;
 		}
-		if(rxdata != R1_IDLE)
+		sd_select();
+		rxdata = sd_command(CMD55_APP_CMD, 0);
+		if (rxdata & ~R1_IDLE)
 		{
-			errors++;
-			continue;
+			sd_deselect();
+			sd_type = SD_CARD_UNKNOWN;
+			return SD_ERROR_CMD55;
 		}
-		else break;
+		rxdata = sd_command(ACMD41_SEND_OP_COND, hcs);
+		sd_deselect();
+	} while (rxdata == R1_IDLE);	//in_idle_state = 1
+	if (rxdata != R1_NOERROR)
+	{
+		sd_type = SD_CARD_UNKNOWN;
+		return SD_ERROR_ACMD41;
 	}
-	if(errors >= retries)return SD_ERROR_CMD0;
-    printf(LPC_UART0,"I have cleared errors");
-	/* Check if the card is not MMC */
-	/* Start its internal initialization process */
-	while(1)
+
+	/* Card Capacity Status in the OCR */
+	if (sd_type == SD_CARD_V2)
 	{
-		SD_SendCommand(CMD55_APP_CMD, SD_arg);
-		if(SD_WaitR1(&rxdata,0,1000)!= SD_OK) return SD_ERROR_CMD55;
+		sd_select();
+		rxdata = sd_command(CMD58_READ_OCR, 0);
+		for (i = 0; i < 4; i++) resp[i] = sd_xchg(0xFF);
+		sd_deselect();
+		if (rxdata != R1_NOERROR)
+		{
+			sd_type = SD_CARD_UNKNOWN;
+			return SD_ERROR_CMD58;
+		}
+		if (resp[0] & 0x40) sd_type = SD_CARD_V2_HC;
+	}
 
-		SD_SendCommand(ACMD41_SEND_OP_COND, SD_arg);
-		SD_WaitR1(&rxdata,0,1000);
-		if (rxdata & R1_IDLE) //in_idle_state = 1
-			for (i = 0; i < 1000; i++); /* wait for a while */
-		else
-			break; //in_idle_state=0 --> ready
+	/* Byte addressed cards may default to another block length */
+	if (sd_type != SD_CARD_V2_HC)
+	{
+		sd_select();
+		rxdata = sd_command(CMD16_SET_BLOCKLEN, SD_BLOCK_SIZE);
+		sd_deselect();
+		if (rxdata != R1_NOERROR)
+		{
+			sd_type = SD_CARD_UNKNOWN;
+			return SD_ERROR_CMD16;
+		}
 	}
-	printf(LPC_UART0,"I have cleared waiting");
+
 	/* Enable CRC */
-	SD_arg[3] = 0x01;
-	SD_SendCommand(CMD59_CRC_ON_OFF, SD_arg);
-	if(SD_WaitR1(&rxdata,0,1000)!= SD_OK) return SD_ERROR_CMD59;
-	if(rxdata != R1_NOERROR) return SD_ERROR_CMD59;
+	sd_select();
+	rxdata = sd_command(CMD59_CRC_ON_OFF, 1);
+	sd_deselect();
+	if (rxdata != R1_NOERROR)
+	{
+		sd_type = SD_CARD_UNKNOWN;
+		return SD_ERROR_CMD59;
+	}
+
+	/* Data transfer clock, the SPI divider is at least 8 so run PCLK at CCLK */
+	CLKPWR_SetPCLKDiv(CLKPWR_PCLKSEL_SPI, CLKPWR_PCLKSEL_CCLK_DIV_1);
+	SPIBUS_SetClock(&sd_dev, SD_SPI_FAST_CLOCK);
 
 	return SD_OK;
 }
 
 
+/*********************************************************************//**
+ * @brief		Get the type of the card found by SD_Init()
+ * @param[in]	none
+ * @return 		SD_CARD_UNKNOWN if no card has been initialised
+ **********************************************************************/
+sd_card_type SD_GetCardType (void)
+{
+	return sd_type;
+}
+
+
+/*********************************************************************//**
+ * @brief		Read one block
+ * @param[in]	- block: block number
+ * 				- buffer: SD_BLOCK_SIZE bytes
+ * @return 		SD_OK or error code
+ **********************************************************************/
+sd_error SD_ReadBlock (uint32_t block, uint8_t *buffer)
+{
+	return SD_ReadBlocks(block, buffer, 1);
+}
+
+
+/*********************************************************************//**
+ * @brief		Read consecutive blocks
+ * @param[in]	- block: first block number
+ * 				- buffer: count * SD_BLOCK_SIZE bytes
+ * 				- count: number of blocks
+ * @return 		SD_OK, SD_NG if the card refused the command, or the
+ * 				error of the first bad block (SD_ERROR_CRC etc.)
+ *
+ * Note: a single block uses CMD17, several blocks stream with CMD18 and
+ * CMD12, CS stays asserted for the whole transfer.
+ **********************************************************************/
+sd_error SD_ReadBlocks (uint32_t block, uint8_t *buffer, uint32_t count)
+{
+	sd_error ret;
+
+	if ((buffer == NULL) || (count == 0)) return SD_CMD_BAD_PARAMETER;
+	if (sd_type == SD_CARD_UNKNOWN) return SD_NG;
+
+	sd_select();
+	if (count == 1)
+	{
+		if (sd_command(CMD17_READ_SINGLE_BLOCK, sd_block_addr(block)) != R1_NOERROR) ret = SD_NG;
+		else ret = sd_read_data(buffer);
+	}
+	else
+	{
+		if (sd_command(CMD18_READ_MULTIPLE_BLOCK, sd_block_addr(block)) != R1_NOERROR) ret = SD_NG;
+		else
+		{
+			do
+			{
+				ret = sd_read_data(buffer);
+				buffer += SD_BLOCK_SIZE;
+			} while ((ret == SD_OK) && --count);
+
+			/* Stop the stream, R1b */
+			sd_command(CMD12_STOP_TRANSMISSION, 0);
+			if (!sd_wait_ready(SD_READ_TIMEOUT_MS) && (ret == SD_OK)) ret = SD_ERROR_TIMEOUT;
+		}
+	}
+	sd_deselect();
+	return ret;
+}
+
+
+/*********************************************************************//**
+ * @brief		Write one block
+ * @param[in]	- block: block number
+ * 				- buffer: SD_BLOCK_SIZE bytes
+ * @return 		SD_OK or error code
+ **********************************************************************/
+sd_error SD_WriteBlock (uint32_t block, const uint8_t *buffer)
+{
+	return SD_WriteBlocks(block, buffer, 1);
+}
+
+
+/*********************************************************************//**
+ * @brief		Write consecutive blocks
+ * @param[in]	- block: first block number
+ * 				- buffer: count * SD_BLOCK_SIZE bytes
+ * 				- count: number of blocks
+ * @return 		SD_OK, SD_NG if the card refused the command, SD_ERROR_CRC
+ * 				or SD_ERROR_WRITE if a block was rejected, SD_ERROR_TIMEOUT
+ *
+ * Note: several blocks are streamed with CMD25 after an ACMD23 pre-erase
+ * hint. The function returns as soon as the last block is accepted, the
+ * card finishes programming on its own: see SD_IsBusy() and SD_Sync().
+ **********************************************************************/
+sd_error SD_WriteBlocks (uint32_t block, const uint8_t *buffer, uint32_t count)
+{
+	sd_error ret;
+	Bool accepted = FALSE;
+
+	if ((buffer == NULL) || (count == 0)) return SD_CMD_BAD_PARAMETER;
+	if (sd_type == SD_CARD_UNKNOWN) return SD_NG;
+
+	sd_select();
+	if (count == 1)
+	{
+		if (sd_command(CMD24_WRITE_BLOCK, sd_block_addr(block)) != R1_NOERROR) ret = SD_NG;
+		else
+		{
+			ret = sd_write_data(buffer, SD_TOKEN_START_BLOCK);
+			accepted = (ret == SD_OK) ? TRUE : FALSE;
+		}
+	}
+	else
+	{
+		/* Pre-erase hint, failure only costs speed */
+		if (sd_command(CMD55_APP_CMD, 0) == R1_NOERROR)
+		{
+			sd_command(ACMD23_SET_WR_BLK_ERASE_COUNT, count);
+		}
+
+		if (sd_command(CMD25_WRITE_MULTIPLE_BLOCK, sd_block_addr(block)) != R1_NOERROR) ret = SD_NG;
+		else
+		{
+			do
+			{
+				ret = sd_write_data(buffer, SD_TOKEN_START_MULTI);
+				buffer += SD_BLOCK_SIZE;
+				/* Card must be ready before the next token */
+				if (!sd_wait_ready(SD_WRITE_TIMEOUT_MS) && (ret == SD_OK)) ret = SD_ERROR_TIMEOUT;
+			} while ((ret == SD_OK) && --count);
+
+			/* The stop token starts a busy period even if no block was taken */
+			sd_xchg(SD_TOKEN_STOP_TRAN);
+			sd_xchg(0xFF);
+			accepted = TRUE;
+		}
+	}
+	/* Programming busy is drained by the next command, only once the
+	 * card took a block or a stop token: a rejected command leaves it idle */
+	if (accepted) sd_busy = TRUE;
+	sd_deselect();
+	return ret;
+}
+
+
+/*********************************************************************//**
+ * @brief		Check without blocking whether a write is still programming
+ * @param[in]	none
+ * @return 		TRUE while the card signals busy
+ **********************************************************************/
+Bool SD_IsBusy (void)
+{
+	if (sd_busy)
+	{
+		sd_select();
+		if (sd_xchg(0xFF) == 0xFF) sd_busy = FALSE;
+		sd_deselect();
+	}
+	return sd_busy;
+}
+
+
+/*********************************************************************//**
+ * @brief		Wait until the last write has been programmed
+ * @param[in]	none
+ * @return 		SD_OK or SD_ERROR_TIMEOUT
+ **********************************************************************/
+sd_error SD_Sync (void)
+{
+	sd_error ret = SD_OK;
+
+	if (sd_busy)
+	{
+		sd_select();
+		if (sd_wait_ready(SD_WRITE_TIMEOUT_MS)) sd_busy = FALSE;
+		else ret = SD_ERROR_TIMEOUT;
+		sd_deselect();
+	}
+	return ret;
+}
+
+
 /*********************************************************************//**
  * @brief		Get SD card's CID register
  * @param[in]	none
@@ -346,6 +753,26 @@ void SD_ErrorMsg (sd_error sd_status)
 		printf(LPC_UART0,"Fail CMD59\n\r");
 		break;
 
+	case SD_ERROR_CMD8:
+		printf(LPC_UART0,"Fail CMD8\n\r");
+		break;
+
+	case SD_ERROR_CMD16:
+		printf(LPC_UART0,"Fail CMD16\n\r");
+		break;
+
+	case SD_ERROR_CMD58:
+		printf(LPC_UART0,"Fail CMD58\n\r");
+		break;
+
+	case SD_ERROR_CRC:
+		printf(LPC_UART0,"Fail...CRC error.\n\r");
+		break;
+
+	case SD_ERROR_WRITE:
+		printf(LPC_UART0,"Fail...Write rejected.\n\r");
+		break;
+
 	case SD_ERROR_BUS_NOT_IDLE:
 		printf(LPC_UART0,"Fail...Device is not in idle state.\n\r");
 		break;
@@ -26,6 +26,21 @@ const char *status_reg[4]={"   STATUS REGISTER:\r\n\n",
                            "WPEN X    X    X   --  BP1  BP0  WEL  WIP",
 };
 
+/** E2PROM on SSP0 (CS P0.16) and on SSP1 (CS P0.6), mode 0, 8 bit frames */
+static SPIBUS_DEVICE_Type eep_dev[2] = {
+	{SPIBUS_SSP0, 0, _BIT(16), SPIBUS_MODE0, 8, EEP_MAX_CLOCK},
+	{SPIBUS_SSP1, 0, _BIT(6),  SPIBUS_MODE0, 8, EEP_MAX_CLOCK},
+};
+
+/** 25AA160A: 2K x 8, 16 byte pages, 5 ms write cycle */
+static E2P_DEVICE_Type e2p_dev[2] = {
+	{NULL, &eep_dev[0], 0, 2, 16, 2048, 5},
+	{NULL, &eep_dev[1], 0, 2, 16, 2048, 5},
+};
+
+#define EEP_DEV(SSPx)	(&eep_dev[((SSPx) == LPC_SSP0) ? 0 : 1])
+#define E2P_DEV(SSPx)	(&e2p_dev[((SSPx) == LPC_SSP0) ? 0 : 1])
+
 
 void print_status_reg(void)
 {
@@ -57,7 +72,7 @@ uint8_t Ssp_Eeprom_Read_Status_Reg (LPC_SSP_TypeDef *SSPx)
 	SSP_DATA_SETUP_Type xferConfig;
 
 	Tx_Buf1[0] = EEP_RDSR;                      /* Read Status 8bit msb    */
-	CS_Force1 (SSPx, DISABLE);                        /* Select device           */
+	SPIBUS_Select(EEP_DEV(SSPx));                     /* Select device           */
 
 	xferConfig.tx_data = Tx_Buf1;               /* Send Instruction Byte    */
 	xferConfig.rx_data = Rx_Buf1;               /* Store byte in Rx_Buf[0]  */
@@ -68,7 +83,7 @@ uint8_t Ssp_Eeprom_Read_Status_Reg (LPC_SSP_TypeDef *SSPx)
 
 	if(Rx_Buf1[0])
 	{
-		CS_Force1 (SSPx, ENABLE);                     /* Select device           */
+		SPIBUS_Release(EEP_DEV(SSPx));                /* Select device           */
 		return(Rx_Buf1[0]);                    /* Return value            */
 	}
 	else
@@ -125,23 +140,23 @@ uchar Ssp_Eeprom_Write_Status_Reg (LPC_SSP_TypeDef *SSPx, uint8_t status_reg)
 
 	WriteData[0] = EEP_WREN;
 
-	CS_Force1 (SSPx, DISABLE);                            /* Select device           */
+	SPIBUS_Select(EEP_DEV(SSPx));                         /* Select device           */
 
 	xferConfig.tx_data = WriteData;            /* Send Instruction Byte    */
 	xferConfig.rx_data = Rx_Buf1;               /* Store byte in Rx_Buf[0]  */
 	xferConfig.length = 1;
 	SSP_ReadWrite(SSPx, &xferConfig, SSP_TRANSFER_POLLING);  /* Write Enable Latch      */
-	CS_Force1 (SSPx, ENABLE);                          /* CS high inactive        */
+	SPIBUS_Release(EEP_DEV(SSPx));                     /* CS high inactive        */
 
-	CS_Force1 (SSPx, DISABLE);                            /* Select device           */
+	SPIBUS_Select(EEP_DEV(SSPx));                         /* Select device           */
 	xferConfig.tx_data = Tx_Buf1;               /* Send Instruction Byte    */
 	xferConfig.length = 2;
 	WriteStatus = SSP_ReadWrite(SSPx, &xferConfig, SSP_TRANSFER_POLLING);
 
 	if(WriteStatus)
 	{
-		CS_Force1 (SSPx, ENABLE);                          /* CS high inactive        */
-		delay_ms(4);
+		SPIBUS_Release(EEP_DEV(SSPx));                     /* CS high inactive        */
+		E2P_WaitReady(E2P_DEV(SSPx));                      /* WIP polling             */
 		return(1);
 	}
 	else
@@ -160,32 +175,9 @@ uchar Ssp_Eeprom_Write_Status_Reg (LPC_SSP_TypeDef *SSPx, uint8_t status_reg)
  **********************************************************************/
 uchar Ssp_Eeprom_Write_Byte (LPC_SSP_TypeDef *SSPx, uint16 eep_address, uint8_t byte_data)
 {
-	SSP_DATA_SETUP_Type xferConfig;
-	uint8_t WriteData[1],WriteStatus =0;
-
-	Tx_Buf1[0] = EEP_WRITE;                  /* WRITE IR 8bit msb       */
-	Tx_Buf1[1] = (uchar)(eep_address>>8);    // 1st byte extract
-	Tx_Buf1[2] = (uchar) eep_address;        // 2nd byte extract
-	Tx_Buf1[3] = byte_data;                  /* byte data lsb           */
-
-	WriteData[0] = EEP_WREN;
-
-	CS_Force1 (SSPx, DISABLE);
-	xferConfig.tx_data = WriteData;            /* Send Instruction Byte    */
-	xferConfig.rx_data = Rx_Buf1;               /* Store byte in Rx_Buf[0]  */
-	xferConfig.length = 1;
-	SSP_ReadWrite(SSPx, &xferConfig, SSP_TRANSFER_POLLING);  /* Write Enable Latch      */
-	CS_Force1 (SSPx, ENABLE);
-
-	CS_Force1 (SSPx, DISABLE);                              /* CS low active           */
-	xferConfig.tx_data = Tx_Buf1;               /* Send Instruction Byte    */
-	xferConfig.length = 4;
-	WriteStatus = SSP_ReadWrite(SSPx, &xferConfig, SSP_TRANSFER_POLLING);
-
-	if(WriteStatus)
+	/* WREN, WRITE and WIP polling are done by the E2PROM engine */
+	if(E2P_Write(E2P_DEV(SSPx), eep_address, &byte_data, 1) == SUCCESS)
 	{
-		CS_Force1 (SSPx, ENABLE);                            /* CS high inactive        */
-		delay_ms(4);
 		return(1);
 	}
 	else
@@ -205,76 +197,13 @@ uchar Ssp_Eeprom_Write_Byte (LPC_SSP_TypeDef *SSPx, uint16 eep_address, uint8_t
  **********************************************************************/
 uchar Ssp_Eeprom_Write (LPC_SSP_TypeDef *SSPx, uint16_t eep_address, uint8_t *data_start, uint8_t length)
 {
-	SSP_DATA_SETUP_Type xferConfig;
-	uint8_t WriteData[1],WriteStatus =0,ip_len,new_length;
-	uint16 new_address;
-
-	WriteData[0] = EEP_WREN;
-
-	Tx_Buf1[0] = EEP_WRITE;                  // WRITE IR 8bit msb
-	Tx_Buf1[1] = (uchar)(eep_address>>8);    // 1st byte extract
-	Tx_Buf1[2] = (uchar)eep_address;         // 2nd byte extract
-
-	/* Intern page length(ip_len) gives length from address that can be occupied in page */
-	ip_len = 0x10 - (eep_address % 0x10);
-	new_address = eep_address + ip_len;
-
-	if(length > ip_len)
+	/* Split at pages, each one starts as soon as WIP clears */
+	if(E2P_Write(E2P_DEV(SSPx), eep_address, data_start, length) == SUCCESS)
 	{
-		new_length = length - ip_len;
-
-		CS_Force1 (SSPx, DISABLE);
-		xferConfig.tx_data = WriteData;            /* Send Instruction Byte    */
-		xferConfig.rx_data = Rx_Buf1;               /* Store byte in Rx_Buf[0]  */
-		xferConfig.length = 1;
-		SSP_ReadWrite(SSPx, &xferConfig, SSP_TRANSFER_POLLING);  /* Write Enable Latch      */
-		CS_Force1 (SSPx, ENABLE);
-
-		CS_Force1 (SSPx, DISABLE);                            // CS low active
-		xferConfig.tx_data = Tx_Buf1;                   /* Send Instruction Byte    */
-		xferConfig.length = 3;
-		SSP_ReadWrite(SSPx, &xferConfig, SSP_TRANSFER_POLLING);
-
-		xferConfig.tx_data = data_start;               // Pass value
-		xferConfig.length = ip_len;
-		WriteStatus = SSP_ReadWrite(SSPx, &xferConfig, SSP_TRANSFER_POLLING);
-
-		if(WriteStatus)
-		{
-			CS_Force1 (SSPx, ENABLE);                            /* CS high inactive        */
-		}
-		else
-			return(0);
-		// Recursive function
-		delay_ms(4);
-		Ssp_Eeprom_Write(SSPx, new_address,(data_start + ip_len),new_length);
-	}
-
-	if(length <= ip_len+1)
-	{
-		CS_Force1 (SSPx, DISABLE);
-		xferConfig.tx_data = WriteData;            /* Send Instruction Byte    */
-		xferConfig.rx_data = Rx_Buf1;               /* Store byte in Rx_Buf[0]  */
-		xferConfig.length = 1;
-		SSP_ReadWrite(SSPx, &xferConfig, SSP_TRANSFER_POLLING);  /* Write Enable Latch      */
-		CS_Force1 (SSPx, ENABLE);
-
-		CS_Force1 (SSPx, DISABLE);                            // CS low
-		xferConfig.tx_data = Tx_Buf1;                   /* Send Instruction Byte    */
-		xferConfig.length = 3;
-		SSP_ReadWrite(SSPx, &xferConfig, SSP_TRANSFER_POLLING);
-
-		xferConfig.tx_data = data_start;               // Pass value
-		xferConfig.length = length;
-		WriteStatus = SSP_ReadWrite(SSPx, &xferConfig, SSP_TRANSFER_POLLING);
-		if(WriteStatus)
-		{
-			CS_Force1 (SSPx, ENABLE);                            /* CS high inactive        */
-		}
-		else
-			return(0);
+		return(1);
 	}
-	return(1);
+	else
+		return(0);
 }
 
 
@@ -288,26 +217,11 @@ uchar Ssp_Eeprom_Write (LPC_SSP_TypeDef *SSPx, uint16_t eep_address, uint8_t *da
  **********************************************************************/
 uint8_t Ssp_Eeprom_Read_Byte (LPC_SSP_TypeDef *SSPx, uint16 eep_address)
 {
-	SSP_DATA_SETUP_Type xferConfig;
-
-	Tx_Buf1[0] = EEP_READ;                 /* READ IR 8bit msb        */
-	Tx_Buf1[1] = (uchar)(eep_address>>8);  // 1st byte extract
-	Tx_Buf1[2] = (uchar)eep_address;       // 2nd byte extract
-
-	CS_Force1 (SSPx, DISABLE);
-	xferConfig.tx_data = Tx_Buf1;               /* Send Instruction Byte    */
-	xferConfig.rx_data = Rx_Buf1;               /* Store byte in Rx_Buf[0]  */
-	xferConfig.length = 3;
-	SSP_ReadWrite(SSPx, &xferConfig, SSP_TRANSFER_POLLING);
-	xferConfig.tx_data = NULL;
-	xferConfig.rx_data = Rx_Buf1;               /* Store byte in Rx_Buf[0]  */
-	xferConfig.length = 1;
-	SSP_ReadWrite(SSPx, &xferConfig, SSP_TRANSFER_POLLING);
+	uint8_t dat;
 
-	if(Rx_Buf1[0])
+	if(E2P_Read(E2P_DEV(SSPx), eep_address, &dat, 1) == SUCCESS)
 	{
-		CS_Force1 (SSPx, ENABLE);
-		return(Rx_Buf1[0]);                    /* Return value            */
+		return(dat);                          /* Return value            */
 	}
 	else
 		return(0);
@@ -326,27 +240,9 @@ uint8_t Ssp_Eeprom_Read_Byte (LPC_SSP_TypeDef *SSPx, uint16 eep_address)
  **********************************************************************/
 uchar Ssp_Eeprom_Read (LPC_SSP_TypeDef *SSPx, uint16_t eep_address, uint8_t *dest_addr, uint8_t length)
 {
-	SSP_DATA_SETUP_Type xferConfig;
-	uchar ReadStatus =0;
-
-	Tx_Buf1[0] = EEP_READ;                      // READ IR 8bit msb
-	Tx_Buf1[1] = (uchar)(eep_address>>8);       // 1st byte extract
-	Tx_Buf1[2] = (uchar)eep_address;            // 2nd byte extract
-
-	CS_Force1 (SSPx, DISABLE);
-	xferConfig.tx_data = Tx_Buf1;               /* Send Instruction Byte    */
-	xferConfig.rx_data = Rx_Buf1;               /* Store byte in Rx_Buf[0]  */
-	xferConfig.length = 3;
-	SSP_ReadWrite(SSPx, &xferConfig, SSP_TRANSFER_POLLING);
-	xferConfig.tx_data = NULL;
-	xferConfig.rx_data = dest_addr;               /* Store byte  */
-	xferConfig.length = length;
-	ReadStatus = SSP_ReadWrite(SSPx, &xferConfig, SSP_TRANSFER_POLLING);
-
-	if(ReadStatus)
+	/* One sequential read of any length */
+	if(E2P_Read(E2P_DEV(SSPx), eep_address, dest_addr, length) == SUCCESS)
 	{
-		CS_Force1 (SSPx, ENABLE);
-		delay_ms(4);
 		return(1);                                // Return value
 	}
 	else
@@ -418,6 +314,16 @@ void Display_Eeprom_Loc (LPC_SSP_TypeDef *SSPx, uint16 mem_start_address, uint16
 }
 
 
+/*********************************************************************//**
+ * @brief		Serial E2PROM descriptor of the 25AA160A, for users of
+ * 				the lpc_eeprom engine such as the key/value store
+ * @param[in]	SSPx: LPC_SSP0 or LPC_SSP1
+ * @return 		E2PROM part
+ **********************************************************************/
+E2P_DEVICE_Type *Ssp_Eeprom_Device (LPC_SSP_TypeDef *SSPx)
+{
+	return E2P_DEV(SSPx);
+}
 
 
 /**
@@ -28,6 +28,51 @@
 
 /******************************************************************************/
 static volatile uint16_t TextColor = Black, BackColor = White;
+static uchar keybd = KEY1;                // on-screen keyboard shown by GLCD_Getche()
+
+/* SSD2119 on SSP1, CS on P0.6: 8 bit frames for commands and register
+   data, 16 bit frames (one per pixel) for pixel streams */
+static SPIBUS_DEVICE_Type GLCD_Dev = {SPIBUS_SSP1, 0, _BIT(6), SPIBUS_MODE0, 8, GLCD_MAX_CLOCK};
+static SPIBUS_DEVICE_Type GLCD_PixDev = {SPIBUS_SSP1, 0, _BIT(6), SPIBUS_MODE0, 16, GLCD_MAX_CLOCK};
+
+#ifdef GLCD_COMP_MODE
+/* Dirty rectangle compositor: tile pool, coverage masks and screen map */
+typedef struct
+{
+	uint16_t x0, y0, x1, y1;
+} GLCD_RECT_Type;
+
+static Bool GLCD_CompOn = FALSE;
+static uint8_t GLCD_TileUsed = 0;
+static int8_t GLCD_TileMap[GLCD_TILES_Y][GLCD_TILES_X];
+static uint16_t GLCD_TilePix[GLCD_TILE_POOL][GLCD_TILE_SIZE*GLCD_TILE_SIZE];
+static uint32_t GLCD_TileMask[GLCD_TILE_POOL][GLCD_TILE_SIZE];
+static GLCD_RECT_Type GLCD_TileDirty[GLCD_TILE_POOL];   // screen coordinates
+static uint8_t GLCD_TileX[GLCD_TILE_POOL], GLCD_TileY[GLCD_TILE_POOL];
+#else
+#define GLCD_CompOn		FALSE
+#endif
+
+#ifdef GLCD_GLYPH_CACHE_MODE
+/* Font_24x16 glyphs expanded to RGB565 for a text/back color pair */
+typedef struct
+{
+	uchar    Char;          // 0: free slot
+	uint16_t Text, Back;
+	uint32_t Stamp;         // string serial of the last use
+} GLCD_GLYPH_Type;
+
+static GLCD_GLYPH_Type GLCD_GlyphTag[GLCD_GLYPH_SLOTS];
+static uint16_t GLCD_GlyphPix[GLCD_GLYPH_SLOTS][CHAR_H*CHAR_W];
+static uint32_t GLCD_GlyphSerial = 0;
+#endif
+
+#ifdef GLCD_DMA_MODE
+/* Pixel stream DMA chain, one full screen at most per start */
+static GPDMA_LLI_Type GLCD_DMA_LLI[GLCD_DMA_NUM_LLI];
+static uint16_t GLCD_DMA_Color;
+static __IO Bool GLCD_DMA_Done;
+#endif
 
 // Swap two bytes
 #define SWAP(x,y) do { (x)=(x)^(y); (y)=(x)^(y); (x)=(x)^(y); } while(0)
@@ -269,6 +314,13 @@ void GLCD_Init (void)
 
 	delay_ms(5);
 
+#ifdef GLCD_DMA_MODE
+	if (!(LPC_SC->PCONP & CLKPWR_PCONP_PCGPDMA))
+	{
+		GPDMA_Init();            // DMA controller for pixel streaming
+	}
+#endif
+
 	Write_Command_Glcd(0x22);    // RAM data write/read
 }
 
@@ -281,6 +333,14 @@ void GLCD_Init (void)
  **********************************************************************/
 void GLCD_PutPixel (uint16_t x, uint16_t y, uint16_t color)
 {
+#ifdef GLCD_COMP_MODE
+	if (GLCD_CompOn)
+	{
+		GLCD_Comp_Pixel(x, y, color);
+		return;
+	}
+#endif
+
 	Write_Command_Glcd(0x4E);     /* GDDRAM Horizontal */
 	Write_Data_Glcd(x);
 
@@ -321,7 +381,7 @@ void GLCD_SetBackColor (uint16_t color)
  **********************************************************************/
 static __INLINE void wr_dat_start (void)
 {
-	CS_Force1 (LPC_SSP1, DISABLE);
+	SPIBUS_Select(&GLCD_Dev);
 	GPIO_SetValue(2, LCD_RS);  // select data mode
 }
 
@@ -333,7 +393,7 @@ static __INLINE void wr_dat_start (void)
  **********************************************************************/
 static __INLINE void wr_dat_stop (void)
 {
-	CS_Force1 (LPC_SSP1, ENABLE);
+	SPIBUS_Release(&GLCD_Dev);
 }
 
 
@@ -356,6 +416,447 @@ static __INLINE void wr_dat_only (uint16_t c)
 }
 
 
+#ifdef GLCD_DMA_MODE
+/*********************************************************************//**
+ * @brief	    GPDMA completion callback of the pixel stream channel
+ * @param[in]	ChannelNum   DMA channel
+ *              Status       GPDMA_CB_DONE or GPDMA_CB_ERROR
+ * @return 		None
+ **********************************************************************/
+static void GLCD_DMA_Callback (uint32_t ChannelNum, uint32_t Status)
+{
+	GLCD_DMA_Done = TRUE;
+}
+
+
+/*********************************************************************//**
+ * @brief	    Push a pixel run into SSP1 TX FIFO through GPDMA
+ * @param[in]	src      first pixel
+ *              count    number of pixels
+ *              inc      TRUE: src is a buffer, FALSE: repeat *src
+ * @return 		FALSE if no DMA channel is free, nothing was sent
+ **********************************************************************/
+static Bool GLCD_Stream_DMA (const uint16_t *src, uint32_t count, Bool inc)
+{
+	GPDMA_Channel_CFG_Type cfg;
+	uint32_t ctrl, run;
+	int32_t ch;
+
+	ch = GPDMA_ChannelAlloc(GPDMA_PRIO_LOW);
+	if (ch < 0)
+	{
+		return FALSE;
+	}
+
+	// Halfword frames into SSP1 data register
+	ctrl = GPDMA_MakeControl(GPDMA_TRANSFERTYPE_M2P, 0, GPDMA_CONN_SSP1_Tx, 0);
+	ctrl &= ~(GPDMA_DMACCxControl_SWidth(0x07) | GPDMA_DMACCxControl_DWidth(0x07));
+	ctrl |= GPDMA_DMACCxControl_SWidth(GPDMA_WIDTH_HALFWORD) \
+			| GPDMA_DMACCxControl_DWidth(GPDMA_WIDTH_HALFWORD);
+	if (!inc)
+	{
+		ctrl &= ~GPDMA_DMACCxControl_SI;
+	}
+
+	cfg.ChannelNum = ch;
+	cfg.TransferType = GPDMA_TRANSFERTYPE_M2P;
+	cfg.SrcConn = 0;
+	cfg.DstConn = GPDMA_CONN_SSP1_Tx;
+	GPDMA_SetCallback(ch, GLCD_DMA_Callback);
+	SSP_DMACmd(LPC_SSP1, SSP_DMA_TX, ENABLE);
+
+	while (count)
+	{
+		run = MIN(count, GLCD_DMA_NUM_LLI * GPDMA_MAX_XFER_SIZE);
+		GPDMA_BuildLLI(GLCD_DMA_LLI, GLCD_DMA_NUM_LLI, (uint32_t)src,
+						GPDMA_GetPeriphAddr(GPDMA_CONN_SSP1_Tx), run, ctrl);
+		GLCD_DMA_Done = FALSE;
+		GPDMA_SetupLLI(&cfg, GLCD_DMA_LLI);
+		GPDMA_ChannelCmd(ch, ENABLE);
+		while (!GLCD_DMA_Done);
+
+		if (inc)
+		{
+			src += run;
+		}
+		count -= run;
+	}
+
+	SSP_DMACmd(LPC_SSP1, SSP_DMA_TX, DISABLE);
+	GPDMA_ChannelFree(ch);
+	return TRUE;
+}
+#endif
+
+
+/*********************************************************************//**
+ * @brief	    Open a pixel stream on a window: set window and cursor,
+ *              select SSP1 16-bit frames and keep CS asserted until
+ *              GLCD_Stream_Stop()
+ * @param[in]	x        horizontal position
+ *              y        vertical position
+ *              w        width of window
+ *              h        height of window
+ * @return 		None
+ **********************************************************************/
+void GLCD_Stream_Start (uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+	GLCD_Set_Loc (x,y,w,h);
+
+	// One SSP frame per pixel for the whole window
+	SPIBUS_Select(&GLCD_PixDev);
+	GPIO_SetValue(2, LCD_RS);  // select data mode
+}
+
+
+/*********************************************************************//**
+ * @brief	    Stream a run of one colour, TX FIFO is kept full
+ * @param[in]	color    pixel color
+ *              count    number of pixels
+ * @return 		None
+ **********************************************************************/
+void GLCD_Stream_Fill (uint16_t color, uint32_t count)
+{
+#ifdef GLCD_DMA_MODE
+	GLCD_DMA_Color = color;
+	if ((count > 64) && GLCD_Stream_DMA(&GLCD_DMA_Color, count, FALSE))
+	{
+		return;
+	}
+#endif
+	while (count--)
+	{
+		while (!(LPC_SSP1->SR & SSP_SR_TNF));
+		LPC_SSP1->DR = color;
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief	    Stream a caller's RGB565 buffer, TX FIFO is kept full
+ * @param[in]	pixels   pixel buffer (halfword aligned)
+ *              count    number of pixels
+ * @return 		None
+ **********************************************************************/
+void GLCD_Stream_Pixels (const uint16_t *pixels, uint32_t count)
+{
+#ifdef GLCD_DMA_MODE
+	if ((count > 64) && GLCD_Stream_DMA(pixels, count, TRUE))
+	{
+		return;
+	}
+#endif
+	while (count--)
+	{
+		while (!(LPC_SSP1->SR & SSP_SR_TNF));
+		LPC_SSP1->DR = *pixels++;
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief	    Close a pixel stream: wait for the last frame, discard
+ *              received frames and release CS, the next command
+ *              selects 8-bit frames again
+ * @param[in]	None
+ * @return 		None
+ **********************************************************************/
+void GLCD_Stream_Stop (void)
+{
+	while (!(LPC_SSP1->SR & SSP_SR_TFE));
+	while (LPC_SSP1->SR & SSP_SR_BSY);
+
+	// RX FIFO overflowed while streaming, nothing in it is needed
+	while (LPC_SSP1->SR & SSP_SR_RNE)
+	{
+		(void)LPC_SSP1->DR;
+	}
+	LPC_SSP1->ICR = SSP_ICR_ROR;
+
+	SPIBUS_Release(&GLCD_PixDev);
+}
+
+
+#ifdef GLCD_COMP_MODE
+/*********************************************************************//**
+ * @brief	    Get the cache tile holding a screen tile, a tile is taken
+ *              from the pool on first use. When the pool is exhausted all
+ *              pending drawing is flushed to the panel first.
+ * @param[in]	tx       tile column
+ *              ty       tile row
+ * @return 		Pool index of the tile
+ **********************************************************************/
+static uint8_t GLCD_Comp_Tile (uint8_t tx, uint8_t ty)
+{
+	int8_t t;
+	uint8_t i;
+
+	t = GLCD_TileMap[ty][tx];
+	if (t >= 0)
+	{
+		return (uint8_t)t;
+	}
+
+	if (GLCD_TileUsed == GLCD_TILE_POOL)
+	{
+		GLCD_Comp_Flush();
+	}
+
+	t = GLCD_TileUsed++;
+	GLCD_TileMap[ty][tx] = t;
+	GLCD_TileX[t] = tx;
+	GLCD_TileY[t] = ty;
+	for (i = 0; i < GLCD_TILE_SIZE; i++)
+	{
+		GLCD_TileMask[t][i] = 0;
+	}
+	GLCD_TileDirty[t].x0 = WIDTH;
+	GLCD_TileDirty[t].y0 = HEIGHT;
+	GLCD_TileDirty[t].x1 = 0;
+	GLCD_TileDirty[t].y1 = 0;
+	return (uint8_t)t;
+}
+
+
+/*********************************************************************//**
+ * @brief	    Draw a horizontal span into one cache tile
+ * @param[in]	x        horizontal position (within the tile)
+ *              y        vertical position
+ *              w        span width, must not cross the tile edge
+ *              color    span color
+ * @return 		None
+ **********************************************************************/
+static void GLCD_Comp_Span (uint16_t x, uint16_t y, uint16_t w, uint16_t color)
+{
+	uint8_t t;
+	uint16_t *pix;
+	uint32_t lx, ly, mask;
+	GLCD_RECT_Type *d;
+
+	t = GLCD_Comp_Tile(x/GLCD_TILE_SIZE, y/GLCD_TILE_SIZE);
+	lx = x % GLCD_TILE_SIZE;
+	ly = y % GLCD_TILE_SIZE;
+
+	pix = &GLCD_TilePix[t][ly*GLCD_TILE_SIZE + lx];
+	mask = (w >= 32) ? 0xFFFFFFFF : (((1UL << w) - 1) << lx);
+	GLCD_TileMask[t][ly] |= mask;
+	for (lx = 0; lx < w; lx++)
+	{
+		*pix++ = color;
+	}
+
+	d = &GLCD_TileDirty[t];
+	if (x < d->x0) d->x0 = x;
+	if (y < d->y0) d->y0 = y;
+	if (x + w - 1 > d->x1) d->x1 = x + w - 1;
+	if (y > d->y1) d->y1 = y;
+}
+
+
+/*********************************************************************//**
+ * @brief	    Stream one rectangle of cached pixels, every pixel of the
+ *              rectangle must be covered
+ * @param[in]	r        rectangle in screen coordinates
+ * @return 		None
+ **********************************************************************/
+static void GLCD_Comp_Burst (GLCD_RECT_Type *r)
+{
+	uint16_t x, y, run;
+	uint8_t t;
+
+	GLCD_Stream_Start(r->x0, r->y0, r->x1 - r->x0 + 1, r->y1 - r->y0 + 1);
+	for (y = r->y0; y <= r->y1; y++)
+	{
+		for (x = r->x0; x <= r->x1; x += run)
+		{
+			t = GLCD_TileMap[y/GLCD_TILE_SIZE][x/GLCD_TILE_SIZE];
+			run = MIN(r->x1 + 1, (x/GLCD_TILE_SIZE + 1)*GLCD_TILE_SIZE) - x;
+			GLCD_Stream_Pixels(&GLCD_TilePix[t][(y%GLCD_TILE_SIZE)*GLCD_TILE_SIZE + x%GLCD_TILE_SIZE], run);
+		}
+	}
+	GLCD_Stream_Stop();
+}
+
+
+/*********************************************************************//**
+ * @brief	    Enable/Disable the dirty rectangle compositor. While
+ *              enabled every drawing primitive draws into the tile cache
+ *              and nothing reaches the panel until GLCD_Comp_Flush().
+ * @param[in]	NewState	ENABLE/DISABLE, DISABLE flushes pending drawing
+ * @return 		None
+ **********************************************************************/
+void GLCD_Comp_Cmd (FunctionalState NewState)
+{
+	uint32_t i;
+
+	if (NewState && !GLCD_CompOn)
+	{
+		for (i = 0; i < GLCD_TILES_X*GLCD_TILES_Y; i++)
+		{
+			GLCD_TileMap[0][i] = -1;
+		}
+		GLCD_TileUsed = 0;
+		GLCD_CompOn = TRUE;
+	}
+	else if (!NewState && GLCD_CompOn)
+	{
+		GLCD_Comp_Flush();
+		GLCD_CompOn = FALSE;
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief	    Draw a pixel into the tile cache
+ * @param[in]	x        horizontal position
+ *              y        vertical position
+ *              color    pixel color
+ * @return 		None
+ **********************************************************************/
+void GLCD_Comp_Pixel (uint16_t x, uint16_t y, uint16_t color)
+{
+	if ((x < WIDTH) && (y < HEIGHT))
+	{
+		GLCD_Comp_Span(x, y, 1, color);
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief	    Fill a window in the tile cache, clipped to the screen
+ * @param[in]	x        horizontal position
+ *              y        vertical position
+ *              w        width of window
+ *              h        height of window
+ *              color    window color
+ * @return 		None
+ **********************************************************************/
+void GLCD_Comp_Fill (uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color)
+{
+	uint16_t xe, ye, cx, run;
+
+	if ((x >= WIDTH) || (y >= HEIGHT))
+	{
+		return;
+	}
+	xe = MIN(x + w, WIDTH);
+	ye = MIN(y + h, HEIGHT);
+
+	for (; y < ye; y++)
+	{
+		for (cx = x; cx < xe; cx += run)
+		{
+			run = MIN(xe, (cx/GLCD_TILE_SIZE + 1)*GLCD_TILE_SIZE) - cx;
+			GLCD_Comp_Span(cx, y, run, color);
+		}
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief	    Write all pending drawing to the panel and release the
+ *              tile cache. Fully covered dirty rectangles of abutting
+ *              tiles are merged so that each is sent as one window burst,
+ *              partly covered tiles are sent as one burst per row run.
+ * @param[in]	None
+ * @return 		None
+ **********************************************************************/
+void GLCD_Comp_Flush (void)
+{
+	GLCD_RECT_Type rect[GLCD_TILE_POOL], row;
+	uint32_t span, bits;
+	uint8_t t, i, j, n = 0, ly, lx;
+	Bool full, merged;
+	GLCD_RECT_Type *d;
+
+	for (t = 0; t < GLCD_TileUsed; t++)
+	{
+		d = &GLCD_TileDirty[t];
+		if (d->x0 > d->x1)
+		{
+			continue;
+		}
+
+		span = (d->x1 - d->x0 == 31) ? 0xFFFFFFFF :
+				(((1UL << (d->x1 - d->x0 + 1)) - 1) << (d->x0 % GLCD_TILE_SIZE));
+		full = TRUE;
+		for (ly = d->y0 % GLCD_TILE_SIZE; ly <= d->y1 % GLCD_TILE_SIZE; ly++)
+		{
+			if ((GLCD_TileMask[t][ly] & span) != span)
+			{
+				full = FALSE;
+				break;
+			}
+		}
+
+		if (full)
+		{
+			rect[n++] = *d;
+			continue;
+		}
+
+		// Partly covered: one burst per run of covered pixels in a row
+		for (ly = d->y0 % GLCD_TILE_SIZE; ly <= d->y1 % GLCD_TILE_SIZE; ly++)
+		{
+			bits = GLCD_TileMask[t][ly];
+			for (lx = 0; lx < GLCD_TILE_SIZE; lx++)
+			{
+				if (!(bits & (1UL << lx)))
+				{
+					continue;
+				}
+				row.x0 = GLCD_TileX[t]*GLCD_TILE_SIZE + lx;
+				while ((lx < GLCD_TILE_SIZE) && (bits & (1UL << lx)))
+				{
+					lx++;
+				}
+				row.x1 = GLCD_TileX[t]*GLCD_TILE_SIZE + lx - 1;
+				row.y0 = row.y1 = GLCD_TileY[t]*GLCD_TILE_SIZE + ly;
+				GLCD_Comp_Burst(&row);
+			}
+		}
+	}
+
+	// Merge rectangles sharing an edge of the same length
+	do
+	{
+		merged = FALSE;
+		for (i = 0; i < n; i++)
+		{
+			for (j = i + 1; j < n; j++)
+			{
+				if (((rect[i].y0 == rect[j].y0) && (rect[i].y1 == rect[j].y1) &&
+					 ((rect[i].x1 + 1 == rect[j].x0) || (rect[j].x1 + 1 == rect[i].x0))) ||
+					((rect[i].x0 == rect[j].x0) && (rect[i].x1 == rect[j].x1) &&
+					 ((rect[i].y1 + 1 == rect[j].y0) || (rect[j].y1 + 1 == rect[i].y0))))
+				{
+					rect[i].x0 = MIN(rect[i].x0, rect[j].x0);
+					rect[i].y0 = MIN(rect[i].y0, rect[j].y0);
+					rect[i].x1 = MAX(rect[i].x1, rect[j].x1);
+					rect[i].y1 = MAX(rect[i].y1, rect[j].y1);
+					rect[j] = rect[--n];
+					merged = TRUE;
+					break;
+				}
+			}
+		}
+	} while (merged);
+
+	for (i = 0; i < n; i++)
+	{
+		GLCD_Comp_Burst(&rect[i]);
+	}
+
+	// Panel now holds every drawn pixel, release the cache
+	for (t = 0; t < GLCD_TileUsed; t++)
+	{
+		GLCD_TileMap[GLCD_TileY[t]][GLCD_TileX[t]] = -1;
+	}
+	GLCD_TileUsed = 0;
+}
+#endif
+
+
 /*********************************************************************//**
  * @brief	    Clear display
  * @param[in]	color    display clearing color
@@ -363,21 +864,20 @@ static __INLINE void wr_dat_only (uint16_t c)
  **********************************************************************/
 void GLCD_Clear (uint16_t color)
 {
-	unsigned int   i;
-
-	GLCD_Window (0,0,320,240);    // Window Max
+#ifdef GLCD_COMP_MODE
+	uint32_t i;
 
-	Write_Command_Glcd(0x4E);     /* GDDRAM Horizontal */
-	Write_Data_Glcd(0);
-
-	Write_Command_Glcd(0x4F);     /* GDDRAM Vertical */
-	Write_Data_Glcd(0);
+	// Pending drawing is overwritten anyway, drop it
+	for (i = 0; i < GLCD_TILES_X*GLCD_TILES_Y; i++)
+	{
+		GLCD_TileMap[0][i] = -1;
+	}
+	GLCD_TileUsed = 0;
+#endif
 
-	Write_Command_Glcd(0x22);
-	wr_dat_start();
-	for(i = 0; i < (WIDTH*HEIGHT); i++)
-		wr_dat_only(color);
-	wr_dat_stop();
+	GLCD_Stream_Start(0,0,WIDTH,HEIGHT);    // Window Max
+	GLCD_Stream_Fill(color, WIDTH*HEIGHT);
+	GLCD_Stream_Stop();
 }
 
 
@@ -394,6 +894,20 @@ void GLCD_Draw_Char (uint16_t x, uint16_t y, uint16_t *c)
 
 	x = x-CHAR_W;
 
+#ifdef GLCD_COMP_MODE
+	if (GLCD_CompOn)
+	{
+		for (j = 0; j < CHAR_H; j++)
+		{
+			for (i = 0; i < CHAR_W; i++)
+			{
+				GLCD_Comp_Pixel(x+i, y+j, (c[j] & (1 << i)) ? TextColor : BackColor);
+			}
+		}
+		return;
+	}
+#endif
+
 	Write_Command_Glcd(0x45);      /* Horizontal GRAM Start Address      */
 	Write_Data_Glcd(x);
 
@@ -434,6 +948,149 @@ void GLCD_Draw_Char (uint16_t x, uint16_t y, uint16_t *c)
 }
 
 
+#ifdef GLCD_GLYPH_CACHE_MODE
+/*********************************************************************//**
+ * @brief	    Find a glyph expanded in the current text and back color,
+ *              the least recently used slot is refilled on a miss. Slots
+ *              used by the string being drawn are never taken.
+ * @param[in]	c        ascii character
+ * @return 		Expanded glyph, NULL when every slot is in use
+ **********************************************************************/
+static const uint16_t *GLCD_Glyph_Get (uchar c)
+{
+	GLCD_GLYPH_Type *g, *lru = NULL;
+	uint16_t *pix, bits;
+	uint8_t i, j;
+
+	for (i = 0; i < GLCD_GLYPH_SLOTS; i++)
+	{
+		g = &GLCD_GlyphTag[i];
+		if ((g->Char == c) && (g->Text == TextColor) && (g->Back == BackColor))
+		{
+			g->Stamp = GLCD_GlyphSerial;
+			return GLCD_GlyphPix[i];
+		}
+		if ((g->Stamp != GLCD_GlyphSerial) || (g->Char == 0))
+		{
+			if ((lru == NULL) || (g->Char == 0) ||
+				((lru->Char != 0) && (g->Stamp < lru->Stamp)))
+			{
+				lru = g;
+			}
+		}
+	}
+
+	if (lru == NULL)
+	{
+		return NULL;
+	}
+
+	lru->Char = c;
+	lru->Text = TextColor;
+	lru->Back = BackColor;
+	lru->Stamp = GLCD_GlyphSerial;
+
+	pix = GLCD_GlyphPix[lru - GLCD_GlyphTag];
+	for (j = 0; j < CHAR_H; j++)
+	{
+		bits = Font_24x16[(c - 32) * CHAR_H + j];
+		for (i = 0; i < CHAR_W; i++)
+		{
+			*pix++ = (bits & (1 << i)) ? TextColor : BackColor;
+		}
+	}
+	return GLCD_GlyphPix[lru - GLCD_GlyphTag];
+}
+#endif
+
+
+/*********************************************************************//**
+ * @brief	    Draw a string of Font_24x16 characters through a single
+ *              window write. Rows are streamed across the whole string,
+ *              blank glyph rows are merged into one background run.
+ * @param[in]	x        horizontal position (right edge of the first
+ *                       character, as GLCD_Draw_Char)
+ *              y        vertical position
+ *              s        pointer to string
+ *              n        number of characters, must fit on the line
+ * @return 		None
+ **********************************************************************/
+void GLCD_Draw_String (uint16_t x, uint16_t y, uchar *s, uint16_t n)
+{
+	uint32_t back, text;
+	uint16_t bits;
+	uint8_t i, j, k;
+#ifdef GLCD_GLYPH_CACHE_MODE
+	const uint16_t *glyph[WIDTH/CHAR_W];
+
+	GLCD_GlyphSerial++;
+	for (i = 0; i < n; i++)
+	{
+		glyph[i] = GLCD_Glyph_Get(s[i]);
+	}
+#endif
+
+	GLCD_Stream_Start(x - CHAR_W, y, n * CHAR_W, CHAR_H);
+	back = 0;
+	for (j = 0; j < CHAR_H; j++)
+	{
+		for (i = 0; i < n; i++)
+		{
+			bits = Font_24x16[(s[i] - 32) * CHAR_H + j];
+			if (bits == 0)
+			{
+				back += CHAR_W;
+				continue;
+			}
+#ifdef GLCD_GLYPH_CACHE_MODE
+			if (glyph[i] != NULL)
+			{
+				if (back)
+				{
+					GLCD_Stream_Fill(BackColor, back);
+					back = 0;
+				}
+				GLCD_Stream_Pixels(&glyph[i][j * CHAR_W], CHAR_W);
+				continue;
+			}
+#endif
+			// Run length encode the row
+			text = 0;
+			for (k = 0; k < CHAR_W; k++)
+			{
+				if (bits & (1 << k))
+				{
+					if (back)
+					{
+						GLCD_Stream_Fill(BackColor, back);
+						back = 0;
+					}
+					text++;
+				}
+				else
+				{
+					if (text)
+					{
+						GLCD_Stream_Fill(TextColor, text);
+						text = 0;
+					}
+					back++;
+				}
+			}
+			if (text)
+			{
+				GLCD_Stream_Fill(TextColor, text);
+			}
+		}
+	}
+	if (back)
+	{
+		GLCD_Stream_Fill(BackColor, back);
+	}
+	GLCD_Stream_Stop();
+}
+
+
 /*********************************************************************//**
  * @brief	    Disply character on given line
  * @param[in]	ln       line number
@@ -457,7 +1114,31 @@ void GLCD_Display_Char (uint16_t ln, uint16_t col, uchar c)
  **********************************************************************/
 void GLCD_Display_String (uint16_t ln, uint16_t col, uchar *s)
 {
+	uint16_t n;
+
 	GLCD_Window(0,0,320,240);  // Window Max
+
+	// Characters left of the screen or composed off screen go one by one
+	if (GLCD_CompOn)
+	{
+		n = 0;
+	}
+	else
+	{
+		if ((col == 0) && *s)
+		{
+			GLCD_Display_Char(ln, col++, *s++);
+		}
+		for (n = 0; s[n] && ((col + n) * CHAR_W <= WIDTH); n++);
+	}
+
+	if (n)
+	{
+		GLCD_Draw_String(col * CHAR_W, ln * CHAR_H, s, n);
+		s += n;
+		col += n;
+	}
+
 	while (*s)
 	{
 		GLCD_Display_Char(ln, col++, *s++);
@@ -491,20 +1172,26 @@ void GLCD_ClearLn (uint16_t ln)
  **********************************************************************/
 void GLCD_Bitmap (uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t *bitmap)
 {
+#ifdef GLCD_COMP_MODE
 	uint32_t i,j,k;
 
-	GLCD_Set_Loc (x,y,w,h);
-
-	wr_dat_start();
-	k = 16;
-	for (j = 0; j < h; j++)
+	if (GLCD_CompOn)
 	{
-		for (i = 0; i < w; i++)
+		k = 16;
+		for (j = 0; j < h; j++)
 		{
-			wr_dat_only(bitmap[k++]);
+			for (i = 0; i < w; i++)
+			{
+				GLCD_Comp_Pixel(x+i, y+j, bitmap[k++]);
+			}
 		}
+		return;
 	}
-	wr_dat_stop();
+#endif
+
+	GLCD_Stream_Start (x,y,w,h);
+	GLCD_Stream_Pixels (&bitmap[16], (uint32_t)w*h);   // skip bitmap header
+	GLCD_Stream_Stop ();
 }
 
 
@@ -522,19 +1209,17 @@ void GLCD_Bitmap (uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t *bitm
  **********************************************************************/
 void GLCD_Window_Fill (uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color)
 {
-	uint32_t i,j;
-
-	GLCD_Set_Loc (x,y,w,h);
-
-	wr_dat_start();
-	for (j = 0; j < h; j++)
+#ifdef GLCD_COMP_MODE
+	if (GLCD_CompOn)
 	{
-		for (i = 0; i < w; i++)
-		{
-			wr_dat_only(color);
-		}
+		GLCD_Comp_Fill(x, y, w, h, color);
+		return;
 	}
-	wr_dat_stop();
+#endif
+
+	GLCD_Stream_Start (x,y,w,h);
+	GLCD_Stream_Fill (color, (uint32_t)w*h);
+	GLCD_Stream_Stop ();
 }
 
 
@@ -556,6 +1241,13 @@ void GLCD_Line(int16_t x1, int16_t y1, int16_t x2, int16_t y2, uint16_t color)
 	x = x1;
 	y = y1;
 
+	// Horizontal and vertical lines are a one pixel wide window
+	if ((dx == 0) || (dy == 0))
+	{
+		GLCD_Window_Fill(MIN(x1,x2), MIN(y1,y2), dx+1, dy+1, color);
+		return;
+	}
+
 	if(x1 > x2)
 		addx = -1;
 	else
@@ -967,17 +1659,22 @@ void GLCD_Text(int16_t x, int16_t y, uint8_t* textptr, uint16_t length, uint8_t
       }
       for(j=0; j<row; ++j, x+=size)         // Loop through character byte data
       {
-         for(k=0; k<col*size; ++k)          // Loop through the vertical pixels
+         for(k=0; k<col; )                  // Loop through the vertical pixels
          {
-            if(bit_test(pixelData[j], k)) // Check if the pixel should be set
+            if(!bit_test(pixelData[j], k))  // Skip background
             {
-               for(l=0; l<size; ++l)      // The next two loops change the
-               {                          // character's size
-                  for(m=0; m<size; ++m)
-                  {
-                     GLCD_PutPixel(x+m, y+k*size+l, color); // Draws the pixel
-                  }
-               }
+               ++k;
+               continue;
+            }
+            for(l=k; (k<col) && bit_test(pixelData[j], k); ++k);  // Run of set pixels
+            m = (k-l)*size;
+            if((size == 1) && (m == 1))
+            {
+               GLCD_PutPixel(x, y+l, color);
+            }
+            else
+            {
+               GLCD_Window_Fill(x, y+l*size, size, m, color);  // Whole run scaled
             }
          }
       }
@@ -1205,98 +1902,61 @@ int16 gprintf(int16_t x, int16_t y, int8_t size, uint16_t color, const char *for
 }
 
 
+/*********************************************************************//**
+ * @brief	    Wait for a key on the on-screen keyboard
+ * @param[in]	None
+ * @return 		character or special key (CAPS, BK_SPACE, CR, GLOBE)
+ *
+ * Note: keys are taken from the press events of the touch pipeline,
+ * so each touch gives one key and the pen must be lifted in between.
+ **********************************************************************/
 schar GLCD_Getche(void)
 {
 	schar key=0;
-	ts_event ts;
-	uint16_t x,y;
-	Bool flag = 0,up=1;
+	TSC_EVENT_Type ev;
+	Bool flag = 0;
 
-	uint16_t good_state = 0;
-	uint16_t adc_state = 0;
-    uint16_t temp;
+	TSC2004_Start();
 
 	while(1)
 	{
-		good_state = 0;
-		adc_state = 0;
+		if(!flag)
+		{
+			switch(keybd)
+			{
+			case KEY1: GLCD_Bitmap(0,133,320,107,key1); break;
+			case KEY2: GLCD_Bitmap(0,133,320,107,key2); break;
+			case KEY3: GLCD_Bitmap(0,133,320,107,key3); break;
+			}
+			flag = 1;
+		}
 
-		while (good_state<3)          // while less that 3 good samples
+		if(!TSC2004_GetEvent(&ev) || (ev.type != TSC_EV_PRESS))
 		{
-			TSC2004_Read_Values (&ts);
-
-			x = (uint16_t)((ts.x)/11)-24;
-		   	y = (uint16_t)((ts.y)/13)-36;
-
-		   	temp = x;
-		   	if (adc_state == temp)
-		   	{
-		   		good_state++;
-		   	}
-		   	else
-		   	{
-		   		good_state = 0;
-		   	}
-
-		   	adc_state = temp;
+			continue;
 		}
-		x = adc_state;               //Sampled X value
 
 		switch(keybd)
 		{
 		case KEY1:
-			if(!flag)
-			{
-				GLCD_Bitmap(0,133,320,107,key1);
-				flag = 1;
-			}
-			key = Keyboard1(x,y);
+			key = Keyboard1(ev.x,ev.y);
 			break;
 
 		case KEY2:
-			if(!flag)
-			{
-				GLCD_Bitmap(0,133,320,107,key2);
-				flag = 1;
-			}
-			key = Keyboard2(x,y);
+			key = Keyboard2(ev.x,ev.y);
 			break;
 
 		case KEY3:
-			if(!flag)
-			{
-				GLCD_Bitmap(0,133,320,107,key3);
-				flag = 1;
-			}
-			key = Keyboard3(x,y);
+			key = Keyboard3(ev.x,ev.y);
 			break;
 		}
 
-		if(key == 0)
-		{
-			up = 0;    // pen up done now key can be pressed
-		}
-
-		if(key == KEY1 && !up)
-		{
-			flag = 0;
-			keybd = KEY1;
-			up = 1;
-		}
-		else if(key == KEY2 && !up)
+		if((key == KEY1) || (key == KEY2) || (key == KEY3))
 		{
 			flag = 0;
-			keybd = KEY2;
-			up = 1;
+			keybd = key;
 		}
-		else if(key == KEY3 && !up)
-		{
-			flag = 0;
-			keybd = KEY3;
-			up = 1;
-		}
-
-		if((key!=KEY1) && (key!=KEY2) && (key!=KEY3) && key && !up)
+		else if(key)
 		{
 			return(key);
 		}
@@ -1990,6 +2650,10 @@ void Show_BarGraph(void)
 	COORDINATE_Type point1,point2,point3;
 	COLORCFG_Type tricfg;
     uint16_t y_scale,x_scale,i;
+	Bool comp = GLCD_CompOn;
+
+	// Compose axes, arrows and labels off screen, flush them in a few bursts
+	GLCD_Comp_Cmd(ENABLE);
 
 	// X and Y lines
 	GLCD_Line(30,5,30,238,Black);
@@ -2067,6 +2731,12 @@ void Show_BarGraph(void)
 	{
 		gprintf(x_scale,225,1,Black,"%d02",i);
 	}
+
+	GLCD_Comp_Flush();
+	if (!comp)
+	{
+		GLCD_Comp_Cmd(DISABLE);
+	}
 }
 
 
@@ -2080,6 +2750,10 @@ void Show_BarGraph_VI(void)
 	COORDINATE_Type point1,point2,point3;
 	COLORCFG_Type tricfg;
     uint16_t y_scale,x_scale,i;
+	Bool comp = GLCD_CompOn;
+
+	// Compose axes, arrows and labels off screen, flush them in a few bursts
+	GLCD_Comp_Cmd(ENABLE);
 
 	// X and Y lines
 	GLCD_Line(30,5,30,238,Black);
@@ -2164,6 +2838,12 @@ void Show_BarGraph_VI(void)
 			gprintf(x_scale-5,225,1,Black,"%d03",i*10);
 		}
 	}
+
+	GLCD_Comp_Flush();
+	if (!comp)
+	{
+		GLCD_Comp_Cmd(DISABLE);
+	}
 }
 
 
@@ -2180,7 +2860,7 @@ uchar Write_Command_Glcd (uint8_t Command)
 
 	GPIO_ClearValue(2, LCD_RS);  //select command mode
 
-	CS_Force1 (LPC_SSP1, DISABLE);                        /* Select device           */
+	SPIBUS_Select(&GLCD_Dev);                             /* Select device           */
 	xferConfig.tx_data = &Command;               /* Send Instruction Byte    */
 	xferConfig.rx_data = NULL;
 	xferConfig.length = 1;
@@ -2188,7 +2868,7 @@ uchar Write_Command_Glcd (uint8_t Command)
 
 	if(WriteStatus)
 	{
-		CS_Force1 (LPC_SSP1, ENABLE);                          /* CS high inactive        */
+		SPIBUS_Release(&GLCD_Dev);                             /* CS high inactive        */
 		for(i=925; i>0; i--);
 		GPIO_SetValue(2, LCD_RS);  // select data mode
 		return(1);
@@ -2213,7 +2893,7 @@ uchar Write_Data_Glcd (uint16_t data)
 
 	GPIO_SetValue(2, LCD_RS);  // select data mode
 
-	CS_Force1 (LPC_SSP1, DISABLE);                        /* Select device           */
+	SPIBUS_Select(&GLCD_Dev);                             /* Select device           */
 	xferConfig.tx_data = Tx_Buf1;               /* Send Instruction Byte    */
 	xferConfig.rx_data = NULL;
 	xferConfig.length = 2;
@@ -2221,7 +2901,7 @@ uchar Write_Data_Glcd (uint16_t data)
 
 	if(WriteStatus)
 	{
-		CS_Force1 (LPC_SSP1, ENABLE);                          /* CS high inactive        */
+		SPIBUS_Release(&GLCD_Dev);                             /* CS high inactive        */
 		return(1);
 	}
 	else
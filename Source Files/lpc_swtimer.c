@@ -0,0 +1,403 @@
+/******************************************************************//**
+* @file		lpc_swtimer.c
+* @brief	Contains all functions support for the software timer wheel:
+* 			hierarchical wheels of 32 slots advanced by SysTick,
+* 			callbacks run from PendSV or a polled dispatch
+* @version	1.0
+* @date		04. July. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* Peripheral group ----------------------------------------------------------- */
+/** @addtogroup SWTIMER
+ * @{
+ */
+
+/* Includes ------------------------------------------------------------------- */
+#include "lpc_swtimer.h"
+
+
+/* Private Macros ------------------------------------------------------------- */
+/** @defgroup SWTIMER_Private_Macros SWTIMER Private Macros
+ * @{
+ */
+
+/** slot value of a timer waiting in the due list */
+#define SW_SLOT_DUE				0xFF
+
+/** Ticks covered by one slot of a level */
+#define SW_SPAN(level)			(1UL << (5 * (level)))
+
+/**
+ * @}
+ */
+
+
+/* Private Variables ---------------------------------------------------------- */
+/** @defgroup SWTIMER_Private_Variables SWTIMER Private Variables
+ * @{
+ */
+
+static SWTIMER_Type *sw_wheel[SWTIMER_LEVELS][SWTIMER_SLOTS];
+static uint32_t sw_map[SWTIMER_LEVELS];		// bit set when a slot is not empty
+static SWTIMER_Type *sw_due;					// expired, waiting for their callback
+static SWTIMER_Type **sw_due_tail = &sw_due;
+static __IO uint32_t sw_now;					// last tick processed
+
+/**
+ * @}
+ */
+
+
+/* Private Functions ---------------------------------------------------------- */
+/*********************************************************************//**
+ * @brief		Remove a timer from its slot or from the due list
+ * @param[in]	t: running timer, interrupts masked
+ * @return 		None
+ **********************************************************************/
+static void sw_unlink (SWTIMER_Type *t)
+{
+	*t->pprev = t->next;
+	if (t->next != NULL)
+	{
+		t->next->pprev = t->pprev;
+	}
+	else if (t->slot == SW_SLOT_DUE)
+	{
+		sw_due_tail = t->pprev;
+	}
+
+	if ((t->slot != SW_SLOT_DUE) && (sw_wheel[t->slot >> 5][t->slot & 31] == NULL))
+	{
+		sw_map[t->slot >> 5] &= ~(1UL << (t->slot & 31));
+	}
+	t->pprev = NULL;
+}
+
+
+/*********************************************************************//**
+ * @brief		Put a timer in the slot its expiry falls in: the lowest
+ * 				level whose 32 slots reach that far
+ * @param[in]	t: stopped timer with expires set, interrupts masked
+ * @return 		None
+ **********************************************************************/
+static void sw_insert (SWTIMER_Type *t)
+{
+	uint32_t delta = t->expires - sw_now;
+	uint32_t level, idx;
+
+	for (level = 0; level < (SWTIMER_LEVELS - 1); level++)
+	{
+		if (delta < SW_SPAN(level + 1))
+		{
+			break;
+		}
+	}
+	idx = (t->expires >> (5 * level)) & 31;
+
+	t->slot = (uint8_t)((level << 5) | idx);
+	t->next = sw_wheel[level][idx];
+	if (t->next != NULL)
+	{
+		t->next->pprev = &t->next;
+	}
+	sw_wheel[level][idx] = t;
+	t->pprev = &sw_wheel[level][idx];
+	sw_map[level] |= (1UL << idx);
+}
+
+
+/*********************************************************************//**
+ * @brief		Append a timer to the due list
+ * @param[in]	t: stopped timer, interrupts masked
+ * @return 		None
+ **********************************************************************/
+static void sw_make_due (SWTIMER_Type *t)
+{
+	t->slot = SW_SLOT_DUE;
+	t->next = NULL;
+	t->pprev = sw_due_tail;
+	*sw_due_tail = t;
+	sw_due_tail = &t->next;
+}
+
+
+/*********************************************************************//**
+ * @brief		First non-empty slot after the current one
+ * @param[in]	map: occupancy of a level
+ * @param[in]	cur: current slot of that level
+ * @return 		Slots ahead, 1 .. 32 (32 is the current slot, one turn on)
+ **********************************************************************/
+static uint32_t sw_ahead (uint32_t map, uint32_t cur)
+{
+	uint32_t r;
+
+	r = (cur == 31) ? map : ((map >> (cur + 1)) | (map << (31 - cur)));
+	r &= (0 - r);								// lowest set bit
+	return (31 - __CLZ(r)) + 1;
+}
+/* End of Private Functions --------------------------------------------------- */
+
+
+/*----------------- INTERRUPT SERVICE ROUTINES --------------------------*/
+#if (SWTIMER_DISPATCH == SWTIMER_DISPATCH_PENDSV)
+/*********************************************************************//**
+ * @brief 		PendSV handler, runs the callbacks of expired timers at
+ * 				the lowest interrupt priority
+ * @param		None
+ * @return 		None
+ ***********************************************************************/
+void PendSV_Handler(void)
+{
+	SWTIMER_Dispatch();
+}
+#endif
+
+
+/* Public Functions ----------------------------------------------------------- */
+/** @addtogroup SWTIMER_Public_Functions
+ * @{
+ */
+
+/*********************************************************************//**
+ * @brief		Set up a timer, stopped
+ * @param[in]	timer: timer to set up
+ * @param[in]	callback: called on each expiry
+ * @param[in]	arg: passed to callback
+ * @return 		None
+ **********************************************************************/
+void SWTIMER_Init (SWTIMER_Type *timer, SWTIMER_Callback_Type callback, void *arg)
+{
+	timer->next = NULL;
+	timer->pprev = NULL;
+	timer->period = 0;
+	timer->callback = callback;
+	timer->arg = arg;
+
+#if (SWTIMER_DISPATCH == SWTIMER_DISPATCH_PENDSV)
+	NVIC_SetPriority(PendSV_IRQn, 0xFF);		// below every peripheral
+#endif
+}
+
+
+/*********************************************************************//**
+ * @brief		Start or restart a timer
+ * @param[in]	timer: timer set up with SWTIMER_Init()
+ * @param[in]	delay: ticks to the first expiry, at least 1
+ * @param[in]	period: ticks between later expiries, 0 for a one-shot
+ * @return 		None
+ *
+ * Note: O(1), the timer goes in one slot of one wheel. It moves to a
+ * lower wheel each time that wheel comes round to it, at most
+ * SWTIMER_LEVELS - 1 times in its life.
+ **********************************************************************/
+void SWTIMER_Start (SWTIMER_Type *timer, uint32_t delay, uint32_t period)
+{
+	uint32_t primask;
+
+	if (delay == 0)
+	{
+		delay = 1;
+	}
+	if (delay > SWTIMER_MAX_DELAY)
+	{
+		delay = SWTIMER_MAX_DELAY;
+	}
+	if (period > SWTIMER_MAX_DELAY)
+	{
+		period = SWTIMER_MAX_DELAY;
+	}
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if (timer->pprev != NULL)
+	{
+		sw_unlink(timer);
+	}
+	timer->expires = sw_now + delay;
+	timer->period = period;
+	sw_insert(timer);
+	__set_PRIMASK(primask);
+}
+
+
+/*********************************************************************//**
+ * @brief		Stop a timer, O(1)
+ * @param[in]	timer: timer set up with SWTIMER_Init()
+ * @return 		None
+ *
+ * Note: an expiry already waiting for dispatch is cancelled as well.
+ **********************************************************************/
+void SWTIMER_Stop (SWTIMER_Type *timer)
+{
+	uint32_t primask;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if (timer->pprev != NULL)
+	{
+		sw_unlink(timer);
+	}
+	__set_PRIMASK(primask);
+}
+
+
+/*********************************************************************//**
+ * @brief		Check if a timer is running
+ * @param[in]	timer: timer set up with SWTIMER_Init()
+ * @return 		TRUE if started and not expired (one-shot) or stopped
+ **********************************************************************/
+Bool SWTIMER_IsRunning (SWTIMER_Type *timer)
+{
+	return (timer->pprev != NULL) ? TRUE : FALSE;
+}
+
+
+/*********************************************************************//**
+ * @brief		Advance the wheels by one tick, called from
+ * 				SysTick_Handler
+ * @param		None
+ * @return 		None
+ *
+ * Note: when a wheel wraps, the next slot of the wheel above is spread
+ * over the lower wheels. The current slot of the lowest wheel then
+ * holds exactly the timers due now, which move to the due list.
+ **********************************************************************/
+void SWTIMER_Tick (void)
+{
+	SWTIMER_Type *t, *next;
+	uint32_t now, level, idx;
+
+	now = ++sw_now;
+
+	for (level = 1; level < SWTIMER_LEVELS; level++)
+	{
+		if (now & (SW_SPAN(level) - 1))
+		{
+			break;
+		}
+		idx = (now >> (5 * level)) & 31;
+		t = sw_wheel[level][idx];
+		sw_wheel[level][idx] = NULL;
+		sw_map[level] &= ~(1UL << idx);
+		for (; t != NULL; t = next)
+		{
+			next = t->next;
+			sw_insert(t);
+		}
+	}
+
+	idx = now & 31;
+	t = sw_wheel[0][idx];
+	sw_wheel[0][idx] = NULL;
+	sw_map[0] &= ~(1UL << idx);
+	for (; t != NULL; t = next)
+	{
+		next = t->next;
+		sw_make_due(t);
+	}
+
+	if (sw_due != NULL)
+	{
+#if (SWTIMER_DISPATCH == SWTIMER_DISPATCH_PENDSV)
+		SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+#endif
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief		Run the callbacks of the expired timers
+ * @param		None
+ * @return 		None
+ *
+ * Note: runs from PendSV_Handler, or from the main loop when
+ * SWTIMER_DISPATCH_SEL selects polling. A periodic timer is restarted
+ * before its callback, on its original phase, skipping any periods
+ * missed while dispatch was late.
+ **********************************************************************/
+void SWTIMER_Dispatch (void)
+{
+	SWTIMER_Type *t;
+	SWTIMER_Callback_Type callback;
+	void *arg;
+	uint32_t primask;
+
+	while (1)
+	{
+		primask = __get_PRIMASK();
+		__disable_irq();
+		t = sw_due;
+		if (t == NULL)
+		{
+			__set_PRIMASK(primask);
+			return;
+		}
+		sw_unlink(t);
+		if (t->period != 0)
+		{
+			t->expires += t->period;
+			if ((int32_t)(t->expires - sw_now) <= 0)
+			{
+				t->expires += ((sw_now - t->expires) / t->period + 1) * t->period;
+			}
+			sw_insert(t);
+		}
+		callback = t->callback;
+		arg = t->arg;
+		__set_PRIMASK(primask);
+
+		if (callback != NULL)
+		{
+			callback(arg);
+		}
+	}
+}
+
+
+/*********************************************************************//**
+ * @brief		Ticks that can pass before the wheel needs SWTIMER_Tick()
+ * 				to do anything
+ * @param		None
+ * @return 		Ticks to the next expiry or wheel cascade, 0 if callbacks
+ * 				are waiting, SWTIMER_MAX_DELAY if no timer runs
+ *
+ * Note: used by the tickless idle to stretch SysTick. A timer in an
+ * upper wheel counts from the tick its slot is cascaded, so the result
+ * may be early, never late.
+ **********************************************************************/
+uint32_t SWTIMER_NextExpiry (void)
+{
+	uint32_t level, now, ahead, best = SWTIMER_MAX_DELAY;
+
+	if (sw_due != NULL)
+	{
+		return 0;
+	}
+
+	now = sw_now;
+	for (level = 0; level < SWTIMER_LEVELS; level++)
+	{
+		if (sw_map[level] == 0)
+		{
+			continue;
+		}
+		ahead = sw_ahead(sw_map[level], (now >> (5 * level)) & 31);
+		ahead = (((now >> (5 * level)) + ahead) << (5 * level)) - now;
+		if (ahead < best)
+		{
+			best = ahead;
+		}
+	}
+	return best;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+/* --------------------------------- End Of File ------------------------------ */
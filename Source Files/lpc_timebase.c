@@ -0,0 +1,193 @@
+/******************************************************************//**
+* @file		lpc_timebase.c
+* @brief	Contains all functions support for the monotonic timebase:
+* 			microseconds from a timer that is never stopped, cycles
+* 			from the DWT counter extended to 64 bits
+* @version	1.0
+* @date		07. July. 2014
+* @author	Dwijay.Edutech Learning Solutions
+**********************************************************************/
+
+/* Peripheral group ----------------------------------------------------------- */
+/** @addtogroup TIMEBASE
+ * @{
+ */
+
+/* Includes ------------------------------------------------------------------- */
+#include "lpc_timebase.h"
+#include "lpc17xx_clkpwr.h"
+
+
+/* Private Macros ------------------------------------------------------------- */
+/** @defgroup TIMEBASE_Private_Macros TIMEBASE Private Macros
+ * @{
+ */
+
+/** DWT registers, not described by this CMSIS core header */
+#define TB_DWT_CTRL				(*(__IO uint32_t *)0xE0001000UL)
+#define TB_DWT_CYCCNT			(*(__IO uint32_t *)0xE0001004UL)
+#define TB_DWT_CTRL_CYCCNTENA	((uint32_t)(1<<0))
+
+/**
+ * @}
+ */
+
+
+/* Private Variables ---------------------------------------------------------- */
+/** @defgroup TIMEBASE_Private_Variables TIMEBASE Private Variables
+ * @{
+ */
+
+static uint8_t tb_ready;
+static uint32_t tb_cyc_hi;			// upper word of the cycle count
+static uint32_t tb_cyc_last;		// CYCCNT at the last now_cycles()
+
+/**
+ * @}
+ */
+
+
+/* Public Functions ----------------------------------------------------------- */
+/** @addtogroup TIMEBASE_Public_Functions
+ * @{
+ */
+
+/*********************************************************************//**
+ * @brief		Start the timebase, later calls do nothing
+ * @param		None
+ * @return 		None
+ *
+ * Note: TIMEBASE_TIM counts microseconds from here on and is never
+ * stopped or reset: TIM_Init(), TIM_DeInit(), TIM_Config(), TIM_Cmd()
+ * and TIM_ResetCounter() refuse it. The prescaler is exact when PCLK
+ * is a whole number of MHz.
+ **********************************************************************/
+void TIMEBASE_Init (void)
+{
+	if (tb_ready)
+	{
+		return;
+	}
+
+	CLKPWR_ConfigPPWR(TIMEBASE_PCONP, ENABLE);
+	CLKPWR_SetPCLKDiv(TIMEBASE_PCLKSEL, CLKPWR_PCLKSEL_CCLK_DIV_4);
+
+	TIMEBASE_TIM->TCR = 2;						/* Reset timer */
+	TIMEBASE_TIM->CTCR = 0;						/* Timer mode */
+	TIMEBASE_TIM->MCR = 0;						/* Free running, no match */
+	TIMEBASE_TIM->CCR = 0;
+	TIMEBASE_TIM->IR = 0x3F;
+	TIMEBASE_TIM->PR = (CLKPWR_GetPCLK(TIMEBASE_PCLKSEL) / 1000000) - 1;
+	TIMEBASE_TIM->TCR = 1;						/* Start the counter */
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	TB_DWT_CTRL |= TB_DWT_CTRL_CYCCNTENA;
+	tb_cyc_last = TB_DWT_CYCCNT;
+
+	tb_ready = 1;
+}
+
+
+/*********************************************************************//**
+ * @brief		Microseconds since TIMEBASE_Init()
+ * @param		None
+ * @return 		Time in us, wraps after 71 minutes
+ *
+ * Note: keeps counting while the core sleeps, compare two readings by
+ * unsigned subtraction.
+ **********************************************************************/
+uint32_t now_us (void)
+{
+	return TIMEBASE_TIM->TC;
+}
+
+
+/*********************************************************************//**
+ * @brief		Core clock cycles since TIMEBASE_Init(), for profiling
+ * @param		None
+ * @return 		64-bit cycle count
+ *
+ * Note: CYCCNT wraps every 2^32 cycles (43 s at 100 MHz), a wrap is
+ * seen by comparing with the previous reading, so this must be called
+ * at least that often. SysTick_Handler does. The counter stops while
+ * the core sleeps, use now_us() for wall time.
+ **********************************************************************/
+uint64_t now_cycles (void)
+{
+	uint32_t primask, cyc, hi;
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	cyc = TB_DWT_CYCCNT;
+	if (cyc < tb_cyc_last)
+	{
+		tb_cyc_hi++;
+	}
+	tb_cyc_last = cyc;
+	hi = tb_cyc_hi;
+	__set_PRIMASK(primask);
+
+	return ((uint64_t)hi << 32) | cyc;
+}
+
+
+/*********************************************************************//**
+ * @brief		Deadline a number of microseconds from now
+ * @param[in]	us: time to the deadline, at most TIMEBASE_MAX_DEADLINE
+ * @return 		Deadline for deadline_expired() and deadline_left()
+ **********************************************************************/
+uint32_t deadline_us (uint32_t us)
+{
+	return now_us() + us;
+}
+
+
+/*********************************************************************//**
+ * @brief		Check if a deadline has passed
+ * @param[in]	deadline: value from deadline_us()
+ * @return 		TRUE once now_us() has reached it
+ **********************************************************************/
+Bool deadline_expired (uint32_t deadline)
+{
+	return ((int32_t)(now_us() - deadline) >= 0) ? TRUE : FALSE;
+}
+
+
+/*********************************************************************//**
+ * @brief		Time left to a deadline
+ * @param[in]	deadline: value from deadline_us()
+ * @return 		Microseconds left, 0 if it has passed
+ **********************************************************************/
+uint32_t deadline_left (uint32_t deadline)
+{
+	int32_t left = (int32_t)(deadline - now_us());
+
+	return (left > 0) ? (uint32_t)left : 0;
+}
+
+
+/*********************************************************************//**
+ * @brief		Micro sec delay function
+ * @param[in]	us: value in micro sec
+ * @return 		None
+ *
+ * Note: busy-waits on now_us(), the timer is left running.
+ **********************************************************************/
+void delay_us (uint32_t us)
+{
+	uint32_t start;
+
+	TIMEBASE_Init();
+	start = now_us();
+	while ((uint32_t)(now_us() - start) < us);
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+/* --------------------------------- End Of File ------------------------------ */